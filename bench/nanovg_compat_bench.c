@@ -0,0 +1,659 @@
+// Benchmarks representative workloads through the compat layer without a GPU, on Linux
+//
+// nanovg_compat_bench [-b null|cpu] [-n frames] [-t threads] [-f font.ttf] [-o out.json] [-c baseline.json] [-r pct]
+//
+//   -b backend   null runs nanovg & the compat layer only, drawing into a recorder whose backend does nothing, so the
+//                numbers cover path building, flattening, expansion & text layout. cpu also rasterizes with the
+//                software renderer & counts the context's allocations. Defaults to null
+//   -n frames    Frames per workload. Defaults to 200
+//   -t threads   Rasterizer threads of the cpu backend. Defaults to 1, for stable numbers
+//   -f font      TrueType font for the text workloads, which are skipped without one
+//   -o path      Writes the results as JSON to `path` instead of stdout
+//   -c baseline  Compares ns/frame against a JSON file written by an earlier run, exits with 1 on a regression
+//   -r pct       Regression threshold of -c, in percent. Defaults to 10
+
+#include "nanovg_compat.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WIDTH 1280
+#define HEIGHT 720
+#define MAX_RESULTS 16
+
+typedef struct BenchResult
+{
+    const char* name;
+    int         frames;
+    double      nsPerFrame;
+    double      frontendNsPerFrame; // Frame time minus the backend flush
+    double      nsPerPath;
+    double      verticesPerSec;
+    double      allocationsPerFrame; // -1 when allocations aren't counted
+} BenchResult;
+
+typedef struct Bench
+{
+    NVGcontext* target; // Context of the cpu backend
+    NVGcontext* vg;     // Context drawn to, a recorder of target for the null backend
+    int         null;
+    int         damage; // Frames are redrawn with NVG_DAMAGE_PARTIAL instead of cleared
+    int         frames;
+    int         font;
+    BenchResult results[MAX_RESULTS];
+    int         nresults;
+} Bench;
+
+// Draws one frame of a workload. Returns the number of paths filled or stroked
+typedef int (*BenchDraw)(NVGcontext* vg, int frame);
+
+static long long nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+static void drawKnob(NVGcontext* vg, float cx, float cy, float value)
+{
+    float    a0   = NVG_PI * 0.75f;
+    float    a1   = a0 + NVG_PI * 1.5f * value;
+    NVGpaint knob = nvgRadialGradient(
+        vg,
+        cx - 6.0f,
+        cy - 6.0f,
+        2.0f,
+        20.0f,
+        nvgRGBA(90, 90, 100, 255),
+        nvgRGBA(30, 30, 36, 255));
+
+    nvgBeginPath(vg);
+    nvgArc(vg, cx, cy, 24.0f, a0, NVG_PI * 2.25f, NVG_CW);
+    nvgStrokeWidth(vg, 4.0f);
+    nvgStrokeColor(vg, nvgRGBA(50, 50, 56, 255));
+    nvgStroke(vg);
+
+    nvgBeginPath(vg);
+    nvgArc(vg, cx, cy, 24.0f, a0, a1, NVG_CW);
+    nvgStrokeColor(vg, nvgRGBA(80, 170, 255, 255));
+    nvgStroke(vg);
+
+    nvgBeginPath(vg);
+    nvgCircle(vg, cx, cy, 18.0f);
+    nvgFillPaint(vg, knob);
+    nvgFill(vg);
+
+    nvgBeginPath(vg);
+    nvgMoveTo(vg, cx + cosf(a1) * 6.0f, cy + sinf(a1) * 6.0f);
+    nvgLineTo(vg, cx + cosf(a1) * 16.0f, cy + sinf(a1) * 16.0f);
+    nvgStrokeWidth(vg, 2.0f);
+    nvgStrokeColor(vg, nvgRGBA(230, 230, 230, 255));
+    nvgStroke(vg);
+}
+
+static int drawKnobs(NVGcontext* vg, int frame)
+{
+    int x, y;
+    for (y = 0; y < 12; y++)
+        for (x = 0; x < 20; x++)
+            drawKnob(vg, 32.0f + x * 62.0f, 32.0f + y * 58.0f, 0.5f + 0.5f * sinf(frame * 0.05f + x * 0.3f + y * 0.7f));
+    return 12 * 20 * 4;
+}
+
+// The knob grid with a single knob moving, as in a typical control panel
+static int drawDashboard(NVGcontext* vg, int frame)
+{
+    int x, y;
+    for (y = 0; y < 12; y++)
+    {
+        for (x = 0; x < 20; x++)
+        {
+            float phase = x == 7 && y == 5 ? frame * 0.05f : 0.0f;
+            drawKnob(vg, 32.0f + x * 62.0f, 32.0f + y * 58.0f, 0.5f + 0.5f * sinf(phase + x * 0.3f + y * 0.7f));
+        }
+    }
+    return 12 * 20 * 4;
+}
+
+// drawKnobs with nvg__flattenPathsSIMD in place of nanovg's flattener
+static int drawKnobsSimd(NVGcontext* vg, int frame)
+{
+    int npaths;
+    nvgSimdTessellation(vg, 1, 0);
+    npaths = drawKnobs(vg, frame);
+    nvgSimdTessellation(vg, 0, 0);
+    return npaths;
+}
+
+static int drawPolylines(NVGcontext* vg, int frame)
+{
+    int line, i;
+    for (line = 0; line < 4; line++)
+    {
+        float y0 = 90.0f + line * 180.0f;
+
+        nvgBeginPath(vg);
+        nvgMoveTo(vg, 0.0f, y0);
+        for (i = 1; i < 8192; i++)
+        {
+            float x = i * (WIDTH / 8192.0f);
+            nvgLineTo(vg, x, y0 + 70.0f * sinf(i * 0.013f + frame * 0.1f + line) * cosf(i * 0.0011f));
+        }
+        nvgStrokeWidth(vg, 1.5f);
+        nvgStrokeColor(vg, nvgRGBA(255, 200, 80, 255));
+        nvgStroke(vg);
+
+        nvgLineTo(vg, WIDTH, y0 + 90.0f);
+        nvgLineTo(vg, 0.0f, y0 + 90.0f);
+        nvgClosePath(vg);
+        nvgFillColor(vg, nvgRGBA(255, 200, 80, 40));
+        nvgFill(vg);
+    }
+    return 8;
+}
+
+static int drawText(NVGcontext* vg, int frame)
+{
+    static const float sizes[3] = {12.0f, 14.0f, 18.0f};
+    char               label[64];
+    int                x, y;
+
+    nvgFontFace(vg, "bench");
+    nvgFillColor(vg, nvgRGBA(220, 220, 220, 255));
+    nvgTextAlign(vg, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+    for (y = 0; y < 40; y++)
+    {
+        nvgFontSize(vg, sizes[y % 3]);
+        for (x = 0; x < 8; x++)
+        {
+            snprintf(label, sizeof(label), "Param %d.%d %+.2f dB", y, x, sinf(frame * 0.01f + x + y) * 12.0f);
+            nvgText(vg, 8.0f + x * 158.0f, 4.0f + y * 17.0f, label, NULL);
+        }
+    }
+    nvgFontSize(vg, 14.0f);
+    nvgTextBox(
+        vg,
+        8.0f,
+        690.0f,
+        600.0f,
+        "The quick brown fox jumps over the lazy dog, then wraps onto the next row of the text box.",
+        NULL);
+    return 0;
+}
+
+static int drawGradients(NVGcontext* vg, int frame)
+{
+    int x, y, npaths = 0;
+    for (y = 0; y < 10; y++)
+    {
+        for (x = 0; x < 16; x++)
+        {
+            float    rx = 8.0f + x * 79.0f;
+            float    ry = 8.0f + y * 71.0f;
+            float    t  = 0.5f + 0.5f * sinf(frame * 0.03f + x + y);
+            NVGcolor c0 = nvgHSLA(t, 0.6f, 0.5f, 255);
+            NVGcolor c1 = nvgHSLA(1.0f - t, 0.6f, 0.3f, 255);
+            NVGpaint paint;
+
+            switch ((x + y) % 3)
+            {
+            case 0:
+                paint = nvgLinearGradient(vg, rx, ry, rx + 70.0f, ry + 62.0f, c0, c1);
+                break;
+            case 1:
+                paint = nvgBoxGradient(vg, rx + 4.0f, ry + 4.0f, 62.0f, 54.0f, 8.0f, 12.0f, c0, c1);
+                break;
+            default:
+                paint = nvgRadialGradient(vg, rx + 35.0f, ry + 31.0f, 4.0f, 40.0f, c0, c1);
+                break;
+            }
+            nvgBeginPath(vg);
+            nvgRoundedRect(vg, rx, ry, 70.0f, 62.0f, 6.0f);
+            nvgFillPaint(vg, paint);
+            nvgFill(vg);
+            npaths++;
+        }
+    }
+    return npaths;
+}
+
+static int drawStrokeBlur(NVGcontext* vg, int frame)
+{
+    int i, npaths = 0;
+    for (i = 0; i < 64; i++)
+    {
+        float x = 40.0f + (i % 8) * 150.0f;
+        float y = 40.0f + (i / 8) * 85.0f;
+
+        nvgBeginPath(vg);
+        nvgMoveTo(vg, x, y + 40.0f);
+        nvgBezierTo(vg, x + 40.0f, y - 20.0f * sinf(frame * 0.05f + i), x + 80.0f, y + 80.0f, x + 120.0f, y + 20.0f);
+        nvgStrokeWidth(vg, 3.0f);
+        nvgStrokeColor(vg, nvgRGBA(120, 255, 160, 160));
+        nvgStrokeBlur(vg, 1.0f + (i % 4) * 2.0f);
+
+        nvgBeginPath(vg);
+        nvgRoundedRect(vg, x, y, 120.0f, 60.0f, 10.0f);
+        nvgStrokeBlur(vg, 4.0f);
+        npaths += 2;
+    }
+    return npaths;
+}
+
+// drawStrokeBlur with nvg__expandStrokeSIMD in place of nanovg's stroke expander
+static int drawStrokeBlurSimd(NVGcontext* vg, int frame)
+{
+    int npaths;
+    nvgSimdTessellation(vg, 0, 1);
+    npaths = drawStrokeBlur(vg, frame);
+    nvgSimdTessellation(vg, 0, 0);
+    return npaths;
+}
+
+static int drawNested(NVGcontext* vg, float x, float y, float w, float h, int depth, int frame)
+{
+    int i, npaths = 1;
+
+    nvgSave(vg);
+    nvgIntersectScissor(vg, x, y, w, h);
+    nvgBeginPath(vg);
+    nvgRect(vg, x, y, w, h);
+    nvgFillColor(vg, nvgRGBA(40 + depth * 30, 40, 60, 255));
+    nvgFill(vg);
+    if (depth < 4)
+    {
+        // Children overflow their parent a little, so the scissor clips them
+        float cw = w * 0.5f + 6.0f;
+        float ch = h * 0.5f + 6.0f;
+        float dx = sinf(frame * 0.02f + depth) * 4.0f;
+        for (i = 0; i < 4; i++)
+            npaths += drawNested(vg, x + (i % 2) * w * 0.5f + dx, y + (i / 2) * h * 0.5f, cw, ch, depth + 1, frame);
+    }
+    nvgRestore(vg);
+    return npaths;
+}
+
+static int drawScissor(NVGcontext* vg, int frame)
+{
+    int x, y, npaths = 0;
+    for (y = 0; y < 2; y++)
+        for (x = 0; x < 4; x++)
+            npaths += drawNested(vg, 8.0f + x * 318.0f, 8.0f + y * 356.0f, 310.0f, 348.0f, 0, frame);
+    return npaths;
+}
+
+static void beginFrame(Bench* bench)
+{
+    if (! bench->null && ! bench->damage)
+        nvgClearWithColor(bench->target, nvgRGBA(0, 0, 0, 255));
+    nvgBeginFrame(bench->vg, WIDTH, HEIGHT, 1.0f);
+}
+
+static void runWorkload(Bench* bench, const char* name, BenchDraw draw)
+{
+    BenchResult*      result = &bench->results[bench->nresults];
+    NanoVGFrameStats* stats  = (NanoVGFrameStats*)calloc(bench->frames, sizeof(NanoVGFrameStats));
+    long long         start, elapsed, frontend = 0;
+    double            vertices = 0.0, allocations = 0.0;
+    int               i, n, npaths = 0;
+
+    if (stats == NULL || bench->nresults == MAX_RESULTS)
+    {
+        free(stats);
+        return;
+    }
+
+    // Warm up caches & buffers, then restart the telemetry ring
+    for (i = 0; i < 10; i++)
+    {
+        beginFrame(bench);
+        draw(bench->vg, i);
+        nvgEndFrame(bench->vg);
+    }
+    nvgTelemetryFrames(bench->vg, 0);
+    nvgTelemetryFrames(bench->vg, bench->frames);
+
+    start = nowNs();
+    for (i = 0; i < bench->frames; i++)
+    {
+        beginFrame(bench);
+        npaths += draw(bench->vg, i);
+        nvgEndFrame(bench->vg);
+    }
+    elapsed = nowNs() - start;
+
+    n = nvgGetFrameStats(bench->vg, stats, bench->frames);
+    for (i = 0; i < n; i++)
+    {
+        frontend    += stats[i].frameNs - stats[i].flushNs;
+        vertices    += (double)(stats[i].vertexBytes + stats[i].vertexBytesSaved) / sizeof(NVGvertex);
+        allocations += stats[i].allocations;
+    }
+    free(stats);
+
+    result->name                = name;
+    result->frames              = bench->frames;
+    result->nsPerFrame          = (double)elapsed / bench->frames;
+    result->frontendNsPerFrame  = n > 0 ? (double)frontend / n : 0.0;
+    result->nsPerPath           = npaths > 0 ? (double)elapsed / npaths : 0.0;
+    result->verticesPerSec      = elapsed > 0 ? vertices * 1e9 / elapsed : 0.0;
+    result->allocationsPerFrame = bench->null ? -1.0 : (n > 0 ? allocations / n : 0.0);
+    bench->nresults++;
+}
+
+static NVGcontext* createTarget(int threads)
+{
+    NVGcontext* ctx = nvgCreateContextAllocator(NULL, NVG_ANTIALIAS, WIDTH, HEIGHT, NULL);
+    if (ctx != NULL)
+        cpunvgSetThreadCount(ctx, threads);
+    return ctx;
+}
+
+// Time from context creation to the end of the first frame of the text workload, with the glyphs rasterized on
+// demand, or loaded from `atlas` when it isn't NULL
+static void runStartup(Bench* bench, const char* name, const char* fontPath, const char* atlas, int threads)
+{
+    BenchResult* result = &bench->results[bench->nresults];
+    Bench        run    = *bench;
+    long long    start  = nowNs();
+    long long    elapsed;
+
+    if (bench->nresults == MAX_RESULTS)
+        return;
+    run.target = createTarget(threads);
+    if (run.target == NULL)
+        return;
+    run.vg = run.null ? nvgCreateRecorder(run.target) : run.target;
+    if (run.vg == NULL || nvgCreateFont(run.vg, "bench", fontPath) == -1 ||
+        (atlas != NULL && nvgLoadGlyphAtlas(run.vg, atlas) == 0))
+    {
+        fprintf(stderr, "nanovg_compat_bench: %s failed\n", name);
+    }
+    else
+    {
+        beginFrame(&run);
+        drawText(run.vg, 0);
+        nvgEndFrame(run.vg);
+        elapsed = nowNs() - start;
+
+        memset(result, 0, sizeof(*result));
+        result->name                = name;
+        result->frames              = 1;
+        result->nsPerFrame          = (double)elapsed;
+        result->frontendNsPerFrame  = (double)elapsed;
+        result->allocationsPerFrame = -1.0;
+        bench->nresults++;
+    }
+
+    if (run.vg != NULL && run.vg != run.target)
+        nvgDeleteRecorder(run.vg);
+    nvgDeleteContext(run.target);
+}
+
+// Bakes the glyphs drawn by drawText into a temporary file. Returns 1 on success
+static int bakeAtlas(const char* fontPath, char* path)
+{
+    static const float sizes[3] = {12.0f, 14.0f, 18.0f};
+    NVGcontext*        ctx;
+    int                i, font, fd, ok = 1;
+
+    fd = mkstemp(path);
+    if (fd < 0)
+        return 0;
+    close(fd);
+
+    ctx = nvgCreateContext(NULL, NVG_ANTIALIAS, 1, 1);
+    if (ctx == NULL)
+        return 0;
+    font = nvgCreateFont(ctx, "bench", fontPath);
+    ok   = font != -1;
+    for (i = 0; ok && i < 3; i++)
+        ok = nvgBakeGlyphs(ctx, font, sizes[i], 0.0f, 32, 126) >= 0;
+    ok = ok && nvgSaveGlyphAtlas(ctx, path);
+    nvgDeleteContext(ctx);
+    return ok;
+}
+
+static void writeJson(FILE* file, const Bench* bench)
+{
+    int i;
+    fprintf(file, "{\n  \"backend\": \"%s\",\n  \"workloads\": [\n", bench->null ? "null" : "cpu");
+    for (i = 0; i < bench->nresults; i++)
+    {
+        const BenchResult* r = &bench->results[i];
+        fprintf(
+            file,
+            "    {\"name\": \"%s\", \"frames\": %d, \"nsPerFrame\": %.0f, \"frontendNsPerFrame\": %.0f, "
+            "\"nsPerPath\": %.1f, \"verticesPerSec\": %.0f, \"allocationsPerFrame\": %.2f}%s\n",
+            r->name,
+            r->frames,
+            r->nsPerFrame,
+            r->frontendNsPerFrame,
+            r->nsPerPath,
+            r->verticesPerSec,
+            r->allocationsPerFrame,
+            i + 1 < bench->nresults ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+}
+
+// Reads the nsPerFrame of workload `name` from a file written by writeJson. Returns 0 when it's missing
+static double baselineNs(const char* json, const char* name)
+{
+    char        key[96];
+    const char* entry;
+    const char* value;
+
+    snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+    entry = strstr(json, key);
+    if (entry == NULL)
+        return 0.0;
+    value = strstr(entry, "\"nsPerFrame\": ");
+    if (value == NULL)
+        return 0.0;
+    return strtod(value + strlen("\"nsPerFrame\": "), NULL);
+}
+
+// Prints the change of each workload against `path`. Returns the number of workloads slower by more than `threshold`
+// percent, or -1 when the file can't be read
+static int compareBaseline(const Bench* bench, const char* path, double threshold)
+{
+    FILE* file = fopen(path, "rb");
+    char* json;
+    long  size;
+    int   i, regressions = 0;
+
+    if (file == NULL)
+        return -1;
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    json = (char*)malloc(size + 1);
+    if (json == NULL || fread(json, 1, size, file) != (size_t)size)
+    {
+        free(json);
+        fclose(file);
+        return -1;
+    }
+    json[size] = '\0';
+    fclose(file);
+
+    for (i = 0; i < bench->nresults; i++)
+    {
+        const BenchResult* r    = &bench->results[i];
+        double             base = baselineNs(json, r->name);
+        double             change;
+        if (base <= 0.0)
+        {
+            fprintf(stderr, "%-16s not in baseline\n", r->name);
+            continue;
+        }
+        change = (r->nsPerFrame - base) * 100.0 / base;
+        fprintf(stderr, "%-16s %+7.1f%%%s\n", r->name, change, change > threshold ? "  REGRESSION" : "");
+        if (change > threshold)
+            regressions++;
+    }
+    free(json);
+    return regressions;
+}
+
+static int usage(void)
+{
+    fprintf(
+        stderr,
+        "usage: nanovg_compat_bench [-b null|cpu] [-n frames] [-t threads] [-f font.ttf] [-o out.json] "
+        "[-c baseline.json] [-r pct]\n");
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    Bench       bench;
+    const char* fontPath  = NULL;
+    const char* output    = NULL;
+    const char* baseline  = NULL;
+    double      threshold = 10.0;
+    int         threads   = 1;
+    int         i, status = 0;
+
+    memset(&bench, 0, sizeof(bench));
+    bench.null   = 1;
+    bench.frames = 200;
+    bench.font   = -1;
+
+    for (i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        if (arg[0] != '-' || arg[1] == '\0' || arg[2] != '\0' || i + 1 >= argc)
+            return usage();
+        switch (arg[1])
+        {
+        case 'b':
+            if (strcmp(argv[i + 1], "null") != 0 && strcmp(argv[i + 1], "cpu") != 0)
+                return usage();
+            bench.null = strcmp(argv[++i], "null") == 0;
+            break;
+        case 'n':
+            bench.frames = atoi(argv[++i]);
+            if (bench.frames <= 0)
+                return usage();
+            break;
+        case 't':
+            threads = atoi(argv[++i]);
+            break;
+        case 'f':
+            fontPath = argv[++i];
+            break;
+        case 'o':
+            output = argv[++i];
+            break;
+        case 'c':
+            baseline = argv[++i];
+            break;
+        case 'r':
+            threshold = atof(argv[++i]);
+            break;
+        default:
+            return usage();
+        }
+    }
+
+    bench.target = createTarget(threads);
+    if (bench.target == NULL)
+    {
+        fprintf(stderr, "nanovg_compat_bench: failed to create a context\n");
+        return 1;
+    }
+    bench.vg = bench.null ? nvgCreateRecorder(bench.target) : bench.target;
+    if (bench.vg == NULL)
+    {
+        fprintf(stderr, "nanovg_compat_bench: failed to create a recorder\n");
+        nvgDeleteContext(bench.target);
+        return 1;
+    }
+    if (fontPath != NULL)
+    {
+        bench.font = nvgCreateFont(bench.vg, "bench", fontPath);
+        if (bench.font == -1)
+            fprintf(stderr, "nanovg_compat_bench: failed to load %s, skipping text\n", fontPath);
+    }
+
+    runWorkload(&bench, "knobs", drawKnobs);
+    runWorkload(&bench, "knobsSimd", drawKnobsSimd);
+    runWorkload(&bench, "polylines", drawPolylines);
+    if (bench.font != -1)
+        runWorkload(&bench, "text", drawText);
+    runWorkload(&bench, "gradients", drawGradients);
+    runWorkload(&bench, "strokeBlur", drawStrokeBlur);
+    runWorkload(&bench, "strokeBlurSimd", drawStrokeBlurSimd);
+    runWorkload(&bench, "scissor", drawScissor);
+    runWorkload(&bench, "dashboard", drawDashboard);
+    if (! bench.null)
+    {
+        // Partial redraw needs the framebuffer of the cpu backend
+        nvgDamageMode(bench.vg, NVG_DAMAGE_PARTIAL, nvgRGBA(0, 0, 0, 255));
+        bench.damage = 1;
+        runWorkload(&bench, "dashboardDamage", drawDashboard);
+        bench.damage = 0;
+        nvgDamageMode(bench.vg, NVG_DAMAGE_OFF, nvgRGBA(0, 0, 0, 255));
+    }
+
+    if (bench.vg != bench.target)
+        nvgDeleteRecorder(bench.vg);
+    nvgDeleteContext(bench.target);
+
+    if (bench.font != -1)
+    {
+        char atlas[] = "/tmp/nanovg_compat_bench_XXXXXX";
+        runStartup(&bench, "startup", fontPath, NULL, threads);
+        if (bakeAtlas(fontPath, atlas))
+            runStartup(&bench, "startupAtlas", fontPath, atlas, threads);
+        else
+            fprintf(stderr, "nanovg_compat_bench: failed to bake a glyph atlas\n");
+        unlink(atlas);
+    }
+
+    for (i = 0; i < bench.nresults; i++)
+        fprintf(
+            stderr,
+            "%-16s %12.0f ns/frame %12.0f frontend ns/frame %10.1f ns/path\n",
+            bench.results[i].name,
+            bench.results[i].nsPerFrame,
+            bench.results[i].frontendNsPerFrame,
+            bench.results[i].nsPerPath);
+
+    if (output != NULL)
+    {
+        FILE* file = fopen(output, "w");
+        if (file == NULL)
+        {
+            fprintf(stderr, "nanovg_compat_bench: failed to write %s\n", output);
+            return 1;
+        }
+        writeJson(file, &bench);
+        fclose(file);
+    }
+    else
+    {
+        writeJson(stdout, &bench);
+    }
+
+    if (baseline != NULL)
+    {
+        int regressions = compareBaseline(&bench, baseline, threshold);
+        if (regressions < 0)
+        {
+            fprintf(stderr, "nanovg_compat_bench: failed to read %s\n", baseline);
+            status = 1;
+        }
+        else if (regressions > 0)
+        {
+            status = 1;
+        }
+    }
+    return status;
+}
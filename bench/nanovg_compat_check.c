@@ -0,0 +1,1337 @@
+// Checks the compat layer's alternative code paths against the nanovg code they replace, without a GPU, on Linux
+//
+// nanovg_compat_check [check...]
+//
+// Runs the named checks, or all of them when none is given. Prints a line per check with what it measured, and exits
+// with 1 when a check fails.
+
+#include "nanovg_compat.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define WIDTH 1280
+#define HEIGHT 720
+
+// Vertices the backend of a geometry context received, in submission order
+typedef struct CheckGeometry
+{
+    NVGvertex* verts;
+    int        nverts;
+    int        cverts;
+    int        npaths;
+    int        maxCallVerts; // Most vertices received by one call
+    int        fillCalls;
+    int        strokeCalls;
+} CheckGeometry;
+
+// Returns 1 when the check passed. `detail` gets a line describing what was measured
+typedef int (*CheckRun)(char* detail, int size);
+
+static long long nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+//
+// Geometry context, whose backend keeps the vertices of fills & strokes
+//
+
+static void geometryAppend(CheckGeometry* geometry, const NVGvertex* verts, int nverts)
+{
+    if (nverts <= 0)
+        return;
+    if (geometry->nverts + nverts > geometry->cverts)
+    {
+        int        cverts = (geometry->nverts + nverts) * 2;
+        NVGvertex* grown  = (NVGvertex*)realloc(geometry->verts, sizeof(NVGvertex) * cverts);
+        if (grown == NULL)
+            return;
+        geometry->verts  = grown;
+        geometry->cverts = cverts;
+    }
+    memcpy(&geometry->verts[geometry->nverts], verts, sizeof(NVGvertex) * nverts);
+    geometry->nverts += nverts;
+}
+
+static int geometryCreate(void* uptr) { return 1; }
+
+static int geometryCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
+{
+    return 1;
+}
+
+static int geometryDeleteTexture(void* uptr, int image) { return 1; }
+
+static int geometryUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+    return 1;
+}
+
+static int geometryGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+    *w = 512;
+    *h = 512;
+    return 1;
+}
+
+static void geometryViewport(void* uptr, float width, float height, float devicePixelRatio) {}
+
+static void geometryCancel(void* uptr) {}
+
+static void geometryFlush(void* uptr) {}
+
+static void geometryFill(
+    void*                      uptr,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    const float*               bounds,
+    const NVGpath*             paths,
+    int                        npaths)
+{
+    CheckGeometry* geometry = (CheckGeometry*)uptr;
+    int            i, first = geometry->nverts;
+    for (i = 0; i < npaths; i++)
+    {
+        geometryAppend(geometry, paths[i].fill, paths[i].nfill);
+        geometryAppend(geometry, paths[i].stroke, paths[i].nstroke);
+    }
+    geometry->npaths += npaths;
+    geometry->fillCalls++;
+    if (geometry->nverts - first > geometry->maxCallVerts)
+        geometry->maxCallVerts = geometry->nverts - first;
+}
+
+static void geometryStroke(
+    void*                      uptr,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    float                      strokeWidth,
+    const NVGpath*             paths,
+    int                        npaths)
+{
+    CheckGeometry* geometry = (CheckGeometry*)uptr;
+    int            i, first = geometry->nverts;
+    for (i = 0; i < npaths; i++)
+        geometryAppend(geometry, paths[i].stroke, paths[i].nstroke);
+    geometry->npaths += npaths;
+    geometry->strokeCalls++;
+    if (geometry->nverts - first > geometry->maxCallVerts)
+        geometry->maxCallVerts = geometry->nverts - first;
+}
+
+static void geometryTriangles(
+    void*                      uptr,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    const NVGvertex*           verts,
+    int                        nverts,
+    float                      fringe)
+{
+}
+
+static void geometryDelete(void* uptr) {}
+
+// Context drawing into `geometry`, with the compat layer installed
+static NVGcontext* createGeometryContext(CheckGeometry* geometry, int flags)
+{
+    NVGparams params;
+
+    memset(geometry, 0, sizeof(*geometry));
+    memset(&params, 0, sizeof(params));
+    params.userPtr              = geometry;
+    params.edgeAntiAlias        = flags & NVG_ANTIALIAS ? 1 : 0;
+    params.renderCreate         = geometryCreate;
+    params.renderCreateTexture  = geometryCreateTexture;
+    params.renderDeleteTexture  = geometryDeleteTexture;
+    params.renderUpdateTexture  = geometryUpdateTexture;
+    params.renderGetTextureSize = geometryGetTextureSize;
+    params.renderViewport       = geometryViewport;
+    params.renderCancel         = geometryCancel;
+    params.renderFlush          = geometryFlush;
+    params.renderFill           = geometryFill;
+    params.renderStroke         = geometryStroke;
+    params.renderTriangles      = geometryTriangles;
+    params.renderDelete         = geometryDelete;
+    return nvgCompatInit(nvgCreateInternal(&params));
+}
+
+static void deleteGeometryContext(NVGcontext* vg, CheckGeometry* geometry)
+{
+    if (vg != NULL)
+        nvgDeleteInternal(vg);
+    free(geometry->verts);
+    memset(geometry, 0, sizeof(*geometry));
+}
+
+//
+// Flattening
+//
+
+// Cubics of the flatten check: 90 degree arcs as drawn by nvgArc & nvgCircle, and curves with random control points,
+// from a few pixels to most of the screen
+#define FLATTEN_CURVES 96
+
+static void flattenCurves(float curves[FLATTEN_CURVES][8])
+{
+    unsigned int seed = 1;
+    int          i, j;
+
+    for (i = 0; i < FLATTEN_CURVES; i++)
+    {
+        float  size = 4.0f * powf(2.0f, (float)(i % 8));
+        float* c    = curves[i];
+        if (i % 3 == 0)
+        {
+            float k = 0.5522847493f * size;
+            c[0]    = size;
+            c[1]    = 0.0f;
+            c[2]    = size;
+            c[3]    = k;
+            c[4]    = k;
+            c[5]    = size;
+            c[6]    = 0.0f;
+            c[7]    = size;
+        }
+        else
+        {
+            for (j = 0; j < 8; j++)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                c[j] = ((seed >> 8) / 16777216.0f) * size;
+            }
+        }
+    }
+}
+
+static void evalCubic(const float* c, float t, float* x, float* y)
+{
+    float u = 1.0f - t;
+    *x      = u * u * u * c[0] + 3.0f * u * u * t * c[2] + 3.0f * u * t * t * c[4] + t * t * t * c[6];
+    *y      = u * u * u * c[1] + 3.0f * u * u * t * c[3] + 3.0f * u * t * t * c[5] + t * t * t * c[7];
+}
+
+static float distToSegment(float x, float y, const NVGvertex* a, const NVGvertex* b)
+{
+    float dx = b->x - a->x, dy = b->y - a->y;
+    float d  = dx * dx + dy * dy;
+    float t  = d > 0.0f ? ((x - a->x) * dx + (y - a->y) * dy) / d : 0.0f;
+    t        = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+    dx       = a->x + t * dx - x;
+    dy       = a->y + t * dy - y;
+    return sqrtf(dx * dx + dy * dy);
+}
+
+// Largest distance from the curve to the polyline `verts`, sampled along the curve
+static float flattenError(const float* c, const NVGvertex* verts, int nverts)
+{
+    float error = 0.0f;
+    int   i, j;
+    for (i = 0; i <= 512; i++)
+    {
+        float x, y, d = 1e30f;
+        evalCubic(c, i / 512.0f, &x, &y);
+        for (j = 0; j + 1 < nverts; j++)
+        {
+            float s = distToSegment(x, y, &verts[j], &verts[j + 1]);
+            d       = s < d ? s : d;
+        }
+        error = d > error ? d : error;
+    }
+    return error;
+}
+
+// Fills each curve, closed by a line, without antialiasing so the fill vertices are the flattened points. Returns the
+// total number of points & the largest flattening error, in pixels, of the curves
+static int flattenRun(int simd, float ratio, float curves[FLATTEN_CURVES][8], float* maxError)
+{
+    CheckGeometry geometry;
+    NVGcontext*   vg = createGeometryContext(&geometry, 0);
+    int           i, npoints = 0;
+
+    *maxError = 0.0f;
+    if (vg == NULL)
+        return -1;
+    nvgSimdTessellation(vg, simd, 0);
+    for (i = 0; i < FLATTEN_CURVES; i++)
+    {
+        const float* c = curves[i];
+        float        error;
+
+        geometry.nverts = 0;
+        nvgBeginFrame(vg, WIDTH, HEIGHT, ratio);
+        nvgBeginPath(vg);
+        nvgMoveTo(vg, c[0], c[1]);
+        nvgBezierTo(vg, c[2], c[3], c[4], c[5], c[6], c[7]);
+        nvgClosePath(vg);
+        nvgFill(vg);
+        nvgEndFrame(vg);
+
+        // The closing line adds no point, the polyline runs from the first vertex around to the last, then back.
+        // Errors are measured in device pixels
+        error     = flattenError(c, geometry.verts, geometry.nverts) * ratio;
+        *maxError = error > *maxError ? error : *maxError;
+        npoints  += geometry.nverts;
+    }
+    deleteGeometryContext(vg, &geometry);
+    return npoints;
+}
+
+// The deviation allowed by nanovg's flatness test, in device pixels. nvg__tesselateBezier stops splitting once the
+// control points are within sqrt(tessTol) / 2 of the chord on average, tessTol being 0.25 / devicePixelRatio
+static float flattenTolerance(float ratio) { return sqrtf(0.25f / ratio) * 0.5f * ratio; }
+
+static int checkFlatten(char* detail, int size)
+{
+    static const float ratios[2] = {1.0f, 2.0f};
+    float              curves[FLATTEN_CURVES][8];
+    int                i, ok = 1, len = 0;
+
+    flattenCurves(curves);
+    for (i = 0; i < 2; i++)
+    {
+        float recursiveError, simdError;
+        int   recursive = flattenRun(0, ratios[i], curves, &recursiveError);
+        int   simd      = flattenRun(1, ratios[i], curves, &simdError);
+        float tolerance = flattenTolerance(ratios[i]);
+
+        // Uniform segments may use more points than recursive subdivision, but not many more, and must stay within
+        // the tolerance, which the recursive flattener doesn't always do near cusps
+        if (recursive <= 0 || simd <= 0 || simdError > tolerance * 1.01f || simd > recursive * 3 / 2)
+            ok = 0;
+        len += snprintf(
+            detail + len,
+            size - len,
+            "%sdpr %.0f: %d points, error %.3f px recursive, %d points, error %.3f px simd",
+            i > 0 ? "; " : "",
+            ratios[i],
+            recursive,
+            recursiveError,
+            simd,
+            simdError);
+        if (len >= size)
+            break;
+    }
+    return ok;
+}
+
+// Time to flatten & fill the knobs of the bench, nanovg's flattener against the SIMD one
+static int checkFlattenTime(char* detail, int size)
+{
+    long long     elapsed[2];
+    CheckGeometry geometry;
+    int           simd, frame, i;
+
+    for (simd = 0; simd < 2; simd++)
+    {
+        NVGcontext* vg = createGeometryContext(&geometry, NVG_ANTIALIAS);
+        long long   start;
+        if (vg == NULL)
+            return 0;
+        nvgSimdTessellation(vg, simd, 0);
+        start = nowNs();
+        for (frame = 0; frame < 200; frame++)
+        {
+            geometry.nverts = 0;
+            nvgBeginFrame(vg, WIDTH, HEIGHT, 1.0f);
+            for (i = 0; i < 240; i++)
+            {
+                float cx = 32.0f + (i % 20) * 62.0f;
+                float cy = 32.0f + (i / 20) * 58.0f;
+                nvgBeginPath(vg);
+                nvgArc(vg, cx, cy, 24.0f, NVG_PI * 0.75f, NVG_PI * (0.8f + (frame % 100) * 0.014f), NVG_CW);
+                nvgArc(vg, cx, cy, 18.0f, NVG_PI * (0.8f + (frame % 100) * 0.014f), NVG_PI * 0.75f, NVG_CCW);
+                nvgClosePath(vg);
+                nvgFill(vg);
+                nvgBeginPath(vg);
+                nvgCircle(vg, cx, cy, 14.0f);
+                nvgFill(vg);
+            }
+            nvgEndFrame(vg);
+        }
+        elapsed[simd] = nowNs() - start;
+        deleteGeometryContext(vg, &geometry);
+    }
+    snprintf(
+        detail,
+        size,
+        "%.0f ns/frame recursive, %.0f ns/frame simd",
+        elapsed[0] / 200.0,
+        elapsed[1] / 200.0);
+    // Timing isn't a pass criterion, machines differ
+    return 1;
+}
+
+//
+// Stroke expansion
+//
+
+// Open & closed paths with sharp, shallow & reversing corners, a curve & a degenerate segment
+static void strokePaths(NVGcontext* vg, float x, float y)
+{
+    nvgBeginPath(vg);
+    nvgMoveTo(vg, x, y + 40.0f);
+    nvgLineTo(vg, x + 20.0f, y);
+    nvgLineTo(vg, x + 24.0f, y + 60.0f);
+    nvgLineTo(vg, x + 60.0f, y + 56.0f);
+    nvgLineTo(vg, x + 60.0f, y + 56.0f);
+    nvgLineTo(vg, x + 30.0f, y + 58.0f);
+    nvgBezierTo(vg, x + 80.0f, y + 90.0f, x + 120.0f, y - 20.0f, x + 140.0f, y + 30.0f);
+    nvgMoveTo(vg, x + 150.0f, y + 10.0f);
+    nvgLineTo(vg, x + 200.0f, y + 12.0f);
+    nvgLineTo(vg, x + 160.0f, y + 30.0f);
+    nvgClosePath(vg);
+    nvgRoundedRect(vg, x + 210.0f, y, 60.0f, 40.0f, 8.0f);
+}
+
+// Strokes the paths with every join & cap, at a few widths, with nanovg's stroke expander or the SIMD one
+static void strokeRun(CheckGeometry* geometry, int simd, int antiAlias)
+{
+    static const int   joins[3]  = {NVG_MITER, NVG_ROUND, NVG_BEVEL};
+    static const int   caps[3]   = {NVG_BUTT, NVG_ROUND, NVG_SQUARE};
+    static const float widths[3] = {1.0f, 3.0f, 12.0f};
+    NVGcontext*        vg        = createGeometryContext(geometry, antiAlias ? NVG_ANTIALIAS : 0);
+    int                i, j, k;
+
+    if (vg == NULL)
+        return;
+    nvgSimdTessellation(vg, 0, simd);
+    nvgBeginFrame(vg, WIDTH, HEIGHT, 1.0f);
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            for (k = 0; k < 3; k++)
+            {
+                float x = 10.0f + j * 290.0f + k * 10.0f;
+                float y = 10.0f + i * 200.0f + k * 50.0f;
+                nvgLineJoin(vg, joins[i]);
+                nvgLineCap(vg, caps[j]);
+                nvgStrokeWidth(vg, widths[k]);
+                strokePaths(vg, x, y);
+                nvgStroke(vg);
+                strokePaths(vg, x, y);
+                nvgStrokeBlur(vg, 1.0f + k * 3.0f);
+            }
+        }
+    }
+    nvgEndFrame(vg);
+    // Keeps the vertices, the caller frees them
+    nvgDeleteInternal(vg);
+}
+
+static int checkStroke(char* detail, int size)
+{
+    CheckGeometry nanovg, simd;
+    float         maxDiff = 0.0f;
+    int           antiAlias, i, ok = 1, nverts = 0;
+
+    for (antiAlias = 0; antiAlias < 2; antiAlias++)
+    {
+        strokeRun(&nanovg, 0, antiAlias);
+        strokeRun(&simd, 1, antiAlias);
+        if (nanovg.nverts == 0 || nanovg.nverts != simd.nverts || nanovg.npaths != simd.npaths)
+            ok = 0;
+        for (i = 0; ok && i < nanovg.nverts; i++)
+        {
+            const NVGvertex* a = &nanovg.verts[i];
+            const NVGvertex* b = &simd.verts[i];
+            float            d = fmaxf(fmaxf(fabsf(a->x - b->x), fabsf(a->y - b->y)), fabsf(a->u - b->u));
+            d                  = fmaxf(d, fabsf(a->v - b->v));
+            maxDiff            = d > maxDiff ? d : maxDiff;
+        }
+        nverts += nanovg.nverts;
+        deleteGeometryContext(NULL, &nanovg);
+        deleteGeometryContext(NULL, &simd);
+    }
+    // The SIMD expander evaluates the same expressions in the same order, any difference is a bug. Needs the library
+    // built without FMA contraction, see NVG_COMPAT_SIMD_STROKE
+    ok = ok && maxDiff == 0.0f;
+    snprintf(detail, size, "%d vertices over 3 joins x 3 caps x 3 widths, largest difference %g", nverts, maxDiff);
+    return ok;
+}
+
+// Time to expand the strokeBlur workload of the bench, nanovg's stroke expander against the SIMD one
+static int checkStrokeTime(char* detail, int size)
+{
+    long long     elapsed[2];
+    CheckGeometry geometry;
+    int           simd, frame, i;
+
+    for (simd = 0; simd < 2; simd++)
+    {
+        NVGcontext* vg = createGeometryContext(&geometry, NVG_ANTIALIAS);
+        long long   start;
+        if (vg == NULL)
+            return 0;
+        nvgSimdTessellation(vg, 0, simd);
+        start = nowNs();
+        for (frame = 0; frame < 200; frame++)
+        {
+            geometry.nverts = 0;
+            nvgBeginFrame(vg, WIDTH, HEIGHT, 1.0f);
+            for (i = 0; i < 64; i++)
+            {
+                float x  = 40.0f + (i % 8) * 150.0f;
+                float y  = 40.0f + (i / 8) * 85.0f;
+                float cy = y - 20.0f * sinf(frame * 0.05f + i);
+                nvgBeginPath(vg);
+                nvgMoveTo(vg, x, y + 40.0f);
+                nvgBezierTo(vg, x + 40.0f, cy, x + 80.0f, y + 80.0f, x + 120.0f, y + 20.0f);
+                nvgStrokeWidth(vg, 3.0f);
+                nvgStrokeBlur(vg, 1.0f + (i % 4) * 2.0f);
+                nvgBeginPath(vg);
+                nvgRoundedRect(vg, x, y, 120.0f, 60.0f, 10.0f);
+                nvgStrokeBlur(vg, 4.0f);
+            }
+            nvgEndFrame(vg);
+        }
+        elapsed[simd] = nowNs() - start;
+        deleteGeometryContext(vg, &geometry);
+    }
+    snprintf(detail, size, "%.0f ns/frame nanovg, %.0f ns/frame simd", elapsed[0] / 200.0, elapsed[1] / 200.0);
+    return 1;
+}
+
+//
+// Partial redraw
+//
+
+#define DAMAGE_WIDTH 320
+#define DAMAGE_HEIGHT 240
+#define DAMAGE_FRAMES 24
+
+// Static panels & strokes, a ball moving across them, and a scissored bar whose colour changes. Frames 9 to 15 repeat
+// frame 8, nothing is damaged then.
+static void drawDamageFrame(NVGcontext* vg, int frame)
+{
+    int   t = frame < 8 ? frame : (frame < 16 ? 8 : frame - 7);
+    int   i;
+    float bx = 20.0f + t * 13.7f;
+
+    for (i = 0; i < 6; i++)
+    {
+        float x = 10.0f + (i % 3) * 102.0f;
+        float y = 20.0f + (i / 3) * 110.0f;
+        nvgBeginPath(vg);
+        nvgRoundedRect(vg, x, y, 96.0f, 96.0f, 6.0f);
+        nvgFillPaint(vg, nvgLinearGradient(vg, x, y, x, y + 96.0f, nvgRGBA(70, 80, 90, 255), nvgRGBA(30, 32, 40, 255)));
+        nvgFill(vg);
+        nvgBeginPath(vg);
+        nvgArc(vg, x + 48.0f, y + 48.0f, 30.0f, NVG_PI * 0.75f, NVG_PI * (0.9f + i * 0.2f), NVG_CW);
+        nvgStrokeWidth(vg, 3.0f);
+        nvgStrokeColor(vg, nvgRGBA(80, 170, 255, 255));
+        nvgStroke(vg);
+    }
+
+    nvgBeginPath(vg);
+    nvgCircle(vg, bx, 120.0f + 40.0f * sinf(t * 0.7f), 14.5f);
+    nvgFillColor(vg, nvgRGBA(255, 120, 60, 200));
+    nvgFill(vg);
+
+    nvgSave(vg);
+    nvgScissor(vg, 0.0f, 0.0f, 200.5f, 12.0f);
+    nvgBeginPath(vg);
+    nvgRect(vg, 0.0f, 2.0f, 320.0f, 8.0f);
+    nvgFillColor(vg, nvgRGBA(40, 200, 120 + t * 10, 255));
+    nvgFill(vg);
+    nvgRestore(vg);
+}
+
+static int checkDamage(char* detail, int size)
+{
+    NVGcolor       clear = nvgRGBA(16, 18, 22, 255);
+    NVGcontext*    full  = nvgCreateContext(NULL, NVG_ANTIALIAS, DAMAGE_WIDTH, DAMAGE_HEIGHT);
+    NVGcontext*    part  = nvgCreateContext(NULL, NVG_ANTIALIAS, DAMAGE_WIDTH, DAMAGE_HEIGHT);
+    unsigned char* a     = (unsigned char*)malloc(DAMAGE_WIDTH * DAMAGE_HEIGHT * 4);
+    unsigned char* b     = (unsigned char*)malloc(DAMAGE_WIDTH * DAMAGE_HEIGHT * 4);
+    int            rects[64];
+    int            frame, i, n, ok = 1, maxDiff = 0, ndiff = 0, damagedPixels = 0, idleRects = 0;
+
+    if (full == NULL || part == NULL || a == NULL || b == NULL)
+    {
+        ok = 0;
+        snprintf(detail, size, "failed to create the contexts");
+    }
+    else
+    {
+        cpunvgSetThreadCount(full, 1);
+        cpunvgSetThreadCount(part, 1);
+        nvgDamageMode(part, NVG_DAMAGE_PARTIAL, clear);
+        for (frame = 0; frame < DAMAGE_FRAMES; frame++)
+        {
+            nvgClearWithColor(full, clear);
+            nvgBeginFrame(full, DAMAGE_WIDTH, DAMAGE_HEIGHT, 1.0f);
+            drawDamageFrame(full, frame);
+            nvgEndFrame(full);
+
+            nvgBeginFrame(part, DAMAGE_WIDTH, DAMAGE_HEIGHT, 1.0f);
+            drawDamageFrame(part, frame);
+            nvgEndFrame(part);
+
+            n = nvgGetDamageRects(part, rects, 16);
+            for (i = 0; i < n; i++)
+                damagedPixels += rects[i * 4 + 2] * rects[i * 4 + 3];
+            if (frame > 8 && frame < 16)
+                idleRects += n;
+
+            nvgReadPixels(full, 0, 0, 0, DAMAGE_WIDTH, DAMAGE_HEIGHT, a);
+            nvgReadPixels(part, 0, 0, 0, DAMAGE_WIDTH, DAMAGE_HEIGHT, b);
+            for (i = 0; i < DAMAGE_WIDTH * DAMAGE_HEIGHT * 4; i++)
+            {
+                int d   = abs(a[i] - b[i]);
+                maxDiff = d > maxDiff ? d : maxDiff;
+                ndiff  += d > 0;
+            }
+        }
+        // Both draw the same calls over the same background, partial frames clear & redraw the damage only. Blending
+        // in the same order gives the same pixels, up to rounding at the edge of a damage rect.
+        ok = maxDiff <= 1 && idleRects == 0;
+        snprintf(
+            detail,
+            size,
+            "%d frames, %.1f%% of the pixels redrawn, %d rects on unchanged frames, %d channels differ, by up to %d",
+            DAMAGE_FRAMES,
+            damagedPixels * 100.0 / ((double)DAMAGE_WIDTH * DAMAGE_HEIGHT * DAMAGE_FRAMES),
+            idleRects,
+            ndiff,
+            maxDiff);
+    }
+    free(a);
+    free(b);
+    if (full != NULL)
+        nvgDeleteContext(full);
+    if (part != NULL)
+        nvgDeleteContext(part);
+    return ok;
+}
+
+//
+// Blur
+//
+
+#define BLUR_SIZE 128
+#define BLUR_CDF 4096
+#define BLUR_ROWS 640
+
+// Blurred shapes of the blur check: x, y, w, h, corner radius & standard deviation. A rect, rounded rects, a circle
+typedef struct BlurShape
+{
+    float x, y, w, h, r, sigma;
+} BlurShape;
+
+static const BlurShape blurShapes[] = {
+    {24.0f, 24.0f, 80.0f, 60.0f, 0.0f, 4.0f},
+    {24.0f, 24.0f, 80.0f, 60.0f, 10.0f, 4.0f},
+    {24.0f, 34.0f, 80.0f, 60.0f, 10.0f, 1.0f},
+    {34.0f, 34.0f, 60.0f, 60.0f, 20.0f, 8.0f},
+    {24.0f, 24.0f, 80.0f, 80.0f, 40.0f, 3.0f},
+};
+
+// Normal CDF from -6 to 6, summed from samples of the Gaussian with the trapezoidal rule
+static void blurCdf(double cdf[BLUR_CDF + 1])
+{
+    double step = 12.0 / BLUR_CDF, prev = exp(-18.0), sum = 0.0;
+    int    i;
+
+    cdf[0] = 0.0;
+    for (i = 1; i <= BLUR_CDF; i++)
+    {
+        double t = -6.0 + i * step;
+        double g = exp(-0.5 * t * t);
+        sum     += (prev + g) * 0.5 * step;
+        cdf[i]   = sum;
+        prev     = g;
+    }
+    for (i = 0; i <= BLUR_CDF; i++)
+        cdf[i] /= sum;
+}
+
+static double blurCdfAt(const double cdf[BLUR_CDF + 1], double t)
+{
+    double u = (t + 6.0) * (BLUR_CDF / 12.0);
+    int    i = (int)floor(u);
+    if (i < 0)
+        return 0.0;
+    if (i >= BLUR_CDF)
+        return 1.0;
+    return cdf[i] + (cdf[i + 1] - cdf[i]) * (u - i);
+}
+
+// Coverage of the shape convolved with the Gaussian at `px`, `py`: the Gaussian sampled every 1/64 sigma across the
+// rows of the shape, each row against the tabulated CDF
+static double blurReference(const double cdf[BLUR_CDF + 1], const BlurShape* shape, double px, double py)
+{
+    double ex = shape->w * 0.5, ey = shape->h * 0.5, r = shape->r, sigma = shape->sigma;
+    double step = 10.0 * sigma / BLUR_ROWS, sum = 0.0;
+    int    i;
+
+    px -= shape->x + ex;
+    py -= shape->y + ey;
+    for (i = 0; i < BLUR_ROWS; i++)
+    {
+        double v = -5.0 * sigma + (i + 0.5) * step;
+        double y = fabs(py - v), d, half;
+        if (y >= ey)
+            continue;
+        d    = y > ey - r ? y - (ey - r) : 0.0;
+        half = ex - r + sqrt(r * r - d * d);
+        sum += exp(-0.5 * v * v / (sigma * sigma)) *
+               (blurCdfAt(cdf, (px + half) / sigma) - blurCdfAt(cdf, (px - half) / sigma));
+    }
+    return sum * step * 0.39894228 / sigma;
+}
+
+// nvgShadow on the software renderer against a convolution of the shape with a sampled Gaussian. The renderer
+// evaluates the blur with an approximation of erf & 8 samples of the Gaussian across the rows.
+static int checkBlur(char* detail, int size)
+{
+    NVGcontext*    vg      = nvgCreateContext(NULL, NVG_ANTIALIAS, BLUR_SIZE, BLUR_SIZE);
+    unsigned char* pixels  = (unsigned char*)malloc(BLUR_SIZE * BLUR_SIZE * 4);
+    double*        cdf     = (double*)malloc(sizeof(double) * (BLUR_CDF + 1));
+    int            nshapes = (int)(sizeof(blurShapes) / sizeof(blurShapes[0]));
+    int            i, x, y, ok = 1, maxDiff = 0, worst = 0;
+    double         sumDiff = 0.0;
+
+    if (vg == NULL || pixels == NULL || cdf == NULL)
+    {
+        ok = 0;
+        snprintf(detail, size, "failed to create the context");
+    }
+    else
+    {
+        cpunvgSetThreadCount(vg, 1);
+        blurCdf(cdf);
+        for (i = 0; i < nshapes; i++)
+        {
+            const BlurShape* shape = &blurShapes[i];
+
+            nvgClearWithColor(vg, nvgRGBA(0, 0, 0, 0));
+            nvgBeginFrame(vg, BLUR_SIZE, BLUR_SIZE, 1.0f);
+            nvgShadow(vg, shape->x, shape->y, shape->w, shape->h, shape->r, shape->sigma, nvgRGBA(255, 255, 255, 255));
+            nvgEndFrame(vg);
+            nvgReadPixels(vg, 0, 0, 0, BLUR_SIZE, BLUR_SIZE, pixels);
+
+            for (y = 0; y < BLUR_SIZE; y++)
+            {
+                for (x = 0; x < BLUR_SIZE; x++)
+                {
+                    double expected = blurReference(cdf, shape, x + 0.5, y + 0.5) * 255.0;
+                    int    d        = (int)(fabs(pixels[(y * BLUR_SIZE + x) * 4 + 3] - expected) + 0.5);
+                    sumDiff        += d;
+                    if (d > maxDiff)
+                    {
+                        maxDiff = d;
+                        worst   = i;
+                    }
+                }
+            }
+        }
+        // The renderer's erf is within 5e-4, the rest is the 8 samples of the Gaussian missing the bend of corners
+        ok = maxDiff <= 5;
+        snprintf(
+            detail,
+            size,
+            "%d shapes, alpha off by %.3f on average, by up to %d, at sigma %g & radius %g",
+            nshapes,
+            sumDiff / ((double)BLUR_SIZE * BLUR_SIZE * nshapes),
+            maxDiff,
+            blurShapes[worst].sigma,
+            blurShapes[worst].r);
+    }
+    free(pixels);
+    free(cdf);
+    if (vg != NULL)
+        nvgDeleteContext(vg);
+    return ok;
+}
+
+//
+// Path instances
+//
+
+#define INSTANCES 5
+
+// Scaled, stretched & shrunk copies, under a current transform that scales them again
+static const float instanceXforms[INSTANCES][6] = {
+    {1.0f, 0.0f, 0.0f, 1.0f, 40.0f, 40.0f},
+    {3.0f, 0.0f, 0.0f, 3.0f, 140.0f, 60.0f},
+    {1.0f, 0.0f, 0.0f, 2.5f, 320.0f, 60.0f},
+    {0.25f, 0.0f, 0.0f, 0.25f, 420.0f, 40.0f},
+    {-4.0f, 0.0f, 0.0f, 1.0f, 640.0f, 200.0f},
+};
+
+static void instancePath(NVGcontext* vg)
+{
+    nvgBeginPath(vg);
+    nvgCircle(vg, 0.0f, 0.0f, 20.0f);
+    nvgRoundedRect(vg, 10.0f, 10.0f, 40.0f, 20.0f, 6.0f);
+}
+
+// Fills the copies with nvgDrawPathInstances, or each with nvgTransform & nvgFill
+static void instancesRun(CheckGeometry* geometry, int instanced)
+{
+    NVGcontext* vg = createGeometryContext(geometry, NVG_ANTIALIAS);
+    int         i;
+
+    if (vg == NULL)
+        return;
+    nvgBeginFrame(vg, WIDTH, HEIGHT, 1.0f);
+    nvgTranslate(vg, 20.0f, 10.0f);
+    nvgScale(vg, 1.5f, 1.5f);
+    nvgFillColor(vg, nvgRGBA(255, 255, 255, 255));
+    if (instanced)
+    {
+        instancePath(vg);
+        nvgDrawPathInstances(vg, &instanceXforms[0][0], NULL, INSTANCES);
+    }
+    else
+    {
+        for (i = 0; i < INSTANCES; i++)
+        {
+            const float* m = instanceXforms[i];
+            nvgSave(vg);
+            nvgTransform(vg, m[0], m[1], m[2], m[3], m[4], m[5]);
+            instancePath(vg);
+            nvgFill(vg);
+            nvgRestore(vg);
+        }
+    }
+    nvgEndFrame(vg);
+    // Keeps the vertices, the caller frees them
+    nvgDeleteInternal(vg);
+}
+
+#define OVERLAP_SIZE 96
+#define OVERLAP_INSTANCES 3
+
+// Copies at the same scale, each overlapping the previous one
+static const float overlapXforms[OVERLAP_INSTANCES][6] = {
+    {1.0f, 0.0f, 0.0f, 1.0f, 30.0f, 40.0f},
+    {1.0f, 0.0f, 0.0f, 1.0f, 50.0f, 40.0f},
+    {1.0f, 0.0f, 0.0f, 1.0f, 66.0f, 56.0f},
+};
+
+// Fills the overlapping copies of a translucent circle on the software renderer, with nvgDrawPathInstances or each
+// with nvgTransform & nvgFill
+static void renderOverlap(NVGcontext* vg, int instanced, unsigned char* pixels)
+{
+    int i;
+
+    nvgClearWithColor(vg, nvgRGBA(0, 0, 0, 0));
+    nvgBeginFrame(vg, OVERLAP_SIZE, OVERLAP_SIZE, 1.0f);
+    nvgFillColor(vg, nvgRGBA(255, 255, 255, 128));
+    for (i = 0; i < (instanced ? 1 : OVERLAP_INSTANCES); i++)
+    {
+        const float* m = overlapXforms[i];
+        nvgSave(vg);
+        if (! instanced)
+            nvgTransform(vg, m[0], m[1], m[2], m[3], m[4], m[5]);
+        nvgBeginPath(vg);
+        nvgCircle(vg, 0.0f, 0.0f, 20.0f);
+        if (instanced)
+            nvgDrawPathInstances(vg, &overlapXforms[0][0], NULL, OVERLAP_INSTANCES);
+        else
+            nvgFill(vg);
+        nvgRestore(vg);
+    }
+    nvgEndFrame(vg);
+    nvgReadPixels(vg, 0, 0, 0, OVERLAP_SIZE, OVERLAP_SIZE, pixels);
+}
+
+// Overlapping translucent copies blend over each other as separate fills do, rather than being covered once by a
+// single stencil pass. Returns the largest difference of a channel, or -1 when the renderer can't be created.
+static int overlapDiff(void)
+{
+    unsigned char* a  = (unsigned char*)malloc(OVERLAP_SIZE * OVERLAP_SIZE * 4);
+    unsigned char* b  = (unsigned char*)malloc(OVERLAP_SIZE * OVERLAP_SIZE * 4);
+    NVGcontext*    vg = nvgCreateContext(NULL, NVG_ANTIALIAS, OVERLAP_SIZE, OVERLAP_SIZE);
+    int            i, maxDiff = -1;
+
+    if (a != NULL && b != NULL && vg != NULL)
+    {
+        cpunvgSetThreadCount(vg, 1);
+        renderOverlap(vg, 1, a);
+        renderOverlap(vg, 0, b);
+        for (i = 0, maxDiff = 0; i < OVERLAP_SIZE * OVERLAP_SIZE * 4; i++)
+            maxDiff = abs(a[i] - b[i]) > maxDiff ? abs(a[i] - b[i]) : maxDiff;
+    }
+    if (vg != NULL)
+        nvgDeleteContext(vg);
+    free(a);
+    free(b);
+    return maxDiff;
+}
+
+// Scaled copies are tessellated at their own scale, their vertices & fringe match filling each copy on its own.
+// Overlapping translucent copies match filling each copy on its own on the software renderer.
+static int checkInstances(char* detail, int size)
+{
+    CheckGeometry instanced, filled;
+    float         maxDiff = 0.0f;
+    int           i, overlap, ok = 1;
+
+    instancesRun(&instanced, 1);
+    instancesRun(&filled, 0);
+    if (filled.nverts == 0 || filled.nverts != instanced.nverts)
+        ok = 0;
+    for (i = 0; ok && i < filled.nverts; i++)
+    {
+        const NVGvertex* a = &filled.verts[i];
+        const NVGvertex* b = &instanced.verts[i];
+        float            d = fmaxf(fmaxf(fabsf(a->x - b->x), fabsf(a->y - b->y)), fabsf(a->u - b->u));
+        d                  = fmaxf(d, fabsf(a->v - b->v));
+        maxDiff            = d > maxDiff ? d : maxDiff;
+    }
+    // The instanced vertices went through two more transforms, rounding moves them by far less than a pixel
+    ok = ok && maxDiff < 1e-3f;
+    // The overlaps are 64 apart when covered once
+    overlap = overlapDiff();
+    ok      = ok && overlap >= 0 && overlap <= 2;
+    snprintf(
+        detail,
+        size,
+        "%d copies, %d vertices instanced, %d filled, largest difference %g px, overlapping copies off by up to %d",
+        INSTANCES,
+        instanced.nverts,
+        filled.nverts,
+        maxDiff,
+        overlap);
+    deleteGeometryContext(NULL, &instanced);
+    deleteGeometryContext(NULL, &filled);
+    return ok;
+}
+
+//
+// Fast fills
+//
+
+#define FAST_WIDTH 256
+#define FAST_HEIGHT 160
+
+// Rects, or rounded rects & circles, at fractional positions, some under a scale. Filled with the fast functions, or
+// as a path with nvgFill
+static void drawFastScene(NVGcontext* vg, int curved, int fast)
+{
+    int i;
+
+    nvgFillColor(vg, nvgRGBA(255, 255, 255, 255));
+    for (i = 0; i < 8; i++)
+    {
+        float x = 8.3f + (i % 4) * 61.7f;
+        float y = 10.6f + (i / 4) * 70.2f;
+        float w = 30.0f + i * 3.3f;
+        float h = 40.0f - i * 2.1f;
+        float r = i % 2 ? h * 0.5f : 7.5f;
+
+        nvgSave(vg);
+        if (i >= 6)
+        {
+            nvgTranslate(vg, x, y);
+            nvgScale(vg, 1.5f, 1.5f);
+            x = y = 0.0f;
+        }
+        if (curved && i % 2)
+        {
+            if (fast)
+                nvgFillCircleFast(vg, x + r, y + r, r);
+            else
+            {
+                nvgBeginPath(vg);
+                nvgCircle(vg, x + r, y + r, r);
+                nvgFill(vg);
+            }
+        }
+        else
+        {
+            r = curved ? r : 0.0f;
+            if (fast)
+                nvgFillRoundedRectFast(vg, x, y, w, h, r);
+            else
+            {
+                nvgBeginPath(vg);
+                nvgRoundedRect(vg, x, y, w, h, r);
+                nvgFill(vg);
+            }
+        }
+        nvgRestore(vg);
+    }
+}
+
+static void renderFastScene(NVGcontext* vg, float ratio, int curved, int fast, unsigned char* pixels)
+{
+    int w = (int)(FAST_WIDTH * ratio), h = (int)(FAST_HEIGHT * ratio);
+
+    nvgClearWithColor(vg, nvgRGBA(0, 0, 0, 0));
+    nvgBeginFrame(vg, FAST_WIDTH, FAST_HEIGHT, ratio);
+    drawFastScene(vg, curved, fast);
+    nvgEndFrame(vg);
+    nvgReadPixels(vg, 0, 0, 0, w, h, pixels);
+}
+
+// nvgFillRectFast, nvgFillRoundedRectFast & nvgFillCircleFast against nvgFill on the software renderer, at a device
+// pixel ratio of 1 & 2. Straight edges get the same 1 device pixel ramp as the fill's fringe, curved ones differ by
+// nanovg's flattening, up to a quarter of a device pixel. Either way the edges are as wide: as many pixels are partly
+// covered.
+static int checkFastFill(char* detail, int size)
+{
+    unsigned char* a = (unsigned char*)malloc(FAST_WIDTH * FAST_HEIGHT * 4 * 4);
+    unsigned char* b = (unsigned char*)malloc(FAST_WIDTH * FAST_HEIGHT * 4 * 4);
+    int            ratio, curved, i, ok = 1, n = 0;
+
+    if (a == NULL || b == NULL)
+    {
+        ok = 0;
+        snprintf(detail, size, "failed to allocate the framebuffers");
+    }
+    for (ratio = 1; ok && ratio <= 2; ratio++)
+    {
+        NVGcontext* vg = nvgCreateContext(NULL, NVG_ANTIALIAS, FAST_WIDTH * ratio, FAST_HEIGHT * ratio);
+        if (vg == NULL)
+        {
+            ok = 0;
+            snprintf(detail, size, "failed to create the context");
+            break;
+        }
+        cpunvgSetThreadCount(vg, 1);
+        for (curved = 0; curved < 2; curved++)
+        {
+            int npixels = FAST_WIDTH * FAST_HEIGHT * ratio * ratio, maxDiff = 0, partialFill = 0, partialFast = 0;
+
+            renderFastScene(vg, (float)ratio, curved, 0, a);
+            renderFastScene(vg, (float)ratio, curved, 1, b);
+            for (i = 0; i < npixels; i++)
+            {
+                int d        = abs(a[i * 4 + 3] - b[i * 4 + 3]);
+                maxDiff      = d > maxDiff ? d : maxDiff;
+                partialFill += a[i * 4 + 3] > 0 && a[i * 4 + 3] < 255;
+                partialFast += b[i * 4 + 3] > 0 && b[i * 4 + 3] < 255;
+            }
+            // A ramp twice too wide is off by 64 half a device pixel from a straight edge, & partly covers twice the
+            // pixels
+            ok = ok && maxDiff <= (curved ? 72 : 8) && partialFast * 4 <= partialFill * 5 &&
+                 partialFill * 4 <= partialFast * 5;
+            n += snprintf(
+                detail + n,
+                size - n,
+                "%sratio %d %s: alpha off by up to %d, %d & %d edge pixels",
+                n > 0 ? ", " : "",
+                ratio,
+                curved ? "curves" : "rects",
+                maxDiff,
+                partialFill,
+                partialFast);
+        }
+        nvgDeleteContext(vg);
+    }
+    free(a);
+    free(b);
+    return ok;
+}
+
+//
+// Draw call batching
+//
+
+#define BATCH_ROWS 6
+#define BATCH_COLUMNS 8
+
+// Rows of a step sequencer: a panel fill, then a ring per step with the same stroke style
+static void batchRun(CheckGeometry* geometry, int batching, NanoVGBatchStats* stats)
+{
+    NVGcontext* vg = createGeometryContext(geometry, NVG_ANTIALIAS);
+    int         i, j;
+
+    if (vg == NULL)
+        return;
+    nvgDrawBatching(vg, batching);
+    nvgBeginFrame(vg, WIDTH, HEIGHT, 1.0f);
+    for (i = 0; i < BATCH_ROWS; i++)
+    {
+        float y = 20.0f + i * 110.0f;
+        nvgBeginPath(vg);
+        nvgRect(vg, 10.0f, y, 1260.0f, 100.0f);
+        nvgFillColor(vg, nvgRGBA(40, 44, 52, 255));
+        nvgFill(vg);
+        for (j = 0; j < BATCH_COLUMNS; j++)
+        {
+            nvgBeginPath(vg);
+            nvgCircle(vg, 80.0f + j * 150.0f, y + 50.0f, 36.0f);
+            nvgStrokeWidth(vg, 4.0f);
+            nvgStrokeColor(vg, nvgRGBA(80, 170, 255, 255));
+            nvgStroke(vg);
+        }
+    }
+    nvgEndFrame(vg);
+    *stats = nvgGetBatchStats(vg);
+    // Keeps the vertices, the caller frees them
+    nvgDeleteInternal(vg);
+}
+
+// Counts the fill & stroke calls the backend receives with batching off & on. Each row's rings merge into one call,
+// fills aren't merged, & the backend gets the same vertices in the same order either way
+static int checkBatching(char* detail, int size)
+{
+    CheckGeometry    off, on;
+    NanoVGBatchStats offStats, onStats;
+    int              ok;
+
+    batchRun(&off, 0, &offStats);
+    batchRun(&on, 1, &onStats);
+    ok = off.nverts > 0 && off.nverts == on.nverts &&
+         memcmp(off.verts, on.verts, sizeof(NVGvertex) * off.nverts) == 0 && off.fillCalls == BATCH_ROWS &&
+         on.fillCalls == BATCH_ROWS && off.strokeCalls == BATCH_ROWS * BATCH_COLUMNS &&
+         on.strokeCalls == BATCH_ROWS && onStats.submitted == offStats.submitted &&
+         onStats.issued == on.fillCalls + on.strokeCalls;
+    snprintf(
+        detail,
+        size,
+        "%d fill & %d stroke calls without batching, %d & %d with, %d submitted & %d issued",
+        off.fillCalls,
+        off.strokeCalls,
+        on.fillCalls,
+        on.strokeCalls,
+        onStats.submitted,
+        onStats.issued);
+    deleteGeometryContext(NULL, &off);
+    deleteGeometryContext(NULL, &on);
+    return ok;
+}
+
+//
+// Telemetry
+//
+
+// A frame of fills & strokes reports the vertices of its largest call as its high water mark
+static int checkTelemetry(char* detail, int size)
+{
+    CheckGeometry    geometry;
+    NVGcontext*      vg = createGeometryContext(&geometry, NVG_ANTIALIAS);
+    NanoVGFrameStats stats;
+    int              ok = 0;
+
+    if (vg == NULL)
+    {
+        snprintf(detail, size, "failed to create the context");
+        return 0;
+    }
+    nvgTelemetryFrames(vg, 4);
+    nvgBeginFrame(vg, WIDTH, HEIGHT, 1.0f);
+    drawDamageFrame(vg, 0);
+    nvgBeginPath(vg);
+    nvgCircle(vg, 640.0f, 360.0f, 300.0f);
+    nvgStrokeWidth(vg, 4.0f);
+    nvgStroke(vg);
+    nvgEndFrame(vg);
+
+    memset(&stats, 0, sizeof(stats));
+    if (nvgGetFrameStats(vg, &stats, 1) == 1)
+        ok = stats.vertsHighWater > 0 && stats.vertsHighWater == geometry.maxCallVerts;
+    snprintf(
+        detail,
+        size,
+        "%d draw calls, %d vertices at most per call, the backend got %d",
+        stats.drawCalls,
+        stats.vertsHighWater,
+        geometry.maxCallVerts);
+    deleteGeometryContext(vg, &geometry);
+    return ok;
+}
+
+//
+// Shrink policy
+//
+
+#define SHRINK_FRAMES 24
+
+// Repeats a frame whose largest call has far more vertices than nanovg's initial vertex cache, with the shrink policy
+// on. Once the buffers have grown, later frames must not allocate: shrinking a buffer that is still in use would
+// make the next frame grow it again.
+static int checkShrink(char* detail, int size)
+{
+    NVGcontext*      vg = nvgCreateContextAllocator(NULL, NVG_ANTIALIAS, DAMAGE_WIDTH, DAMAGE_HEIGHT, NULL);
+    NanoVGFrameStats stats;
+    int              frame, i, ok = 1, steadyAllocations = 0, vertsCapacity = 0;
+
+    if (vg == NULL)
+    {
+        snprintf(detail, size, "failed to create the context");
+        return 0;
+    }
+    cpunvgSetThreadCount(vg, 1);
+    nvgTelemetryFrames(vg, 1);
+    nvgShrinkPolicy(vg, 4, 2.0f);
+    for (frame = 0; frame < SHRINK_FRAMES; frame++)
+    {
+        nvgClearWithColor(vg, nvgRGBA(0, 0, 0, 255));
+        nvgBeginFrame(vg, DAMAGE_WIDTH, DAMAGE_HEIGHT, 1.0f);
+        drawDamageFrame(vg, 5);
+        nvgBeginPath(vg);
+        nvgMoveTo(vg, 0.0f, 120.0f);
+        for (i = 1; i < 400; i++)
+            nvgLineTo(vg, i * 0.8f, 120.0f + 40.0f * sinf(i * 0.3f));
+        nvgStrokeWidth(vg, 2.0f);
+        nvgStroke(vg);
+        nvgEndFrame(vg);
+
+        memset(&stats, 0, sizeof(stats));
+        if (nvgGetFrameStats(vg, &stats, 1) != 1)
+            ok = 0;
+        if (frame >= SHRINK_FRAMES / 3)
+            steadyAllocations += stats.allocations;
+        vertsCapacity = stats.vertsCapacity;
+    }
+    ok = ok && steadyAllocations == 0 && vertsCapacity >= stats.vertsHighWater;
+    snprintf(
+        detail,
+        size,
+        "%d allocations over the last %d frames, %d vertices at most per call, vertex cache of %d",
+        steadyAllocations,
+        SHRINK_FRAMES - SHRINK_FRAMES / 3,
+        stats.vertsHighWater,
+        vertsCapacity);
+    nvgDeleteContext(vg);
+    return ok;
+}
+
+//
+// Packed vertices
+//
+
+// The damage frame & a polyline at fractional positions, with float or packed vertices. Fills in the frame
+// stats, which hold the vertex bytes passed to the backend & those saved by packing.
+static void renderPacked(NVGcontext* vg, int ratio, int format, unsigned char* pixels, NanoVGFrameStats* stats)
+{
+    float xy[64];
+    int   i;
+
+    for (i = 0; i < 32; i++)
+    {
+        xy[i * 2]     = 12.3f + i * 9.37f;
+        xy[i * 2 + 1] = 200.0f + 20.0f * sinf(i * 0.61f);
+    }
+    memset(stats, 0, sizeof(*stats));
+    nvgVertexFormat(vg, format);
+    nvgClearWithColor(vg, nvgRGBA(16, 18, 22, 255));
+    nvgBeginFrame(vg, DAMAGE_WIDTH, DAMAGE_HEIGHT, (float)ratio);
+    drawDamageFrame(vg, 5);
+    nvgStrokeWidth(vg, 1.7f);
+    nvgStrokeColor(vg, nvgRGBA(230, 230, 120, 255));
+    nvgStrokePolyline(vg, xy, 32);
+    nvgEndFrame(vg);
+    nvgGetFrameStats(vg, stats, 1);
+    nvgReadPixels(vg, 0, 0, 0, DAMAGE_WIDTH * ratio, DAMAGE_HEIGHT * ratio, pixels);
+}
+
+// Packed vertices against float ones on the software renderer, at a device pixel ratio of 1 & 2. Packing moves edges
+// by up to 1/32 device pixel, which shifts the 1 pixel wide antialiasing ramp by up to 8 levels, plus rounding. The
+// backend must get half the vertex bytes, & the frame stats must count the other half as saved.
+static int checkPacked(char* detail, int size)
+{
+    unsigned char* a = (unsigned char*)malloc(DAMAGE_WIDTH * DAMAGE_HEIGHT * 4 * 4);
+    unsigned char* b = (unsigned char*)malloc(DAMAGE_WIDTH * DAMAGE_HEIGHT * 4 * 4);
+    int            ratio, i, ok = 1, n = 0;
+
+    if (a == NULL || b == NULL)
+    {
+        ok = 0;
+        snprintf(detail, size, "failed to allocate the framebuffers");
+    }
+    for (ratio = 1; ok && ratio <= 2; ratio++)
+    {
+        NVGcontext*      vg = nvgCreateContext(NULL, NVG_ANTIALIAS, DAMAGE_WIDTH * ratio, DAMAGE_HEIGHT * ratio);
+        NanoVGFrameStats floatStats, packedStats;
+        int              maxDiff = 0, ndiff = 0;
+
+        if (vg == NULL)
+        {
+            ok = 0;
+            snprintf(detail, size, "failed to create the context");
+            break;
+        }
+        cpunvgSetThreadCount(vg, 1);
+        nvgTelemetryFrames(vg, 1);
+        ok = nvgVertexFormat(vg, NVG_VERTEX_PACKED) == NVG_VERTEX_PACKED;
+        renderPacked(vg, ratio, NVG_VERTEX_FLOAT, a, &floatStats);
+        renderPacked(vg, ratio, NVG_VERTEX_PACKED, b, &packedStats);
+        for (i = 0; i < DAMAGE_WIDTH * DAMAGE_HEIGHT * ratio * ratio * 4; i++)
+        {
+            int d    = abs(a[i] - b[i]);
+            maxDiff  = d > maxDiff ? d : maxDiff;
+            ndiff   += d > 0;
+        }
+        ok = ok && maxDiff <= 10 && floatStats.vertexBytes > 0 && floatStats.vertexBytesSaved == 0 &&
+             packedStats.vertexBytes * 2 == floatStats.vertexBytes &&
+             packedStats.vertexBytesSaved == packedStats.vertexBytes;
+        n += snprintf(
+            detail + n,
+            size - n,
+            "%sratio %d: %zu vertex bytes packed, %zu float, %d channels off by up to %d",
+            n > 0 ? ", " : "",
+            ratio,
+            packedStats.vertexBytes,
+            floatStats.vertexBytes,
+            ndiff,
+            maxDiff);
+        nvgDeleteContext(vg);
+    }
+    free(a);
+    free(b);
+    return ok;
+}
+
+//
+// Driver
+//
+
+typedef struct Check
+{
+    const char* name;
+    CheckRun    run;
+} Check;
+
+static const Check checks[] = {
+    {"flatten", checkFlatten},
+    {"flattenTime", checkFlattenTime},
+    {"stroke", checkStroke},
+    {"strokeTime", checkStrokeTime},
+    {"damage", checkDamage},
+    {"blur", checkBlur},
+    {"instances", checkInstances},
+    {"fastFill", checkFastFill},
+    {"batching", checkBatching},
+    {"telemetry", checkTelemetry},
+    {"shrink", checkShrink},
+    {"packed", checkPacked},
+};
+
+int main(int argc, char** argv)
+{
+    char detail[1024];
+    int  i, j, failed = 0;
+
+    for (i = 0; i < (int)(sizeof(checks) / sizeof(checks[0])); i++)
+    {
+        int selected = argc < 2, ok;
+        for (j = 1; j < argc; j++)
+            selected |= strcmp(argv[j], checks[i].name) == 0;
+        if (! selected)
+            continue;
+
+        detail[0] = '\0';
+        ok        = checks[i].run(detail, sizeof(detail));
+        printf("%-16s %s  %s\n", checks[i].name, ok ? "ok  " : "FAIL", detail);
+        failed += ! ok;
+    }
+    return failed > 0 ? 1 : 0;
+}
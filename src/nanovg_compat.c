@@ -1,110 +1,7726 @@
 #ifdef _WIN32
 #define NANOVG_D3D11_IMPLEMENTATION
 #elif defined __linux__
-#define NANOVG_GLES2_IMPLEMENTATION
-// TODO: add linux support
+#define NANOVG_CPU_IMPLEMENTATION
+// Rects written with cpunvgWriteImageRegion are counted, invalidate damage & are captured like other texture updates
+struct NVGcontext;
+static void nvg__compatImageWritten(
+    struct NVGcontext* ctx,
+    int                image,
+    int                x,
+    int                y,
+    int                w,
+    int                h,
+    const void*        data,
+    int                pitch);
+#define CPUNVG_IMAGE_WRITTEN(ctx, image, x, y, w, h, data, pitch)                                                      \
+    nvg__compatImageWritten(ctx, image, x, y, w, h, data, pitch)
 #endif
 
 #include "nanovg_compat.h"
+
+// NVG_MALLOC, NVG_REALLOC & NVG_FREE, used by nanovg & this file, go through the allocator hooks further down
+static void* nvg__allocMalloc(size_t size);
+static void* nvg__allocRealloc(void* ptr, size_t size);
+static void  nvg__allocFree(void* ptr);
+#define NVG_MALLOC(s) nvg__allocMalloc(s)
+#define NVG_REALLOC(p, s) nvg__allocRealloc(p, s)
+#define NVG_FREE(p) nvg__allocFree(p)
+
+// nvgFill, nvgStroke, nvgText & nvgTextBox are defined by this file so fills & strokes go through the compat
+// tessellation path and so they can be timed. nanovg's definitions are kept under these names. nvgInternalParams is
+// too, as the userPtr of a context's params is its compat state, see nvg__compatInstall.
+#define nvgFill nvg__nanovgFill
+#define nvgStroke nvg__nanovgStroke
+#define nvgText nvg__nanovgText
+#define nvgTextBox nvg__nanovgTextBox
+#define nvgInternalParams nvg__nanovgInternalParams
 #include "nanovg.c"
+#undef nvgFill
+#undef nvgStroke
+#undef nvgText
+#undef nvgTextBox
+#undef nvgInternalParams
+
+#include <stdint.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// Default flattener of new contexts, see nvgSimdTessellation(). 0 uses nanovg's recursive nvg__flattenPaths, 1 uses
+// nvg__flattenPathsSIMD which computes the number of segments of each Bezier up front and evaluates them 4 at a time
+// with forward differencing.
+#ifndef NVG_COMPAT_SIMD_FLATTEN
+#define NVG_COMPAT_SIMD_FLATTEN 0
+#endif
+
+// Default stroke expander of new contexts, see nvgSimdTessellation(). 0 uses nanovg's nvg__expandStroke, 1 uses
+// nvg__expandStrokeSIMD which computes joins and emits miter runs 4 points at a time. Output is bit identical as long
+// as the compiler doesn't contract nanovg's scalar a * b + c into fused multiply adds the SIMD code can't match:
+// CMakeLists.txt builds this file with -ffp-contract=off on GCC & Clang, MSVC doesn't contract by default.
+#ifndef NVG_COMPAT_SIMD_STROKE
+#define NVG_COMPAT_SIMD_STROKE 0
+#endif
+
+// Set when the backend shaders evaluate blur paints, whose feather is negative, see nvgBoxShadow() & nvgFillBlur().
+// The software renderer does, the D3D11 & Metal shaders don't, so those get the closest box gradient & linear fringe.
+#ifndef NVG_COMPAT_BLUR_PAINT
+#ifdef __linux__
+#define NVG_COMPAT_BLUR_PAINT 1
+#else
+#define NVG_COMPAT_BLUR_PAINT 0
+#endif
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NVG_COMPAT_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define NVG_COMPAT_NEON 1
+#endif
+
+// 4 wide float vector, falls back to plain arrays without SSE2 or NEON
+#if defined(NVG_COMPAT_SSE2)
+typedef __m128 nvg__f4;
+#define nvg__f4set1(a) _mm_set1_ps(a)
+#define nvg__f4add(a, b) _mm_add_ps(a, b)
+#define nvg__f4sub(a, b) _mm_sub_ps(a, b)
+#define nvg__f4mul(a, b) _mm_mul_ps(a, b)
+#define nvg__f4load(p) _mm_loadu_ps(p)
+#define nvg__f4store(p, a) _mm_storeu_ps(p, a)
+#define nvg__f4neg(a) _mm_xor_ps(a, _mm_set1_ps(-0.0f))
+#define nvg__f4div(a, b) _mm_div_ps(a, b)
+#define nvg__f4min(a, b) _mm_min_ps(a, b)
+#define nvg__f4max(a, b) _mm_max_ps(a, b)
+// Bit i is set where a[i] < b[i]
+#define nvg__f4ltmask(a, b) _mm_movemask_ps(_mm_cmplt_ps(a, b))
+// a > b ? x : y
+static nvg__f4 nvg__f4selgt(nvg__f4 a, nvg__f4 b, nvg__f4 x, nvg__f4 y)
+{
+    __m128 m = _mm_cmpgt_ps(a, b);
+    return _mm_or_ps(_mm_and_ps(m, x), _mm_andnot_ps(m, y));
+}
+#elif defined(NVG_COMPAT_NEON)
+typedef float32x4_t nvg__f4;
+#define nvg__f4set1(a) vdupq_n_f32(a)
+#define nvg__f4add(a, b) vaddq_f32(a, b)
+#define nvg__f4sub(a, b) vsubq_f32(a, b)
+#define nvg__f4mul(a, b) vmulq_f32(a, b)
+#define nvg__f4load(p) vld1q_f32(p)
+#define nvg__f4store(p, a) vst1q_f32(p, a)
+#define nvg__f4neg(a) vnegq_f32(a)
+#define nvg__f4div(a, b) vdivq_f32(a, b)
+#define nvg__f4min(a, b) vminq_f32(a, b)
+#define nvg__f4max(a, b) vmaxq_f32(a, b)
+static int nvg__f4ltmask(nvg__f4 a, nvg__f4 b)
+{
+    static const uint32_t bits[4] = {1, 2, 4, 8};
+    return (int)vaddvq_u32(vandq_u32(vcltq_f32(a, b), vld1q_u32(bits)));
+}
+static nvg__f4 nvg__f4selgt(nvg__f4 a, nvg__f4 b, nvg__f4 x, nvg__f4 y) { return vbslq_f32(vcgtq_f32(a, b), x, y); }
+#else
+typedef struct
+{
+    float v[4];
+} nvg__f4;
+static nvg__f4 nvg__f4set1(float a)
+{
+    nvg__f4 r = {{a, a, a, a}};
+    return r;
+}
+static nvg__f4 nvg__f4add(nvg__f4 a, nvg__f4 b)
+{
+    int i;
+    for (i = 0; i < 4; i++)
+        a.v[i] += b.v[i];
+    return a;
+}
+static nvg__f4 nvg__f4sub(nvg__f4 a, nvg__f4 b)
+{
+    int i;
+    for (i = 0; i < 4; i++)
+        a.v[i] -= b.v[i];
+    return a;
+}
+static nvg__f4 nvg__f4mul(nvg__f4 a, nvg__f4 b)
+{
+    int i;
+    for (i = 0; i < 4; i++)
+        a.v[i] *= b.v[i];
+    return a;
+}
+static nvg__f4 nvg__f4load(const float* p)
+{
+    nvg__f4 r = {{p[0], p[1], p[2], p[3]}};
+    return r;
+}
+static void nvg__f4store(float* p, nvg__f4 a) { memcpy(p, a.v, sizeof(a.v)); }
+static nvg__f4 nvg__f4neg(nvg__f4 a)
+{
+    int i;
+    for (i = 0; i < 4; i++)
+        a.v[i] = -a.v[i];
+    return a;
+}
+static nvg__f4 nvg__f4div(nvg__f4 a, nvg__f4 b)
+{
+    int i;
+    for (i = 0; i < 4; i++)
+        a.v[i] /= b.v[i];
+    return a;
+}
+static nvg__f4 nvg__f4min(nvg__f4 a, nvg__f4 b)
+{
+    int i;
+    for (i = 0; i < 4; i++)
+        a.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+    return a;
+}
+static nvg__f4 nvg__f4max(nvg__f4 a, nvg__f4 b)
+{
+    int i;
+    for (i = 0; i < 4; i++)
+        a.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+    return a;
+}
+static int nvg__f4ltmask(nvg__f4 a, nvg__f4 b)
+{
+    int i, mask = 0;
+    for (i = 0; i < 4; i++)
+        if (a.v[i] < b.v[i])
+            mask |= 1 << i;
+    return mask;
+}
+static nvg__f4 nvg__f4selgt(nvg__f4 a, nvg__f4 b, nvg__f4 x, nvg__f4 y)
+{
+    int i;
+    for (i = 0; i < 4; i++)
+        x.v[i] = a.v[i] > b.v[i] ? x.v[i] : y.v[i];
+    return x;
+}
+#endif
+
+NanoVGDrawCallCount nvgGetDrawCallCount(NVGcontext* ctx)
+{
+    NanoVGDrawCallCount callCount;
+    callCount.draws  = ctx->drawCallCount;
+    callCount.fill   = ctx->fillTriCount;
+    callCount.stroke = ctx->strokeTriCount;
+    callCount.text   = ctx->textTriCount;
+    callCount.total  = ctx->drawCallCount + ctx->fillTriCount + ctx->strokeTriCount + ctx->textTriCount;
+    return callCount;
+}
+
+NVGcolor nvgGetFillColor(NVGcontext* ctx)
+{
+    NVGstate* state = nvg__getState(ctx);
+    return state->fill.innerColor;
+}
+
+void nvgCurrentScissor(NVGcontext* ctx, float* x, float* y, float* w, float* h)
+{
+    NVGstate* state = nvg__getState(ctx);
+    float     pxform[6], invxorm[6];
+    float     ex, ey, tex, tey;
+
+    // If no previous scissor has been set, set the scissor as current scissor.
+    if (state->scissor.extent[0] < 0)
+    {
+        return;
+    }
+
+    // Transform the current scissor rect into current transform space.
+    // If there is difference in rotation, this will be approximation.
+    memcpy(pxform, state->scissor.xform, sizeof(float) * 6);
+    ex = state->scissor.extent[0];
+    ey = state->scissor.extent[1];
+    nvgTransformInverse(invxorm, state->xform);
+    nvgTransformMultiply(pxform, invxorm);
+    tex = ex * fabsf(pxform[0]) + ey * fabsf(pxform[2]);
+    tey = ex * fabsf(pxform[1]) + ey * fabsf(pxform[3]);
+
+    *x = pxform[4] - tex;
+    *y = pxform[5] - tey;
+    *w = tex * 2;
+    *h = tey * 2;
+}
+
+void    nvgPopPath(NVGcontext* ctx, int N) { ctx->ncommands -= N; }
+int     nvgPathLen(NVGcontext* ctx) { return ctx->ncommands; }
+float** nvgGetPath(NVGcontext* ctx) { return &ctx->commands; }
+
+//
+// Allocator hooks
+//
+// Every NVG_MALLOC block starts with a header naming the allocator state it came from, so NVG_REALLOC & NVG_FREE
+// reach the same allocator and the bytes are counted per context. New blocks come from g_allocCurrent, or from the C
+// runtime when it's NULL. For contexts from nvgCreateContextAllocator it's set while the context is created, from
+// nvgBeginFrame to the end of nvgEndFrame or nvgCancelFrame, in the texture create shim, & while the wrapper creates
+// per context state, see nvg__compatMalloc.
+//
+
+typedef struct NVGallocState
+{
+    NVGallocator allocator;
+    int          counted;  // 0 for the C runtime default, which isn't counted as contexts & threads share it
+    int          released; // The context was deleted, the state is freed with its last block
+    int          blocks;
+    int          allocations;
+    size_t       allocatedBytes;
+    size_t       liveBytes;
+} NVGallocState;
+
+typedef union NVGallocHeader
+{
+    struct
+    {
+        NVGallocState* state;
+        size_t         size;
+    } info;
+    double align[2]; // Keeps blocks 16 byte aligned
+} NVGallocHeader;
+
+static void* nvg__crtMalloc(void* userPtr, size_t size) { return malloc(size); }
+static void* nvg__crtRealloc(void* userPtr, void* ptr, size_t size) { return realloc(ptr, size); }
+static void  nvg__crtFree(void* userPtr, void* ptr) { free(ptr); }
+
+#ifdef _MSC_VER
+#define NVG_THREAD_LOCAL __declspec(thread)
+#else
+#define NVG_THREAD_LOCAL __thread
+#endif
+
+static NVGallocState g_allocDefault = {{nvg__crtMalloc, nvg__crtRealloc, nvg__crtFree, NULL}, 0, 0, 0, 0, 0, 0};
+// Per thread, so recorders allocate from the C runtime while the render thread creates a context
+static NVG_THREAD_LOCAL NVGallocState* g_allocCurrent = NULL;
+
+static void* nvg__allocMalloc(size_t size)
+{
+    NVGallocState*  state = g_allocCurrent != NULL ? g_allocCurrent : &g_allocDefault;
+    NVGallocHeader* header;
+
+    header = (NVGallocHeader*)state->allocator.allocate(state->allocator.userPtr, sizeof(NVGallocHeader) + size);
+    if (header == NULL)
+        return NULL;
+    header->info.state = state;
+    header->info.size  = size;
+    if (state->counted)
+    {
+        state->blocks++;
+        state->allocations++;
+        state->allocatedBytes += size;
+        state->liveBytes      += size;
+    }
+    return header + 1;
+}
+
+static void* nvg__allocRealloc(void* ptr, size_t size)
+{
+    NVGallocHeader* header;
+    NVGallocState*  state;
+    size_t          prevSize;
+
+    if (ptr == NULL)
+        return nvg__allocMalloc(size);
+    header   = (NVGallocHeader*)ptr - 1;
+    state    = header->info.state;
+    prevSize = header->info.size;
+    ptr      = state->allocator.reallocate(state->allocator.userPtr, header, sizeof(NVGallocHeader) + size);
+    if (ptr == NULL)
+        return NULL;
+    header            = (NVGallocHeader*)ptr;
+    header->info.size = size;
+    if (state->counted)
+    {
+        state->allocations++;
+        state->allocatedBytes += size;
+        state->liveBytes      += size - prevSize;
+    }
+    return header + 1;
+}
+
+static void nvg__allocFree(void* ptr)
+{
+    NVGallocHeader* header;
+    NVGallocState*  state;
+
+    if (ptr == NULL)
+        return;
+    header = (NVGallocHeader*)ptr - 1;
+    state  = header->info.state;
+    if (state->counted)
+    {
+        state->blocks--;
+        state->liveBytes -= header->info.size;
+    }
+    state->allocator.deallocate(state->allocator.userPtr, header);
+    if (state->released && state->blocks == 0)
+        free(state);
+}
+
+// Called once the context of `state` is deleted
+static void nvg__allocRelease(NVGallocState* state)
+{
+    if (g_allocCurrent == state)
+        g_allocCurrent = NULL;
+    state->released = 1;
+    if (state->blocks == 0)
+        free(state);
+}
+
+//
+// Compat state
+//
+// Features of this wrapper need per context state and need to see every call made to the backend. NVGcontext can't
+// be extended, so the state takes the place of the backend's userPtr in ctx->params: creating it moves the params to
+// `backend` and swaps every callback for the shims below, which forward to the originals. The state is freed by the
+// renderDelete shim. Nothing is shared between contexts, so contexts can be created & deleted while recorders of
+// other contexts run on other threads.
+//
+
+enum NVGdisplayCallType
+{
+    NVG_DISPLAY_FILL,
+    NVG_DISPLAY_STROKE,
+    NVG_DISPLAY_TRIANGLES,
+};
+
+struct NVGdisplayList
+{
+    struct NVGdisplayCall* calls;
+    int                    ncalls;
+    int                    ccalls;
+    NVGpath*               paths;
+    int                    npaths;
+    int                    cpaths;
+    NVGvertex*             verts;
+    int                    nverts;
+    int                    cverts;
+};
+
+typedef struct NVGcompat
+{
+    NVGcontext* ctx;
+    // Params of the backend, whose callbacks the compat ones forward to
+    NVGparams backend;
+
+    // Display list being recorded, if any
+    NVGdisplayList* recording;
+    // Scratch space for submitting transformed geometry
+    NVGpath*   scratchPaths;
+    int        cscratchPaths;
+    NVGvertex* scratchVerts;
+    int        cscratchVerts;
+    // Set while nvg__flattenPathsSIMD & nvg__expandStrokeSIMD replace nanovg's flattener & stroke expander
+    int simdFlatten;
+    int simdStroke;
+    // Structure of arrays copy of ctx->cache->points used by the SIMD stroker
+    float* soa;
+    int    csoa;
+    // Bytes per pixel of images by id, 0 when unknown
+    unsigned char* imageBpp;
+    int            cimageBpp;
+
+    // Tessellation cache, NULL while disabled
+    struct NVGtessCache* tessCache;
+    // Text run cache, NULL while disabled
+    struct NVGtextCache* textCache;
+    // Frame stats, NULL while disabled
+    struct NVGtelemetry* telemetry;
+    // Pending merged draw call, NULL while batching is disabled
+    struct NVGbatch* batch;
+    // Calls made by nanovg & calls made to the backend since nvgBeginFrame
+    NanoVGBatchStats batchStats;
+    // Set from nvgBeginFrame to the end of nvgEndFrame or nvgCancelFrame
+    int inFrame;
+    // Size of the current frame, in logical pixels
+    float viewWidth;
+    float viewHeight;
+    // Set while culling is enabled, paths culled since nvgBeginFrame
+    int             cull;
+    NanoVGCullStats cullStats;
+    // Set while a bulk primitive draws the paths it added to the path cache, which don't match the commands
+    int bulk;
+    // Adaptive tessellation, NULL while disabled
+    struct NVGlod* lod;
+    // Layout of the vertices passed to the backend, see nvgVertexFormat, the backend's packed draw calls & the
+    // geometry of the call being packed
+    int              vertexFormat;
+    NVGpackedParams  packed;
+    NVGpackedCall    packedCall;
+    NVGpackedVertex* packedVerts;
+    int              cpackedVerts;
+    NVGpackedPath*   packedPaths;
+    int              cpackedPaths;
+    // Damage tracking, NULL while disabled
+    struct NVGdamage* damage;
+    // Readback slots, NULL until the first nvgRequestReadback
+    struct NVGreadback* readback;
+    // Image atlas, NULL while disabled
+    struct NVGatlas* atlas;
+    // Streaming images, NULL until the first nvgCreateStreamImage
+    struct NVGstreams* streams;
+    // Rect passed to nvgWriteImageRegion, repacked to the image's row pitch for backends that need it
+    unsigned char* uploadScratch;
+    int            cuploadScratch;
+    // Copies of the path drawn by nvgDrawPathInstances, its commands while they're replaced by scaled ones & the
+    // device bounds of each copy, 4 floats per copy
+    NVGpath*   instancePaths;
+    int        cinstancePaths;
+    NVGvertex* instanceVerts;
+    int        cinstanceVerts;
+    float*     instanceCommands;
+    int        cinstanceCommands;
+    float*     instanceBounds;
+    int        cinstanceBounds;
+
+    // Allocator of contexts created with nvgCreateContextAllocator, NULL otherwise, & the allocator that was current
+    // before nvgBeginFrame made it current
+    NVGallocState* alloc;
+    NVGallocState* allocPrev;
+    // Frame arena, NULL until the first nvgFrameAlloc
+    struct NVGarena* arena;
+    // Shrink policy, NULL while disabled
+    struct NVGshrink* shrink;
+    // Frame capture, NULL while not capturing
+    struct NVGcapture* capture;
+} NVGcompat;
+
+// The compat callbacks get the compat state as their userPtr
+static NVGcompat* nvg__compatFromUptr(void* uptr) { return (NVGcompat*)uptr; }
+
+// Grows an array to hold at least `count` elements. Returns 0 on allocation failure
+static int nvg__compatReserve(void** ptr, int* capacity, int count, int elemSize)
+{
+    void* data;
+    int   cap;
+    if (count <= *capacity)
+        return 1;
+    cap  = nvg__maxi(count, 16) + *capacity / 2; // 1.5x Overallocate
+    data = NVG_REALLOC(*ptr, (size_t)cap * elemSize);
+    if (data == NULL)
+        return 0;
+    *ptr      = data;
+    *capacity = cap;
+    return 1;
+}
+
+static void nvg__recordFill(
+    NVGdisplayList*            list,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    const float*               bounds,
+    const NVGpath*             paths,
+    int                        npaths);
+static void nvg__recordStroke(
+    NVGdisplayList*            list,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    float                      strokeWidth,
+    const NVGpath*             paths,
+    int                        npaths);
+static void nvg__recordTriangles(
+    NVGdisplayList*            list,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    const NVGvertex*           verts,
+    int                        nverts,
+    float                      fringe);
+
+static void nvg__deleteTessCache(struct NVGtessCache* cache);
+static void nvg__deleteTextCache(struct NVGtextCache* cache);
+
+static long long nvg__nowNs(void);
+static void      nvg__telemetrySubmit(NVGcompat* compat, int nverts, int nuniforms, int packed);
+static void      nvg__telemetryUpload(NVGcompat* compat, size_t bytes, int created);
+static void      nvg__telemetryBeginFrame(NVGcompat* compat);
+static void      nvg__telemetryEndFrame(NVGcompat* compat, long long flushNs);
+static void      nvg__deleteTelemetry(struct NVGtelemetry* telemetry);
+
+static int nvg__batchStroke(
+    NVGcompat*                 compat,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    float                      strokeWidth,
+    const NVGpath*             paths,
+    int                        npaths);
+static void nvg__batchIssue(NVGcompat* compat);
+static void nvg__batchClear(struct NVGbatch* batch);
+static void nvg__deleteBatch(struct NVGbatch* batch);
+static int nvg__damageCall(
+    NVGcompat*                 compat,
+    int                        type,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    float                      strokeWidth,
+    const float*               bounds,
+    const NVGpath*             paths,
+    int                        npaths,
+    const NVGvertex*           verts,
+    int                        nverts);
+static void nvg__damageBeginFrame(NVGcompat* compat, float width, float height, float devicePixelRatio);
+static void nvg__damageEndFrame(NVGcompat* compat);
+static void nvg__damageCancel(struct NVGdamage* damage);
+static void nvg__damageImageUpdated(struct NVGdamage* damage, int image);
+static void nvg__deleteDamage(struct NVGdamage* damage);
+static void nvg__readbackEndFrame(NVGcompat* compat);
+static void nvg__deleteReadback(struct NVGreadback* readback);
+static void nvg__deleteAtlas(NVGcontext* ctx, struct NVGatlas* atlas);
+static void nvg__deleteStreams(NVGcontext* ctx, struct NVGstreams* streams);
+static void nvg__lodBeginFrame(NVGcompat* compat);
+static void nvg__lodEndFrame(NVGcompat* compat);
+static int  nvg__packPaths(NVGcompat* compat, const NVGpath* paths, int npaths, const float* bounds);
+static int  nvg__packTriangles(NVGcompat* compat, const NVGvertex* verts, int nverts);
+
+static void*  nvg__compatMalloc(NVGcompat* compat, size_t size);
+static size_t nvg__arenaUsed(const struct NVGarena* arena);
+static void   nvg__arenaReset(struct NVGarena* arena);
+static void   nvg__deleteArena(struct NVGarena* arena);
+static void   nvg__shrinkSample(NVGcompat* compat, int nverts);
+static void   nvg__shrinkEndFrame(NVGcompat* compat);
+
+static void nvg__captureDraw(
+    NVGcompat*                 compat,
+    int                        type,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    float                      strokeWidth,
+    const float*               bounds,
+    const NVGpath*             paths,
+    int                        npaths,
+    const NVGvertex*           verts,
+    int                        nverts);
+static void nvg__captureViewport(NVGcompat* compat, float width, float height, float devicePixelRatio);
+static void nvg__captureEndFrame(NVGcompat* compat, int cancelled);
+static void nvg__captureCreateTexture(
+    NVGcompat*           compat,
+    int                  image,
+    int                  type,
+    int                  w,
+    int                  h,
+    int                  imageFlags,
+    const unsigned char* data);
+static void nvg__captureUpdateTexture(
+    NVGcompat*           compat,
+    int                  image,
+    int                  x,
+    int                  y,
+    int                  w,
+    int                  h,
+    const unsigned char* data);
+static void nvg__captureUpdateRegion(
+    NVGcompat*           compat,
+    int                  image,
+    int                  x,
+    int                  y,
+    int                  w,
+    int                  h,
+    const unsigned char* data,
+    size_t               pitch);
+static int nvg__deleteCapture(struct NVGcapture* capture);
+
+// Passes a fill to the backend
+static void nvg__compatIssueFill(
+    NVGcompat*                 compat,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    const float*               bounds,
+    const NVGpath*             paths,
+    int                        npaths)
+{
+    int packed = compat->vertexFormat == NVG_VERTEX_PACKED && nvg__packPaths(compat, paths, npaths, bounds);
+
+    compat->batchStats.issued++;
+    if (compat->telemetry)
+    {
+        int i, nverts = 0;
+        for (i = 0; i < npaths; i++)
+            nverts += paths[i].nfill + paths[i].nstroke;
+        // Convex fills skip the stencil pass
+        nvg__telemetrySubmit(compat, nverts, npaths == 1 && paths[0].convex ? 1 : 2, packed);
+    }
+    if (compat->capture)
+        nvg__captureDraw(
+            compat,
+            NVG_DISPLAY_FILL,
+            paint,
+            compositeOperation,
+            scissor,
+            fringe,
+            0.0f,
+            bounds,
+            paths,
+            npaths,
+            NULL,
+            0);
+    if (packed)
+        compat->packed.renderFill(
+            compat->backend.userPtr,
+            paint,
+            compositeOperation,
+            scissor,
+            fringe,
+            bounds,
+            &compat->packedCall);
+    else
+        compat->backend.renderFill(
+            compat->backend.userPtr,
+            paint,
+            compositeOperation,
+            scissor,
+            fringe,
+            bounds,
+            paths,
+            npaths);
+}
+
+// Passes a stroke to the backend
+static void nvg__compatIssueStroke(
+    NVGcompat*                 compat,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    float                      strokeWidth,
+    const NVGpath*             paths,
+    int                        npaths)
+{
+    int packed = compat->vertexFormat == NVG_VERTEX_PACKED && nvg__packPaths(compat, paths, npaths, NULL);
+
+    compat->batchStats.issued++;
+    if (compat->telemetry)
+    {
+        int i, nverts = 0;
+        for (i = 0; i < npaths; i++)
+            nverts += paths[i].nstroke;
+        nvg__telemetrySubmit(compat, nverts, 1, packed);
+    }
+    if (compat->capture)
+        nvg__captureDraw(
+            compat,
+            NVG_DISPLAY_STROKE,
+            paint,
+            compositeOperation,
+            scissor,
+            fringe,
+            strokeWidth,
+            NULL,
+            paths,
+            npaths,
+            NULL,
+            0);
+    if (packed)
+        compat->packed.renderStroke(
+            compat->backend.userPtr,
+            paint,
+            compositeOperation,
+            scissor,
+            fringe,
+            strokeWidth,
+            &compat->packedCall);
+    else
+        compat->backend.renderStroke(
+            compat->backend.userPtr,
+            paint,
+            compositeOperation,
+            scissor,
+            fringe,
+            strokeWidth,
+            paths,
+            npaths);
+}
+
+// Passes triangles to the backend
+static void nvg__compatIssueTriangles(
+    NVGcompat*                 compat,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    const NVGvertex*           verts,
+    int                        nverts,
+    float                      fringe)
+{
+    int packed = compat->vertexFormat == NVG_VERTEX_PACKED && nvg__packTriangles(compat, verts, nverts);
+
+    compat->batchStats.issued++;
+    if (compat->telemetry)
+        nvg__telemetrySubmit(compat, nverts, 1, packed);
+    if (compat->capture)
+        nvg__captureDraw(
+            compat,
+            NVG_DISPLAY_TRIANGLES,
+            paint,
+            compositeOperation,
+            scissor,
+            fringe,
+            0.0f,
+            NULL,
+            NULL,
+            0,
+            verts,
+            nverts);
+    if (packed)
+        compat->packed.renderTriangles(
+            compat->backend.userPtr,
+            paint,
+            compositeOperation,
+            scissor,
+            &compat->packedCall,
+            fringe);
+    else
+        compat->backend.renderTriangles(
+            compat->backend.userPtr,
+            paint,
+            compositeOperation,
+            scissor,
+            verts,
+            nverts,
+            fringe);
+}
+
+static void nvg__compatRenderFill(
+    void*                      uptr,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    const float*               bounds,
+    const NVGpath*             paths,
+    int                        npaths)
+{
+    NVGcompat* compat = nvg__compatFromUptr(uptr);
+    if (compat->recording)
+        nvg__recordFill(compat->recording, paint, compositeOperation, scissor, fringe, bounds, paths, npaths);
+    if (compat->shrink)
+    {
+        int i, nverts = 0;
+        for (i = 0; i < npaths; i++)
+            nverts += paths[i].nfill + paths[i].nstroke;
+        nvg__shrinkSample(compat, nverts);
+    }
+    compat->batchStats.submitted++;
+    if (compat->damage && nvg__damageCall(
+                              compat,
+                              NVG_DISPLAY_FILL,
+                              paint,
+                              compositeOperation,
+                              scissor,
+                              fringe,
+                              0.0f,
+                              bounds,
+                              paths,
+                              npaths,
+                              NULL,
+                              0))
+        return;
+    if (compat->batch)
+        nvg__batchIssue(compat);
+    nvg__compatIssueFill(compat, paint, compositeOperation, scissor, fringe, bounds, paths, npaths);
+}
+
+static void nvg__compatRenderStroke(
+    void*                      uptr,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    float                      strokeWidth,
+    const NVGpath*             paths,
+    int                        npaths)
+{
+    NVGcompat* compat = nvg__compatFromUptr(uptr);
+    if (compat->recording)
+        nvg__recordStroke(compat->recording, paint, compositeOperation, scissor, fringe, strokeWidth, paths, npaths);
+    if (compat->shrink)
+    {
+        int i, nverts = 0;
+        for (i = 0; i < npaths; i++)
+            nverts += paths[i].nstroke;
+        nvg__shrinkSample(compat, nverts);
+    }
+    compat->batchStats.submitted++;
+    if (compat->damage && nvg__damageCall(
+                              compat,
+                              NVG_DISPLAY_STROKE,
+                              paint,
+                              compositeOperation,
+                              scissor,
+                              fringe,
+                              strokeWidth,
+                              NULL,
+                              paths,
+                              npaths,
+                              NULL,
+                              0))
+        return;
+    if (compat->batch &&
+        nvg__batchStroke(compat, paint, compositeOperation, scissor, fringe, strokeWidth, paths, npaths))
+        return;
+    nvg__compatIssueStroke(compat, paint, compositeOperation, scissor, fringe, strokeWidth, paths, npaths);
+}
+
+static void nvg__compatRenderTriangles(
+    void*                      uptr,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    const NVGvertex*           verts,
+    int                        nverts,
+    float                      fringe)
+{
+    NVGcompat* compat = nvg__compatFromUptr(uptr);
+    if (compat->recording)
+        nvg__recordTriangles(compat->recording, paint, compositeOperation, scissor, verts, nverts, fringe);
+    if (compat->shrink)
+        nvg__shrinkSample(compat, nverts);
+    compat->batchStats.submitted++;
+    if (compat->damage && nvg__damageCall(
+                              compat,
+                              NVG_DISPLAY_TRIANGLES,
+                              paint,
+                              compositeOperation,
+                              scissor,
+                              fringe,
+                              0.0f,
+                              NULL,
+                              NULL,
+                              0,
+                              verts,
+                              nverts))
+        return;
+    if (compat->batch)
+        nvg__batchIssue(compat);
+    nvg__compatIssueTriangles(compat, paint, compositeOperation, scissor, verts, nverts, fringe);
+}
+
+static void nvg__compatRenderViewport(void* uptr, float width, float height, float devicePixelRatio)
+{
+    NVGcompat* compat = nvg__compatFromUptr(uptr);
+    // Caches, batches & damage state grow during the frame, through the context's allocator
+    if (compat->alloc)
+    {
+        compat->allocPrev = g_allocCurrent;
+        g_allocCurrent    = compat->alloc;
+    }
+    memset(&compat->batchStats, 0, sizeof(compat->batchStats));
+    memset(&compat->cullStats, 0, sizeof(compat->cullStats));
+    compat->viewWidth  = width;
+    compat->viewHeight = height;
+    if (compat->telemetry)
+        nvg__telemetryBeginFrame(compat);
+    if (compat->lod)
+        nvg__lodBeginFrame(compat);
+    if (compat->damage)
+        nvg__damageBeginFrame(compat, width, height, devicePixelRatio);
+    if (compat->capture)
+        nvg__captureViewport(compat, width, height, devicePixelRatio);
+    compat->inFrame = 1;
+    compat->backend.renderViewport(compat->backend.userPtr, width, height, devicePixelRatio);
+}
+
+static void nvg__compatRenderFlush(void* uptr)
+{
+    NVGcompat* compat = nvg__compatFromUptr(uptr);
+    long long  start;
+    if (compat->damage)
+        nvg__damageEndFrame(compat);
+    if (compat->batch)
+        nvg__batchIssue(compat);
+    if (compat->telemetry == NULL)
+    {
+        compat->backend.renderFlush(compat->backend.userPtr);
+    }
+    else
+    {
+        start = nvg__nowNs();
+        compat->backend.renderFlush(compat->backend.userPtr);
+        nvg__telemetryEndFrame(compat, nvg__nowNs() - start);
+    }
+    compat->inFrame = 0;
+    if (compat->lod)
+        nvg__lodEndFrame(compat);
+    if (compat->capture)
+        nvg__captureEndFrame(compat, 0);
+    if (compat->readback)
+        nvg__readbackEndFrame(compat);
+    if (compat->shrink)
+        nvg__shrinkEndFrame(compat);
+    if (compat->arena)
+        nvg__arenaReset(compat->arena);
+    if (compat->alloc)
+        g_allocCurrent = compat->allocPrev;
+}
+
+static void nvg__compatRenderCancel(void* uptr)
+{
+    NVGcompat* compat = nvg__compatFromUptr(uptr);
+    if (compat->batch)
+        nvg__batchClear(compat->batch);
+    if (compat->damage)
+        nvg__damageCancel(compat->damage);
+    compat->backend.renderCancel(compat->backend.userPtr);
+    compat->inFrame = 0;
+    if (compat->capture)
+        nvg__captureEndFrame(compat, 1);
+    if (compat->readback)
+        nvg__readbackEndFrame(compat);
+    if (compat->arena)
+        nvg__arenaReset(compat->arena);
+    if (compat->alloc)
+        g_allocCurrent = compat->allocPrev;
+}
+
+static int nvg__compatImageBpp(NVGcompat* compat, int image)
+{
+    int i;
+    for (i = 0; i < NVG_MAX_FONTIMAGES; i++)
+        if (compat->ctx->fontImages[i] == image)
+            return 1;
+    if (image > 0 && image < compat->cimageBpp && compat->imageBpp[image] != 0)
+        return compat->imageBpp[image];
+    // Created before the compat state existed
+    return 4;
+}
+
+static int nvg__compatRenderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
+{
+    NVGcompat*     compat = nvg__compatFromUptr(uptr);
+    NVGallocState* prev   = g_allocCurrent;
+    int            image  = compat->backend.renderCreateTexture(compat->backend.userPtr, type, w, h, imageFlags, data);
+    int            bpp    = type == NVG_TEXTURE_RGBA ? 4 : 1;
+    int            cap    = compat->cimageBpp;
+
+    if (image <= 0)
+        return image;
+    // Images are mostly created outside of frames
+    if (compat->alloc)
+        g_allocCurrent = compat->alloc;
+    if (nvg__compatReserve((void**)&compat->imageBpp, &compat->cimageBpp, image + 1, 1))
+    {
+        memset(compat->imageBpp + cap, 0, compat->cimageBpp - cap);
+        compat->imageBpp[image] = (unsigned char)bpp;
+    }
+    if (compat->telemetry)
+        nvg__telemetryUpload(compat, data != NULL ? (size_t)w * h * bpp : 0, 1);
+    if (compat->capture)
+        nvg__captureCreateTexture(compat, image, type, w, h, imageFlags, data);
+    g_allocCurrent = prev;
+    return image;
+}
+
+static int nvg__compatRenderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+    NVGcompat* compat = nvg__compatFromUptr(uptr);
+    if (compat->telemetry)
+        nvg__telemetryUpload(compat, (size_t)w * h * nvg__compatImageBpp(compat, image), 0);
+    if (compat->damage)
+        nvg__damageImageUpdated(compat->damage, image);
+    if (compat->capture)
+        nvg__captureUpdateTexture(compat, image, x, y, w, h, data);
+    return compat->backend.renderUpdateTexture(compat->backend.userPtr, image, x, y, w, h, data);
+}
+
+static int nvg__compatRenderDeleteTexture(void* uptr, int image)
+{
+    NVGcompat* compat = nvg__compatFromUptr(uptr);
+    return compat->backend.renderDeleteTexture(compat->backend.userPtr, image);
+}
+
+static int nvg__compatRenderGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+    NVGcompat* compat = nvg__compatFromUptr(uptr);
+    return compat->backend.renderGetTextureSize(compat->backend.userPtr, image, w, h);
+}
+
+static void nvg__compatRenderDelete(void* uptr)
+{
+    NVGcompat* compat = nvg__compatFromUptr(uptr);
+
+    compat->backend.renderDelete(compat->backend.userPtr);
+
+    if (compat->recording)
+        nvgDeleteDisplayList(compat->recording);
+    NVG_FREE(compat->scratchPaths);
+    NVG_FREE(compat->scratchVerts);
+    NVG_FREE(compat->soa);
+    NVG_FREE(compat->imageBpp);
+    nvg__deleteTessCache(compat->tessCache);
+    nvg__deleteTextCache(compat->textCache);
+    nvg__deleteTelemetry(compat->telemetry);
+    nvg__deleteBatch(compat->batch);
+    nvg__deleteDamage(compat->damage);
+    nvg__deleteReadback(compat->readback);
+    nvg__deleteAtlas(NULL, compat->atlas);
+    nvg__deleteStreams(NULL, compat->streams);
+    NVG_FREE(compat->uploadScratch);
+    NVG_FREE(compat->instancePaths);
+    NVG_FREE(compat->instanceVerts);
+    NVG_FREE(compat->instanceCommands);
+    NVG_FREE(compat->instanceBounds);
+    NVG_FREE(compat->packedVerts);
+    NVG_FREE(compat->packedPaths);
+    nvg__deleteArena(compat->arena);
+    NVG_FREE(compat->shrink);
+    nvg__deleteCapture(compat->capture);
+    NVG_FREE(compat->lod);
+    if (compat->alloc)
+        nvg__allocRelease(compat->alloc);
+    NVG_FREE(compat);
+}
+
+// Stores the compat state in the context: the backend's params are moved to compat->backend & every callback is
+// replaced by one taking the compat state as its userPtr, so it's found without any lookup
+static NVGcompat* nvg__compatInstall(NVGcontext* ctx)
+{
+    NVGcompat* compat = (NVGcompat*)NVG_MALLOC(sizeof(NVGcompat));
+    if (compat == NULL)
+        return NULL;
+    memset(compat, 0, sizeof(*compat));
+    compat->ctx         = ctx;
+    compat->backend     = ctx->params;
+    compat->simdFlatten = NVG_COMPAT_SIMD_FLATTEN;
+    compat->simdStroke  = NVG_COMPAT_SIMD_STROKE;
+    compat->cull        = 1;
+
+    ctx->params.userPtr              = compat;
+    ctx->params.renderCreateTexture  = nvg__compatRenderCreateTexture;
+    ctx->params.renderDeleteTexture  = nvg__compatRenderDeleteTexture;
+    ctx->params.renderUpdateTexture  = nvg__compatRenderUpdateTexture;
+    ctx->params.renderGetTextureSize = nvg__compatRenderGetTextureSize;
+    ctx->params.renderViewport       = nvg__compatRenderViewport;
+    ctx->params.renderCancel         = nvg__compatRenderCancel;
+    ctx->params.renderFlush          = nvg__compatRenderFlush;
+    ctx->params.renderFill           = nvg__compatRenderFill;
+    ctx->params.renderStroke         = nvg__compatRenderStroke;
+    ctx->params.renderTriangles      = nvg__compatRenderTriangles;
+    ctx->params.renderDelete         = nvg__compatRenderDelete;
+
+    return compat;
+}
+
+// Contexts from nvgCreateContext get their compat state when created, those made by a backend's own create function
+// on first use
+static NVGcompat* nvg__compat(NVGcontext* ctx)
+{
+    if (ctx->params.renderDelete == nvg__compatRenderDelete)
+        return (NVGcompat*)ctx->params.userPtr;
+    return nvg__compatInstall(ctx);
+}
+
+NVGcontext* nvgCompatInit(NVGcontext* ctx)
+{
+    if (ctx != NULL)
+        nvg__compat(ctx);
+    return ctx;
+}
+
+// Backends find their state through the userPtr of the params
+NVGparams* nvgInternalParams(NVGcontext* ctx)
+{
+    if (ctx->params.renderDelete == nvg__compatRenderDelete)
+        return &((NVGcompat*)ctx->params.userPtr)->backend;
+    return &ctx->params;
+}
+
+//
+// Packed vertices
+//
+// Backends that take packed vertices hand their packed draw calls over when asked for them. Each call is then packed
+// as it's passed to the backend: the origin of its coordinates is the floor of its vertex bounds & they're stored in
+// 1/16 device pixels. Calls that don't fit the packed layout are passed as they are.
+//
+
+// Subpixels per device pixel of packed coordinates
+#define NVG_PACKED_SUBPIXELS 16.0f
+
+int nvgVertexFormat(NVGcontext* ctx, int format)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    if (compat == NULL)
+        return NVG_VERTEX_FLOAT;
+
+    compat->vertexFormat = NVG_VERTEX_FLOAT;
+#ifdef __linux__
+    if (format == NVG_VERTEX_PACKED && cpunvgPackedParams(&compat->backend, &compat->packed))
+        compat->vertexFormat = NVG_VERTEX_PACKED;
+#endif
+    return compat->vertexFormat;
+}
+
+// Grows `bounds` by the vertices, returns 0 when a texture coordinate lies outside 0..1 or a value isn't finite
+static int nvg__packBounds(const NVGvertex* verts, int nverts, float* bounds)
+{
+    int i;
+    for (i = 0; i < nverts; i++)
+    {
+        const NVGvertex* v = &verts[i];
+        // Written so NaNs fail too
+        if (! (v->u >= 0.0f && v->u <= 1.0f && v->v >= 0.0f && v->v <= 1.0f && v->x > -1e6f && v->x < 1e6f &&
+               v->y > -1e6f && v->y < 1e6f))
+            return 0;
+        bounds[0] = nvg__minf(bounds[0], v->x);
+        bounds[1] = nvg__minf(bounds[1], v->y);
+        bounds[2] = nvg__maxf(bounds[2], v->x);
+        bounds[3] = nvg__maxf(bounds[3], v->y);
+    }
+    return 1;
+}
+
+// Sets the origin & scale of the call being packed from the bounds of its vertices, returns 0 when they span too far
+static int nvg__packOrigin(NVGcompat* compat, const float* bounds)
+{
+    NVGpackedCall* call = &compat->packedCall;
+
+    call->scale     = NVG_PACKED_SUBPIXELS * compat->ctx->devicePxRatio;
+    call->origin[0] = floorf(bounds[0]);
+    call->origin[1] = floorf(bounds[1]);
+    return (bounds[2] - call->origin[0]) * call->scale < 65535.0f &&
+           (bounds[3] - call->origin[1]) * call->scale < 65535.0f;
+}
+
+static void nvg__packVertices(const NVGpackedCall* call, const NVGvertex* src, int n, NVGpackedVertex* dst)
+{
+    int i;
+    for (i = 0; i < n; i++)
+    {
+        dst[i].x = (unsigned short)((src[i].x - call->origin[0]) * call->scale + 0.5f);
+        dst[i].y = (unsigned short)((src[i].y - call->origin[1]) * call->scale + 0.5f);
+        dst[i].u = (unsigned short)(src[i].u * 65535.0f + 0.5f);
+        dst[i].v = (unsigned short)(src[i].v * 65535.0f + 0.5f);
+    }
+}
+
+// Packs the vertices of the paths of a fill, or of a stroke when `bounds` is NULL, into packedCall. Returns 0 when
+// they don't fit the packed layout.
+static int nvg__packPaths(NVGcompat* compat, const NVGpath* paths, int npaths, const float* bounds)
+{
+    NVGpackedCall* call = &compat->packedCall;
+    float          extent[4];
+    int            i, fill = bounds != NULL, nverts = 0;
+
+    extent[0] = extent[1] = 1e6f;
+    extent[2] = extent[3] = -1e6f;
+    if (fill)
+    {
+        // The cover quad of a fill spans its bounds
+        NVGvertex corners[2] = {{bounds[0], bounds[1], 0.0f, 0.0f}, {bounds[2], bounds[3], 0.0f, 0.0f}};
+        if (! nvg__packBounds(corners, 2, extent))
+            return 0;
+    }
+    for (i = 0; i < npaths; i++)
+    {
+        if (fill && ! nvg__packBounds(paths[i].fill, paths[i].nfill, extent))
+            return 0;
+        if (! nvg__packBounds(paths[i].stroke, paths[i].nstroke, extent))
+            return 0;
+        nverts += (fill ? paths[i].nfill : 0) + paths[i].nstroke;
+    }
+    if (nverts == 0 || ! nvg__packOrigin(compat, extent))
+        return 0;
+    if (! nvg__compatReserve((void**)&compat->packedVerts, &compat->cpackedVerts, nverts, sizeof(NVGpackedVertex)) ||
+        ! nvg__compatReserve((void**)&compat->packedPaths, &compat->cpackedPaths, npaths, sizeof(NVGpackedPath)))
+        return 0;
+
+    nverts = 0;
+    for (i = 0; i < npaths; i++)
+    {
+        NVGpackedPath* path = &compat->packedPaths[i];
+        path->nfill         = fill ? paths[i].nfill : 0;
+        path->fill          = nverts;
+        nvg__packVertices(call, paths[i].fill, path->nfill, &compat->packedVerts[path->fill]);
+        nverts        += path->nfill;
+        path->nstroke  = paths[i].nstroke;
+        path->stroke   = nverts;
+        nvg__packVertices(call, paths[i].stroke, path->nstroke, &compat->packedVerts[path->stroke]);
+        nverts        += path->nstroke;
+        path->convex   = paths[i].convex;
+    }
+    call->verts  = compat->packedVerts;
+    call->nverts = nverts;
+    call->paths  = compat->packedPaths;
+    call->npaths = npaths;
+    return 1;
+}
+
+// Packs the vertices of a triangles call into packedCall. Returns 0 when they don't fit the packed layout.
+static int nvg__packTriangles(NVGcompat* compat, const NVGvertex* verts, int nverts)
+{
+    NVGpackedCall* call = &compat->packedCall;
+    float          extent[4];
+
+    extent[0] = extent[1] = 1e6f;
+    extent[2] = extent[3] = -1e6f;
+    if (nverts <= 0 || ! nvg__packBounds(verts, nverts, extent) || ! nvg__packOrigin(compat, extent))
+        return 0;
+    if (! nvg__compatReserve((void**)&compat->packedVerts, &compat->cpackedVerts, nverts, sizeof(NVGpackedVertex)))
+        return 0;
+
+    nvg__packVertices(call, verts, nverts, compat->packedVerts);
+    call->verts  = compat->packedVerts;
+    call->nverts = nverts;
+    call->paths  = NULL;
+    call->npaths = 0;
+    return 1;
+}
+
+//
+// Telemetry
+//
+
+typedef struct NVGtelemetry
+{
+    // Ring of completed frames, `head` is the slot of the next one
+    NanoVGFrameStats* frames;
+    int               cframes;
+    int               nframes;
+    int               head;
+    // Frame being recorded, frameStart is 0 outside of frames
+    NanoVGFrameStats current;
+    long long        frameStart;
+    unsigned int     frameIndex;
+    // Allocator counters at the start of the frame
+    int    allocations;
+    size_t allocatedBytes;
+} NVGtelemetry;
+
+// nanovg's backends upload one fragment uniform block of 11 vec4s per draw pass
+#define NVG_TELEMETRY_UNIFORM_BLOCK_SIZE (11 * 4 * sizeof(float))
+
+static long long nvg__nowNs(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (long long)((double)counter.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+#endif
+}
+
+static NVGtelemetry* nvg__telemetry(NVGcontext* ctx)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    return compat != NULL ? compat->telemetry : NULL;
+}
+
+static void nvg__deleteTelemetry(NVGtelemetry* telemetry)
+{
+    if (telemetry == NULL)
+        return;
+    NVG_FREE(telemetry->frames);
+    NVG_FREE(telemetry);
+}
+
+// Counts a call passed to the backend, `packed` when its vertices were passed as NVGpackedVertex
+static void nvg__telemetrySubmit(NVGcompat* compat, int nverts, int nuniforms, int packed)
+{
+    NanoVGFrameStats* stats = &compat->telemetry->current;
+    NVGpathCache*     cache = compat->ctx->cache;
+
+    stats->drawCalls++;
+    stats->vertexBytes      += (size_t)nverts * (packed ? sizeof(NVGpackedVertex) : sizeof(NVGvertex));
+    stats->vertexBytesSaved += packed ? (size_t)nverts * (sizeof(NVGvertex) - sizeof(NVGpackedVertex)) : 0;
+    stats->uniformBytes     += (size_t)nuniforms * NVG_TELEMETRY_UNIFORM_BLOCK_SIZE;
+    stats->pointsHighWater   = nvg__maxi(stats->pointsHighWater, cache->npoints);
+    // nanovg sizes its vertex cache without counting what it writes, the call's vertices are what it held
+    stats->vertsHighWater = nvg__maxi(stats->vertsHighWater, nverts);
+}
+
+static void nvg__telemetryUpload(NVGcompat* compat, size_t bytes, int created)
+{
+    compat->telemetry->current.uploadBytes   += bytes;
+    compat->telemetry->current.imagesCreated += created;
+}
+
+static void nvg__telemetryBeginFrame(NVGcompat* compat)
+{
+    NVGtelemetry* telemetry = compat->telemetry;
+    memset(&telemetry->current, 0, sizeof(telemetry->current));
+    telemetry->current.frame = telemetry->frameIndex++;
+    telemetry->frameStart    = nvg__nowNs();
+    if (compat->alloc)
+    {
+        telemetry->allocations    = compat->alloc->allocations;
+        telemetry->allocatedBytes = compat->alloc->allocatedBytes;
+    }
+}
+
+static void nvg__telemetryEndFrame(NVGcompat* compat, long long flushNs)
+{
+    NVGtelemetry*     telemetry = compat->telemetry;
+    NanoVGFrameStats* stats     = &telemetry->current;
+    NVGcontext*       ctx       = compat->ctx;
+
+    // Telemetry was enabled mid frame
+    if (telemetry->frameStart == 0)
+        return;
+
+    stats->flushNs        = flushNs;
+    stats->frameNs        = nvg__nowNs() - telemetry->frameStart;
+    stats->fillTris       = ctx->fillTriCount;
+    stats->strokeTris     = ctx->strokeTriCount;
+    stats->textTris       = ctx->textTriCount;
+    stats->pointsCapacity = ctx->cache->cpoints;
+    stats->vertsCapacity  = ctx->cache->cverts;
+    if (compat->alloc)
+    {
+        stats->allocations    = compat->alloc->allocations - telemetry->allocations;
+        stats->allocatedBytes = compat->alloc->allocatedBytes - telemetry->allocatedBytes;
+        stats->heapBytes      = compat->alloc->liveBytes;
+    }
+    if (compat->arena)
+        stats->arenaBytes = nvg__arenaUsed(compat->arena);
+    stats->lodScale = 1.0f;
+    if (compat->lod)
+    {
+        NanoVGLodStats lod = nvgGetLodStats(ctx);
+        stats->lodScale    = lod.scale;
+        stats->lodSkipBlur = lod.skipBlur;
+    }
+
+    telemetry->frames[telemetry->head] = *stats;
+    telemetry->head                    = (telemetry->head + 1) % telemetry->cframes;
+    telemetry->nframes                 = nvg__mini(telemetry->nframes + 1, telemetry->cframes);
+    telemetry->frameStart              = 0;
+}
+
+void nvgTelemetryFrames(NVGcontext* ctx, int frames)
+{
+    NVGcompat*    compat = nvg__compat(ctx);
+    NVGtelemetry* telemetry;
+    if (compat == NULL)
+        return;
+
+    nvg__deleteTelemetry(compat->telemetry);
+    compat->telemetry = NULL;
+    if (frames <= 0)
+        return;
+
+    telemetry = (NVGtelemetry*)nvg__compatMalloc(compat, sizeof(NVGtelemetry));
+    if (telemetry == NULL)
+        return;
+    memset(telemetry, 0, sizeof(*telemetry));
+    telemetry->frames = (NanoVGFrameStats*)nvg__compatMalloc(compat, sizeof(NanoVGFrameStats) * frames);
+    if (telemetry->frames == NULL)
+    {
+        NVG_FREE(telemetry);
+        return;
+    }
+    telemetry->cframes = frames;
+    compat->telemetry  = telemetry;
+}
+
+int nvgGetFrameStats(NVGcontext* ctx, NanoVGFrameStats* stats, int maxFrames)
+{
+    NVGtelemetry* telemetry = nvg__telemetry(ctx);
+    int           i, n;
+    if (telemetry == NULL)
+        return 0;
+
+    n = nvg__mini(maxFrames, telemetry->nframes);
+    for (i = 0; i < n; i++)
+        stats[i] = telemetry->frames[(telemetry->head - 1 - i + telemetry->cframes) % telemetry->cframes];
+    return n;
+}
+
+//
+// Display lists
+//
+
+typedef struct NVGdisplayCall
+{
+    int                        type;
+    NVGpaint                   paint;
+    NVGcompositeOperationState compositeOperation;
+    NVGscissor                 scissor;
+    float                      fringe;
+    float                      strokeWidth;
+    float                      bounds[4];
+    // Paths are stored with their fill & stroke pointers as offsets into the list's vertices
+    int pathOffset;
+    int npaths;
+    int vertOffset;
+    int nverts;
+} NVGdisplayCall;
+
+static NVGdisplayCall* nvg__recordCall(
+    NVGdisplayList*            list,
+    int                        type,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe)
+{
+    NVGdisplayCall* call;
+    if (! nvg__compatReserve((void**)&list->calls, &list->ccalls, list->ncalls + 1, sizeof(NVGdisplayCall)))
+        return NULL;
+    call = &list->calls[list->ncalls++];
+    memset(call, 0, sizeof(*call));
+    call->type               = type;
+    call->paint              = *paint;
+    call->compositeOperation = compositeOperation;
+    call->scissor            = *scissor;
+    call->fringe             = fringe;
+    return call;
+}
+
+static int nvg__recordVerts(NVGdisplayList* list, const NVGvertex* verts, int nverts)
+{
+    int offset = list->nverts;
+    if (! nvg__compatReserve((void**)&list->verts, &list->cverts, list->nverts + nverts, sizeof(NVGvertex)))
+        return -1;
+    if (nverts > 0)
+        memcpy(&list->verts[offset], verts, sizeof(NVGvertex) * nverts);
+    list->nverts += nverts;
+    return offset;
+}
+
+static int nvg__recordPaths(NVGdisplayList* list, NVGdisplayCall* call, const NVGpath* paths, int npaths)
+{
+    int i;
+    if (! nvg__compatReserve((void**)&list->paths, &list->cpaths, list->npaths + npaths, sizeof(NVGpath)))
+        return 0;
+    call->pathOffset = list->npaths;
+    call->npaths     = npaths;
+    for (i = 0; i < npaths; i++)
+    {
+        NVGpath* copy = &list->paths[list->npaths + i];
+        int      fill, stroke;
+        *copy  = paths[i];
+        fill   = nvg__recordVerts(list, paths[i].fill, paths[i].nfill);
+        stroke = nvg__recordVerts(list, paths[i].stroke, paths[i].nstroke);
+        if (fill < 0 || stroke < 0)
+            return 0;
+        copy->fill   = (NVGvertex*)(size_t)fill;
+        copy->stroke = (NVGvertex*)(size_t)stroke;
+    }
+    list->npaths += npaths;
+    return 1;
+}
+
+static void nvg__recordFill(
+    NVGdisplayList*            list,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    const float*               bounds,
+    const NVGpath*             paths,
+    int                        npaths)
+{
+    NVGdisplayCall* call = nvg__recordCall(list, NVG_DISPLAY_FILL, paint, compositeOperation, scissor, fringe);
+    if (call == NULL)
+        return;
+    memcpy(call->bounds, bounds, sizeof(call->bounds));
+    if (! nvg__recordPaths(list, call, paths, npaths))
+        list->ncalls--;
+}
+
+static void nvg__recordStroke(
+    NVGdisplayList*            list,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    float                      strokeWidth,
+    const NVGpath*             paths,
+    int                        npaths)
+{
+    NVGdisplayCall* call = nvg__recordCall(list, NVG_DISPLAY_STROKE, paint, compositeOperation, scissor, fringe);
+    if (call == NULL)
+        return;
+    call->strokeWidth = strokeWidth;
+    if (! nvg__recordPaths(list, call, paths, npaths))
+        list->ncalls--;
+}
+
+static void nvg__recordTriangles(
+    NVGdisplayList*            list,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    const NVGvertex*           verts,
+    int                        nverts,
+    float                      fringe)
+{
+    NVGdisplayCall* call = nvg__recordCall(list, NVG_DISPLAY_TRIANGLES, paint, compositeOperation, scissor, fringe);
+    if (call == NULL)
+        return;
+    call->vertOffset = nvg__recordVerts(list, verts, nverts);
+    call->nverts     = nverts;
+    if (call->vertOffset < 0)
+        list->ncalls--;
+}
+
+void nvgBeginDisplayList(NVGcontext* ctx)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    if (compat == NULL)
+        return;
+    if (compat->recording)
+        nvgDeleteDisplayList(compat->recording);
+    compat->recording = (NVGdisplayList*)nvg__compatMalloc(compat, sizeof(NVGdisplayList));
+    if (compat->recording)
+        memset(compat->recording, 0, sizeof(NVGdisplayList));
+}
+
+NVGdisplayList* nvgEndDisplayList(NVGcontext* ctx)
+{
+    NVGcompat*      compat = nvg__compat(ctx);
+    NVGdisplayList* list   = NULL;
+    if (compat != NULL)
+    {
+        list              = compat->recording;
+        compat->recording = NULL;
+    }
+    return list;
+}
+
+void nvgDeleteDisplayList(NVGdisplayList* list)
+{
+    if (list == NULL)
+        return;
+    NVG_FREE(list->calls);
+    NVG_FREE(list->paths);
+    NVG_FREE(list->verts);
+    NVG_FREE(list);
+}
+
+// Copies `nverts` from the list into the scratch buffer at `offset`, transformed by `xform`
+static NVGvertex* nvg__transformVerts(
+    NVGcompat*       compat,
+    int              offset,
+    const NVGvertex* src,
+    int              nverts,
+    const float*     xform)
+{
+    NVGvertex* dst = &compat->scratchVerts[offset];
+    int        i;
+    for (i = 0; i < nverts; i++)
+    {
+        nvgTransformPoint(&dst[i].x, &dst[i].y, xform, src[i].x, src[i].y);
+        dst[i].u = src[i].u;
+        dst[i].v = src[i].v;
+    }
+    return dst;
+}
+
+void nvgDrawDisplayList(NVGcontext* ctx, const NVGdisplayList* list, const float* xform)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    float      identity[6];
+    int        i, j, transform;
+
+    if (compat == NULL || list == NULL)
+        return;
+    if (xform == NULL)
+    {
+        nvgTransformIdentity(identity);
+        xform = identity;
+    }
+    transform = xform[0] != 1.0f || xform[1] != 0.0f || xform[2] != 0.0f || xform[3] != 1.0f || xform[4] != 0.0f ||
+                xform[5] != 0.0f;
+    if (transform &&
+        ! nvg__compatReserve((void**)&compat->scratchVerts, &compat->cscratchVerts, list->nverts, sizeof(NVGvertex)))
+        return;
+
+    for (i = 0; i < list->ncalls; i++)
+    {
+        const NVGdisplayCall* call    = &list->calls[i];
+        NVGpaint              paint   = call->paint;
+        NVGscissor            scissor = call->scissor;
+        NVGpath*              paths;
+
+        if (transform)
+        {
+            nvgTransformMultiply(paint.xform, xform);
+            if (scissor.extent[0] >= 0.0f)
+                nvgTransformMultiply(scissor.xform, xform);
+        }
+
+        if (call->type == NVG_DISPLAY_TRIANGLES)
+        {
+            const NVGvertex* verts = &list->verts[call->vertOffset];
+            if (transform)
+                verts = nvg__transformVerts(compat, call->vertOffset, verts, call->nverts, xform);
+            ctx->params.renderTriangles(
+                ctx->params.userPtr,
+                &paint,
+                call->compositeOperation,
+                &scissor,
+                verts,
+                call->nverts,
+                call->fringe);
+            ctx->drawCallCount++;
+            ctx->textTriCount += call->nverts / 3;
+            continue;
+        }
+
+        if (! nvg__compatReserve(
+                (void**)&compat->scratchPaths,
+                &compat->cscratchPaths,
+                call->npaths,
+                sizeof(NVGpath)))
+            return;
+        paths = compat->scratchPaths;
+        for (j = 0; j < call->npaths; j++)
+        {
+            const NVGpath* src    = &list->paths[call->pathOffset + j];
+            int            fill   = (int)(size_t)src->fill;
+            int            stroke = (int)(size_t)src->stroke;
+            paths[j]              = *src;
+            if (transform)
+            {
+                paths[j].fill   = nvg__transformVerts(compat, fill, &list->verts[fill], src->nfill, xform);
+                paths[j].stroke = nvg__transformVerts(compat, stroke, &list->verts[stroke], src->nstroke, xform);
+            }
+            else
+            {
+                paths[j].fill   = &list->verts[fill];
+                paths[j].stroke = &list->verts[stroke];
+            }
+        }
+
+        if (call->type == NVG_DISPLAY_FILL)
+        {
+            float bounds[4];
+            memcpy(bounds, call->bounds, sizeof(bounds));
+            if (transform)
+            {
+                // Bounds of the transformed corners
+                float cx[4], cy[4];
+                nvgTransformPoint(&cx[0], &cy[0], xform, bounds[0], bounds[1]);
+                nvgTransformPoint(&cx[1], &cy[1], xform, bounds[2], bounds[1]);
+                nvgTransformPoint(&cx[2], &cy[2], xform, bounds[2], bounds[3]);
+                nvgTransformPoint(&cx[3], &cy[3], xform, bounds[0], bounds[3]);
+                bounds[0] = nvg__minf(nvg__minf(cx[0], cx[1]), nvg__minf(cx[2], cx[3]));
+                bounds[1] = nvg__minf(nvg__minf(cy[0], cy[1]), nvg__minf(cy[2], cy[3]));
+                bounds[2] = nvg__maxf(nvg__maxf(cx[0], cx[1]), nvg__maxf(cx[2], cx[3]));
+                bounds[3] = nvg__maxf(nvg__maxf(cy[0], cy[1]), nvg__maxf(cy[2], cy[3]));
+            }
+            ctx->params.renderFill(
+                ctx->params.userPtr,
+                &paint,
+                call->compositeOperation,
+                &scissor,
+                call->fringe,
+                bounds,
+                paths,
+                call->npaths);
+            for (j = 0; j < call->npaths; j++)
+            {
+                ctx->fillTriCount += paths[j].nfill - 2;
+                ctx->fillTriCount += paths[j].nstroke - 2;
+                ctx->drawCallCount += 2;
+            }
+        }
+        else
+        {
+            ctx->params.renderStroke(
+                ctx->params.userPtr,
+                &paint,
+                call->compositeOperation,
+                &scissor,
+                call->fringe,
+                call->strokeWidth,
+                paths,
+                call->npaths);
+            for (j = 0; j < call->npaths; j++)
+            {
+                ctx->strokeTriCount += paths[j].nstroke - 2;
+                ctx->drawCallCount++;
+            }
+        }
+    }
+}
+
+//
+// Recorders
+//
+// A recorder is an NVGcontext whose backend does nothing but answer image size queries from the target context's
+// backend. Its compat state records every fill, stroke & triangle call into a display list, so the whole nanovg
+// pipeline, up to the tessellated geometry, runs on the thread using the recorder.
+//
+
+typedef struct NVGrecorder
+{
+    NVGcontext* target;
+} NVGrecorder;
+
+static int nvg__recorderCreate(void* uptr) { return 1; }
+
+// Recorders can't own images. Returns an id that's never valid, as nanovg needs one for its font atlas
+static int nvg__recorderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
+{
+    return -1;
+}
+
+static int nvg__recorderDeleteTexture(void* uptr, int image) { return 1; }
+
+static int nvg__recorderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+    return 1;
+}
+
+static int nvg__recorderGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+    NVGparams* params = &((NVGrecorder*)uptr)->target->params;
+    return params->renderGetTextureSize(params->userPtr, image, w, h);
+}
+
+static void nvg__recorderViewport(void* uptr, float width, float height, float devicePixelRatio) {}
+static void nvg__recorderCancel(void* uptr) {}
+static void nvg__recorderFlush(void* uptr) {}
+
+static void nvg__recorderFill(
+    void*                      uptr,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    const float*               bounds,
+    const NVGpath*             paths,
+    int                        npaths)
+{
+}
+
+static void nvg__recorderStroke(
+    void*                      uptr,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    float                      strokeWidth,
+    const NVGpath*             paths,
+    int                        npaths)
+{
+}
+
+static void nvg__recorderTriangles(
+    void*                      uptr,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    const NVGvertex*           verts,
+    int                        nverts,
+    float                      fringe)
+{
+}
+
+static void nvg__recorderDelete(void* uptr) { NVG_FREE(uptr); }
+
+NVGcontext* nvgCreateRecorder(NVGcontext* ctx)
+{
+    NVGparams    params;
+    NVGrecorder* recorder;
+    NVGcontext*  rec;
+
+    // The recording threads read the compat state of `ctx` through the recorder
+    if (nvg__compat(ctx) == NULL)
+        return NULL;
+    recorder = (NVGrecorder*)NVG_MALLOC(sizeof(NVGrecorder));
+    if (recorder == NULL)
+        return NULL;
+    recorder->target = ctx;
+
+    memset(&params, 0, sizeof(params));
+    params.userPtr              = recorder;
+    params.edgeAntiAlias        = ctx->params.edgeAntiAlias;
+    params.renderCreate         = nvg__recorderCreate;
+    params.renderCreateTexture  = nvg__recorderCreateTexture;
+    params.renderDeleteTexture  = nvg__recorderDeleteTexture;
+    params.renderUpdateTexture  = nvg__recorderUpdateTexture;
+    params.renderGetTextureSize = nvg__recorderGetTextureSize;
+    params.renderViewport       = nvg__recorderViewport;
+    params.renderCancel         = nvg__recorderCancel;
+    params.renderFlush          = nvg__recorderFlush;
+    params.renderFill           = nvg__recorderFill;
+    params.renderStroke         = nvg__recorderStroke;
+    params.renderTriangles      = nvg__recorderTriangles;
+    params.renderDelete         = nvg__recorderDelete;
+
+    // Frees `recorder` through renderDelete on failure
+    rec = nvgCreateInternal(&params);
+    if (rec == NULL)
+        return NULL;
+    if (nvg__compat(rec) == NULL)
+    {
+        nvgDeleteInternal(rec);
+        return NULL;
+    }
+    return rec;
+}
+
+void nvgDeleteRecorder(NVGcontext* recorder) { nvgDeleteInternal(recorder); }
+
+void nvgBeginRecording(NVGcontext* recorder, float windowWidth, float windowHeight, float devicePixelRatio)
+{
+    nvgBeginFrame(recorder, windowWidth, windowHeight, devicePixelRatio);
+    nvgBeginDisplayList(recorder);
+}
+
+NVGdisplayList* nvgEndRecording(NVGcontext* recorder)
+{
+    NVGdisplayList* list = nvgEndDisplayList(recorder);
+    nvgEndFrame(recorder);
+    return list;
+}
+
+//
+// Draw call batching
+//
+// Consecutive strokes with the same paint, composite operation, scissor, fringe & width are merged into a single
+// backend call holding all their paths. The backends don't overlap stencil strokes within a call, so calls are only
+// merged when their vertex bounds are disjoint. The result is then the same as drawing them one by one.
+//
+// Fills aren't merged. The backends draw a fill of several paths with the stencil method, a stencil pass then a cover
+// quad over the union of their bounds, which costs more than the single pass of each convex fill it replaces.
+//
+
+#define NVG_BATCH_MAX_CALLS 256
+
+typedef struct NVGbatch
+{
+    NVGpaint                   paint;
+    NVGcompositeOperationState compositeOperation;
+    NVGscissor                 scissor;
+    float                      fringe;
+    float                      strokeWidth;
+    // Vertex bounds of each merged call, 4 floats per call
+    float* callBounds;
+    int    ncalls;
+    int    ccallBounds;
+    // Paths are stored with their fill & stroke pointers as offsets into `verts` until issued
+    NVGpath*   paths;
+    int        npaths;
+    int        cpaths;
+    NVGvertex* verts;
+    int        nverts;
+    int        cverts;
+} NVGbatch;
+
+static void nvg__batchClear(NVGbatch* batch)
+{
+    batch->ncalls = 0;
+    batch->npaths = 0;
+    batch->nverts = 0;
+}
+
+static void nvg__deleteBatch(NVGbatch* batch)
+{
+    if (batch == NULL)
+        return;
+    NVG_FREE(batch->callBounds);
+    NVG_FREE(batch->paths);
+    NVG_FREE(batch->verts);
+    NVG_FREE(batch);
+}
+
+static void nvg__batchIssue(NVGcompat* compat)
+{
+    NVGbatch* batch = compat->batch;
+    int       i;
+
+    if (batch->ncalls == 0)
+        return;
+    for (i = 0; i < batch->npaths; i++)
+    {
+        batch->paths[i].fill   = &batch->verts[(size_t)batch->paths[i].fill];
+        batch->paths[i].stroke = &batch->verts[(size_t)batch->paths[i].stroke];
+    }
+    nvg__compatIssueStroke(
+        compat,
+        &batch->paint,
+        batch->compositeOperation,
+        &batch->scissor,
+        batch->fringe,
+        batch->strokeWidth,
+        batch->paths,
+        batch->npaths);
+    nvg__batchClear(batch);
+}
+
+static int nvg__batchAppendVerts(NVGbatch* batch, const NVGvertex* verts, int nverts, float* bounds)
+{
+    int offset = batch->nverts, i;
+    if (! nvg__compatReserve((void**)&batch->verts, &batch->cverts, batch->nverts + nverts, sizeof(NVGvertex)))
+        return -1;
+    for (i = 0; i < nverts; i++)
+    {
+        batch->verts[offset + i] = verts[i];
+        bounds[0]                = nvg__minf(bounds[0], verts[i].x);
+        bounds[1]                = nvg__minf(bounds[1], verts[i].y);
+        bounds[2]                = nvg__maxf(bounds[2], verts[i].x);
+        bounds[3]                = nvg__maxf(bounds[3], verts[i].y);
+    }
+    batch->nverts += nverts;
+    return offset;
+}
+
+// Copies the paths of a call into the batch. Returns 0 on allocation failure
+static int nvg__batchAppend(NVGbatch* batch, const NVGpath* paths, int npaths)
+{
+    float* bounds;
+    int    i, npathsBefore = batch->npaths, nvertsBefore = batch->nverts;
+
+    if (! nvg__compatReserve(
+            (void**)&batch->callBounds,
+            &batch->ccallBounds,
+            (batch->ncalls + 1) * 4,
+            sizeof(float)) ||
+        ! nvg__compatReserve((void**)&batch->paths, &batch->cpaths, batch->npaths + npaths, sizeof(NVGpath)))
+        return 0;
+
+    bounds    = &batch->callBounds[batch->ncalls * 4];
+    bounds[0] = bounds[1] = 1e6f;
+    bounds[2] = bounds[3] = -1e6f;
+    for (i = 0; i < npaths; i++)
+    {
+        NVGpath* copy = &batch->paths[batch->npaths + i];
+        int      fill, stroke;
+        *copy  = paths[i];
+        fill   = nvg__batchAppendVerts(batch, paths[i].fill, paths[i].nfill, bounds);
+        stroke = nvg__batchAppendVerts(batch, paths[i].stroke, paths[i].nstroke, bounds);
+        if (fill < 0 || stroke < 0)
+        {
+            batch->npaths = npathsBefore;
+            batch->nverts = nvertsBefore;
+            return 0;
+        }
+        copy->fill   = (NVGvertex*)(size_t)fill;
+        copy->stroke = (NVGvertex*)(size_t)stroke;
+    }
+    batch->npaths += npaths;
+    batch->ncalls++;
+    return 1;
+}
+
+// Returns 1 if the vertex bounds of the last call appended to the batch overlap those of any other call in it
+static int nvg__batchOverlaps(const NVGbatch* batch)
+{
+    const float* last = &batch->callBounds[(batch->ncalls - 1) * 4];
+    int          i;
+    for (i = 0; i < batch->ncalls - 1; i++)
+    {
+        const float* b = &batch->callBounds[i * 4];
+        if (last[0] < b[2] && b[0] < last[2] && last[1] < b[3] && b[1] < last[3])
+            return 1;
+    }
+    return 0;
+}
+
+// Adds a stroke to the pending batch, issuing the batch first when the stroke can't be merged into it. Returns 0 when
+// the stroke can't be batched at all, the caller then issues it directly.
+static int nvg__batchStroke(
+    NVGcompat*                 compat,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    float                      strokeWidth,
+    const NVGpath*             paths,
+    int                        npaths)
+{
+    NVGbatch* batch = compat->batch;
+    int       compatible;
+
+    compatible = batch->ncalls > 0 && batch->ncalls < NVG_BATCH_MAX_CALLS && batch->fringe == fringe &&
+                 batch->strokeWidth == strokeWidth && memcmp(&batch->paint, paint, sizeof(NVGpaint)) == 0 &&
+                 memcmp(&batch->compositeOperation, &compositeOperation, sizeof(compositeOperation)) == 0 &&
+                 memcmp(&batch->scissor, scissor, sizeof(NVGscissor)) == 0;
+
+    if (compatible)
+    {
+        int npathsBefore = batch->npaths, nvertsBefore = batch->nverts;
+        if (nvg__batchAppend(batch, paths, npaths))
+        {
+            if (! nvg__batchOverlaps(batch))
+                return 1;
+            // Undo, issue the batch and start a new one with this stroke
+            batch->ncalls--;
+            batch->npaths = npathsBefore;
+            batch->nverts = nvertsBefore;
+        }
+    }
+
+    nvg__batchIssue(compat);
+    batch->paint              = *paint;
+    batch->compositeOperation = compositeOperation;
+    batch->scissor            = *scissor;
+    batch->fringe             = fringe;
+    batch->strokeWidth        = strokeWidth;
+    return nvg__batchAppend(batch, paths, npaths);
+}
+
+void nvgDrawBatching(NVGcontext* ctx, int enabled)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    if (compat == NULL)
+        return;
+
+    if (! enabled)
+    {
+        if (compat->batch)
+            nvg__batchIssue(compat);
+        nvg__deleteBatch(compat->batch);
+        compat->batch = NULL;
+        return;
+    }
+    if (compat->batch == NULL)
+    {
+        compat->batch = (NVGbatch*)nvg__compatMalloc(compat, sizeof(NVGbatch));
+        if (compat->batch != NULL)
+            memset(compat->batch, 0, sizeof(NVGbatch));
+    }
+}
+
+NanoVGBatchStats nvgGetBatchStats(NVGcontext* ctx)
+{
+    NanoVGBatchStats stats;
+    NVGcompat*       compat = nvg__compat(ctx);
+    memset(&stats, 0, sizeof(stats));
+    if (compat != NULL)
+        stats = compat->batchStats;
+    return stats;
+}
+
+//
+// Culling
+//
+
+// Writes the bounds of the points of the path commands, Bezier control points included, & returns their number
+static int nvg__commandBounds(NVGcontext* ctx, float* bounds)
+{
+    int i = 0, j, npoints = 0;
+
+    bounds[0] = bounds[1] = 1e6f;
+    bounds[2] = bounds[3] = -1e6f;
+    while (i < ctx->ncommands)
+    {
+        int          cmd = (int)ctx->commands[i];
+        int          n   = cmd == NVG_BEZIERTO ? 3 : cmd == NVG_MOVETO || cmd == NVG_LINETO ? 1 : 0;
+        const float* p   = &ctx->commands[i + 1];
+        for (j = 0; j < n; j++, p += 2)
+        {
+            bounds[0] = nvg__minf(bounds[0], p[0]);
+            bounds[1] = nvg__minf(bounds[1], p[1]);
+            bounds[2] = nvg__maxf(bounds[2], p[0]);
+            bounds[3] = nvg__maxf(bounds[3], p[1]);
+        }
+        npoints += n;
+        i       += 1 + n * 2 + (cmd == NVG_WINDING);
+    }
+    return npoints;
+}
+
+// Returns 1 when the current path, grown by `pad`, lies entirely outside the viewport or the scissor, counting it as
+// culled. Bounds are taken from the path commands, which nanovg stores transformed, so Bezier control points make them
+// conservative. They hold whether or not the path cache is already flattened, so a stroke following a fill of the same
+// path is culled too. Paths the bulk primitives add straight to the path cache are never culled, nor are those
+// recorded in display lists, which may be drawn with another transform.
+static int nvg__cullPath(NVGcontext* ctx, float pad)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    NVGstate*  state  = nvg__getState(ctx);
+    float      bounds[4], view[4];
+    int        npoints;
+
+    if (compat == NULL || ! compat->cull || ! compat->inFrame || compat->recording != NULL || compat->bulk)
+        return 0;
+
+    npoints = nvg__commandBounds(ctx, bounds);
+
+    view[0] = 0.0f;
+    view[1] = 0.0f;
+    view[2] = compat->viewWidth;
+    view[3] = compat->viewHeight;
+    if (state->scissor.extent[0] >= 0.0f)
+    {
+        // Bounding box of the transformed scissor rect, as in nvgCurrentScissor()
+        const float* m   = state->scissor.xform;
+        float        tex = state->scissor.extent[0] * fabsf(m[0]) + state->scissor.extent[1] * fabsf(m[2]);
+        float        tey = state->scissor.extent[0] * fabsf(m[1]) + state->scissor.extent[1] * fabsf(m[3]);
+        view[0]          = nvg__maxf(view[0], m[4] - tex);
+        view[1]          = nvg__maxf(view[1], m[5] - tey);
+        view[2]          = nvg__minf(view[2], m[4] + tex);
+        view[3]          = nvg__minf(view[3], m[5] + tey);
+    }
+
+    if (bounds[0] - pad < view[2] && bounds[2] + pad > view[0] && bounds[1] - pad < view[3] &&
+        bounds[3] + pad > view[1])
+        return 0;
+    compat->cullStats.paths++;
+    compat->cullStats.points += npoints;
+    return 1;
+}
+
+void nvgCulling(NVGcontext* ctx, int enabled)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    if (compat != NULL)
+        compat->cull = enabled;
+}
+
+NanoVGCullStats nvgGetCullStats(NVGcontext* ctx)
+{
+    NanoVGCullStats stats;
+    NVGcompat*      compat = nvg__compat(ctx);
+    memset(&stats, 0, sizeof(stats));
+    if (compat != NULL)
+        stats = compat->cullStats;
+    return stats;
+}
+
+//
+// Adaptive tessellation
+//
+// nvg__tessParams picks the tolerances of each path & nvg__tessExpand swaps them into ctx->tessTol & ctx->distTol
+// while flattening, so the tessellation cache keys entries by the tolerance they were flattened with. distTol, below
+// which points are merged, is scaled along with tessTol.
+//
+
+// Governor step & the fraction of the budget under which it steps back
+#define NVG_LOD_STEP 1.25f
+#define NVG_LOD_HEADROOM 0.75
+
+typedef struct NVGlod
+{
+    // 0 bounds follow ctx->tessTol
+    float          minTol;
+    float          maxTol;
+    float          relTol;
+    long long      budgetNs;
+    long long      frameStart;
+    NanoVGLodStats stats;
+} NVGlod;
+
+static NVGlod* nvg__lodState(NVGcompat* compat)
+{
+    if (compat->lod == NULL)
+    {
+        compat->lod = (NVGlod*)nvg__compatMalloc(compat, sizeof(NVGlod));
+        if (compat->lod == NULL)
+            return NULL;
+        memset(compat->lod, 0, sizeof(NVGlod));
+        compat->lod->stats.scale = 1.0f;
+    }
+    return compat->lod;
+}
+
+static void nvg__lodRelease(NVGcompat* compat)
+{
+    if (compat->lod->relTol == 0.0f && compat->lod->budgetNs == 0 && compat->lod->minTol == 0.0f &&
+        compat->lod->maxTol == 0.0f)
+    {
+        NVG_FREE(compat->lod);
+        compat->lod = NULL;
+    }
+}
+
+static void nvg__lodRange(NVGcontext* ctx, const NVGlod* lod, float* minTol, float* maxTol)
+{
+    *minTol = lod->minTol > 0.0f ? lod->minTol : ctx->tessTol;
+    *maxTol = nvg__maxf(lod->maxTol > 0.0f ? lod->maxTol : ctx->tessTol * 4.0f, *minTol);
+}
+
+// Scales the tolerances of the current path by its size & the governor's decision
+static void nvg__lodTolerance(NVGcontext* ctx, NVGcompat* compat, float* tessTol, float* distTol)
+{
+    NVGlod* lod = compat->lod;
+    float   tol = ctx->tessTol;
+    float   minTol, maxTol, bounds[4];
+
+    // Bulk primitives fill the path cache directly, their commands aren't the path
+    if (lod->relTol > 0.0f && ctx->cache->npaths == 0 && nvg__commandBounds(ctx, bounds) > 0)
+        tol = nvg__maxf(bounds[2] - bounds[0], bounds[3] - bounds[1]) * lod->relTol;
+
+    nvg__lodRange(ctx, lod, &minTol, &maxTol);
+    tol      = nvg__clampf(tol * lod->stats.scale, minTol, maxTol);
+    *tessTol = tol;
+    *distTol = ctx->distTol * tol / ctx->tessTol;
+
+    lod->stats.minTol = lod->stats.paths > 0 ? nvg__minf(lod->stats.minTol, tol) : tol;
+    lod->stats.maxTol = lod->stats.paths > 0 ? nvg__maxf(lod->stats.maxTol, tol) : tol;
+    lod->stats.paths++;
+}
+
+static void nvg__lodBeginFrame(NVGcompat* compat)
+{
+    compat->lod->stats.paths  = 0;
+    compat->lod->stats.minTol = 0.0f;
+    compat->lod->stats.maxTol = 0.0f;
+    compat->lod->frameStart   = nvg__nowNs();
+}
+
+static void nvg__lodEndFrame(NVGcompat* compat)
+{
+    NVGlod* lod = compat->lod;
+    float   minTol, maxTol;
+
+    if (lod->budgetNs == 0 || lod->frameStart == 0)
+        return;
+    lod->stats.frameNs = nvg__nowNs() - lod->frameStart;
+    lod->frameStart    = 0;
+    nvg__lodRange(compat->ctx, lod, &minTol, &maxTol);
+
+    if (lod->stats.frameNs > lod->budgetNs)
+    {
+        if (lod->stats.scale < maxTol / minTol)
+        {
+            lod->stats.scale = nvg__minf(lod->stats.scale * NVG_LOD_STEP, maxTol / minTol);
+            lod->stats.coarsened++;
+        }
+        else if (! lod->stats.skipBlur)
+        {
+            lod->stats.skipBlur = 1;
+            lod->stats.coarsened++;
+        }
+    }
+    else if (lod->stats.frameNs < lod->budgetNs * NVG_LOD_HEADROOM)
+    {
+        if (lod->stats.skipBlur)
+        {
+            lod->stats.skipBlur = 0;
+            lod->stats.refined++;
+        }
+        else if (lod->stats.scale > 1.0f)
+        {
+            lod->stats.scale = nvg__maxf(lod->stats.scale / NVG_LOD_STEP, 1.0f);
+            lod->stats.refined++;
+        }
+    }
+}
+
+void nvgTessellationLod(NVGcontext* ctx, float minTol, float maxTol, float relTol)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    NVGlod*    lod;
+    if (compat == NULL || (lod = nvg__lodState(compat)) == NULL)
+        return;
+    lod->minTol = nvg__maxf(minTol, 0.0f);
+    lod->maxTol = nvg__maxf(maxTol, 0.0f);
+    lod->relTol = nvg__maxf(relTol, 0.0f);
+    nvg__lodRelease(compat);
+}
+
+void nvgTessellationGovernor(NVGcontext* ctx, long long budgetNs)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    NVGlod*    lod;
+    if (compat == NULL || (lod = nvg__lodState(compat)) == NULL)
+        return;
+    lod->budgetNs = budgetNs > 0 ? budgetNs : 0;
+    if (lod->budgetNs == 0)
+    {
+        lod->stats.scale    = 1.0f;
+        lod->stats.skipBlur = 0;
+    }
+    lod->stats.coarsened = 0;
+    lod->stats.refined   = 0;
+    nvg__lodRelease(compat);
+}
+
+NanoVGLodStats nvgGetLodStats(NVGcontext* ctx)
+{
+    NanoVGLodStats stats;
+    NVGcompat*     compat = nvg__compat(ctx);
+    memset(&stats, 0, sizeof(stats));
+    stats.scale = 1.0f;
+    if (compat != NULL && compat->lod != NULL)
+        stats = compat->lod->stats;
+    return stats;
+}
+
+//
+// SIMD flattening
+//
+
+// Largest number of segments a Bezier is split into. Matches the 10 levels of recursion in nvg__tesselateBezier
+#define NVG_FLATTEN_MAX_SEGMENTS 1024
+
+// Number of uniform segments keeping a cubic within `tol` of its polyline. The distance between a curve and its chords
+// is bounded by 1/8 of the largest second derivative times the parameter step squared, which for a cubic is
+// 6 * max(|p0 - 2p1 + p2|, |p1 - 2p2 + p3|).
+static int nvg__bezierSegments(
+    float x1,
+    float y1,
+    float x2,
+    float y2,
+    float x3,
+    float y3,
+    float x4,
+    float y4,
+    float tol)
+{
+    float ax = x1 - 2.0f * x2 + x3, ay = y1 - 2.0f * y2 + y3;
+    float bx = x2 - 2.0f * x3 + x4, by = y2 - 2.0f * y3 + y4;
+    float dd = nvg__sqrtf(nvg__maxf(ax * ax + ay * ay, bx * bx + by * by));
+    int   n  = (int)ceilf(nvg__sqrtf(0.75f * dd / tol));
+    return nvg__clampi(n, 1, NVG_FLATTEN_MAX_SEGMENTS);
+}
+
+// Evaluates the cubic at t = 1/n .. 1 into xs & ys. Each lane runs its own forward difference over every 4th point.
+static void nvg__evalBezier(
+    float  x1,
+    float  y1,
+    float  x2,
+    float  y2,
+    float  x3,
+    float  y3,
+    float  x4,
+    float  y4,
+    int    n,
+    float* xs,
+    float* ys)
+{
+    // p(t) = a t^3 + b t^2 + c t + d
+    float   ax = -x1 + 3.0f * (x2 - x3) + x4, ay = -y1 + 3.0f * (y2 - y3) + y4;
+    float   bx = 3.0f * (x1 - 2.0f * x2 + x3), by = 3.0f * (y1 - 2.0f * y2 + y3);
+    float   cx = 3.0f * (x2 - x1), cy = 3.0f * (y2 - y1);
+    float   h = 1.0f / n, s = 4.0f * h;
+    float   px[4], py[4], d1x[4], d1y[4], d2x[4], d2y[4];
+    nvg__f4 fx, fy, dx1, dy1, dx2, dy2, dx3, dy3;
+    int     i, lane;
+
+    // Value and forward differences of each lane with a step of 4/n, starting at t = (lane + 1) / n
+    for (lane = 0; lane < 4; lane++)
+    {
+        float u  = (lane + 1) * h;
+        px[lane] = ((ax * u + bx) * u + cx) * u + x1;
+        py[lane] = ((ay * u + by) * u + cy) * u + y1;
+        // First difference p(u + s) - p(u) and second difference expanded in powers of u
+        d1x[lane] = ax * (3.0f * u * u * s + 3.0f * u * s * s + s * s * s) + bx * (2.0f * u * s + s * s) + cx * s;
+        d1y[lane] = ay * (3.0f * u * u * s + 3.0f * u * s * s + s * s * s) + by * (2.0f * u * s + s * s) + cy * s;
+        d2x[lane] = ax * (6.0f * u * s * s + 6.0f * s * s * s) + bx * (2.0f * s * s);
+        d2y[lane] = ay * (6.0f * u * s * s + 6.0f * s * s * s) + by * (2.0f * s * s);
+    }
+    fx  = nvg__f4load(px);
+    fy  = nvg__f4load(py);
+    dx1 = nvg__f4load(d1x);
+    dy1 = nvg__f4load(d1y);
+    dx2 = nvg__f4load(d2x);
+    dy2 = nvg__f4load(d2y);
+    dx3 = nvg__f4set1(6.0f * ax * s * s * s);
+    dy3 = nvg__f4set1(6.0f * ay * s * s * s);
+
+    for (i = 0; i < n; i += 4)
+    {
+        nvg__f4store(&xs[i], fx);
+        nvg__f4store(&ys[i], fy);
+        fx  = nvg__f4add(fx, dx1);
+        fy  = nvg__f4add(fy, dy1);
+        dx1 = nvg__f4add(dx1, dx2);
+        dy1 = nvg__f4add(dy1, dy2);
+        dx2 = nvg__f4add(dx2, dx3);
+        dy2 = nvg__f4add(dy2, dy3);
+    }
+    // Land exactly on the end point
+    xs[n - 1] = x4;
+    ys[n - 1] = y4;
+}
+
+static void nvg__tesselateBezierSIMD(
+    NVGcontext* ctx,
+    float       x1,
+    float       y1,
+    float       x2,
+    float       y2,
+    float       x3,
+    float       y3,
+    float       x4,
+    float       y4,
+    int         type)
+{
+    // Rounded up to a multiple of 4 for the vector stores
+    float xs[NVG_FLATTEN_MAX_SEGMENTS + 4], ys[NVG_FLATTEN_MAX_SEGMENTS + 4];
+    // Equivalent deviation of the flatness test in nvg__tesselateBezier
+    float tol = nvg__sqrtf(ctx->tessTol) * 0.5f;
+    int   n   = nvg__bezierSegments(x1, y1, x2, y2, x3, y3, x4, y4, tol);
+    int   i;
+
+    nvg__evalBezier(x1, y1, x2, y2, x3, y3, x4, y4, n, xs, ys);
+    for (i = 0; i < n - 1; i++)
+        nvg__addPoint(ctx, xs[i], ys[i], 0);
+    nvg__addPoint(ctx, xs[n - 1], ys[n - 1], type);
+}
+
+// nvg__flattenPaths, using nvg__tesselateBezierSIMD for curves
+static void nvg__finishPaths(NVGcontext* ctx);
+
+static void nvg__flattenPathsSIMD(NVGcontext* ctx)
+{
+    NVGpathCache* cache = ctx->cache;
+    NVGpoint*     last;
+    float*        cp1;
+    float*        cp2;
+    float*        p;
+    int           i;
+
+    if (cache->npaths > 0)
+        return;
+
+    // Flatten
+    i = 0;
+    while (i < ctx->ncommands)
+    {
+        int cmd = (int)ctx->commands[i];
+        switch (cmd)
+        {
+        case NVG_MOVETO:
+            nvg__addPath(ctx);
+            p = &ctx->commands[i + 1];
+            nvg__addPoint(ctx, p[0], p[1], NVG_PT_CORNER);
+            i += 3;
+            break;
+        case NVG_LINETO:
+            p = &ctx->commands[i + 1];
+            nvg__addPoint(ctx, p[0], p[1], NVG_PT_CORNER);
+            i += 3;
+            break;
+        case NVG_BEZIERTO:
+            last = nvg__lastPoint(ctx);
+            if (last != NULL)
+            {
+                cp1 = &ctx->commands[i + 1];
+                cp2 = &ctx->commands[i + 3];
+                p   = &ctx->commands[i + 5];
+                nvg__tesselateBezierSIMD(
+                    ctx,
+                    last->x,
+                    last->y,
+                    cp1[0],
+                    cp1[1],
+                    cp2[0],
+                    cp2[1],
+                    p[0],
+                    p[1],
+                    NVG_PT_CORNER);
+            }
+            i += 7;
+            break;
+        case NVG_CLOSE:
+            nvg__closePath(ctx);
+            i++;
+            break;
+        case NVG_WINDING:
+            nvg__pathWinding(ctx, (int)ctx->commands[i + 1]);
+            i += 2;
+            break;
+        default:
+            i++;
+        }
+    }
+
+    nvg__finishPaths(ctx);
+}
+
+// Second half of nvg__flattenPaths, computes the segment directions, winding & bounds of the paths in the cache
+static void nvg__finishPaths(NVGcontext* ctx)
+{
+    NVGpathCache* cache = ctx->cache;
+    NVGpoint*     p0;
+    NVGpoint*     p1;
+    NVGpoint*     pts;
+    NVGpath*      path;
+    int           i, j;
+    float         area;
+
+    cache->bounds[0] = cache->bounds[1] = 1e6f;
+    cache->bounds[2] = cache->bounds[3] = -1e6f;
+
+    // Calculate the direction and length of line segments.
+    for (j = 0; j < cache->npaths; j++)
+    {
+        path = &cache->paths[j];
+        pts  = &cache->points[path->first];
+
+        // If the first and last points are the same, remove the last, mark as closed path.
+        p0 = &pts[path->count - 1];
+        p1 = &pts[0];
+        if (nvg__ptEquals(p0->x, p0->y, p1->x, p1->y, ctx->distTol))
+        {
+            path->count--;
+            p0           = &pts[path->count - 1];
+            path->closed = 1;
+        }
+
+        // Enforce winding.
+        if (path->count > 2)
+        {
+            area = nvg__polyArea(pts, path->count);
+            if (path->winding == NVG_CCW && area < 0.0f)
+                nvg__polyReverse(pts, path->count);
+            if (path->winding == NVG_CW && area > 0.0f)
+                nvg__polyReverse(pts, path->count);
+        }
+
+        for (i = 0; i < path->count; ++i)
+        {
+            // Calculate segment direction and length
+            p0->dx  = p1->x - p0->x;
+            p0->dy  = p1->y - p0->y;
+            p0->len = nvg__normalize(&p0->dx, &p0->dy);
+            // Update bounds
+            cache->bounds[0] = nvg__minf(cache->bounds[0], p0->x);
+            cache->bounds[1] = nvg__minf(cache->bounds[1], p0->y);
+            cache->bounds[2] = nvg__maxf(cache->bounds[2], p0->x);
+            cache->bounds[3] = nvg__maxf(cache->bounds[3], p0->y);
+            // Advance
+            p0 = p1++;
+        }
+    }
+}
+
+//
+// SIMD stroke expansion
+//
+
+typedef struct NVGpointsSoA
+{
+    float* x;
+    float* y;
+    float* dx;
+    float* dy;
+    float* len;
+    float* dmx;
+    float* dmy;
+} NVGpointsSoA;
+
+// Copies the points of the path cache into the compat SoA buffers
+static int nvg__pointsToSoA(NVGcontext* ctx, NVGcompat* compat, NVGpointsSoA* soa)
+{
+    NVGpathCache* cache = ctx->cache;
+    // Padded so 4 wide loads past the last point stay in bounds
+    int stride = cache->npoints + 4;
+    int i;
+
+    if (compat == NULL || ! nvg__compatReserve((void**)&compat->soa, &compat->csoa, stride * 7, sizeof(float)))
+        return 0;
+    soa->x   = compat->soa;
+    soa->y   = soa->x + stride;
+    soa->dx  = soa->y + stride;
+    soa->dy  = soa->dx + stride;
+    soa->len = soa->dy + stride;
+    soa->dmx = soa->len + stride;
+    soa->dmy = soa->dmx + stride;
+
+    for (i = 0; i < cache->npoints; i++)
+    {
+        const NVGpoint* pt = &cache->points[i];
+        soa->x[i]          = pt->x;
+        soa->y[i]          = pt->y;
+        soa->dx[i]         = pt->dx;
+        soa->dy[i]         = pt->dy;
+        soa->len[i]        = pt->len;
+    }
+    for (; i < stride; i++)
+        soa->x[i] = soa->y[i] = soa->dx[i] = soa->dy[i] = soa->len[i] = 0.0f;
+    return 1;
+}
+
+// nvg__calculateJoins for a single point, p0 being the previous point
+static int nvg__joinFlags(
+    NVGpointsSoA* soa,
+    int           i0,
+    int           i1,
+    unsigned char corner,
+    float         iw,
+    int           lineJoin,
+    float         miterLimit)
+{
+    float dlx0 = soa->dy[i0], dly0 = -soa->dx[i0];
+    float dlx1 = soa->dy[i1], dly1 = -soa->dx[i1];
+    float dmx = (dlx0 + dlx1) * 0.5f, dmy = (dly0 + dly1) * 0.5f;
+    float dmr2 = dmx * dmx + dmy * dmy;
+    float cross, limit;
+    int   flags = corner ? NVG_PT_CORNER : 0;
+
+    if (dmr2 > 0.000001f)
+    {
+        float scale = 1.0f / dmr2;
+        if (scale > 600.0f)
+            scale = 600.0f;
+        dmx *= scale;
+        dmy *= scale;
+    }
+    soa->dmx[i1] = dmx;
+    soa->dmy[i1] = dmy;
+
+    cross = soa->dx[i1] * soa->dy[i0] - soa->dx[i0] * soa->dy[i1];
+    if (cross > 0.0f)
+        flags |= NVG_PT_LEFT;
+
+    limit = nvg__maxf(1.01f, nvg__minf(soa->len[i0], soa->len[i1]) * iw);
+    if ((dmr2 * limit * limit) < 1.0f)
+        flags |= NVG_PR_INNERBEVEL;
+
+    if (flags & NVG_PT_CORNER)
+    {
+        if ((dmr2 * miterLimit * miterLimit) < 1.0f || lineJoin == NVG_BEVEL || lineJoin == NVG_ROUND)
+            flags |= NVG_PT_BEVEL;
+    }
+    return flags;
+}
+
+// nvg__calculateJoins over SoA copies of the points. Extrusions are written to the SoA buffers and to the points
+static void nvg__calculateJoinsSIMD(NVGcontext* ctx, NVGpointsSoA* soa, float w, int lineJoin, float miterLimit)
+{
+    NVGpathCache* cache = ctx->cache;
+    float         iw    = w > 0.0f ? 1.0f / w : 0.0f;
+    nvg__f4       vhalf = nvg__f4set1(0.5f), veps = nvg__f4set1(0.000001f), vone = nvg__f4set1(1.0f);
+    nvg__f4       vmax = nvg__f4set1(600.0f), vlim = nvg__f4set1(1.01f), viw = nvg__f4set1(iw);
+    nvg__f4       vzero = nvg__f4set1(0.0f), vmiter = nvg__f4set1(miterLimit);
+    int           i, j, lane;
+
+    for (i = 0; i < cache->npaths; i++)
+    {
+        NVGpath*  path  = &cache->paths[i];
+        NVGpoint* pts   = &cache->points[path->first];
+        int       first = path->first;
+        int       nleft = 0;
+
+        path->nbevel = 0;
+
+        for (j = 0; j < path->count; j++)
+        {
+            int flags;
+
+            if (j > 0 && j + 4 <= path->count)
+            {
+                // Lanes j .. j+3, previous points are j-1 .. j+2
+                int     c = first + j, p = c - 1;
+                nvg__f4 dx0 = nvg__f4load(&soa->dx[p]), dy0 = nvg__f4load(&soa->dy[p]);
+                nvg__f4 dx1 = nvg__f4load(&soa->dx[c]), dy1 = nvg__f4load(&soa->dy[c]);
+                nvg__f4 dmx   = nvg__f4mul(nvg__f4add(dy0, dy1), vhalf);
+                nvg__f4 dmy   = nvg__f4mul(nvg__f4add(nvg__f4neg(dx0), nvg__f4neg(dx1)), vhalf);
+                nvg__f4 dmr2  = nvg__f4add(nvg__f4mul(dmx, dmx), nvg__f4mul(dmy, dmy));
+                nvg__f4 scale = nvg__f4selgt(dmr2, veps, nvg__f4min(nvg__f4div(vone, dmr2), vmax), vone);
+                nvg__f4 limit = nvg__f4max(
+                    vlim,
+                    nvg__f4mul(nvg__f4min(nvg__f4load(&soa->len[p]), nvg__f4load(&soa->len[c])), viw));
+                nvg__f4 cross  = nvg__f4sub(nvg__f4mul(dx1, dy0), nvg__f4mul(dx0, dy1));
+                int     left   = nvg__f4ltmask(vzero, cross);
+                int     inner  = nvg__f4ltmask(nvg__f4mul(nvg__f4mul(dmr2, limit), limit), vone);
+                int     mitred = nvg__f4ltmask(nvg__f4mul(nvg__f4mul(dmr2, vmiter), vmiter), vone);
+
+                nvg__f4store(&soa->dmx[c], nvg__f4mul(dmx, scale));
+                nvg__f4store(&soa->dmy[c], nvg__f4mul(dmy, scale));
+
+                for (lane = 0; lane < 4; lane++)
+                {
+                    NVGpoint* pt = &pts[j + lane];
+                    flags        = (pt->flags & NVG_PT_CORNER) ? NVG_PT_CORNER : 0;
+                    if (left & (1 << lane))
+                        flags |= NVG_PT_LEFT;
+                    if (inner & (1 << lane))
+                        flags |= NVG_PR_INNERBEVEL;
+                    if ((flags & NVG_PT_CORNER) &&
+                        ((mitred & (1 << lane)) || lineJoin == NVG_BEVEL || lineJoin == NVG_ROUND))
+                        flags |= NVG_PT_BEVEL;
+
+                    pt->flags = (unsigned char)flags;
+                    pt->dmx   = soa->dmx[c + lane];
+                    pt->dmy   = soa->dmy[c + lane];
+                    nleft    += (flags & NVG_PT_LEFT) != 0;
+                    if ((flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0)
+                        path->nbevel++;
+                }
+                j += 3;
+                continue;
+            }
+
+            flags = nvg__joinFlags(
+                soa,
+                first + (j > 0 ? j - 1 : path->count - 1),
+                first + j,
+                pts[j].flags & NVG_PT_CORNER,
+                iw,
+                lineJoin,
+                miterLimit);
+            pts[j].flags = (unsigned char)flags;
+            pts[j].dmx   = soa->dmx[first + j];
+            pts[j].dmy   = soa->dmy[first + j];
+            nleft       += (flags & NVG_PT_LEFT) != 0;
+            if ((flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0)
+                path->nbevel++;
+        }
+
+        path->convex = (nleft == path->count) ? 1 : 0;
+    }
+}
+
+// Emits the two miter vertices of points [i, end), which have no bevels
+static NVGvertex* nvg__miterRun(NVGvertex* dst, const NVGpointsSoA* soa, int i, int end, float w, float u0, float u1)
+{
+    nvg__f4 vw = nvg__f4set1(w);
+    float   xp[4], yp[4], xm[4], ym[4];
+    int     lane;
+
+    for (; i + 4 <= end; i += 4)
+    {
+        nvg__f4 x = nvg__f4load(&soa->x[i]), y = nvg__f4load(&soa->y[i]);
+        nvg__f4 mx = nvg__f4mul(nvg__f4load(&soa->dmx[i]), vw), my = nvg__f4mul(nvg__f4load(&soa->dmy[i]), vw);
+        nvg__f4store(xp, nvg__f4add(x, mx));
+        nvg__f4store(yp, nvg__f4add(y, my));
+        nvg__f4store(xm, nvg__f4sub(x, mx));
+        nvg__f4store(ym, nvg__f4sub(y, my));
+        for (lane = 0; lane < 4; lane++)
+        {
+            nvg__vset(dst, xp[lane], yp[lane], u0, 1);
+            dst++;
+            nvg__vset(dst, xm[lane], ym[lane], u1, 1);
+            dst++;
+        }
+    }
+    for (; i < end; i++)
+    {
+        nvg__vset(dst, soa->x[i] + (soa->dmx[i] * w), soa->y[i] + (soa->dmy[i] * w), u0, 1);
+        dst++;
+        nvg__vset(dst, soa->x[i] - (soa->dmx[i] * w), soa->y[i] - (soa->dmy[i] * w), u1, 1);
+        dst++;
+    }
+    return dst;
+}
+
+// nvg__expandStroke using nvg__calculateJoinsSIMD and nvg__miterRun. Joins and caps use nanovg's functions.
+static int nvg__expandStrokeSIMD(
+    NVGcontext* ctx,
+    NVGcompat*  compat,
+    float       w,
+    float       fringe,
+    int         lineCap,
+    int         lineJoin,
+    float       miterLimit)
+{
+    NVGpathCache* cache = ctx->cache;
+    NVGvertex*    verts;
+    NVGvertex*    dst;
+    NVGpointsSoA  soa;
+    int           cverts, i, j;
+    float         aa = fringe;
+    float         u0 = 0.0f, u1 = 1.0f;
+    int           ncap = nvg__curveDivs(w, NVG_PI, ctx->tessTol); // Calculate divisions per half circle.
+
+    if (! nvg__pointsToSoA(ctx, compat, &soa))
+        return nvg__expandStroke(ctx, w, fringe, lineCap, lineJoin, miterLimit);
+
+    w += aa * 0.5f;
+
+    // Disable the gradient used for antialiasing when antialiasing is not used.
+    if (aa == 0.0f)
+    {
+        u0 = 0.5f;
+        u1 = 0.5f;
+    }
+
+    nvg__calculateJoinsSIMD(ctx, &soa, w, lineJoin, miterLimit);
+
+    // Calculate max vertex usage.
+    cverts = 0;
+    for (i = 0; i < cache->npaths; i++)
+    {
+        NVGpath* path = &cache->paths[i];
+        int      loop = (path->closed == 0) ? 0 : 1;
+        if (lineJoin == NVG_ROUND)
+            cverts += (path->count + path->nbevel * (ncap + 2) + 1) * 2; // plus one for loop
+        else
+            cverts += (path->count + path->nbevel * 5 + 1) * 2; // plus one for loop
+        if (loop == 0)
+        {
+            // space for caps
+            if (lineCap == NVG_ROUND)
+                cverts += (ncap * 2 + 2) * 2;
+            else
+                cverts += (3 + 3) * 2;
+        }
+    }
+
+    verts = nvg__allocTempVerts(ctx, cverts);
+    if (verts == NULL)
+        return 0;
+
+    for (i = 0; i < cache->npaths; i++)
+    {
+        NVGpath*  path = &cache->paths[i];
+        NVGpoint* pts  = &cache->points[path->first];
+        NVGpoint* p0;
+        NVGpoint* p1;
+        int       s, e, loop;
+        float     dx, dy;
+
+        path->fill  = 0;
+        path->nfill = 0;
+
+        // Calculate fringe or stroke
+        loop         = (path->closed == 0) ? 0 : 1;
+        dst          = verts;
+        path->stroke = dst;
+
+        if (loop)
+        {
+            // Looping
+            p0 = &pts[path->count - 1];
+            p1 = &pts[0];
+            s  = 0;
+            e  = path->count;
+        }
+        else
+        {
+            // Add cap
+            p0 = &pts[0];
+            p1 = &pts[1];
+            s  = 1;
+            e  = path->count - 1;
+        }
+
+        if (loop == 0)
+        {
+            // Add cap
+            dx = p1->x - p0->x;
+            dy = p1->y - p0->y;
+            nvg__normalize(&dx, &dy);
+            if (lineCap == NVG_BUTT)
+                dst = nvg__buttCapStart(dst, p0, dx, dy, w, -aa * 0.5f, aa, u0, u1);
+            else if (lineCap == NVG_BUTT || lineCap == NVG_SQUARE)
+                dst = nvg__buttCapStart(dst, p0, dx, dy, w, w - aa, aa, u0, u1);
+            else if (lineCap == NVG_ROUND)
+                dst = nvg__roundCapStart(dst, p0, dx, dy, w, ncap, aa, u0, u1);
+        }
+
+        for (j = s; j < e;)
+        {
+            if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0)
+            {
+                if (lineJoin == NVG_ROUND)
+                    dst = nvg__roundJoin(dst, p0, p1, w, w, u0, u1, ncap, aa);
+                else
+                    dst = nvg__bevelJoin(dst, p0, p1, w, w, u0, u1, aa);
+                p0 = p1++;
+                j++;
+            }
+            else
+            {
+                // Run of points without bevels
+                int end = j + 1;
+                while (end < e && (pts[end].flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) == 0)
+                    end++;
+                dst = nvg__miterRun(dst, &soa, path->first + j, path->first + end, w, u0, u1);
+                p0  = &pts[end - 1];
+                p1  = &pts[end];
+                j   = end;
+            }
+        }
+
+        if (loop)
+        {
+            // Loop it
+            nvg__vset(dst, verts[0].x, verts[0].y, u0, 1);
+            dst++;
+            nvg__vset(dst, verts[1].x, verts[1].y, u1, 1);
+            dst++;
+        }
+        else
+        {
+            // Add cap
+            dx = p1->x - p0->x;
+            dy = p1->y - p0->y;
+            nvg__normalize(&dx, &dy);
+            if (lineCap == NVG_BUTT)
+                dst = nvg__buttCapEnd(dst, p1, dx, dy, w, -aa * 0.5f, aa, u0, u1);
+            else if (lineCap == NVG_BUTT || lineCap == NVG_SQUARE)
+                dst = nvg__buttCapEnd(dst, p1, dx, dy, w, w - aa, aa, u0, u1);
+            else if (lineCap == NVG_ROUND)
+                dst = nvg__roundCapEnd(dst, p1, dx, dy, w, ncap, aa, u0, u1);
+        }
+
+        path->nstroke = (int)(dst - verts);
+
+        verts = dst;
+    }
+
+    return 1;
+}
+
+//
+// Tessellation cache
+//
+// Entries are keyed by the command buffer made relative to its first point, so the same shape drawn at different
+// positions shares an entry, plus everything else the flattener and expanders read. Coordinates are quantized to
+// 1/NVG_TESS_CACHE_PRECISION of a unit before hashing.
+//
+
+#define NVG_TESS_CACHE_BUCKETS 1024
+#define NVG_TESS_CACHE_PRECISION 1024.0f
+
+typedef struct NVGtessParams
+{
+    int   stroke;
+    int   antiAlias;
+    float tessTol;
+    float distTol;
+    float fringe;
+    // Half the stroke width, as passed to nvg__expandStroke
+    float w;
+    int   lineCap;
+    int   lineJoin;
+    float miterLimit;
+    // Quantized nvg__getAverageScale of the current transform
+    int scale;
+    // Flattener & stroke expander, bit 0 set for nvg__flattenPathsSIMD, bit 1 for nvg__expandStrokeSIMD
+    int simd;
+} NVGtessParams;
+
+typedef struct NVGtessEntry
+{
+    uint64_t             hash;
+    NVGtessParams        params;
+    int*                 key;
+    int                  nkey;
+    NVGpath*             paths;
+    int                  npaths;
+    NVGvertex*           verts;
+    int                  nverts;
+    float                bounds[4];
+    size_t               bytes;
+    struct NVGtessEntry* chain;
+    struct NVGtessEntry* prev;
+    struct NVGtessEntry* next;
+} NVGtessEntry;
+
+typedef struct NVGtessCache
+{
+    NVGtessEntry*        buckets[NVG_TESS_CACHE_BUCKETS];
+    NVGtessEntry*        head; // Most recently used
+    NVGtessEntry*        tail;
+    size_t               budget;
+    int*                 key;
+    int                  ckey;
+    NanoVGTessCacheStats stats;
+} NVGtessCache;
+
+static int nvg__quantizeCoord(float v) { return (int)floorf(v * NVG_TESS_CACHE_PRECISION + 0.5f); }
+
+// Writes the quantized, origin relative command buffer to cache->key. Returns the number of ints written
+static int nvg__tessKey(NVGcontext* ctx, NVGtessCache* cache, float ox, float oy)
+{
+    int i = 0, n = 0;
+
+    if (! nvg__compatReserve((void**)&cache->key, &cache->ckey, ctx->ncommands, sizeof(int)))
+        return -1;
+
+    while (i < ctx->ncommands)
+    {
+        int cmd = (int)ctx->commands[i];
+        int j, ncoords = 0;
+
+        cache->key[n++] = cmd;
+        switch (cmd)
+        {
+        case NVG_MOVETO:
+        case NVG_LINETO:
+            ncoords = 2;
+            break;
+        case NVG_BEZIERTO:
+            ncoords = 6;
+            break;
+        case NVG_WINDING:
+            cache->key[n++] = (int)ctx->commands[i + 1];
+            i++;
+            break;
+        }
+        for (j = 0; j < ncoords; j += 2)
+        {
+            cache->key[n++] = nvg__quantizeCoord(ctx->commands[i + 1 + j] - ox);
+            cache->key[n++] = nvg__quantizeCoord(ctx->commands[i + 2 + j] - oy);
+        }
+        i += 1 + ncoords;
+    }
+    return n;
+}
+
+static uint64_t nvg__hashBytes(uint64_t hash, const void* data, size_t size)
+{
+    // FNV-1a
+    const unsigned char* bytes = (const unsigned char*)data;
+    size_t               i;
+    for (i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static void nvg__tessUnlink(NVGtessCache* cache, NVGtessEntry* entry)
+{
+    if (entry->prev)
+        entry->prev->next = entry->next;
+    else
+        cache->head = entry->next;
+    if (entry->next)
+        entry->next->prev = entry->prev;
+    else
+        cache->tail = entry->prev;
+    entry->prev = entry->next = NULL;
+}
+
+static void nvg__tessPushFront(NVGtessCache* cache, NVGtessEntry* entry)
+{
+    entry->prev = NULL;
+    entry->next = cache->head;
+    if (cache->head)
+        cache->head->prev = entry;
+    cache->head = entry;
+    if (cache->tail == NULL)
+        cache->tail = entry;
+}
+
+static void nvg__tessFreeEntry(NVGtessCache* cache, NVGtessEntry* entry)
+{
+    NVGtessEntry** link = &cache->buckets[entry->hash % NVG_TESS_CACHE_BUCKETS];
+    while (*link != entry)
+        link = &(*link)->chain;
+    *link = entry->chain;
+
+    nvg__tessUnlink(cache, entry);
+    cache->stats.entries--;
+    cache->stats.bytes -= entry->bytes;
+    NVG_FREE(entry->key);
+    NVG_FREE(entry->paths);
+    NVG_FREE(entry->verts);
+    NVG_FREE(entry);
+}
+
+static void nvg__tessTrim(NVGtessCache* cache)
+{
+    while (cache->tail != NULL && cache->stats.bytes > cache->budget)
+    {
+        nvg__tessFreeEntry(cache, cache->tail);
+        cache->stats.evictions++;
+    }
+}
+
+static void nvg__deleteTessCache(NVGtessCache* cache)
+{
+    if (cache == NULL)
+        return;
+    while (cache->head != NULL)
+        nvg__tessFreeEntry(cache, cache->head);
+    NVG_FREE(cache->key);
+    NVG_FREE(cache);
+}
+
+// Stores the tessellated paths in ctx->cache, with vertices made relative to (ox, oy)
+static void nvg__tessInsert(
+    NVGcontext*          ctx,
+    NVGtessCache*        cache,
+    uint64_t             hash,
+    const NVGtessParams* params,
+    int                  nkey,
+    float                ox,
+    float                oy)
+{
+    NVGpathCache* pc    = ctx->cache;
+    NVGtessEntry* entry = NULL;
+    int           i, j, nverts = 0, offset = 0;
+
+    for (i = 0; i < pc->npaths; i++)
+        nverts += pc->paths[i].nfill + pc->paths[i].nstroke;
+
+    entry = (NVGtessEntry*)NVG_MALLOC(sizeof(NVGtessEntry));
+    if (entry == NULL)
+        return;
+    memset(entry, 0, sizeof(*entry));
+    entry->key   = (int*)NVG_MALLOC(sizeof(int) * nvg__maxi(nkey, 1));
+    entry->paths = (NVGpath*)NVG_MALLOC(sizeof(NVGpath) * nvg__maxi(pc->npaths, 1));
+    entry->verts = (NVGvertex*)NVG_MALLOC(sizeof(NVGvertex) * nvg__maxi(nverts, 1));
+    if (entry->key == NULL || entry->paths == NULL || entry->verts == NULL)
+    {
+        NVG_FREE(entry->key);
+        NVG_FREE(entry->paths);
+        NVG_FREE(entry->verts);
+        NVG_FREE(entry);
+        return;
+    }
+
+    entry->hash   = hash;
+    entry->params = *params;
+    entry->nkey   = nkey;
+    memcpy(entry->key, cache->key, sizeof(int) * nkey);
+    entry->npaths    = pc->npaths;
+    entry->nverts    = nverts;
+    entry->bounds[0] = pc->bounds[0] - ox;
+    entry->bounds[1] = pc->bounds[1] - oy;
+    entry->bounds[2] = pc->bounds[2] - ox;
+    entry->bounds[3] = pc->bounds[3] - oy;
+
+    for (i = 0; i < pc->npaths; i++)
+    {
+        const NVGpath* src = &pc->paths[i];
+        NVGpath*       dst = &entry->paths[i];
+        *dst               = *src;
+        dst->fill          = (NVGvertex*)(size_t)offset;
+        for (j = 0; j < src->nfill; j++, offset++)
+        {
+            entry->verts[offset]    = src->fill[j];
+            entry->verts[offset].x -= ox;
+            entry->verts[offset].y -= oy;
+        }
+        dst->stroke = (NVGvertex*)(size_t)offset;
+        for (j = 0; j < src->nstroke; j++, offset++)
+        {
+            entry->verts[offset]    = src->stroke[j];
+            entry->verts[offset].x -= ox;
+            entry->verts[offset].y -= oy;
+        }
+    }
+
+    entry->bytes = sizeof(NVGtessEntry) + sizeof(int) * nkey + sizeof(NVGpath) * entry->npaths +
+                   sizeof(NVGvertex) * nverts;
+
+    entry->chain                                  = cache->buckets[hash % NVG_TESS_CACHE_BUCKETS];
+    cache->buckets[hash % NVG_TESS_CACHE_BUCKETS] = entry;
+    nvg__tessPushFront(cache, entry);
+    cache->stats.entries++;
+    cache->stats.bytes += entry->bytes;
+    nvg__tessTrim(cache);
+}
+
+// Copies a cache entry into the compat scratch buffers, moved back to (ox, oy)
+static const NVGpath* nvg__tessRestore(NVGcompat* compat, const NVGtessEntry* entry, float ox, float oy, float* bounds)
+{
+    int i;
+
+    if (! nvg__compatReserve(
+            (void**)&compat->scratchVerts,
+            &compat->cscratchVerts,
+            entry->nverts,
+            sizeof(NVGvertex)) ||
+        ! nvg__compatReserve(
+            (void**)&compat->scratchPaths,
+            &compat->cscratchPaths,
+            entry->npaths,
+            sizeof(NVGpath)))
+        return NULL;
+
+    for (i = 0; i < entry->nverts; i++)
+    {
+        compat->scratchVerts[i]    = entry->verts[i];
+        compat->scratchVerts[i].x += ox;
+        compat->scratchVerts[i].y += oy;
+    }
+    for (i = 0; i < entry->npaths; i++)
+    {
+        compat->scratchPaths[i]        = entry->paths[i];
+        compat->scratchPaths[i].fill   = &compat->scratchVerts[(size_t)entry->paths[i].fill];
+        compat->scratchPaths[i].stroke = &compat->scratchVerts[(size_t)entry->paths[i].stroke];
+    }
+    bounds[0] = entry->bounds[0] + ox;
+    bounds[1] = entry->bounds[1] + oy;
+    bounds[2] = entry->bounds[2] + ox;
+    bounds[3] = entry->bounds[3] + oy;
+    return compat->scratchPaths;
+}
+
+static void nvg__tessExpand(NVGcontext* ctx, NVGcompat* compat, const NVGtessParams* params)
+{
+    NVGtelemetry* telemetry = compat != NULL ? compat->telemetry : NULL;
+    long long     start     = telemetry ? nvg__nowNs() : 0;
+    long long     flattened;
+    float         tessTol = ctx->tessTol, distTol = ctx->distTol;
+
+    // Round joins & caps are divided by tessTol too, so it stays swapped in through the expansion
+    ctx->tessTol = params->tessTol;
+    ctx->distTol = params->distTol;
+    if (compat != NULL && compat->simdFlatten)
+        nvg__flattenPathsSIMD(ctx);
+    else
+        nvg__flattenPaths(ctx);
+    flattened = telemetry ? nvg__nowNs() : 0;
+
+    if (params->stroke && compat != NULL && compat->simdStroke)
+        nvg__expandStrokeSIMD(
+            ctx,
+            compat,
+            params->w,
+            params->antiAlias ? params->fringe : 0.0f,
+            params->lineCap,
+            params->lineJoin,
+            params->miterLimit);
+    else if (params->stroke)
+        nvg__expandStroke(
+            ctx,
+            params->w,
+            params->antiAlias ? params->fringe : 0.0f,
+            params->lineCap,
+            params->lineJoin,
+            params->miterLimit);
+    else
+        nvg__expandFill(ctx, params->antiAlias ? params->fringe : 0.0f, NVG_MITER, 2.4f);
+    ctx->tessTol = tessTol;
+    ctx->distTol = distTol;
+
+    if (telemetry)
+    {
+        long long expanded            = nvg__nowNs();
+        telemetry->current.flattenNs += flattened - start;
+        if (params->stroke)
+            telemetry->current.expandStrokeNs += expanded - flattened;
+        else
+            telemetry->current.expandFillNs += expanded - flattened;
+    }
+}
+
+// Flattens and expands the current path, or restores the result from the tessellation cache when `cached` is set
+// and the cache is enabled. Writes the number of paths to `npaths` and their bounds to `bounds`.
+static const NVGpath* nvg__tessellate(
+    NVGcontext*          ctx,
+    const NVGtessParams* params,
+    int                  cached,
+    int*                 npaths,
+    float*               bounds)
+{
+    NVGcompat*    compat = nvg__compat(ctx);
+    NVGtessCache* cache  = compat != NULL && cached ? compat->tessCache : NULL;
+    NVGtessEntry* entry;
+    uint64_t      hash;
+    float         ox = 0.0f, oy = 0.0f;
+    int           nkey;
+
+    if (cache != NULL && ctx->ncommands >= 3 && (int)ctx->commands[0] == NVG_MOVETO)
+    {
+        ox   = ctx->commands[1];
+        oy   = ctx->commands[2];
+        nkey = nvg__tessKey(ctx, cache, ox, oy);
+        if (nkey >= 0)
+        {
+            hash = nvg__hashBytes(14695981039346656037ull, params, sizeof(*params));
+            hash = nvg__hashBytes(hash, cache->key, sizeof(int) * nkey);
+
+            for (entry = cache->buckets[hash % NVG_TESS_CACHE_BUCKETS]; entry != NULL; entry = entry->chain)
+            {
+                if (entry->hash == hash && entry->nkey == nkey &&
+                    memcmp(&entry->params, params, sizeof(*params)) == 0 &&
+                    memcmp(entry->key, cache->key, sizeof(int) * nkey) == 0)
+                {
+                    const NVGpath* paths = nvg__tessRestore(compat, entry, ox, oy, bounds);
+                    if (paths == NULL)
+                        break;
+                    nvg__tessUnlink(cache, entry);
+                    nvg__tessPushFront(cache, entry);
+                    cache->stats.hits++;
+                    *npaths = entry->npaths;
+                    return paths;
+                }
+            }
+
+            cache->stats.misses++;
+            nvg__tessExpand(ctx, compat, params);
+            nvg__tessInsert(ctx, cache, hash, params, nkey, ox, oy);
+            *npaths = ctx->cache->npaths;
+            memcpy(bounds, ctx->cache->bounds, sizeof(float) * 4);
+            return ctx->cache->paths;
+        }
+    }
+
+    nvg__tessExpand(ctx, compat, params);
+    *npaths = ctx->cache->npaths;
+    memcpy(bounds, ctx->cache->bounds, sizeof(float) * 4);
+    return ctx->cache->paths;
+}
+
+static void nvg__tessParams(NVGcontext* ctx, NVGtessParams* params, int stroke, float fringe, float w)
+{
+    NVGstate*  state  = nvg__getState(ctx);
+    NVGcompat* compat = nvg__compat(ctx);
+
+    // Zeroed so padding hashes consistently
+    memset(params, 0, sizeof(*params));
+    params->stroke    = stroke;
+    params->antiAlias = ctx->params.edgeAntiAlias && state->shapeAntiAlias;
+    params->tessTol   = ctx->tessTol;
+    params->distTol   = ctx->distTol;
+    params->fringe    = fringe;
+    params->scale     = (int)floorf(nvg__getAverageScale(state->xform) * 64.0f + 0.5f);
+    if (stroke)
+    {
+        params->w          = w;
+        params->lineCap    = state->lineCap;
+        params->lineJoin   = state->lineJoin;
+        params->miterLimit = state->miterLimit;
+    }
+    if (compat != NULL)
+        params->simd = (compat->simdFlatten ? 1 : 0) | (compat->simdStroke ? 2 : 0);
+    if (compat != NULL && compat->lod != NULL && compat->recording == NULL)
+        nvg__lodTolerance(ctx, compat, &params->tessTol, &params->distTol);
+}
+
+void nvgSimdTessellation(NVGcontext* ctx, int flatten, int stroke)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    if (compat == NULL)
+        return;
+    compat->simdFlatten = flatten;
+    compat->simdStroke  = stroke;
+}
+
+void nvgTessellationCacheBudget(NVGcontext* ctx, int budgetBytes)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    if (compat == NULL)
+        return;
+
+    if (budgetBytes <= 0)
+    {
+        nvg__deleteTessCache(compat->tessCache);
+        compat->tessCache = NULL;
+        return;
+    }
+    if (compat->tessCache == NULL)
+    {
+        compat->tessCache = (NVGtessCache*)nvg__compatMalloc(compat, sizeof(NVGtessCache));
+        if (compat->tessCache == NULL)
+            return;
+        memset(compat->tessCache, 0, sizeof(NVGtessCache));
+    }
+    compat->tessCache->budget = (size_t)budgetBytes;
+    nvg__tessTrim(compat->tessCache);
+}
+
+NanoVGTessCacheStats nvgGetTessellationCacheStats(NVGcontext* ctx)
+{
+    NanoVGTessCacheStats stats;
+    NVGcompat*           compat = nvg__compat(ctx);
+    memset(&stats, 0, sizeof(stats));
+    if (compat != NULL && compat->tessCache != NULL)
+        stats = compat->tessCache->stats;
+    return stats;
+}
+
+static void nvg__fill(NVGcontext* ctx, const NVGpaint* paint, float fringeWidth, int cached)
+{
+    NVGstate*      state     = nvg__getState(ctx);
+    NVGpaint       fillPaint = *paint;
+    NVGtessParams  params;
+    const NVGpath* paths;
+    float          bounds[4];
+    int            i, npaths = 0;
+
+    // The antialiasing fringe reaches half its width out of the path
+    if (nvg__cullPath(ctx, fringeWidth * 0.5f))
+        return;
+
+    nvg__tessParams(ctx, &params, 0, fringeWidth, 0.0f);
+    paths = nvg__tessellate(ctx, &params, cached, &npaths, bounds);
+
+    // Apply global alpha
+    fillPaint.innerColor.a *= state->alpha;
+    fillPaint.outerColor.a *= state->alpha;
+
+    ctx->params.renderFill(
+        ctx->params.userPtr,
+        &fillPaint,
+        state->compositeOperation,
+        &state->scissor,
+        fringeWidth,
+        bounds,
+        paths,
+        npaths);
+
+    // Count triangles
+    for (i = 0; i < npaths; i++)
+    {
+        ctx->fillTriCount  += paths[i].nfill - 2;
+        ctx->fillTriCount  += paths[i].nstroke - 2;
+        ctx->drawCallCount += 2;
+    }
+}
+
+static void nvg__stroke(NVGcontext* ctx, float fringeWidth, int cached)
+{
+    NVGstate*      state       = nvg__getState(ctx);
+    float          scale       = nvg__getAverageScale(state->xform);
+    float          strokeWidth = nvg__clampf(state->strokeWidth * scale, 0.0f, 200.0f);
+    NVGpaint       strokePaint = state->stroke;
+    NVGtessParams  params;
+    const NVGpath* paths;
+    float          bounds[4];
+    int            i, npaths = 0;
+
+    if (strokeWidth < fringeWidth)
+    {
+        // If the stroke width is less than pixel size, use alpha to emulate
+        // coverage. Since coverage is area, scale by alpha*alpha.
+        float alpha               = nvg__clampf(strokeWidth / fringeWidth, 0.0f, 1.0f);
+        strokePaint.innerColor.a *= alpha * alpha;
+        strokePaint.outerColor.a *= alpha * alpha;
+        strokeWidth               = fringeWidth;
+    }
+
+    // Miter joins reach up to miterLimit half widths out of the path, square caps sqrt(2)
+    if (nvg__cullPath(ctx, strokeWidth * 0.5f * nvg__maxf(state->miterLimit, 1.5f) + fringeWidth))
+        return;
+
+    // Apply global alpha
+    strokePaint.innerColor.a *= state->alpha;
+    strokePaint.outerColor.a *= state->alpha;
+
+    nvg__tessParams(ctx, &params, 1, fringeWidth, strokeWidth * 0.5f);
+    paths = nvg__tessellate(ctx, &params, cached, &npaths, bounds);
+
+    ctx->params.renderStroke(
+        ctx->params.userPtr,
+        &strokePaint,
+        state->compositeOperation,
+        &state->scissor,
+        fringeWidth,
+        strokeWidth,
+        paths,
+        npaths);
+
+    // Count triangles
+    for (i = 0; i < npaths; i++)
+    {
+        ctx->strokeTriCount += paths[i].nstroke - 2;
+        ctx->drawCallCount++;
+    }
+}
+
+void nvgFill(NVGcontext* ctx) { nvg__fill(ctx, &nvg__getState(ctx)->fill, ctx->fringeWidth, 0); }
+
+void nvgFillCached(NVGcontext* ctx) { nvg__fill(ctx, &nvg__getState(ctx)->fill, ctx->fringeWidth, 1); }
+
+void nvgStroke(NVGcontext* ctx) { nvg__stroke(ctx, ctx->fringeWidth, 0); }
+
+void nvgStrokeCached(NVGcontext* ctx) { nvg__stroke(ctx, ctx->fringeWidth, 1); }
+
+void nvgStrokeBlur(NVGcontext* ctx, float fringeWidth)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    // Over the governor's budget with tolerances as coarse as they go
+    if (compat != NULL && compat->lod != NULL && compat->lod->stats.skipBlur)
+        fringeWidth = ctx->fringeWidth;
+    nvg__stroke(ctx, fringeWidth, 1);
+}
+
+NVGpaint nvgBoxShadow(
+    NVGcontext* ctx,
+    float       x,
+    float       y,
+    float       w,
+    float       h,
+    float       r,
+    float       blur,
+    NVGcolor    icol,
+    NVGcolor    ocol)
+{
+    NVGpaint paint;
+    if (blur <= 0.0f)
+        return nvgBoxGradient(ctx, x, y, w, h, r, 1.0f, icol, ocol);
+#if NVG_COMPAT_BLUR_PAINT
+    paint         = nvgBoxGradient(ctx, x, y, w, h, nvg__minf(r, nvg__minf(w, h) * 0.5f), 1.0f, icol, ocol);
+    paint.feather = -blur;
+#else
+    // Same slope at the edge as the Gaussian profile, 1 / (sigma * sqrt(2 pi))
+    paint = nvgBoxGradient(ctx, x, y, w, h, r, blur * 2.5066283f, icol, ocol);
+#endif
+    return paint;
+}
+
+void nvgShadow(NVGcontext* ctx, float x, float y, float w, float h, float r, float blur, NVGcolor color)
+{
+    NVGstate* state          = nvg__getState(ctx);
+    NVGpaint  paint          = nvgBoxShadow(ctx, x, y, w, h, r, blur, color, nvgRGBAf(color.r, color.g, color.b, 0.0f));
+    float     pad            = nvg__maxf(blur * 3.0f, 0.5f);
+    int       shapeAntiAlias = state->shapeAntiAlias;
+
+    nvgTransformMultiply(paint.xform, state->xform);
+    nvgBeginPath(ctx);
+    nvgRect(ctx, x - pad, y - pad, w + pad * 2.0f, h + pad * 2.0f);
+    // The paint fades out within the quad, it needs no fringe
+    state->shapeAntiAlias = 0;
+    nvg__fill(ctx, &paint, ctx->fringeWidth, 1);
+    state->shapeAntiAlias = shapeAntiAlias;
+}
+
+void nvgFillBlur(NVGcontext* ctx, float blur)
+{
+    NVGstate* state = nvg__getState(ctx);
+    NVGpaint  paint = state->fill;
+    float     sigma = blur * nvg__getAverageScale(state->xform);
+
+    if (sigma <= 0.0f)
+    {
+        nvg__fill(ctx, &paint, ctx->fringeWidth, 1);
+        return;
+    }
+#if NVG_COMPAT_BLUR_PAINT
+    // Solid colours get a Gaussian edge, the backend maps the coverage of a fringe spanning -3 to 3 sigma through erf
+    if (paint.image == 0 && paint.extent[0] == 0.0f && paint.extent[1] == 0.0f)
+    {
+        paint.feather = -1.0f;
+        nvg__fill(ctx, &paint, sigma * 6.0f, 1);
+        return;
+    }
+#endif
+    // Linear fringe with the slope of the Gaussian profile at the edge
+    nvg__fill(ctx, &paint, sigma * 2.5066283f, 1);
+}
+
+void nvgFillRoundedRectFast(NVGcontext* ctx, float x, float y, float w, float h, float r)
+{
+    NVGstate* state          = nvg__getState(ctx);
+    NVGpaint  paint          = state->fill;
+    float     scale          = nvg__getAverageScale(state->xform);
+    int       shapeAntiAlias = state->shapeAntiAlias;
+    float     feather;
+
+    // Gradients & images need their own paint, aliased shapes have no fringe to replace
+    if (paint.image != 0 || paint.extent[0] != 0.0f || paint.extent[1] != 0.0f || ! ctx->params.edgeAntiAlias ||
+        ! shapeAntiAlias || scale <= 0.0f)
+    {
+        nvgBeginPath(ctx);
+        nvgRoundedRect(ctx, x, y, w, h, r);
+        nvg__fill(ctx, &paint, ctx->fringeWidth, 1);
+        return;
+    }
+
+    if (w < 0.0f)
+    {
+        x += w;
+        w  = -w;
+    }
+    if (h < 0.0f)
+    {
+        y += h;
+        h  = -h;
+    }
+    // Coverage ramps over one device pixel centred on the edge, like the fringe of a fill
+    feather = ctx->fringeWidth / scale;
+    paint   = nvgBoxGradient(
+        ctx,
+        x,
+        y,
+        w,
+        h,
+        nvg__clampf(r, 0.0f, nvg__minf(w, h) * 0.5f),
+        feather,
+        paint.innerColor,
+        nvgRGBAf(paint.innerColor.r, paint.innerColor.g, paint.innerColor.b, 0.0f));
+    // nvgBoxGradient clamps the feather to 1, which would be 2 device pixels wide on a high DPI display
+    paint.feather = feather;
+
+    nvgTransformMultiply(paint.xform, state->xform);
+    nvgBeginPath(ctx);
+    nvgRect(ctx, x - feather, y - feather, w + feather * 2.0f, h + feather * 2.0f);
+    state->shapeAntiAlias = 0;
+    nvg__fill(ctx, &paint, ctx->fringeWidth, 1);
+    state->shapeAntiAlias = shapeAntiAlias;
+}
+
+void nvgFillRectFast(NVGcontext* ctx, float x, float y, float w, float h)
+{
+    nvgFillRoundedRectFast(ctx, x, y, w, h, 0.0f);
+}
+
+void nvgFillCircleFast(NVGcontext* ctx, float cx, float cy, float r)
+{
+    nvgFillRoundedRectFast(ctx, cx - r, cy - r, r * 2.0f, r * 2.0f, r);
+}
+
+//
+// Text run cache
+//
+// Runs are laid out at the sub pixel part of their origin, in font pixels, so the cached quads only need the whole
+// pixel part added back when drawn. Atlas coordinates are only valid for the atlas texture they were laid out against,
+// so the cache is emptied whenever ctx->fontImages[ctx->fontImageIdx] or the atlas size changes.
+//
+
+#define NVG_TEXT_CACHE_BUCKETS 512
+
+typedef struct NVGtextKey
+{
+    int   fontId;
+    int   align;
+    float size;
+    float spacing;
+    float blur;
+    // Sub pixel part of the origin, in font pixels
+    float fx;
+    float fy;
+    int   length;
+} NVGtextKey;
+
+typedef struct NVGtextEntry
+{
+    uint64_t             hash;
+    NVGtextKey           key;
+    char*                string;
+    FONSquad*            quads;
+    int                  nquads;
+    float                nextx; // Relative to the whole pixel origin
+    size_t               bytes;
+    struct NVGtextEntry* chain;
+    struct NVGtextEntry* prev;
+    struct NVGtextEntry* next;
+} NVGtextEntry;
+
+typedef struct NVGtextCache
+{
+    NVGtextEntry*        buckets[NVG_TEXT_CACHE_BUCKETS];
+    NVGtextEntry*        head; // Most recently used
+    NVGtextEntry*        tail;
+    size_t               budget;
+    int                  atlasImage;
+    int                  atlasWidth;
+    int                  atlasHeight;
+    FONSquad*            quads;
+    int                  cquads;
+    NanoVGTextCacheStats stats;
+} NVGtextCache;
+
+static void nvg__textUnlink(NVGtextCache* cache, NVGtextEntry* entry)
+{
+    if (entry->prev)
+        entry->prev->next = entry->next;
+    else
+        cache->head = entry->next;
+    if (entry->next)
+        entry->next->prev = entry->prev;
+    else
+        cache->tail = entry->prev;
+    entry->prev = entry->next = NULL;
+}
+
+static void nvg__textPushFront(NVGtextCache* cache, NVGtextEntry* entry)
+{
+    entry->prev = NULL;
+    entry->next = cache->head;
+    if (cache->head)
+        cache->head->prev = entry;
+    cache->head = entry;
+    if (cache->tail == NULL)
+        cache->tail = entry;
+}
+
+static void nvg__textFreeEntry(NVGtextCache* cache, NVGtextEntry* entry)
+{
+    NVGtextEntry** link = &cache->buckets[entry->hash % NVG_TEXT_CACHE_BUCKETS];
+    while (*link != entry)
+        link = &(*link)->chain;
+    *link = entry->chain;
+
+    nvg__textUnlink(cache, entry);
+    cache->stats.entries--;
+    cache->stats.bytes -= entry->bytes;
+    NVG_FREE(entry->string);
+    NVG_FREE(entry->quads);
+    NVG_FREE(entry);
+}
+
+static void nvg__textTrim(NVGtextCache* cache)
+{
+    while (cache->tail != NULL && cache->stats.bytes > cache->budget)
+    {
+        nvg__textFreeEntry(cache, cache->tail);
+        cache->stats.evictions++;
+    }
+}
+
+static void nvg__deleteTextCache(NVGtextCache* cache)
+{
+    if (cache == NULL)
+        return;
+    while (cache->head != NULL)
+        nvg__textFreeEntry(cache, cache->head);
+    NVG_FREE(cache->quads);
+    NVG_FREE(cache);
+}
+
+// Empties the cache when the font atlas texture was replaced by nvg__allocTextAtlas since the last call
+static void nvg__textValidate(NVGcontext* ctx, NVGtextCache* cache)
+{
+    int image = ctx->fontImages[ctx->fontImageIdx];
+    int width = 0, height = 0;
+
+    fonsGetAtlasSize(ctx->fs, &width, &height);
+    if (image == cache->atlasImage && width == cache->atlasWidth && height == cache->atlasHeight)
+        return;
+
+    if (cache->head != NULL)
+        cache->stats.invalidations++;
+    while (cache->head != NULL)
+        nvg__textFreeEntry(cache, cache->head);
+    cache->atlasImage  = image;
+    cache->atlasWidth  = width;
+    cache->atlasHeight = height;
+}
+
+static void nvg__textInsert(
+    NVGtextCache*     cache,
+    uint64_t          hash,
+    const NVGtextKey* key,
+    const char*       string,
+    int               nquads,
+    float             nextx)
+{
+    NVGtextEntry* entry = (NVGtextEntry*)NVG_MALLOC(sizeof(NVGtextEntry));
+    if (entry == NULL)
+        return;
+    memset(entry, 0, sizeof(*entry));
+    entry->string = (char*)NVG_MALLOC(nvg__maxi(key->length, 1));
+    entry->quads  = (FONSquad*)NVG_MALLOC(sizeof(FONSquad) * nvg__maxi(nquads, 1));
+    if (entry->string == NULL || entry->quads == NULL)
+    {
+        NVG_FREE(entry->string);
+        NVG_FREE(entry->quads);
+        NVG_FREE(entry);
+        return;
+    }
+
+    entry->hash   = hash;
+    entry->key    = *key;
+    entry->nquads = nquads;
+    entry->nextx  = nextx;
+    entry->bytes  = sizeof(NVGtextEntry) + key->length + sizeof(FONSquad) * nquads;
+    memcpy(entry->string, string, key->length);
+    memcpy(entry->quads, cache->quads, sizeof(FONSquad) * nquads);
+
+    entry->chain                                  = cache->buckets[hash % NVG_TEXT_CACHE_BUCKETS];
+    cache->buckets[hash % NVG_TEXT_CACHE_BUCKETS] = entry;
+    nvg__textPushFront(cache, entry);
+    cache->stats.entries++;
+    cache->stats.bytes += entry->bytes;
+    nvg__textTrim(cache);
+}
+
+// Transforms quads laid out relative to the whole pixel origin (ox, oy) and draws them with the font atlas, the same
+// way nvgText does
+static void nvg__textEmit(NVGcontext* ctx, const FONSquad* quads, int nquads, float ox, float oy, float invscale)
+{
+    NVGstate*  state     = nvg__getState(ctx);
+    int        isFlipped = nvg__isTransformFlipped(state->xform);
+    NVGvertex* verts     = nvg__allocTempVerts(ctx, nvg__maxi(nquads, 1) * 6);
+    int        i, nverts = 0;
+
+    if (verts == NULL)
+        return;
+
+    for (i = 0; i < nquads; i++)
+    {
+        FONSquad q = quads[i];
+        float    c[4 * 2];
+        q.x0 += ox;
+        q.x1 += ox;
+        q.y0 += oy;
+        q.y1 += oy;
+        if (isFlipped)
+        {
+            float tmp;
+            tmp  = q.y0;
+            q.y0 = q.y1;
+            q.y1 = tmp;
+            tmp  = q.t0;
+            q.t0 = q.t1;
+            q.t1 = tmp;
+        }
+        // Transform corners
+        nvgTransformPoint(&c[0], &c[1], state->xform, q.x0 * invscale, q.y0 * invscale);
+        nvgTransformPoint(&c[2], &c[3], state->xform, q.x1 * invscale, q.y0 * invscale);
+        nvgTransformPoint(&c[4], &c[5], state->xform, q.x1 * invscale, q.y1 * invscale);
+        nvgTransformPoint(&c[6], &c[7], state->xform, q.x0 * invscale, q.y1 * invscale);
+        // Create triangles
+        nvg__vset(&verts[nverts++], c[0], c[1], q.s0, q.t0);
+        nvg__vset(&verts[nverts++], c[4], c[5], q.s1, q.t1);
+        nvg__vset(&verts[nverts++], c[2], c[3], q.s1, q.t0);
+        nvg__vset(&verts[nverts++], c[0], c[1], q.s0, q.t0);
+        nvg__vset(&verts[nverts++], c[6], c[7], q.s0, q.t1);
+        nvg__vset(&verts[nverts++], c[4], c[5], q.s1, q.t1);
+    }
+
+    nvg__flushTextTexture(ctx);
+    nvg__renderText(ctx, verts, nverts);
+}
+
+static float nvg__textCached(
+    NVGcontext*   ctx,
+    NVGtextCache* cache,
+    float         x,
+    float         y,
+    const char*   string,
+    const char*   end)
+{
+    NVGstate*     state    = nvg__getState(ctx);
+    float         scale    = nvg__getFontScale(state) * ctx->devicePxRatio;
+    float         invscale = 1.0f / scale;
+    float         ox       = floorf(x * scale);
+    float         oy       = floorf(y * scale);
+    FONStextIter  iter, prevIter;
+    FONSquad      q;
+    NVGtextKey    key;
+    NVGtextEntry* entry;
+    uint64_t      hash;
+    int           nquads = 0, cacheable = 1;
+
+    if (end == NULL)
+        end = string + strlen(string);
+    if (state->fontId == FONS_INVALID)
+        return x;
+
+    nvg__textValidate(ctx, cache);
+
+    // Zeroed so padding hashes consistently
+    memset(&key, 0, sizeof(key));
+    key.fontId  = state->fontId;
+    key.align   = state->textAlign;
+    key.size    = state->fontSize * scale;
+    key.spacing = state->letterSpacing * scale;
+    key.blur    = state->fontBlur * scale;
+    key.fx      = x * scale - ox;
+    key.fy      = y * scale - oy;
+    key.length  = (int)(end - string);
+
+    hash = nvg__hashBytes(14695981039346656037ull, &key, sizeof(key));
+    hash = nvg__hashBytes(hash, string, key.length);
+
+    for (entry = cache->buckets[hash % NVG_TEXT_CACHE_BUCKETS]; entry != NULL; entry = entry->chain)
+    {
+        if (entry->hash == hash && memcmp(&entry->key, &key, sizeof(key)) == 0 &&
+            memcmp(entry->string, string, key.length) == 0)
+        {
+            nvg__textUnlink(cache, entry);
+            nvg__textPushFront(cache, entry);
+            cache->stats.hits++;
+            nvg__textEmit(ctx, entry->quads, entry->nquads, ox, oy, invscale);
+            return (ox + entry->nextx) / scale;
+        }
+    }
+
+    // Conservative, a glyph takes at least one byte
+    if (! nvg__compatReserve((void**)&cache->quads, &cache->cquads, nvg__maxi(2, key.length), sizeof(FONSquad)))
+        return nvg__nanovgText(ctx, x, y, string, end);
+    cache->stats.misses++;
+
+    fonsSetSize(ctx->fs, key.size);
+    fonsSetSpacing(ctx->fs, key.spacing);
+    fonsSetBlur(ctx->fs, key.blur);
+    fonsSetAlign(ctx->fs, key.align);
+    fonsSetFont(ctx->fs, key.fontId);
+
+    fonsTextIterInit(ctx->fs, &iter, key.fx, key.fy, string, end, FONS_GLYPH_BITMAP_REQUIRED);
+    prevIter = iter;
+    while (fonsTextIterNext(ctx->fs, &iter, &q))
+    {
+        if (iter.prevGlyphIndex == -1)
+        {
+            // The atlas is full. Draw what was laid out against it before it is replaced, the rest of the run can't
+            // be cached as its quads would point into two different atlases.
+            if (nquads != 0)
+                nvg__textEmit(ctx, cache->quads, nquads, ox, oy, invscale);
+            nquads    = 0;
+            cacheable = 0;
+            if (! nvg__allocTextAtlas(ctx))
+                break;
+            iter = prevIter;
+            fonsTextIterNext(ctx->fs, &iter, &q);
+            if (iter.prevGlyphIndex == -1)
+                break;
+        }
+        prevIter               = iter;
+        cache->quads[nquads++] = q;
+    }
+
+    nvg__textEmit(ctx, cache->quads, nquads, ox, oy, invscale);
+    if (cacheable)
+        nvg__textInsert(cache, hash, &key, string, nquads, iter.nextx);
+    return (ox + iter.nextx) / scale;
+}
+
+static float nvg__text(NVGcontext* ctx, float x, float y, const char* string, const char* end)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    if (compat == NULL || compat->textCache == NULL)
+        return nvg__nanovgText(ctx, x, y, string, end);
+    return nvg__textCached(ctx, compat->textCache, x, y, string, end);
+}
+
+// Same as nanovg's nvgTextBox, with the rows drawn through the text run cache
+static void nvg__textBox(NVGcontext* ctx, float x, float y, float breakRowWidth, const char* string, const char* end)
+{
+    NVGcompat* compat   = nvg__compat(ctx);
+    NVGstate*  state    = nvg__getState(ctx);
+    int        oldAlign = state->textAlign;
+    int        halign   = oldAlign & (NVG_ALIGN_LEFT | NVG_ALIGN_CENTER | NVG_ALIGN_RIGHT);
+    int        valign   = oldAlign & (NVG_ALIGN_TOP | NVG_ALIGN_MIDDLE | NVG_ALIGN_BOTTOM | NVG_ALIGN_BASELINE);
+    float      lineh    = 0;
+    NVGtextRow rows[2];
+    int        nrows = 0, i;
+
+    if (compat == NULL || compat->textCache == NULL)
+    {
+        nvg__nanovgTextBox(ctx, x, y, breakRowWidth, string, end);
+        return;
+    }
+    if (state->fontId == FONS_INVALID)
+        return;
+
+    nvgTextMetrics(ctx, NULL, NULL, &lineh);
+
+    state->textAlign = NVG_ALIGN_LEFT | valign;
+
+    while ((nrows = nvgTextBreakLines(ctx, string, end, breakRowWidth, rows, 2)))
+    {
+        for (i = 0; i < nrows; i++)
+        {
+            NVGtextRow* row = &rows[i];
+            if (halign & NVG_ALIGN_LEFT)
+                nvg__textCached(ctx, compat->textCache, x, y, row->start, row->end);
+            else if (halign & NVG_ALIGN_CENTER)
+                nvg__textCached(
+                    ctx,
+                    compat->textCache,
+                    x + breakRowWidth * 0.5f - row->width * 0.5f,
+                    y,
+                    row->start,
+                    row->end);
+            else if (halign & NVG_ALIGN_RIGHT)
+                nvg__textCached(ctx, compat->textCache, x + breakRowWidth - row->width, y, row->start, row->end);
+            y += lineh * state->lineHeight;
+        }
+        string = rows[nrows - 1].next;
+    }
+
+    state->textAlign = oldAlign;
+}
+
+void nvgTextCacheBudget(NVGcontext* ctx, int budgetBytes)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    if (compat == NULL)
+        return;
+
+    if (budgetBytes <= 0)
+    {
+        nvg__deleteTextCache(compat->textCache);
+        compat->textCache = NULL;
+        return;
+    }
+    if (compat->textCache == NULL)
+    {
+        compat->textCache = (NVGtextCache*)nvg__compatMalloc(compat, sizeof(NVGtextCache));
+        if (compat->textCache == NULL)
+            return;
+        memset(compat->textCache, 0, sizeof(NVGtextCache));
+    }
+    else
+    {
+        // Also drops runs laid out before a fallback font was added
+        while (compat->textCache->head != NULL)
+            nvg__textFreeEntry(compat->textCache, compat->textCache->head);
+    }
+    compat->textCache->budget = (size_t)budgetBytes;
+}
+
+NanoVGTextCacheStats nvgGetTextCacheStats(NVGcontext* ctx)
+{
+    NanoVGTextCacheStats stats;
+    NVGcompat*           compat = nvg__compat(ctx);
+    memset(&stats, 0, sizeof(stats));
+    if (compat != NULL && compat->textCache != NULL)
+        stats = compat->textCache->stats;
+    return stats;
+}
+
+float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char* end)
+{
+    NVGtelemetry* telemetry = nvg__telemetry(ctx);
+    long long     start;
+    float         advance;
+    if (telemetry == NULL)
+        return nvg__text(ctx, x, y, string, end);
+
+    start                      = nvg__nowNs();
+    advance                    = nvg__text(ctx, x, y, string, end);
+    telemetry->current.textNs += nvg__nowNs() - start;
+    return advance;
+}
+
+void nvgTextBox(NVGcontext* ctx, float x, float y, float breakRowWidth, const char* string, const char* end)
+{
+    NVGtelemetry* telemetry = nvg__telemetry(ctx);
+    long long     start;
+    if (telemetry == NULL)
+    {
+        nvg__textBox(ctx, x, y, breakRowWidth, string, end);
+        return;
+    }
+
+    start = nvg__nowNs();
+    nvg__textBox(ctx, x, y, breakRowWidth, string, end);
+    telemetry->current.textNs += nvg__nowNs() - start;
+}
+
+//
+// Glyph atlas files
+//
+// A file is the header, the atlas pixels, the fontstash skyline nodes, then each font's NVGglyphAtlasFont followed by
+// its glyphs. Everything is stored in the layout of this build, checked through the sizes in the header.
+//
+
+#define NVG_GLYPH_ATLAS_MAGIC 0x4147564e // "NVGA"
+#define NVG_GLYPH_ATLAS_VERSION 1
+
+typedef struct NVGglyphAtlasHeader
+{
+    unsigned int magic;
+    int          version;
+    int          glyphSize;
+    int          nodeSize;
+    int          width;
+    int          height;
+    int          nnodes;
+    int          nfonts;
+} NVGglyphAtlasHeader;
+
+typedef struct NVGglyphAtlasFont
+{
+    char name[64];
+    int  dataSize;
+    int  nglyphs;
+} NVGglyphAtlasFont;
+
+typedef struct NVGmappedFile
+{
+    const unsigned char* data;
+    size_t               size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+} NVGmappedFile;
+
+static int nvg__mapFile(NVGmappedFile* file, const char* path)
+{
+#ifdef _WIN32
+    LARGE_INTEGER size;
+
+    memset(file, 0, sizeof(*file));
+    file->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file->file == INVALID_HANDLE_VALUE)
+        return 0;
+    if (GetFileSizeEx(file->file, &size) && size.QuadPart > 0)
+        file->mapping = CreateFileMappingA(file->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (file->mapping != NULL)
+        file->data = (const unsigned char*)MapViewOfFile(file->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (file->data == NULL)
+    {
+        if (file->mapping != NULL)
+            CloseHandle(file->mapping);
+        CloseHandle(file->file);
+        return 0;
+    }
+    file->size = (size_t)size.QuadPart;
+    return 1;
+#else
+    struct stat st;
+    void*       data;
+    int         fd = open(path, O_RDONLY);
+
+    memset(file, 0, sizeof(*file));
+    if (fd < 0)
+        return 0;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return 0;
+    }
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file alive
+    close(fd);
+    if (data == MAP_FAILED)
+        return 0;
+    file->data = (const unsigned char*)data;
+    file->size = (size_t)st.st_size;
+    return 1;
+#endif
+}
+
+static void nvg__unmapFile(NVGmappedFile* file)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(file->data);
+    CloseHandle(file->mapping);
+    CloseHandle(file->file);
+#else
+    munmap((void*)file->data, file->size);
+#endif
+}
+
+// Returns the next `size` bytes of the file and moves `offset` past them, or NULL when the file is too short
+static const unsigned char* nvg__readMapped(const NVGmappedFile* file, size_t* offset, size_t size)
+{
+    const unsigned char* data;
+    if (size > file->size - *offset)
+        return NULL;
+    data     = file->data + *offset;
+    *offset += size;
+    return data;
+}
+
+// Makes `image` the only font image, deleting the ones nanovg created
+static void nvg__setFontImage(NVGcontext* ctx, int image)
+{
+    int i;
+    for (i = 0; i < NVG_MAX_FONTIMAGES; i++)
+    {
+        if (ctx->fontImages[i] != 0)
+            nvgDeleteImage(ctx, ctx->fontImages[i]);
+        ctx->fontImages[i] = 0;
+    }
+    ctx->fontImages[0] = image;
+    ctx->fontImageIdx  = 0;
+}
+
+// Doubles the smaller side of the fontstash atlas, keeping its glyphs, and gives nanovg a font image of the new size
+static int nvg__growFontAtlas(NVGcontext* ctx, int* width, int* height)
+{
+    FONScontext* stash = ctx->fs;
+    int          w = *width, h = *height;
+    int          image;
+
+    if (w >= NVG_MAX_FONTIMAGE_SIZE && h >= NVG_MAX_FONTIMAGE_SIZE)
+        return 0;
+    if ((w > h || w >= NVG_MAX_FONTIMAGE_SIZE) && h < NVG_MAX_FONTIMAGE_SIZE)
+        h *= 2;
+    else
+        w *= 2;
+
+    image = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, w, h, 0, NULL);
+    if (image == 0)
+        return 0;
+    if (! fonsExpandAtlas(stash, w, h))
+    {
+        nvgDeleteImage(ctx, image);
+        return 0;
+    }
+    nvg__setFontImage(ctx, image);
+
+    // The new image is empty, upload the whole atlas with the next nvg__flushTextTexture
+    stash->dirtyRect[0] = 0;
+    stash->dirtyRect[1] = 0;
+    stash->dirtyRect[2] = w;
+    stash->dirtyRect[3] = h;
+    *width              = w;
+    *height             = h;
+    return 1;
+}
+
+// Whether the glyph of `codepoint` exists in `font` or one of its fallbacks, fontstash draws .notdef otherwise
+static int nvg__hasGlyph(FONScontext* stash, FONSfont* font, unsigned int codepoint)
+{
+    int i;
+    if (fons__tt_getGlyphIndex(&font->font, (int)codepoint) != 0)
+        return 1;
+    for (i = 0; i < font->nfallbacks; i++)
+        if (fons__tt_getGlyphIndex(&stash->fonts[font->fallbacks[i]]->font, (int)codepoint) != 0)
+            return 1;
+    return 0;
+}
+
+int nvgBakeGlyphs(NVGcontext* ctx, int font, float size, float blur, unsigned int first, unsigned int last)
+{
+    NVGcompat*   compat = nvg__compat(ctx);
+    FONScontext* stash  = ctx->fs;
+    short        isize  = (short)(size * 10.0f);
+    short        iblur  = (short)blur;
+    int          width = 0, height = 0, baked = 0;
+    unsigned int codepoint;
+
+    if (font < 0 || font >= stash->nfonts || isize < 2 || first > last || (compat != NULL && compat->inFrame))
+        return -1;
+
+    fonsGetAtlasSize(stash, &width, &height);
+    for (codepoint = first;; codepoint++)
+    {
+        if (nvg__hasGlyph(stash, stash->fonts[font], codepoint))
+        {
+            FONSglyph* glyph =
+                fons__getGlyph(stash, stash->fonts[font], codepoint, isize, iblur, FONS_GLYPH_BITMAP_REQUIRED);
+            while (glyph == NULL && nvg__growFontAtlas(ctx, &width, &height))
+                glyph = fons__getGlyph(stash, stash->fonts[font], codepoint, isize, iblur, FONS_GLYPH_BITMAP_REQUIRED);
+            if (glyph == NULL)
+            {
+                baked = -1;
+                break;
+            }
+            baked++;
+        }
+        if (codepoint == last)
+            break;
+    }
+
+    nvg__flushTextTexture(ctx);
+    return baked;
+}
+
+int nvgSaveGlyphAtlas(NVGcontext* ctx, const char* path)
+{
+    FONScontext*        stash = ctx->fs;
+    NVGglyphAtlasHeader header;
+    FILE*               file;
+    int                 i, ok;
+
+    memset(&header, 0, sizeof(header));
+    header.magic     = NVG_GLYPH_ATLAS_MAGIC;
+    header.version   = NVG_GLYPH_ATLAS_VERSION;
+    header.glyphSize = (int)sizeof(FONSglyph);
+    header.nodeSize  = (int)sizeof(FONSatlasNode);
+    header.nnodes    = stash->atlas->nnodes;
+    header.nfonts    = stash->nfonts;
+    fonsGetAtlasSize(stash, &header.width, &header.height);
+
+    file = fopen(path, "wb");
+    if (file == NULL)
+        return 0;
+
+    ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(stash->texData, (size_t)header.width * header.height, 1, file) == 1;
+    ok = ok && fwrite(stash->atlas->nodes, sizeof(FONSatlasNode), header.nnodes, file) == (size_t)header.nnodes;
+    for (i = 0; ok && i < stash->nfonts; i++)
+    {
+        FONSfont*         font = stash->fonts[i];
+        NVGglyphAtlasFont entry;
+
+        memset(&entry, 0, sizeof(entry));
+        strncpy(entry.name, font->name, sizeof(entry.name) - 1);
+        entry.dataSize = font->dataSize;
+        entry.nglyphs  = font->nglyphs;
+        ok             = fwrite(&entry, sizeof(entry), 1, file) == 1;
+        ok             = ok && fwrite(font->glyphs, sizeof(FONSglyph), font->nglyphs, file) == (size_t)font->nglyphs;
+    }
+
+    ok = fclose(file) == 0 && ok;
+    return ok;
+}
+
+// Returns the font of the stash matching `entry`, or NULL
+static FONSfont* nvg__glyphAtlasFont(FONScontext* stash, const NVGglyphAtlasFont* entry)
+{
+    char name[sizeof(entry->name)];
+    int  id;
+
+    memcpy(name, entry->name, sizeof(name));
+    name[sizeof(name) - 1] = '\0';
+    id                     = fonsGetFontByName(stash, name);
+    if (id == FONS_INVALID || stash->fonts[id]->dataSize != entry->dataSize)
+        return NULL;
+    return stash->fonts[id];
+}
+
+// Whether the skyline nodes lie inside the atlas & cover its width without gaps, fons__atlasAddRect trusts both
+static int nvg__validGlyphAtlasNodes(const unsigned char* data, const NVGglyphAtlasHeader* header)
+{
+    int i, x = 0;
+
+    for (i = 0; i < header->nnodes; i++)
+    {
+        FONSatlasNode node;
+        memcpy(&node, data + sizeof(FONSatlasNode) * i, sizeof(node));
+        if (node.x != x || node.y < 0 || node.y > header->height || node.width < 0 ||
+            node.x + node.width > header->width)
+            return 0;
+        x = node.x + node.width;
+    }
+    return x == header->width;
+}
+
+// Whether a glyph without a bitmap (x0 < 0) or with a rect inside the atlas
+static int nvg__validGlyphAtlasRect(const FONSglyph* glyph, const NVGglyphAtlasHeader* header)
+{
+    if (glyph->x0 < 0)
+        return 1;
+    return glyph->x0 <= glyph->x1 && glyph->y0 >= 0 && glyph->y0 <= glyph->y1 && glyph->x1 <= header->width &&
+           glyph->y1 <= header->height;
+}
+
+// Checks the header, the sizes, the skyline nodes & the glyph rects of a mapped file. Returns the number of its fonts
+// that exist in the stash, 0 when the file is invalid
+static int nvg__validateGlyphAtlas(FONScontext* stash, const NVGmappedFile* file, NVGglyphAtlasHeader* header)
+{
+    NVGglyphAtlasFont    entry;
+    const unsigned char* data;
+    size_t               offset = 0;
+    int                  i, j, nfonts = 0;
+
+    data = nvg__readMapped(file, &offset, sizeof(*header));
+    if (data == NULL)
+        return 0;
+    memcpy(header, data, sizeof(*header));
+    if (header->magic != NVG_GLYPH_ATLAS_MAGIC || header->version != NVG_GLYPH_ATLAS_VERSION ||
+        header->glyphSize != (int)sizeof(FONSglyph) || header->nodeSize != (int)sizeof(FONSatlasNode) ||
+        header->width <= 0 || header->width > NVG_MAX_FONTIMAGE_SIZE || header->height <= 0 ||
+        header->height > NVG_MAX_FONTIMAGE_SIZE || header->nnodes <= 0 || header->nfonts < 0)
+        return 0;
+    if (nvg__readMapped(file, &offset, (size_t)header->width * header->height) == NULL)
+        return 0;
+    data = nvg__readMapped(file, &offset, sizeof(FONSatlasNode) * header->nnodes);
+    if (data == NULL || ! nvg__validGlyphAtlasNodes(data, header))
+        return 0;
+
+    for (i = 0; i < header->nfonts; i++)
+    {
+        data = nvg__readMapped(file, &offset, sizeof(entry));
+        if (data == NULL)
+            return 0;
+        memcpy(&entry, data, sizeof(entry));
+        if (entry.nglyphs < 0)
+            return 0;
+        data = nvg__readMapped(file, &offset, sizeof(FONSglyph) * entry.nglyphs);
+        if (data == NULL)
+            return 0;
+        for (j = 0; j < entry.nglyphs; j++)
+        {
+            FONSglyph glyph;
+            memcpy(&glyph, data + sizeof(FONSglyph) * j, sizeof(glyph));
+            if (! nvg__validGlyphAtlasRect(&glyph, header))
+                return 0;
+        }
+        if (nvg__glyphAtlasFont(stash, &entry) != NULL)
+            nfonts++;
+    }
+    return nfonts;
+}
+
+// Replaces the atlas of a validated file
+static int nvg__applyGlyphAtlas(NVGcontext* ctx, const NVGmappedFile* file, const NVGglyphAtlasHeader* header)
+{
+    FONScontext*         stash  = ctx->fs;
+    size_t               offset = sizeof(*header);
+    const unsigned char* pixels = nvg__readMapped(file, &offset, (size_t)header->width * header->height);
+    const unsigned char* nodes  = nvg__readMapped(file, &offset, sizeof(FONSatlasNode) * header->nnodes);
+    NVGglyphAtlasFont    entry;
+    int                  i, j, image;
+
+    // Everything that can fail happens before fonsResetAtlas
+    if (stash->atlas->cnodes < header->nnodes)
+    {
+        FONSatlasNode* grown = (FONSatlasNode*)realloc(stash->atlas->nodes, sizeof(FONSatlasNode) * header->nnodes);
+        if (grown == NULL)
+            return 0;
+        stash->atlas->nodes  = grown;
+        stash->atlas->cnodes = header->nnodes;
+    }
+    image = ctx->params.renderCreateTexture(
+        ctx->params.userPtr,
+        NVG_TEXTURE_ALPHA,
+        header->width,
+        header->height,
+        0,
+        pixels);
+    if (image == 0)
+        return 0;
+    if (! fonsResetAtlas(stash, header->width, header->height))
+    {
+        nvgDeleteImage(ctx, image);
+        return 0;
+    }
+    nvg__setFontImage(ctx, image);
+
+    memcpy(stash->texData, pixels, (size_t)header->width * header->height);
+    memcpy(stash->atlas->nodes, nodes, sizeof(FONSatlasNode) * header->nnodes);
+    stash->atlas->nnodes = header->nnodes;
+    stash->dirtyRect[0]  = header->width;
+    stash->dirtyRect[1]  = header->height;
+    stash->dirtyRect[2]  = 0;
+    stash->dirtyRect[3]  = 0;
+
+    for (i = 0; i < header->nfonts; i++)
+    {
+        const unsigned char* glyphs;
+        FONSfont*            font;
+
+        memcpy(&entry, nvg__readMapped(file, &offset, sizeof(entry)), sizeof(entry));
+        glyphs = nvg__readMapped(file, &offset, sizeof(FONSglyph) * entry.nglyphs);
+        font   = nvg__glyphAtlasFont(stash, &entry);
+        for (j = 0; font != NULL && j < entry.nglyphs; j++)
+        {
+            FONSglyph* glyph = fons__allocGlyph(font);
+            int        h;
+            if (glyph == NULL)
+                break;
+            memcpy(glyph, glyphs + sizeof(FONSglyph) * j, sizeof(FONSglyph));
+            h            = fons__hashint(glyph->codepoint) & (FONS_HASH_LUT_SIZE - 1);
+            glyph->next  = font->lut[h];
+            font->lut[h] = font->nglyphs - 1;
+        }
+    }
+    return 1;
+}
+
+int nvgLoadGlyphAtlas(NVGcontext* ctx, const char* path)
+{
+    NVGcompat*          compat = nvg__compat(ctx);
+    NVGmappedFile       file;
+    NVGglyphAtlasHeader header;
+    int                 nfonts;
+
+    if (compat != NULL && compat->inFrame)
+        return 0;
+    if (! nvg__mapFile(&file, path))
+        return 0;
+
+    nfonts = nvg__validateGlyphAtlas(ctx->fs, &file, &header);
+    if (nfonts > 0 && ! nvg__applyGlyphAtlas(ctx, &file, &header))
+        nfonts = 0;
+
+    nvg__unmapFile(&file);
+    return nfonts;
+}
+
+//
+// Bulk primitives
+//
+// Points are transformed & added to the path cache directly, skipping the command buffer & the flattener. The paths
+// are then expanded & drawn like nvgFill & nvgStroke would. The cache is cleared afterwards, so the current path is
+// flattened again from its commands if it's drawn later.
+//
+
+// Fills the paths in the cache & clears it
+static void nvg__bulkFill(NVGcontext* ctx, const NVGpaint* paint)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+
+    if (compat != NULL)
+        compat->bulk = 1;
+    nvg__fill(ctx, paint, ctx->fringeWidth, 0);
+    if (compat != NULL)
+        compat->bulk = 0;
+    nvg__clearPathCache(ctx);
+}
+
+// Strokes the paths in the cache & clears it
+static void nvg__bulkStroke(NVGcontext* ctx)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+
+    if (compat != NULL)
+        compat->bulk = 1;
+    nvg__stroke(ctx, ctx->fringeWidth, 0);
+    if (compat != NULL)
+        compat->bulk = 0;
+    nvg__clearPathCache(ctx);
+}
+
+static void nvg__bulkRect(NVGcontext* ctx, const float* xform, float x, float y, float w, float h)
+{
+    float pts[8];
+    int   i;
+
+    // Same order as nvgRect()
+    nvgTransformPoint(&pts[0], &pts[1], xform, x, y);
+    nvgTransformPoint(&pts[2], &pts[3], xform, x, y + h);
+    nvgTransformPoint(&pts[4], &pts[5], xform, x + w, y + h);
+    nvgTransformPoint(&pts[6], &pts[7], xform, x + w, y);
+
+    nvg__addPath(ctx);
+    for (i = 0; i < 4; i++)
+        nvg__addPoint(ctx, pts[i * 2], pts[i * 2 + 1], NVG_PT_CORNER);
+    nvg__closePath(ctx);
+}
+
+void nvgFillRects(NVGcontext* ctx, const float* xywh, int n, NVGpaint paint)
+{
+    NVGstate* state = nvg__getState(ctx);
+    int       i;
+
+    if (n <= 0)
+        return;
+
+    nvgTransformMultiply(paint.xform, state->xform);
+    nvg__clearPathCache(ctx);
+    for (i = 0; i < n; i++, xywh += 4)
+        nvg__bulkRect(ctx, state->xform, xywh[0], xywh[1], xywh[2], xywh[3]);
+    nvg__finishPaths(ctx);
+
+    nvg__bulkFill(ctx, &paint);
+}
+
+void nvgDrawPoints(NVGcontext* ctx, const float* xy, int n, float size)
+{
+    NVGstate* state = nvg__getState(ctx);
+    float     half  = size * 0.5f;
+    int       i;
+
+    if (n <= 0)
+        return;
+
+    nvg__clearPathCache(ctx);
+    for (i = 0; i < n; i++, xy += 2)
+        nvg__bulkRect(ctx, state->xform, xy[0] - half, xy[1] - half, size, size);
+    nvg__finishPaths(ctx);
+
+    nvg__bulkFill(ctx, &state->fill);
+}
+
+void nvgStrokePolyline(NVGcontext* ctx, const float* xy, int n)
+{
+    NVGstate* state = nvg__getState(ctx);
+    int       i;
+
+    if (n < 2)
+        return;
+
+    nvg__clearPathCache(ctx);
+    nvg__addPath(ctx);
+    for (i = 0; i < n; i++, xy += 2)
+    {
+        float x, y;
+        nvgTransformPoint(&x, &y, state->xform, xy[0], xy[1]);
+        nvg__addPoint(ctx, x, y, NVG_PT_CORNER);
+    }
+    nvg__finishPaths(ctx);
+
+    nvg__bulkStroke(ctx);
+}
+
+// Most copies filled by one call of nvgDrawPathInstances, which bounds the overlap tests of a run
+#define NVG_INSTANCE_MAX_RUN 256
+
+// Writes the path commands `src` transformed by `m` to the command buffer
+static void nvg__transformCommands(NVGcontext* ctx, const float* src, const float* m)
+{
+    int i = 0;
+
+    while (i < ctx->ncommands)
+    {
+        int cmd = (int)src[i];
+        int j, ncoords = cmd == NVG_BEZIERTO ? 6 : cmd == NVG_MOVETO || cmd == NVG_LINETO ? 2 : 0;
+
+        ctx->commands[i] = src[i];
+        if (cmd == NVG_WINDING)
+            ctx->commands[i + 1] = src[i + 1];
+        for (j = 0; j < ncoords; j += 2)
+            nvgTransformPoint(&ctx->commands[i + 1 + j], &ctx->commands[i + 2 + j], m, src[i + 1 + j], src[i + 2 + j]);
+        i += 1 + ncoords + (cmd == NVG_WINDING);
+    }
+}
+
+// Writes the scale, shear & mirroring of the instance transform `xform` in device space to `shape`: the transform is
+// `shape` followed by a rotation & a translation, which leave the fringe & the flattening error as they are
+static void nvg__instanceShape(NVGcontext* ctx, const float* xform, float* shape)
+{
+    float rot[6] = {1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f};
+    float c, s, len;
+
+    memcpy(shape, xform, sizeof(float) * 6);
+    nvgTransformMultiply(shape, nvg__getState(ctx)->xform);
+    shape[4] = shape[5] = 0.0f;
+
+    // Takes out the rotation closest to the 2x2 part, `rot` is its inverse. Mirrored shapes keep their reflection so
+    // the flattener orients their paths as nvgFill() would.
+    c   = shape[0] + shape[3];
+    s   = shape[1] - shape[2];
+    len = sqrtf(c * c + s * s);
+    if (len > 0.0f)
+    {
+        rot[0] = c / len;
+        rot[1] = -s / len;
+        rot[2] = s / len;
+        rot[3] = c / len;
+    }
+    nvgTransformMultiply(shape, rot);
+}
+
+// Writes the device bounds of the copy of the path with device bounds `pathBounds` transformed by `xform`, grown by
+// `pad`. `inv` is the inverse of the current transform.
+static void nvg__instanceBounds(
+    NVGcontext*  ctx,
+    const float* pathBounds,
+    const float* inv,
+    const float* xform,
+    float        pad,
+    float*       bounds)
+{
+    float m[6], x, y;
+    int   i;
+
+    // The copy is placed in device space by backing out of the current transform, applying `xform`, then it again
+    memcpy(m, inv, sizeof(m));
+    nvgTransformMultiply(m, xform);
+    nvgTransformMultiply(m, nvg__getState(ctx)->xform);
+
+    bounds[0] = bounds[1] = 1e6f;
+    bounds[2] = bounds[3] = -1e6f;
+    for (i = 0; i < 4; i++)
+    {
+        nvgTransformPoint(&x, &y, m, pathBounds[i & 1 ? 2 : 0], pathBounds[i & 2 ? 3 : 1]);
+        bounds[0] = nvg__minf(bounds[0], x - pad);
+        bounds[1] = nvg__minf(bounds[1], y - pad);
+        bounds[2] = nvg__maxf(bounds[2], x + pad);
+        bounds[3] = nvg__maxf(bounds[3], y + pad);
+    }
+}
+
+// Returns 1 if the bounds of the copy `last` overlap those of any copy from `first`
+static int nvg__instanceOverlaps(const float* instanceBounds, int first, int last)
+{
+    const float* b0 = &instanceBounds[last * 4];
+    int          i;
+    for (i = first; i < last; i++)
+    {
+        const float* b = &instanceBounds[i * 4];
+        if (b0[0] < b[2] && b[0] < b0[2] && b0[1] < b[3] && b[1] < b0[3])
+            return 1;
+    }
+    return 0;
+}
+
+// Fills the instances `first` to `last` of the tessellated path as one call. The path was tessellated in the space of
+// `invShape`'s inverse, each instance is placed from there by the rest of its transform.
+static void nvg__fillInstances(
+    NVGcontext*     ctx,
+    NVGcompat*      compat,
+    const NVGpaint* paint,
+    const NVGpath*  paths,
+    int             npaths,
+    const float*    xforms,
+    const float*    invShape,
+    int             first,
+    int             last)
+{
+    NVGstate*  state     = nvg__getState(ctx);
+    NVGpaint   fillPaint = *paint;
+    NVGpath*   dstPaths;
+    NVGvertex* dst;
+    float      bounds[4];
+    int        i, j, k, n = last - first, nverts = 0, ntris = 0;
+
+    for (i = 0; i < npaths; i++)
+        nverts += paths[i].nfill + paths[i].nstroke;
+    if (nverts == 0 || n > 0x7fffffff / nverts || n > 0x7fffffff / npaths)
+        return;
+    if (! nvg__compatReserve((void**)&compat->instancePaths, &compat->cinstancePaths, n * npaths, sizeof(NVGpath)) ||
+        ! nvg__compatReserve((void**)&compat->instanceVerts, &compat->cinstanceVerts, n * nverts, sizeof(NVGvertex)))
+        return;
+    dstPaths = compat->instancePaths;
+    dst      = compat->instanceVerts;
+
+    bounds[0] = bounds[1] = 1e6f;
+    bounds[2] = bounds[3] = -1e6f;
+    for (i = first; i < last; i++)
+    {
+        // The instance transform applies in user space: back out of the shape, apply it, then the current transform
+        float m[6];
+        memcpy(m, invShape, sizeof(m));
+        nvgTransformMultiply(m, &xforms[i * 6]);
+        nvgTransformMultiply(m, state->xform);
+
+        for (j = 0; j < npaths; j++, dstPaths++)
+        {
+            const NVGpath* src = &paths[j];
+            *dstPaths          = *src;
+            dstPaths->fill     = dst;
+            for (k = 0; k < src->nfill + src->nstroke; k++, dst++)
+            {
+                const NVGvertex* v = k < src->nfill ? &src->fill[k] : &src->stroke[k - src->nfill];
+                dst->x             = m[0] * v->x + m[2] * v->y + m[4];
+                dst->y             = m[1] * v->x + m[3] * v->y + m[5];
+                dst->u             = v->u;
+                dst->v             = v->v;
+                bounds[0]          = nvg__minf(bounds[0], dst->x);
+                bounds[1]          = nvg__minf(bounds[1], dst->y);
+                bounds[2]          = nvg__maxf(bounds[2], dst->x);
+                bounds[3]          = nvg__maxf(bounds[3], dst->y);
+            }
+            dstPaths->stroke = dstPaths->fill + src->nfill;
+            ntris           += src->nfill - 2 + src->nstroke - 2;
+        }
+    }
+
+    // Apply global alpha
+    fillPaint.innerColor.a *= state->alpha;
+    fillPaint.outerColor.a *= state->alpha;
+
+    ctx->params.renderFill(
+        ctx->params.userPtr,
+        &fillPaint,
+        state->compositeOperation,
+        &state->scissor,
+        ctx->fringeWidth,
+        bounds,
+        compat->instancePaths,
+        n * npaths);
+
+    // Counted as the fill of a single path
+    ctx->fillTriCount  += ntris;
+    ctx->drawCallCount += 2;
+}
+
+void nvgDrawPathInstances(NVGcontext* ctx, const float* xforms, const NVGcolor* colors, int n)
+{
+    NVGcompat*     compat = nvg__compat(ctx);
+    NVGstate*      state  = nvg__getState(ctx);
+    NVGtessParams  params;
+    const NVGpath* paths;
+    float          bounds[4], pathBounds[4], inv[6];
+    int            i, first, npaths = 0;
+
+    if (compat == NULL || n <= 0 || n > 0x7fffffff / 4 || ctx->ncommands == 0)
+        return;
+    if (! nvg__compatReserve(
+            (void**)&compat->instanceCommands,
+            &compat->cinstanceCommands,
+            ctx->ncommands,
+            sizeof(float)) ||
+        ! nvg__compatReserve((void**)&compat->instanceBounds, &compat->cinstanceBounds, n * 4, sizeof(float)))
+        return;
+    memcpy(compat->instanceCommands, ctx->commands, sizeof(float) * ctx->ncommands);
+    nvgTransformInverse(inv, state->xform);
+
+    // The fringe reaches half its width out of each copy, the other half keeps copies that touch apart
+    nvg__commandBounds(ctx, pathBounds);
+    for (i = 0; i < n; i++)
+        nvg__instanceBounds(ctx, pathBounds, inv, &xforms[i * 6], ctx->fringeWidth, &compat->instanceBounds[i * 4]);
+
+    for (first = 0; first < n; first = i)
+    {
+        NVGpaint paint = state->fill;
+        float    shape[6], invShape[6], m[6];
+
+        if (colors != NULL)
+            nvg__setPaintColor(&paint, colors[first]);
+        nvg__instanceShape(ctx, &xforms[first * 6], shape);
+        nvgTransformInverse(invShape, shape);
+
+        // Runs of instances of the same colour & within 1% of the same scale & shear share a tessellation & a call.
+        // The backends fill a call with one stencil pass, where overlapping copies would be covered & blended once,
+        // so runs also end at a copy overlapping another of the run.
+        for (i = first + 1; i < n && i - first < NVG_INSTANCE_MAX_RUN; i++)
+        {
+            if (colors != NULL && memcmp(&colors[i], &colors[first], sizeof(NVGcolor)) != 0)
+                break;
+            if (nvg__instanceOverlaps(compat->instanceBounds, first, i))
+                break;
+            nvg__instanceShape(ctx, &xforms[i * 6], m);
+            nvgTransformPremultiply(m, invShape);
+            if (fabsf(m[0] - 1.0f) + fabsf(m[1]) + fabsf(m[2]) + fabsf(m[3] - 1.0f) > 0.01f)
+                break;
+        }
+
+        // The commands are in device space, tessellate them scaled by the run's shape so the fringe & the flattening
+        // tolerance are in device pixels once the copies are placed
+        memcpy(m, inv, sizeof(m));
+        nvgTransformMultiply(m, shape);
+        nvg__transformCommands(ctx, compat->instanceCommands, m);
+        nvg__clearPathCache(ctx);
+        nvg__tessParams(ctx, &params, 0, ctx->fringeWidth, 0.0f);
+        paths = nvg__tessellate(ctx, &params, 1, &npaths, bounds);
+        nvg__fillInstances(ctx, compat, &paint, paths, npaths, xforms, invShape, first, i);
+    }
+
+    memcpy(ctx->commands, compat->instanceCommands, sizeof(float) * ctx->ncommands);
+    nvg__clearPathCache(ctx);
+}
+
+//
+// Damage tracking
+//
+// Every call passed to the backend gets a hash of its state & geometry and its bounds in framebuffer pixels, clipped
+// by its scissor. At the end of a frame, calls are matched with the previous frame's from the start & from the end.
+// The pixels of a frame can only differ from the previous one where an unmatched call draws, so the bounds of the
+// unmatched calls of both frames are the damage. In partial mode the frame's calls are held back until nvgEndFrame,
+// then each damage rect is cleared & redrawn with only the calls touching it, scissored to the rect.
+//
+
+#define NVG_DAMAGE_MAX_RECTS 16
+
+typedef struct NVGdamageCall
+{
+    uint64_t hash;
+    // x0, y0, x1, y1 in framebuffer pixels, max exclusive
+    int bounds[4];
+} NVGdamageCall;
+
+typedef struct NVGdamage
+{
+    int      mode;
+    NVGcolor clearColor;
+    // Calls of the previous & current frames
+    NVGdamageCall* calls[2];
+    int            ncalls[2];
+    int            ccalls[2];
+    int            current;
+    // Framebuffer size & pixel ratio of the current frame
+    int   width;
+    int   height;
+    float devicePxRatio;
+    // Set when the next frame must be fully redrawn
+    int full;
+    // Calls touching a scissor that isn't axis aligned can't be clipped to damage rects
+    int rotatedScissor;
+    // Damage of the last frame, x, y, w, h
+    int rects[NVG_DAMAGE_MAX_RECTS * 4];
+    int nrects;
+    // Bumped when an image's pixels are updated, hashed with the calls using it
+    unsigned int* imageVersions;
+    int           cimageVersions;
+    // Calls held back in partial mode
+    NVGdisplayList frame;
+} NVGdamage;
+
+static void nvg__deleteDamage(NVGdamage* damage)
+{
+    if (damage == NULL)
+        return;
+    NVG_FREE(damage->calls[0]);
+    NVG_FREE(damage->calls[1]);
+    NVG_FREE(damage->imageVersions);
+    NVG_FREE(damage->frame.calls);
+    NVG_FREE(damage->frame.paths);
+    NVG_FREE(damage->frame.verts);
+    NVG_FREE(damage);
+}
+
+static void nvg__damageCancel(NVGdamage* damage)
+{
+    damage->ncalls[damage->current] = 0;
+    damage->rotatedScissor          = 0;
+    damage->frame.ncalls            = 0;
+    damage->frame.npaths            = 0;
+    damage->frame.nverts            = 0;
+}
+
+static void nvg__damageImageUpdated(NVGdamage* damage, int image)
+{
+    int cap = damage->cimageVersions;
+    if (image <= 0 ||
+        ! nvg__compatReserve((void**)&damage->imageVersions, &damage->cimageVersions, image + 1, sizeof(unsigned int)))
+        return;
+    memset(damage->imageVersions + cap, 0, sizeof(unsigned int) * (damage->cimageVersions - cap));
+    damage->imageVersions[image]++;
+}
+
+static void nvg__damageBeginFrame(NVGcompat* compat, float width, float height, float devicePixelRatio)
+{
+    NVGdamage* damage = compat->damage;
+    int        w      = (int)ceilf(width * devicePixelRatio);
+    int        h      = (int)ceilf(height * devicePixelRatio);
+
+    if (w != damage->width || h != damage->height || devicePixelRatio != damage->devicePxRatio)
+        damage->full = 1;
+    damage->width         = w;
+    damage->height        = h;
+    damage->devicePxRatio = devicePixelRatio;
+    nvg__damageCancel(damage);
+}
+
+static void nvg__damageExtend(float* bounds, const NVGvertex* verts, int nverts)
+{
+    int i;
+    for (i = 0; i < nverts; i++)
+    {
+        bounds[0] = nvg__minf(bounds[0], verts[i].x);
+        bounds[1] = nvg__minf(bounds[1], verts[i].y);
+        bounds[2] = nvg__maxf(bounds[2], verts[i].x);
+        bounds[3] = nvg__maxf(bounds[3], verts[i].y);
+    }
+}
+
+// Returns 1 if the scissor is set & isn't axis aligned
+static int nvg__scissorRotated(const NVGscissor* scissor)
+{
+    return scissor->extent[0] >= 0.0f && (scissor->xform[1] != 0.0f || scissor->xform[2] != 0.0f);
+}
+
+// Records a call. Returns 1 if it's held back for partial redraw
+static int nvg__damageCall(
+    NVGcompat*                 compat,
+    int                        type,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    float                      strokeWidth,
+    const float*               bounds,
+    const NVGpath*             paths,
+    int                        npaths,
+    const NVGvertex*           verts,
+    int                        nverts)
+{
+    NVGdamage*     damage = compat->damage;
+    int            cur    = damage->current;
+    NVGdamageCall* call;
+    float          b[4]    = {1e6f, 1e6f, -1e6f, -1e6f};
+    unsigned int   version = 0;
+    uint64_t       hash;
+    int            i;
+
+    if (! nvg__compatReserve(
+            (void**)&damage->calls[cur],
+            &damage->ccalls[cur],
+            damage->ncalls[cur] + 1,
+            sizeof(NVGdamageCall)))
+    {
+        damage->full = 1;
+        return 0;
+    }
+    call = &damage->calls[cur][damage->ncalls[cur]++];
+
+    if (paint->image > 0 && paint->image < damage->cimageVersions)
+        version = damage->imageVersions[paint->image];
+    hash = nvg__hashBytes(14695981039346656037ull, &type, sizeof(type));
+    hash = nvg__hashBytes(hash, paint, sizeof(*paint));
+    hash = nvg__hashBytes(hash, &version, sizeof(version));
+    hash = nvg__hashBytes(hash, &compositeOperation, sizeof(compositeOperation));
+    hash = nvg__hashBytes(hash, scissor, sizeof(*scissor));
+    hash = nvg__hashBytes(hash, &fringe, sizeof(fringe));
+    hash = nvg__hashBytes(hash, &strokeWidth, sizeof(strokeWidth));
+    if (bounds != NULL)
+        hash = nvg__hashBytes(hash, bounds, sizeof(float) * 4);
+    for (i = 0; i < npaths; i++)
+    {
+        hash = nvg__hashBytes(hash, paths[i].fill, sizeof(NVGvertex) * paths[i].nfill);
+        hash = nvg__hashBytes(hash, paths[i].stroke, sizeof(NVGvertex) * paths[i].nstroke);
+        nvg__damageExtend(b, paths[i].fill, paths[i].nfill);
+        nvg__damageExtend(b, paths[i].stroke, paths[i].nstroke);
+    }
+    hash = nvg__hashBytes(hash, verts, sizeof(NVGvertex) * nverts);
+    nvg__damageExtend(b, verts, nverts);
+    call->hash = hash;
+
+    if (scissor->extent[0] >= 0.0f)
+    {
+        // Bounds of the scissor rect, as in nvgCurrentScissor()
+        const float* xf = scissor->xform;
+        float        ex = scissor->extent[0], ey = scissor->extent[1];
+        float        tex = ex * fabsf(xf[0]) + ey * fabsf(xf[2]);
+        float        tey = ex * fabsf(xf[1]) + ey * fabsf(xf[3]);
+        b[0]             = nvg__maxf(b[0], xf[4] - tex);
+        b[1]             = nvg__maxf(b[1], xf[5] - tey);
+        b[2]             = nvg__minf(b[2], xf[4] + tex);
+        b[3]             = nvg__minf(b[3], xf[5] + tey);
+    }
+
+    // Antialiasing reaches half a pixel past the vertices
+    call->bounds[0] = nvg__maxi((int)floorf(b[0] * damage->devicePxRatio) - 1, 0);
+    call->bounds[1] = nvg__maxi((int)floorf(b[1] * damage->devicePxRatio) - 1, 0);
+    call->bounds[2] = nvg__mini((int)ceilf(b[2] * damage->devicePxRatio) + 1, damage->width);
+    call->bounds[3] = nvg__mini((int)ceilf(b[3] * damage->devicePxRatio) + 1, damage->height);
+    if (call->bounds[2] <= call->bounds[0] || call->bounds[3] <= call->bounds[1])
+        call->bounds[0] = call->bounds[1] = call->bounds[2] = call->bounds[3] = 0;
+
+    if (damage->mode != NVG_DAMAGE_PARTIAL)
+        return 0;
+
+    if (nvg__scissorRotated(scissor))
+        damage->rotatedScissor = 1;
+    if (type == NVG_DISPLAY_FILL)
+        nvg__recordFill(&damage->frame, paint, compositeOperation, scissor, fringe, bounds, paths, npaths);
+    else if (type == NVG_DISPLAY_STROKE)
+        nvg__recordStroke(&damage->frame, paint, compositeOperation, scissor, fringe, strokeWidth, paths, npaths);
+    else
+        nvg__recordTriangles(&damage->frame, paint, compositeOperation, scissor, verts, nverts, fringe);
+    // Recording failed, draw the whole frame
+    if (damage->frame.ncalls != damage->ncalls[cur])
+        damage->full = 1;
+    return 1;
+}
+
+static int nvg__rectsOverlap(const int* a, const int* b)
+{
+    return a[0] < b[0] + b[2] && b[0] < a[0] + a[2] && a[1] < b[1] + b[3] && b[1] < a[1] + a[3];
+}
+
+static void nvg__rectUnion(int* a, const int* b)
+{
+    int x1 = nvg__maxi(a[0] + a[2], b[0] + b[2]);
+    int y1 = nvg__maxi(a[1] + a[3], b[1] + b[3]);
+    a[0]   = nvg__mini(a[0], b[0]);
+    a[1]   = nvg__mini(a[1], b[1]);
+    a[2]   = x1 - a[0];
+    a[3]   = y1 - a[1];
+}
+
+// Adds x0, y0, x1, y1 `bounds` to the damage, keeping the rects disjoint
+static void nvg__damageAdd(NVGdamage* damage, const int* bounds)
+{
+    int rect[4], i, merged;
+
+    if (bounds[2] <= bounds[0] || bounds[3] <= bounds[1])
+        return;
+    rect[0] = bounds[0];
+    rect[1] = bounds[1];
+    rect[2] = bounds[2] - bounds[0];
+    rect[3] = bounds[3] - bounds[1];
+
+    // Merge with overlapping rects until none is left
+    do
+    {
+        merged = 0;
+        for (i = 0; i < damage->nrects; i++)
+        {
+            int* other = &damage->rects[i * 4];
+            if (nvg__rectsOverlap(rect, other))
+            {
+                nvg__rectUnion(rect, other);
+                memmove(other, other + 4, sizeof(int) * 4 * (damage->nrects - i - 1));
+                damage->nrects--;
+                merged = 1;
+                break;
+            }
+        }
+    } while (merged);
+
+    if (damage->nrects == NVG_DAMAGE_MAX_RECTS)
+    {
+        // Out of rects, grow the one growing the least
+        int best = 0, bestGrowth = 0x7fffffff;
+        for (i = 0; i < damage->nrects; i++)
+        {
+            int u[4], growth;
+            memcpy(u, &damage->rects[i * 4], sizeof(u));
+            nvg__rectUnion(u, rect);
+            growth = u[2] * u[3] - damage->rects[i * 4 + 2] * damage->rects[i * 4 + 3];
+            if (growth < bestGrowth)
+            {
+                best       = i;
+                bestGrowth = growth;
+            }
+        }
+        nvg__rectUnion(rect, &damage->rects[best * 4]);
+        memmove(&damage->rects[best * 4], &damage->rects[best * 4 + 4], sizeof(int) * 4 * (damage->nrects - best - 1));
+        damage->nrects--;
+        // The grown rect may overlap others now
+        rect[2] += rect[0];
+        rect[3] += rect[1];
+        nvg__damageAdd(damage, rect);
+        return;
+    }
+
+    memcpy(&damage->rects[damage->nrects * 4], rect, sizeof(rect));
+    damage->nrects++;
+}
+
+// Clears `rect`, in framebuffer pixels, to the clear color
+static void nvg__damageClear(NVGcompat* compat, const int* rect)
+{
+    NVGdamage* damage = compat->damage;
+    float      s      = 1.0f / damage->devicePxRatio;
+    float      x0 = rect[0] * s, y0 = rect[1] * s, x1 = (rect[0] + rect[2]) * s, y1 = (rect[1] + rect[3]) * s;
+    float      bounds[4] = {x0, y0, x1, y1};
+    NVGvertex  verts[4];
+    NVGpath    path;
+    NVGpaint   paint;
+    NVGscissor scissor;
+
+    nvg__vset(&verts[0], x0, y0, 0.5f, 1.0f);
+    nvg__vset(&verts[1], x0, y1, 0.5f, 1.0f);
+    nvg__vset(&verts[2], x1, y1, 0.5f, 1.0f);
+    nvg__vset(&verts[3], x1, y0, 0.5f, 1.0f);
+    memset(&path, 0, sizeof(path));
+    path.fill    = verts;
+    path.nfill   = 4;
+    path.stroke  = verts;
+    path.closed  = 1;
+    path.convex  = 1;
+    path.winding = NVG_CCW;
+
+    memset(&paint, 0, sizeof(paint));
+    nvgTransformIdentity(paint.xform);
+    paint.feather    = 1.0f;
+    paint.innerColor = damage->clearColor;
+    paint.outerColor = damage->clearColor;
+
+    memset(&scissor, 0, sizeof(scissor));
+    scissor.extent[0] = -1.0f;
+    scissor.extent[1] = -1.0f;
+
+    nvg__compatIssueFill(compat, &paint, nvg__compositeOperationState(NVG_COPY), &scissor, s, bounds, &path, 1);
+}
+
+// Replays the calls of the held back frame touching `rect`, in framebuffer pixels, scissored to it. A NULL `rect`
+// replays every call as is.
+static void nvg__damageRedraw(NVGcompat* compat, const int* rect)
+{
+    NVGdamage*      damage = compat->damage;
+    NVGdisplayList* list   = &damage->frame;
+    float           s      = 1.0f / damage->devicePxRatio;
+    int             i, j;
+
+    for (i = 0; i < list->ncalls; i++)
+    {
+        const NVGdisplayCall* call    = &list->calls[i];
+        const int*            bounds  = damage->calls[damage->current][i].bounds;
+        NVGpaint              paint   = call->paint;
+        NVGscissor            scissor = call->scissor;
+        NVGpath*              paths;
+
+        if (rect != NULL)
+        {
+            float x0 = rect[0] * s, y0 = rect[1] * s, x1 = (rect[0] + rect[2]) * s, y1 = (rect[1] + rect[3]) * s;
+            if (bounds[2] <= rect[0] || bounds[0] >= rect[0] + rect[2] || bounds[3] <= rect[1] ||
+                bounds[1] >= rect[1] + rect[3])
+                continue;
+            if (scissor.extent[0] >= 0.0f)
+            {
+                // Axis aligned, intersect in view space. Unit scale keeps the scissor's edge antialiasing the same
+                float ex = scissor.extent[0] * fabsf(scissor.xform[0]);
+                float ey = scissor.extent[1] * fabsf(scissor.xform[3]);
+                x0       = nvg__maxf(x0, scissor.xform[4] - ex);
+                y0       = nvg__maxf(y0, scissor.xform[5] - ey);
+                x1       = nvg__minf(x1, scissor.xform[4] + ex);
+                y1       = nvg__minf(y1, scissor.xform[5] + ey);
+                if (x1 <= x0 || y1 <= y0)
+                    continue;
+            }
+            nvgTransformIdentity(scissor.xform);
+            scissor.xform[4]  = (x0 + x1) * 0.5f;
+            scissor.xform[5]  = (y0 + y1) * 0.5f;
+            scissor.extent[0] = (x1 - x0) * 0.5f;
+            scissor.extent[1] = (y1 - y0) * 0.5f;
+        }
+
+        if (call->type == NVG_DISPLAY_TRIANGLES)
+        {
+            nvg__compatIssueTriangles(
+                compat,
+                &paint,
+                call->compositeOperation,
+                &scissor,
+                &list->verts[call->vertOffset],
+                call->nverts,
+                call->fringe);
+            continue;
+        }
+
+        if (! nvg__compatReserve(
+                (void**)&compat->scratchPaths,
+                &compat->cscratchPaths,
+                call->npaths,
+                sizeof(NVGpath)))
+            return;
+        paths = compat->scratchPaths;
+        for (j = 0; j < call->npaths; j++)
+        {
+            const NVGpath* src = &list->paths[call->pathOffset + j];
+            paths[j]           = *src;
+            paths[j].fill      = &list->verts[(size_t)src->fill];
+            paths[j].stroke    = &list->verts[(size_t)src->stroke];
+        }
+        if (call->type == NVG_DISPLAY_FILL)
+            nvg__compatIssueFill(
+                compat,
+                &paint,
+                call->compositeOperation,
+                &scissor,
+                call->fringe,
+                call->bounds,
+                paths,
+                call->npaths);
+        else
+            nvg__compatIssueStroke(
+                compat,
+                &paint,
+                call->compositeOperation,
+                &scissor,
+                call->fringe,
+                call->strokeWidth,
+                paths,
+                call->npaths);
+    }
+}
+
+static void nvg__damageEndFrame(NVGcompat* compat)
+{
+    NVGdamage*           damage = compat->damage;
+    int                  cur = damage->current, prev = cur ^ 1;
+    const NVGdamageCall* a = damage->calls[prev];
+    const NVGdamageCall* b = damage->calls[cur];
+    int                  na = damage->ncalls[prev], nb = damage->ncalls[cur];
+    int                  first = 0, last = 0, i;
+
+    damage->nrects = 0;
+    if (damage->full)
+    {
+        int all[4] = {0, 0, damage->width, damage->height};
+        nvg__damageAdd(damage, all);
+    }
+    else
+    {
+        // Skip the calls matching from the start & from the end
+        while (first < na && first < nb && a[first].hash == b[first].hash &&
+               memcmp(a[first].bounds, b[first].bounds, sizeof(a[first].bounds)) == 0)
+            first++;
+        while (last < na - first && last < nb - first && a[na - 1 - last].hash == b[nb - 1 - last].hash &&
+               memcmp(a[na - 1 - last].bounds, b[nb - 1 - last].bounds, sizeof(a[0].bounds)) == 0)
+            last++;
+        for (i = first; i < na - last; i++)
+            nvg__damageAdd(damage, a[i].bounds);
+        for (i = first; i < nb - last; i++)
+            nvg__damageAdd(damage, b[i].bounds);
+    }
+
+    if (damage->mode == NVG_DAMAGE_PARTIAL)
+    {
+        if (damage->full || damage->rotatedScissor)
+        {
+            int all[4] = {0, 0, damage->width, damage->height};
+            nvg__damageClear(compat, all);
+            nvg__damageRedraw(compat, NULL);
+        }
+        else
+        {
+            for (i = 0; i < damage->nrects; i++)
+            {
+                nvg__damageClear(compat, &damage->rects[i * 4]);
+                nvg__damageRedraw(compat, &damage->rects[i * 4]);
+            }
+        }
+    }
+
+    damage->full    = 0;
+    damage->current = prev;
+}
+
+void nvgDamageMode(NVGcontext* ctx, int mode, NVGcolor clearColor)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    if (compat == NULL)
+        return;
+
+    if (mode == NVG_DAMAGE_OFF)
+    {
+        nvg__deleteDamage(compat->damage);
+        compat->damage = NULL;
+        return;
+    }
+    if (compat->damage == NULL)
+    {
+        compat->damage = (NVGdamage*)nvg__compatMalloc(compat, sizeof(NVGdamage));
+        if (compat->damage == NULL)
+            return;
+        memset(compat->damage, 0, sizeof(NVGdamage));
+        compat->damage->devicePxRatio = 1.0f;
+    }
+    compat->damage->mode       = mode;
+    compat->damage->clearColor = clearColor;
+    compat->damage->full       = 1;
+}
+
+void nvgDamageInvalidate(NVGcontext* ctx)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    if (compat != NULL && compat->damage != NULL)
+        compat->damage->full = 1;
+}
+
+int nvgGetDamageRects(NVGcontext* ctx, int* xywh, int maxRects)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    int        n;
+    if (compat == NULL || compat->damage == NULL)
+        return 0;
+    n = nvg__mini(maxRects, compat->damage->nrects);
+    memcpy(xywh, compat->damage->rects, sizeof(int) * 4 * n);
+    return n;
+}
+
+//
+// Asynchronous readback
+//
+
+// Number of readbacks that can be in flight at once
+#ifndef NVG_READBACK_SLOTS
+#define NVG_READBACK_SLOTS 4
+#endif
+
+enum NVGreadbackState
+{
+    NVG_READBACK_FREE,
+    NVG_READBACK_QUEUED,  // Requested during a frame, the copy is made at the end of it
+    NVG_READBACK_PENDING, // Copy made, waiting for it to complete
+};
+
+typedef struct NVGreadbackSlot
+{
+    int ticket;
+    int state;
+    int image;
+    int x, y, w, h;
+#ifdef _WIN32
+    // Staging texture the rect is copied to, reused while the rect size & format don't change
+    ID3D11Texture2D* staging;
+    int              stagingW;
+    int              stagingH;
+    DXGI_FORMAT      stagingFormat;
+#else
+    // RGBA pixels copied when the readback starts
+    unsigned char* pixels;
+    int            cpixels;
+#endif
+} NVGreadbackSlot;
+
+typedef struct NVGreadback
+{
+    NVGreadbackSlot slots[NVG_READBACK_SLOTS];
+    int             nextTicket;
+} NVGreadback;
+
+#ifdef _WIN32
+
+// Starts copying the slot's rect into its staging texture. Returns 0 on failure
+static int nvg__readbackStart(NVGcompat* compat, NVGreadbackSlot* slot)
+{
+    struct D3DNVGcontext* D3D    = (struct D3DNVGcontext*)compat->backend.userPtr;
+    struct D3DNVGdevice*  device = (struct D3DNVGdevice*)D3D->userPtr;
+    ID3D11Texture2D*      src    = NULL;
+    D3D11_TEXTURE2D_DESC  desc;
+    D3D11_BOX             box;
+    HRESULT               hr;
+
+    if (slot->image == 0)
+    {
+        hr = D3D_API_3(device->pSwapChain, GetBuffer, 0, &IID_ID3D11Texture2D, (void**)&src);
+        if (FAILED(hr))
+            return 0;
+    }
+    else
+    {
+        struct D3DNVGtexture* tex = D3Dnvg__findTexture(D3D, slot->image);
+        if (tex == NULL)
+            return 0;
+        src = (ID3D11Texture2D*)tex->tex;
+        src->lpVtbl->AddRef(src);
+    }
+
+    D3D_API_1(src, GetDesc, &desc);
+    // Multisampled targets would need a resolve first
+    if (desc.SampleDesc.Count > 1 || slot->x + slot->w > (int)desc.Width || slot->y + slot->h > (int)desc.Height)
+    {
+        D3D_API_RELEASE(src);
+        return 0;
+    }
+
+    if (slot->staging == NULL || slot->stagingW != slot->w || slot->stagingH != slot->h ||
+        slot->stagingFormat != desc.Format)
+    {
+        D3D_API_RELEASE(slot->staging);
+        desc.Width              = slot->w;
+        desc.Height             = slot->h;
+        desc.MipLevels          = 1;
+        desc.ArraySize          = 1;
+        desc.SampleDesc.Count   = 1;
+        desc.SampleDesc.Quality = 0;
+        desc.Usage              = D3D11_USAGE_STAGING;
+        desc.BindFlags          = 0;
+        desc.CPUAccessFlags     = D3D11_CPU_ACCESS_READ;
+        desc.MiscFlags          = 0;
+        hr                      = D3D_API_3(device->pDevice, CreateTexture2D, &desc, NULL, &slot->staging);
+        if (FAILED(hr))
+        {
+            slot->staging = NULL;
+            D3D_API_RELEASE(src);
+            return 0;
+        }
+        slot->stagingW      = slot->w;
+        slot->stagingH      = slot->h;
+        slot->stagingFormat = desc.Format;
+    }
+
+    box.left   = slot->x;
+    box.top    = slot->y;
+    box.front  = 0;
+    box.right  = slot->x + slot->w;
+    box.bottom = slot->y + slot->h;
+    box.back   = 1;
+    device->pDeviceContext->lpVtbl->CopySubresourceRegion(
+        device->pDeviceContext,
+        (ID3D11Resource*)slot->staging,
+        0,
+        0,
+        0,
+        0,
+        (ID3D11Resource*)src,
+        0,
+        &box);
+    D3D_API_RELEASE(src);
+    return 1;
+}
+
+// Copies the slot's pixels to `data` if the GPU is done with them. Returns 1 when copied, 0 while the copy is still
+// running and -1 on failure
+static int nvg__readbackFinish(NVGcompat* compat, NVGreadbackSlot* slot, void* data)
+{
+    struct D3DNVGcontext*    D3D = (struct D3DNVGcontext*)compat->backend.userPtr;
+    D3D11_MAPPED_SUBRESOURCE resource;
+    size_t                   rowBytes = (size_t)slot->w * 4;
+    int                      i, j;
+
+    HRESULT hr = D3D_API_5(
+        D3D->pDeviceContext,
+        Map,
+        (ID3D11Resource*)slot->staging,
+        0,
+        D3D11_MAP_READ,
+        D3D11_MAP_FLAG_DO_NOT_WAIT,
+        &resource);
+    if (hr == DXGI_ERROR_WAS_STILL_DRAWING)
+        return 0;
+    if (FAILED(hr))
+        return -1;
+
+    for (i = 0; i < slot->h; i++)
+    {
+        unsigned char* dst = (unsigned char*)data + i * rowBytes;
+        memcpy(dst, (char*)resource.pData + (size_t)i * resource.RowPitch, rowBytes);
+        // The swap chain is BGRA
+        if (slot->stagingFormat == DXGI_FORMAT_B8G8R8A8_UNORM)
+        {
+            for (j = 0; j < slot->w; j++)
+            {
+                unsigned char b = dst[j * 4];
+                dst[j * 4]      = dst[j * 4 + 2];
+                dst[j * 4 + 2]  = b;
+            }
+        }
+    }
+
+    D3D_API_2(D3D->pDeviceContext, Unmap, (ID3D11Resource*)slot->staging, 0);
+    return 1;
+}
+
+static void nvg__readbackFreeSlot(NVGreadbackSlot* slot) { D3D_API_RELEASE(slot->staging); }
+
+#else
+
+// Copies the slot's rect out of the image. Returns 0 on failure
+static int nvg__readbackStart(NVGcompat* compat, NVGreadbackSlot* slot)
+{
+    int w = 0, h = 0;
+#ifdef __linux__
+    if (cpunvgImageData(compat->ctx, slot->image, &w, &h, NULL) == NULL)
+        return 0;
+#else
+    // The size of the Metal framebuffer isn't known here, mnvgReadPixels clips to it
+    if (slot->image == 0)
+    {
+        w = slot->x + slot->w;
+        h = slot->y + slot->h;
+    }
+    else
+    {
+        nvgImageSize(compat->ctx, slot->image, &w, &h);
+    }
+#endif
+    if (slot->x + slot->w > w || slot->y + slot->h > h)
+        return 0;
+    if (! nvg__compatReserve((void**)&slot->pixels, &slot->cpixels, slot->w * slot->h * 4, 1))
+        return 0;
+    nvgReadPixels(compat->ctx, slot->image, slot->x, slot->y, slot->w, slot->h, slot->pixels);
+    return 1;
+}
+
+// Copies the slot's pixels to `data`. Returns 1 when copied, 0 while the copy is still running and -1 on failure
+static int nvg__readbackFinish(NVGcompat* compat, NVGreadbackSlot* slot, void* data)
+{
+    NVG_NOTUSED(compat);
+    memcpy(data, slot->pixels, (size_t)slot->w * slot->h * 4);
+    return 1;
+}
+
+static void nvg__readbackFreeSlot(NVGreadbackSlot* slot) { NVG_FREE(slot->pixels); }
+
+#endif
+
+// Starts the readbacks requested during the frame, after the backend has rendered it
+static void nvg__readbackEndFrame(NVGcompat* compat)
+{
+    NVGreadback* readback = compat->readback;
+    int          i;
+    for (i = 0; i < NVG_READBACK_SLOTS; i++)
+    {
+        NVGreadbackSlot* slot = &readback->slots[i];
+        if (slot->state != NVG_READBACK_QUEUED)
+            continue;
+        if (nvg__readbackStart(compat, slot))
+            slot->state = NVG_READBACK_PENDING;
+        else
+            slot->state = NVG_READBACK_FREE;
+    }
+}
+
+static void nvg__deleteReadback(NVGreadback* readback)
+{
+    int i;
+    if (readback == NULL)
+        return;
+    for (i = 0; i < NVG_READBACK_SLOTS; i++)
+        nvg__readbackFreeSlot(&readback->slots[i]);
+    NVG_FREE(readback);
+}
+
+static NVGreadbackSlot* nvg__readbackSlot(NVGcompat* compat, int ticket)
+{
+    int i;
+    if (compat == NULL || compat->readback == NULL || ticket <= 0)
+        return NULL;
+    for (i = 0; i < NVG_READBACK_SLOTS; i++)
+        if (compat->readback->slots[i].state != NVG_READBACK_FREE && compat->readback->slots[i].ticket == ticket)
+            return &compat->readback->slots[i];
+    return NULL;
+}
+
+int nvgRequestReadback(NVGcontext* ctx, int image, int x, int y, int w, int h)
+{
+    NVGcompat*       compat = nvg__compat(ctx);
+    NVGreadback*     readback;
+    NVGreadbackSlot* slot = NULL;
+    int              i;
+
+    if (compat == NULL || x < 0 || y < 0 || w <= 0 || h <= 0)
+        return 0;
+    if (compat->readback == NULL)
+    {
+        compat->readback = (NVGreadback*)nvg__compatMalloc(compat, sizeof(NVGreadback));
+        if (compat->readback == NULL)
+            return 0;
+        memset(compat->readback, 0, sizeof(NVGreadback));
+        compat->readback->nextTicket = 1;
+    }
+    readback = compat->readback;
+
+    for (i = 0; i < NVG_READBACK_SLOTS && slot == NULL; i++)
+        if (readback->slots[i].state == NVG_READBACK_FREE)
+            slot = &readback->slots[i];
+    if (slot == NULL)
+        return 0;
+
+    slot->image = image;
+    slot->x     = x;
+    slot->y     = y;
+    slot->w     = w;
+    slot->h     = h;
+    if (compat->inFrame)
+        slot->state = NVG_READBACK_QUEUED;
+    else if (nvg__readbackStart(compat, slot))
+        slot->state = NVG_READBACK_PENDING;
+    else
+        return 0;
+
+    slot->ticket = readback->nextTicket;
+    if (++readback->nextTicket <= 0)
+        readback->nextTicket = 1;
+    return slot->ticket;
+}
+
+int nvgPollReadback(NVGcontext* ctx, int ticket, void* data)
+{
+    NVGcompat*       compat = nvg__compat(ctx);
+    NVGreadbackSlot* slot   = nvg__readbackSlot(compat, ticket);
+    int              result;
+
+    if (slot == NULL)
+        return -1;
+    if (slot->state == NVG_READBACK_QUEUED)
+        return 0;
+    result = nvg__readbackFinish(compat, slot, data);
+    if (result != 0)
+        slot->state = NVG_READBACK_FREE;
+    return result;
+}
+
+void nvgCancelReadback(NVGcontext* ctx, int ticket)
+{
+    NVGreadbackSlot* slot = nvg__readbackSlot(nvg__compat(ctx), ticket);
+    if (slot != NULL)
+        slot->state = NVG_READBACK_FREE;
+}
+
+//
+// Image atlas
+//
+
+// Minimum size of a texture allocation, used to estimate what the atlas images would take as separate textures
+#define NVG_ATLAS_TEXTURE_ALIGN 4096
+// Images are packed with a 1 pixel border copied from their edges, so filtering doesn't pick up their neighbours
+#define NVG_ATLAS_PADDING 1
+
+typedef struct NVGatlasEntry
+{
+    int          generation;
+    int          page; // -1 when free
+    int          x, y, w, h;
+    unsigned int lastUse;
+} NVGatlasEntry;
+
+typedef struct NVGatlasPage
+{
+    int            image;
+    int            type;
+    FONSatlas*     packer;
+    unsigned char* pixels;
+    int            nimages;
+} NVGatlasPage;
+
+typedef struct NVGatlas
+{
+    int            pageSize;
+    int            maxPages;
+    int            imageFlags;
+    NVGatlasPage*  pages;
+    int            npages;
+    int            cpages;
+    NVGatlasEntry* entries;
+    int            nentries;
+    int            centries;
+    unsigned int   useStamp;
+} NVGatlas;
+
+static int nvg__atlasBpp(int type) { return type == NVG_TEXTURE_RGBA ? 4 : 1; }
+
+// Frees the atlas. The page images are deleted too unless `ctx` is NULL, when the backend is being deleted
+static void nvg__deleteAtlas(NVGcontext* ctx, NVGatlas* atlas)
+{
+    int i;
+    if (atlas == NULL)
+        return;
+    for (i = 0; i < atlas->npages; i++)
+    {
+        if (ctx != NULL)
+            nvgDeleteImage(ctx, atlas->pages[i].image);
+        fons__deleteAtlas(atlas->pages[i].packer);
+        NVG_FREE(atlas->pages[i].pixels);
+    }
+    NVG_FREE(atlas->pages);
+    NVG_FREE(atlas->entries);
+    NVG_FREE(atlas);
+}
+
+static NVGatlasEntry* nvg__atlasEntry(NVGatlas* atlas, int id)
+{
+    int index = (id & 0xffff) - 1;
+    if (atlas == NULL || index < 0 || index >= atlas->nentries)
+        return NULL;
+    if (atlas->entries[index].page < 0 || atlas->entries[index].generation != id >> 16)
+        return NULL;
+    return &atlas->entries[index];
+}
+
+static NVGatlasPage* nvg__atlasAddPage(NVGcontext* ctx, NVGatlas* atlas, int type)
+{
+    NVGatlasPage* page;
+    size_t        bytes = (size_t)atlas->pageSize * atlas->pageSize * nvg__atlasBpp(type);
+
+    if (! nvg__compatReserve((void**)&atlas->pages, &atlas->cpages, atlas->npages + 1, sizeof(NVGatlasPage)))
+        return NULL;
+    page = &atlas->pages[atlas->npages];
+    memset(page, 0, sizeof(*page));
+    page->type   = type;
+    page->packer = fons__allocAtlas(atlas->pageSize, atlas->pageSize, FONS_INIT_ATLAS_NODES);
+    page->pixels = (unsigned char*)NVG_MALLOC(bytes);
+    if (page->packer == NULL || page->pixels == NULL)
+        goto error;
+    memset(page->pixels, 0, bytes);
+    // Through the params so alpha pages can be created too
+    page->image = ctx->params.renderCreateTexture(
+        ctx->params.userPtr,
+        type,
+        atlas->pageSize,
+        atlas->pageSize,
+        atlas->imageFlags,
+        page->pixels);
+    if (page->image == 0)
+        goto error;
+    atlas->npages++;
+    return page;
+
+error:
+    fons__deleteAtlas(page->packer);
+    NVG_FREE(page->pixels);
+    return NULL;
+}
+
+// Copies `w` x `h` pixels with `stride` bytes per row to x, y of the page, surrounded by NVG_ATLAS_PADDING copies of
+// their edges
+static void nvg__atlasBlit(
+    NVGatlas*            atlas,
+    NVGatlasPage*        page,
+    int                  x,
+    int                  y,
+    int                  w,
+    int                  h,
+    const unsigned char* data,
+    int                  stride)
+{
+    int bpp   = nvg__atlasBpp(page->type);
+    int pitch = atlas->pageSize * bpp;
+    int i, j;
+    for (i = -NVG_ATLAS_PADDING; i < h + NVG_ATLAS_PADDING; i++)
+    {
+        const unsigned char* src = data + (size_t)nvg__clampi(i, 0, h - 1) * stride;
+        unsigned char*       dst = page->pixels + (size_t)(y + i) * pitch + x * bpp;
+        memcpy(dst, src, (size_t)w * bpp);
+        for (j = 1; j <= NVG_ATLAS_PADDING; j++)
+        {
+            memcpy(dst - j * bpp, src, bpp);
+            memcpy(dst + (w - 1 + j) * bpp, src + (w - 1) * bpp, bpp);
+        }
+    }
+}
+
+// Finds room for a `w` x `h` image on a page of `type`. Returns the page index or -1
+static int nvg__atlasPlace(NVGatlas* atlas, int type, int w, int h, int* x, int* y)
+{
+    int i;
+    for (i = 0; i < atlas->npages; i++)
+    {
+        if (atlas->pages[i].type != type)
+            continue;
+        if (fons__atlasAddRect(atlas->pages[i].packer, w + NVG_ATLAS_PADDING * 2, h + NVG_ATLAS_PADDING * 2, x, y))
+        {
+            *x += NVG_ATLAS_PADDING;
+            *y += NVG_ATLAS_PADDING;
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void nvg__atlasUpload(NVGcontext* ctx, NVGatlasPage* page, int x, int y, int w, int h)
+{
+    ctx->params.renderUpdateTexture(ctx->params.userPtr, page->image, x, y, w, h, page->pixels);
+}
+
+typedef struct NVGatlasSortItem
+{
+    int index;
+    int w, h;
+} NVGatlasSortItem;
+
+static int nvg__atlasCompareHeight(const void* a, const void* b)
+{
+    const NVGatlasSortItem* ia = (const NVGatlasSortItem*)a;
+    const NVGatlasSortItem* ib = (const NVGatlasSortItem*)b;
+    if (ia->h != ib->h)
+        return ib->h - ia->h;
+    return ib->w - ia->w;
+}
+
+// Repacks the images of `type` tallest first, then deletes the pages left empty. Images that no longer fit are
+// evicted.
+static void nvg__atlasDefragment(NVGcontext* ctx, NVGatlas* atlas, int type)
+{
+    unsigned char**   pixels;
+    NVGatlasSortItem* order;
+    int*              remap;
+    int               i, n = 0, npages = 0;
+    int               count = atlas->npages;
+    int               bpp   = nvg__atlasBpp(type);
+    int               pitch = atlas->pageSize * bpp;
+    size_t            bytes = (size_t)pitch * atlas->pageSize;
+
+    pixels = (unsigned char**)NVG_MALLOC(sizeof(unsigned char*) * (count + 1));
+    order  = (NVGatlasSortItem*)NVG_MALLOC(sizeof(NVGatlasSortItem) * (atlas->nentries + 1));
+    remap  = (int*)NVG_MALLOC(sizeof(int) * (count + 1));
+    if (pixels == NULL || order == NULL || remap == NULL)
+        goto done;
+    memset(pixels, 0, sizeof(unsigned char*) * count);
+
+    // Allocate every new page buffer before touching anything, so a failure leaves the atlas as it was
+    for (i = 0; i < count; i++)
+    {
+        if (atlas->pages[i].type != type)
+            continue;
+        pixels[i] = (unsigned char*)NVG_MALLOC(bytes);
+        if (pixels[i] == NULL)
+            goto done;
+        memset(pixels[i], 0, bytes);
+    }
+    // Swap them in, `pixels` keeps the old ones to copy from
+    for (i = 0; i < count; i++)
+    {
+        NVGatlasPage*  page = &atlas->pages[i];
+        unsigned char* old  = page->pixels;
+        if (page->type != type)
+            continue;
+        page->pixels  = pixels[i];
+        pixels[i]     = old;
+        page->nimages = 0;
+        fons__atlasReset(page->packer, atlas->pageSize, atlas->pageSize);
+    }
+
+    for (i = 0; i < atlas->nentries; i++)
+    {
+        NVGatlasEntry* entry = &atlas->entries[i];
+        if (entry->page < 0 || atlas->pages[entry->page].type != type)
+            continue;
+        order[n].index = i;
+        order[n].w     = entry->w;
+        order[n].h     = entry->h;
+        n++;
+    }
+    qsort(order, n, sizeof(NVGatlasSortItem), nvg__atlasCompareHeight);
+
+    for (i = 0; i < n; i++)
+    {
+        NVGatlasEntry* entry = &atlas->entries[order[i].index];
+        int            x, y;
+        int            page = nvg__atlasPlace(atlas, type, entry->w, entry->h, &x, &y);
+        if (page < 0)
+        {
+            entry->page = -1;
+            continue;
+        }
+        nvg__atlasBlit(
+            atlas,
+            &atlas->pages[page],
+            x,
+            y,
+            entry->w,
+            entry->h,
+            pixels[entry->page] + (size_t)entry->y * pitch + entry->x * bpp,
+            pitch);
+        entry->page = page;
+        entry->x    = x;
+        entry->y    = y;
+        atlas->pages[page].nimages++;
+    }
+
+    // Drop the pages left empty & upload the others
+    for (i = 0; i < count; i++)
+    {
+        NVGatlasPage* page = &atlas->pages[i];
+        remap[i]           = -1;
+        if (page->type == type && page->nimages == 0)
+        {
+            nvgDeleteImage(ctx, page->image);
+            fons__deleteAtlas(page->packer);
+            NVG_FREE(page->pixels);
+            continue;
+        }
+        if (page->type == type)
+            nvg__atlasUpload(ctx, page, 0, 0, atlas->pageSize, atlas->pageSize);
+        remap[i]               = npages;
+        atlas->pages[npages++] = *page;
+    }
+    atlas->npages = npages;
+    for (i = 0; i < atlas->nentries; i++)
+        if (atlas->entries[i].page >= 0)
+            atlas->entries[i].page = remap[atlas->entries[i].page];
+
+done:
+    // Old buffers on success, new ones on failure
+    if (pixels != NULL)
+        for (i = 0; i < count; i++)
+            NVG_FREE(pixels[i]);
+    NVG_FREE(pixels);
+    NVG_FREE(order);
+    NVG_FREE(remap);
+}
+
+// Evicts the least recently used images of `type` until `area` pixels are freed, or none are left
+static void nvg__atlasEvict(NVGatlas* atlas, int type, int area)
+{
+    while (area > 0)
+    {
+        NVGatlasEntry* lru = NULL;
+        int            i;
+        for (i = 0; i < atlas->nentries; i++)
+        {
+            NVGatlasEntry* entry = &atlas->entries[i];
+            if (entry->page < 0 || atlas->pages[entry->page].type != type)
+                continue;
+            if (lru == NULL || (int)(entry->lastUse - lru->lastUse) < 0)
+                lru = entry;
+        }
+        if (lru == NULL)
+            return;
+        area -= (lru->w + NVG_ATLAS_PADDING * 2) * (lru->h + NVG_ATLAS_PADDING * 2);
+        atlas->pages[lru->page].nimages--;
+        lru->page = -1;
+    }
+}
+
+void nvgImageAtlas(NVGcontext* ctx, int pageSize, int maxPages, int imageFlags)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    if (compat == NULL)
+        return;
+
+    if (compat->atlas != NULL &&
+        (maxPages <= 0 || compat->atlas->pageSize != pageSize || compat->atlas->imageFlags != imageFlags))
+    {
+        nvg__deleteAtlas(ctx, compat->atlas);
+        compat->atlas = NULL;
+    }
+    if (maxPages <= 0 || pageSize <= 0)
+        return;
+    if (compat->atlas == NULL)
+    {
+        compat->atlas = (NVGatlas*)nvg__compatMalloc(compat, sizeof(NVGatlas));
+        if (compat->atlas == NULL)
+            return;
+        memset(compat->atlas, 0, sizeof(NVGatlas));
+        compat->atlas->pageSize   = pageSize;
+        compat->atlas->imageFlags = imageFlags;
+    }
+    compat->atlas->maxPages = maxPages;
+}
+
+static int nvg__atlasAdd(NVGcontext* ctx, int type, int w, int h, const unsigned char* data)
+{
+    NVGcompat*     compat = nvg__compat(ctx);
+    NVGatlas*      atlas  = compat != NULL ? compat->atlas : NULL;
+    NVGatlasEntry* entry  = NULL;
+    int            area   = (w + NVG_ATLAS_PADDING * 2) * (h + NVG_ATLAS_PADDING * 2);
+    int            i, x, y, page, ntype = 0;
+
+    if (atlas == NULL || w <= 0 || h <= 0 || w > atlas->pageSize / 2 || h > atlas->pageSize / 2)
+        return 0;
+
+    for (i = 0; i < atlas->nentries && entry == NULL; i++)
+        if (atlas->entries[i].page < 0 && atlas->entries[i].generation < 0x7fff)
+            entry = &atlas->entries[i];
+    if (entry == NULL)
+    {
+        if (atlas->nentries >= 0xffff ||
+            ! nvg__compatReserve((void**)&atlas->entries, &atlas->centries, atlas->nentries + 1, sizeof(NVGatlasEntry)))
+            return 0;
+        entry = &atlas->entries[atlas->nentries++];
+        memset(entry, 0, sizeof(*entry));
+        entry->page = -1;
+    }
+
+    page = nvg__atlasPlace(atlas, type, w, h, &x, &y);
+    for (i = 0; i < atlas->npages; i++)
+        ntype += atlas->pages[i].type == type;
+    if (page < 0 && atlas->npages < atlas->maxPages && nvg__atlasAddPage(ctx, atlas, type) != NULL)
+        page = nvg__atlasPlace(atlas, type, w, h, &x, &y);
+    // Moving images would break the paints already used by the frame
+    if (page < 0 && ! compat->inFrame && ntype > 0)
+    {
+        nvg__atlasDefragment(ctx, atlas, type);
+        page = nvg__atlasPlace(atlas, type, w, h, &x, &y);
+        if (page < 0)
+        {
+            nvg__atlasEvict(atlas, type, area);
+            nvg__atlasDefragment(ctx, atlas, type);
+            page = nvg__atlasPlace(atlas, type, w, h, &x, &y);
+            if (page < 0 && atlas->npages < atlas->maxPages && nvg__atlasAddPage(ctx, atlas, type) != NULL)
+                page = nvg__atlasPlace(atlas, type, w, h, &x, &y);
+        }
+    }
+    if (page < 0)
+        return 0;
+
+    nvg__atlasBlit(atlas, &atlas->pages[page], x, y, w, h, data, w * nvg__atlasBpp(type));
+    nvg__atlasUpload(
+        ctx,
+        &atlas->pages[page],
+        x - NVG_ATLAS_PADDING,
+        y - NVG_ATLAS_PADDING,
+        w + NVG_ATLAS_PADDING * 2,
+        h + NVG_ATLAS_PADDING * 2);
+    atlas->pages[page].nimages++;
+    entry->generation++;
+    entry->page    = page;
+    entry->x       = x;
+    entry->y       = y;
+    entry->w       = w;
+    entry->h       = h;
+    entry->lastUse = atlas->useStamp++;
+    return entry->generation << 16 | (int)(entry - atlas->entries + 1);
+}
+
+int nvgAtlasAddRGBA(NVGcontext* ctx, int w, int h, const unsigned char* data)
+{
+    return nvg__atlasAdd(ctx, NVG_TEXTURE_RGBA, w, h, data);
+}
+
+int nvgAtlasAddAlpha(NVGcontext* ctx, int w, int h, const unsigned char* data)
+{
+    return nvg__atlasAdd(ctx, NVG_TEXTURE_ALPHA, w, h, data);
+}
+
+void nvgAtlasRemove(NVGcontext* ctx, int id)
+{
+    NVGcompat*     compat = nvg__compat(ctx);
+    NVGatlasEntry* entry  = compat != NULL ? nvg__atlasEntry(compat->atlas, id) : NULL;
+    if (entry == NULL)
+        return;
+    compat->atlas->pages[entry->page].nimages--;
+    entry->page = -1;
+}
+
+int nvgAtlasImage(NVGcontext* ctx, int id, float* uv)
+{
+    NVGcompat*     compat = nvg__compat(ctx);
+    NVGatlasEntry* entry  = compat != NULL ? nvg__atlasEntry(compat->atlas, id) : NULL;
+    float          size;
+    if (entry == NULL)
+        return 0;
+    size           = (float)compat->atlas->pageSize;
+    entry->lastUse = compat->atlas->useStamp++;
+    if (uv != NULL)
+    {
+        uv[0] = entry->x / size;
+        uv[1] = entry->y / size;
+        uv[2] = (entry->x + entry->w) / size;
+        uv[3] = (entry->y + entry->h) / size;
+    }
+    return compat->atlas->pages[entry->page].image;
+}
+
+NVGpaint nvgAtlasPattern(NVGcontext* ctx, int id, float ox, float oy, float ex, float ey, float angle, float alpha)
+{
+    NVGcompat*     compat = nvg__compat(ctx);
+    NVGatlasEntry* entry;
+    NVGpaint       p;
+    float          sx, sy, dx, dy, cs, sn;
+    int            image = nvgAtlasImage(ctx, id, NULL);
+
+    if (image == 0)
+    {
+        memset(&p, 0, sizeof(p));
+        return p;
+    }
+    entry = nvg__atlasEntry(compat->atlas, id);
+    sx    = ex / entry->w;
+    sy    = ey / entry->h;
+    // Shift the page so the image's corner lands on ox, oy after the rotation
+    cs = cosf(angle);
+    sn = sinf(angle);
+    dx = entry->x * sx;
+    dy = entry->y * sy;
+    return nvgImagePattern(
+        ctx,
+        ox - (dx * cs - dy * sn),
+        oy - (dx * sn + dy * cs),
+        compat->atlas->pageSize * sx,
+        compat->atlas->pageSize * sy,
+        angle,
+        image,
+        alpha);
+}
+
+void nvgAtlasDefragment(NVGcontext* ctx)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    if (compat == NULL || compat->atlas == NULL || compat->inFrame)
+        return;
+    nvg__atlasDefragment(ctx, compat->atlas, NVG_TEXTURE_RGBA);
+    nvg__atlasDefragment(ctx, compat->atlas, NVG_TEXTURE_ALPHA);
+}
+
+int nvgGetAtlasStats(NVGcontext* ctx, NanoVGAtlasPageStats* stats, int maxPages)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    NVGatlas*  atlas;
+    int        i, n;
+
+    if (compat == NULL || compat->atlas == NULL)
+        return 0;
+    atlas = compat->atlas;
+    n     = nvg__mini(maxPages, atlas->npages);
+    for (i = 0; i < n; i++)
+    {
+        size_t bpp = nvg__atlasBpp(atlas->pages[i].type);
+        memset(&stats[i], 0, sizeof(stats[i]));
+        stats[i].image     = atlas->pages[i].image;
+        stats[i].alpha     = atlas->pages[i].type == NVG_TEXTURE_ALPHA;
+        stats[i].images    = atlas->pages[i].nimages;
+        stats[i].pageBytes = (size_t)atlas->pageSize * atlas->pageSize * bpp;
+    }
+    for (i = 0; i < atlas->nentries; i++)
+    {
+        NVGatlasEntry* entry = &atlas->entries[i];
+        size_t         bytes;
+        if (entry->page < 0 || entry->page >= n)
+            continue;
+        bytes = (size_t)entry->w * entry->h * nvg__atlasBpp(atlas->pages[entry->page].type);
+        stats[entry->page].usedBytes += bytes;
+        stats[entry->page].separateBytes +=
+            (bytes + NVG_ATLAS_TEXTURE_ALIGN - 1) / NVG_ATLAS_TEXTURE_ALIGN * NVG_ATLAS_TEXTURE_ALIGN;
+    }
+    return n;
+}
+
+//
+// Image region writes & streaming images
+//
+
+// Most backing textures of a streaming image
+#define NVG_STREAM_MAX_BUFFERS 4
+
+typedef struct NVGstream
+{
+    int            nimages; // 0 when free
+    int            images[NVG_STREAM_MAX_BUFFERS];
+    int            current;
+    int            width;
+    int            height;
+    unsigned char* pixels;
+    // Rect, as x0, y0, x1, y1, written since each texture was last uploaded
+    int dirty[NVG_STREAM_MAX_BUFFERS][4];
+    // Set by writes made since the last rotation
+    int pending;
+} NVGstream;
+
+typedef struct NVGstreams
+{
+    NVGstream* streams;
+    int        nstreams;
+    int        cstreams;
+} NVGstreams;
+
+// Bookkeeping of a rect written to an image by nvgWriteImageRegion or the backends' own write functions, which don't
+// go through renderUpdateTexture: telemetry, damage & capture
+static void nvg__compatImageWritten(
+    NVGcontext* ctx,
+    int         image,
+    int         x,
+    int         y,
+    int         w,
+    int         h,
+    const void* data,
+    int         pitch)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    if (compat == NULL)
+        return;
+    if (compat->telemetry)
+        nvg__telemetryUpload(compat, (size_t)w * h * nvg__compatImageBpp(compat, image), 0);
+    if (compat->damage)
+        nvg__damageImageUpdated(compat->damage, image);
+    if (compat->capture)
+        nvg__captureUpdateRegion(compat, image, x, y, w, h, (const unsigned char*)data, (size_t)pitch);
+}
+
+void nvgWriteImageRegion(NVGcontext* ctx, int image, int x, int y, int w, int h, const void* data, int pitch)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    int        width = 0, height = 0;
+
+    if (compat == NULL || w <= 0 || h <= 0)
+        return;
+    nvgImageSize(ctx, image, &width, &height);
+    if (x < 0 || y < 0 || x + w > width || y + h > height)
+        return;
+
+    // The D3D11 & software renderer functions do the bookkeeping themselves, so direct calls to them are covered too
+#if defined(_WIN32)
+    d3dnvgWriteImageRegion(ctx, image, x, y, w, h, data, pitch);
+#elif defined(__linux__)
+    cpunvgWriteImageRegion(ctx, image, x, y, w, h, data, pitch);
+#else
+    {
+        // renderUpdateTexture reads the rect at `x`, `y` of a whole image, whose rows are `width` pixels apart. The
+        // rows are repacked to that pitch in a scratch holding only the rect, & the pointer passed is moved back by
+        // the offset of the rect, so the backend's reads land in the scratch.
+        int            bpp        = nvg__compatImageBpp(compat, image);
+        size_t         imagePitch = (size_t)width * bpp;
+        size_t         offset     = (size_t)y * imagePitch + (size_t)x * bpp;
+        unsigned char* scratch;
+        int            i;
+
+        if (! nvg__compatReserve(
+                (void**)&compat->uploadScratch,
+                &compat->cuploadScratch,
+                (int)((h - 1) * imagePitch + (size_t)w * bpp),
+                1))
+            return;
+        scratch = compat->uploadScratch;
+        for (i = 0; i < h; i++)
+            memcpy(scratch + i * imagePitch, (const unsigned char*)data + (size_t)i * pitch, (size_t)w * bpp);
+        nvg__compatImageWritten(ctx, image, x, y, w, h, data, pitch);
+        compat->backend.renderUpdateTexture(compat->backend.userPtr, image, x, y, w, h, scratch - offset);
+    }
+#endif
+}
+
+static void nvg__deleteStreams(NVGcontext* ctx, NVGstreams* streams)
+{
+    int i, j;
+    if (streams == NULL)
+        return;
+    for (i = 0; i < streams->nstreams; i++)
+    {
+        if (ctx != NULL)
+            for (j = 0; j < streams->streams[i].nimages; j++)
+                nvgDeleteImage(ctx, streams->streams[i].images[j]);
+        NVG_FREE(streams->streams[i].pixels);
+    }
+    NVG_FREE(streams->streams);
+    NVG_FREE(streams);
+}
+
+static NVGstream* nvg__stream(NVGcompat* compat, int stream)
+{
+    if (compat == NULL || compat->streams == NULL || stream <= 0 || stream > compat->streams->nstreams)
+        return NULL;
+    if (compat->streams->streams[stream - 1].nimages == 0)
+        return NULL;
+    return &compat->streams->streams[stream - 1];
+}
+
+int nvgCreateStreamImage(NVGcontext* ctx, int w, int h, int imageFlags, int buffers, const unsigned char* data)
+{
+    NVGcompat*  compat = nvg__compat(ctx);
+    NVGstreams* streams;
+    NVGstream*  stream = NULL;
+    size_t      bytes  = (size_t)w * h * 4;
+    int         i;
+
+    if (compat == NULL || w <= 0 || h <= 0)
+        return 0;
+    if (compat->streams == NULL)
+    {
+        compat->streams = (NVGstreams*)nvg__compatMalloc(compat, sizeof(NVGstreams));
+        if (compat->streams == NULL)
+            return 0;
+        memset(compat->streams, 0, sizeof(NVGstreams));
+    }
+    streams = compat->streams;
+
+    for (i = 0; i < streams->nstreams && stream == NULL; i++)
+        if (streams->streams[i].nimages == 0)
+            stream = &streams->streams[i];
+    if (stream == NULL)
+    {
+        if (! nvg__compatReserve(
+                (void**)&streams->streams,
+                &streams->cstreams,
+                streams->nstreams + 1,
+                sizeof(NVGstream)))
+            return 0;
+        stream = &streams->streams[streams->nstreams++];
+    }
+    memset(stream, 0, sizeof(*stream));
+
+    stream->pixels = (unsigned char*)NVG_MALLOC(bytes);
+    if (stream->pixels == NULL)
+        return 0;
+    if (data != NULL)
+        memcpy(stream->pixels, data, bytes);
+    else
+        memset(stream->pixels, 0, bytes);
+    stream->width  = w;
+    stream->height = h;
+
+    buffers = nvg__clampi(buffers, 1, NVG_STREAM_MAX_BUFFERS);
+    for (i = 0; i < buffers; i++)
+    {
+        int image = nvgCreateImageRGBA(ctx, w, h, imageFlags, stream->pixels);
+        if (image == 0)
+            break;
+        stream->images[stream->nimages++] = image;
+    }
+    if (stream->nimages < buffers)
+    {
+        for (i = 0; i < stream->nimages; i++)
+            nvgDeleteImage(ctx, stream->images[i]);
+        NVG_FREE(stream->pixels);
+        stream->nimages = 0;
+        return 0;
+    }
+    return (int)(stream - streams->streams) + 1;
+}
+
+void nvgStreamImageWrite(NVGcontext* ctx, int stream, int x, int y, int w, int h, const void* data, int pitch)
+{
+    NVGstream* s = nvg__stream(nvg__compat(ctx), stream);
+    int        i;
+
+    if (s == NULL || w <= 0 || h <= 0 || x < 0 || y < 0 || x + w > s->width || y + h > s->height)
+        return;
+    for (i = 0; i < h; i++)
+        memcpy(s->pixels + ((size_t)(y + i) * s->width + x) * 4, (const unsigned char*)data + (size_t)i * pitch, w * 4);
+
+    for (i = 0; i < s->nimages; i++)
+    {
+        int* dirty = s->dirty[i];
+        if (dirty[2] <= dirty[0])
+        {
+            dirty[0] = x;
+            dirty[1] = y;
+            dirty[2] = x + w;
+            dirty[3] = y + h;
+        }
+        else
+        {
+            dirty[0] = nvg__mini(dirty[0], x);
+            dirty[1] = nvg__mini(dirty[1], y);
+            dirty[2] = nvg__maxi(dirty[2], x + w);
+            dirty[3] = nvg__maxi(dirty[3], y + h);
+        }
+    }
+    s->pending = 1;
+}
+
+int nvgStreamImage(NVGcontext* ctx, int stream)
+{
+    NVGstream* s = nvg__stream(nvg__compat(ctx), stream);
+    int*       dirty;
+
+    if (s == NULL)
+        return 0;
+    if (! s->pending)
+        return s->images[s->current];
+
+    // Move on to the texture drawn longest ago & bring it up to date with the writes made since
+    s->current = (s->current + 1) % s->nimages;
+    s->pending = 0;
+    dirty      = s->dirty[s->current];
+    if (dirty[2] > dirty[0])
+    {
+        ctx->params.renderUpdateTexture(
+            ctx->params.userPtr,
+            s->images[s->current],
+            dirty[0],
+            dirty[1],
+            dirty[2] - dirty[0],
+            dirty[3] - dirty[1],
+            s->pixels);
+        memset(dirty, 0, sizeof(int) * 4);
+    }
+    return s->images[s->current];
+}
+
+void nvgDeleteStreamImage(NVGcontext* ctx, int stream)
+{
+    NVGstream* s = nvg__stream(nvg__compat(ctx), stream);
+    int        i;
+    if (s == NULL)
+        return;
+    for (i = 0; i < s->nimages; i++)
+        nvgDeleteImage(ctx, s->images[i]);
+    NVG_FREE(s->pixels);
+    s->pixels  = NULL;
+    s->nimages = 0;
+}
+
+//
+// Context memory: creation with an allocator, frame arena & shrink policy
+//
+
+// Smallest chunk of the frame arena
+#define NVG_ARENA_MIN_CHUNK (64 * 1024)
+#define NVG_ARENA_ALIGN 16
+
+typedef struct NVGarenaChunk
+{
+    struct NVGarenaChunk* next;
+    size_t                size;
+    size_t                used;
+} NVGarenaChunk;
+
+// Chunk data starts after the header, rounded up to NVG_ARENA_ALIGN
+#define NVG_ARENA_HEADER ((sizeof(NVGarenaChunk) + NVG_ARENA_ALIGN - 1) & ~(size_t)(NVG_ARENA_ALIGN - 1))
+
+typedef struct NVGarena
+{
+    NVGarenaChunk* chunks;  // Newest first
+    size_t         reserve; // Size of the next chunk, the whole previous frame once it needed several
+} NVGarena;
+
+typedef struct NVGshrinkBuffer
+{
+    size_t peak;       // Most used this frame
+    size_t windowPeak; // Most used since the capacity went over the slack
+    int    overFrames;
+} NVGshrinkBuffer;
+
+typedef struct NVGshrink
+{
+    int             frames;
+    float           slack;
+    NVGshrinkBuffer commands;
+    NVGshrinkBuffer points;
+    NVGshrinkBuffer paths;
+    NVGshrinkBuffer verts;
+    NVGshrinkBuffer arena;
+} NVGshrink;
+
+// Allocates from the context's allocator, for state created after the context
+static void* nvg__compatMalloc(NVGcompat* compat, size_t size)
+{
+    NVGallocState* prev = g_allocCurrent;
+    void*          ptr;
+    if (compat->alloc != NULL)
+        g_allocCurrent = compat->alloc;
+    ptr            = NVG_MALLOC(size);
+    g_allocCurrent = prev;
+    return ptr;
+}
+
+NVGcontext* nvgCreateContextAllocator(void* window, int flags, int w, int h, const NVGallocator* allocator)
+{
+    NVGallocState* state = (NVGallocState*)malloc(sizeof(NVGallocState));
+    NVGallocState* prev  = g_allocCurrent;
+    NVGcontext*    ctx;
+    NVGcompat*     compat = NULL;
+
+    if (state == NULL)
+        return NULL;
+    memset(state, 0, sizeof(*state));
+    state->allocator = allocator != NULL ? *allocator : g_allocDefault.allocator;
+    state->counted   = 1;
+
+    g_allocCurrent = state;
+    ctx            = nvgCreateContext(window, flags, w, h);
+    if (ctx != NULL)
+        compat = nvg__compat(ctx);
+    g_allocCurrent = prev;
+
+    if (compat == NULL)
+    {
+        if (ctx != NULL)
+            nvgDeleteContext(ctx);
+        nvg__allocRelease(state);
+        return NULL;
+    }
+    compat->alloc = state;
+    return ctx;
+}
+
+static size_t nvg__arenaUsed(const NVGarena* arena)
+{
+    const NVGarenaChunk* chunk;
+    size_t               used = 0;
+    for (chunk = arena->chunks; chunk != NULL; chunk = chunk->next)
+        used += chunk->used;
+    return used;
+}
+
+static void nvg__arenaFreeChunks(NVGarena* arena)
+{
+    while (arena->chunks != NULL)
+    {
+        NVGarenaChunk* next = arena->chunks->next;
+        NVG_FREE(arena->chunks);
+        arena->chunks = next;
+    }
+}
+
+static void nvg__deleteArena(NVGarena* arena)
+{
+    if (arena == NULL)
+        return;
+    nvg__arenaFreeChunks(arena);
+    NVG_FREE(arena);
+}
+
+// Empties the arena. When the frame needed several chunks, they're replaced by one as large as all of them
+static void nvg__arenaReset(NVGarena* arena)
+{
+    NVGarenaChunk* chunk;
+    if (arena->chunks == NULL)
+        return;
+    if (arena->chunks->next != NULL)
+    {
+        arena->reserve = 0;
+        for (chunk = arena->chunks; chunk != NULL; chunk = chunk->next)
+            arena->reserve += chunk->size;
+        nvg__arenaFreeChunks(arena);
+        return;
+    }
+    arena->chunks->used = 0;
+}
+
+void* nvgFrameAlloc(NVGcontext* ctx, size_t size)
+{
+    NVGcompat*     compat = nvg__compat(ctx);
+    NVGarena*      arena;
+    NVGarenaChunk* chunk;
+    size_t         chunkSize;
+
+    if (compat == NULL)
+        return NULL;
+    if (compat->arena == NULL)
+    {
+        compat->arena = (NVGarena*)nvg__compatMalloc(compat, sizeof(NVGarena));
+        if (compat->arena == NULL)
+            return NULL;
+        memset(compat->arena, 0, sizeof(NVGarena));
+    }
+    arena = compat->arena;
+    size  = (size + NVG_ARENA_ALIGN - 1) & ~(size_t)(NVG_ARENA_ALIGN - 1);
+
+    chunk = arena->chunks;
+    if (chunk == NULL || chunk->size - chunk->used < size)
+    {
+        chunkSize = arena->reserve > NVG_ARENA_MIN_CHUNK ? arena->reserve : NVG_ARENA_MIN_CHUNK;
+        if (chunk != NULL && chunk->size * 2 > chunkSize)
+            chunkSize = chunk->size * 2;
+        if (size > chunkSize)
+            chunkSize = size;
+        chunk = (NVGarenaChunk*)nvg__compatMalloc(compat, NVG_ARENA_HEADER + chunkSize);
+        if (chunk == NULL)
+            return NULL;
+        chunk->next    = arena->chunks;
+        chunk->size    = chunkSize;
+        chunk->used    = 0;
+        arena->chunks  = chunk;
+        arena->reserve = 0;
+    }
+    chunk->used += size;
+    return (unsigned char*)chunk + NVG_ARENA_HEADER + chunk->used - size;
+}
+
+void nvgShrinkPolicy(NVGcontext* ctx, int frames, float slack)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    if (compat == NULL)
+        return;
+
+    if (frames <= 0)
+    {
+        NVG_FREE(compat->shrink);
+        compat->shrink = NULL;
+        return;
+    }
+    if (compat->shrink == NULL)
+    {
+        compat->shrink = (NVGshrink*)nvg__compatMalloc(compat, sizeof(NVGshrink));
+        if (compat->shrink == NULL)
+            return;
+        memset(compat->shrink, 0, sizeof(NVGshrink));
+    }
+    compat->shrink->frames = frames;
+    compat->shrink->slack  = nvg__maxf(slack, 1.0f);
+}
+
+static void nvg__shrinkPeak(NVGshrinkBuffer* buffer, int used)
+{
+    if ((size_t)used > buffer->peak)
+        buffer->peak = (size_t)used;
+}
+
+// Records the use of the context's buffers, called on each draw call with the number of vertices it submits. nanovg
+// builds each call's vertices in its vertex cache but only tracks the cache's capacity, not how much it wrote.
+static void nvg__shrinkSample(NVGcompat* compat, int nverts)
+{
+    NVGshrink*    shrink = compat->shrink;
+    NVGcontext*   ctx    = compat->ctx;
+    NVGpathCache* cache  = ctx->cache;
+
+    nvg__shrinkPeak(&shrink->commands, ctx->ncommands);
+    nvg__shrinkPeak(&shrink->points, cache->npoints);
+    nvg__shrinkPeak(&shrink->paths, cache->npaths);
+    nvg__shrinkPeak(&shrink->verts, nverts);
+}
+
+// Ends the frame of a buffer. Returns the capacity to shrink it to, or 0 to keep it
+static size_t nvg__shrinkCheck(const NVGshrink* shrink, NVGshrinkBuffer* buffer, size_t capacity, size_t minimum)
+{
+    size_t peak = buffer->peak > minimum ? buffer->peak : minimum;
+    size_t target;
+
+    buffer->windowPeak = buffer->peak > buffer->windowPeak ? buffer->peak : buffer->windowPeak;
+    buffer->peak       = 0;
+    if (capacity <= peak * shrink->slack)
+    {
+        buffer->overFrames = 0;
+        buffer->windowPeak = 0;
+        return 0;
+    }
+    if (++buffer->overFrames < shrink->frames)
+        return 0;
+
+    target             = buffer->windowPeak + buffer->windowPeak / 4;
+    target             = target > minimum ? target : minimum;
+    buffer->overFrames = 0;
+    buffer->windowPeak = 0;
+    return target < capacity ? target : 0;
+}
+
+// Shrinks `*ptr` to `count` elements, keeping it as is on failure
+static void nvg__shrinkArray(void** ptr, int* capacity, size_t count, int elemSize)
+{
+    void* data;
+    if (count == 0)
+        return;
+    data = NVG_REALLOC(*ptr, count * elemSize);
+    if (data == NULL)
+        return;
+    *ptr      = data;
+    *capacity = (int)count;
+}
+
+// Applies the shrink policy, after the backend has consumed the frame
+static void nvg__shrinkEndFrame(NVGcompat* compat)
+{
+    NVGshrink*    shrink = compat->shrink;
+    NVGcontext*   ctx    = compat->ctx;
+    NVGpathCache* cache  = ctx->cache;
+    size_t        count;
+
+    // The current path & the cache's content outlive the frame, the vertices were sampled with the calls
+    nvg__shrinkSample(compat, 0);
+    count = nvg__shrinkCheck(shrink, &shrink->commands, ctx->ccommands, NVG_INIT_COMMANDS_SIZE);
+    nvg__shrinkArray((void**)&ctx->commands, &ctx->ccommands, count, sizeof(float));
+    count = nvg__shrinkCheck(shrink, &shrink->points, cache->cpoints, NVG_INIT_POINTS_SIZE);
+    nvg__shrinkArray((void**)&cache->points, &cache->cpoints, count, sizeof(NVGpoint));
+    count = nvg__shrinkCheck(shrink, &shrink->paths, cache->cpaths, NVG_INIT_PATHS_SIZE);
+    nvg__shrinkArray((void**)&cache->paths, &cache->cpaths, count, sizeof(NVGpath));
+    count = nvg__shrinkCheck(shrink, &shrink->verts, cache->cverts, NVG_INIT_VERTS_SIZE);
+    nvg__shrinkArray((void**)&cache->verts, &cache->cverts, count, sizeof(NVGvertex));
+
+    // The arena is shrunk by dropping its chunk, the next one is allocated at the new size
+    if (compat->arena != NULL && compat->arena->chunks != NULL && compat->arena->chunks->next == NULL)
+    {
+        NVGarena* arena    = compat->arena;
+        shrink->arena.peak = arena->chunks->used;
+        count              = nvg__shrinkCheck(shrink, &shrink->arena, arena->chunks->size, NVG_ARENA_MIN_CHUNK);
+        if (count != 0)
+        {
+            nvg__arenaFreeChunks(arena);
+            arena->reserve = count;
+        }
+    }
+}
+
+//
+// Frame capture & replay
+//
+// A trace is an NVGcaptureHeader followed by records, each an NVGcaptureRecordHeader and its payload padded to 4
+// bytes. Records are appended to a buffer on the render thread, which is handed to a writer thread at the end of each
+// frame, so the render thread never waits on the disk unless NVG_CAPTURE_MAX_QUEUED bytes are already queued.
+// Structs are stored in the layout of this build, checked through the sizes in the header.
+//
+
+#ifndef NVG_CAPTURE_MAX_QUEUED
+#define NVG_CAPTURE_MAX_QUEUED (64 * 1024 * 1024)
+#endif
+
+#define NVG_CAPTURE_MAGIC 0x5447564e // "NVGT"
+#define NVG_CAPTURE_VERSION 1
+
+enum NVGcaptureRecordType
+{
+    NVG_CAPTURE_VIEWPORT = 1,
+    NVG_CAPTURE_FLUSH,
+    NVG_CAPTURE_CANCEL,
+    NVG_CAPTURE_FILL,
+    NVG_CAPTURE_STROKE,
+    NVG_CAPTURE_TRIANGLES,
+    NVG_CAPTURE_CREATE_TEXTURE,
+    NVG_CAPTURE_UPDATE_TEXTURE,
+    NVG_CAPTURE_BIND_FRAMEBUFFER,
+    NVG_CAPTURE_CLEAR,
+};
+
+typedef struct NVGcaptureHeader
+{
+    unsigned int magic;
+    int          version;
+    int          vertexSize;
+    int          drawSize;
+    int          pathSize;
+    int          textureSize;
+} NVGcaptureHeader;
+
+typedef struct NVGcaptureRecordHeader
+{
+    unsigned int type;
+    unsigned int size;
+} NVGcaptureRecordHeader;
+
+// Payload of fills, strokes & triangles. Fills & strokes are followed by `count` NVGcapturePath, then the vertices of
+// each path, fill first. Triangles are followed by `count` vertices.
+typedef struct NVGcaptureDraw
+{
+    NVGpaint                   paint;
+    NVGcompositeOperationState compositeOperation;
+    NVGscissor                 scissor;
+    float                      fringe;
+    float                      strokeWidth;
+    float                      bounds[4];
+    int                        count;
+} NVGcaptureDraw;
+
+typedef struct NVGcapturePath
+{
+    int nfill;
+    int nstroke;
+    int closed;
+    int nbevel;
+    int winding;
+    int convex;
+} NVGcapturePath;
+
+// Payload of texture creates & updates, followed by the rows `y` to `y + h` of the image when `hasData` is set
+typedef struct NVGcaptureTexture
+{
+    int image;
+    int type;
+    int width;
+    int height;
+    int imageFlags;
+    int x;
+    int y;
+    int w;
+    int h;
+    int hasData;
+} NVGcaptureTexture;
+
+typedef struct NVGcaptureBuffer
+{
+    unsigned char*           data;
+    size_t                   size;
+    size_t                   capacity;
+    struct NVGcaptureBuffer* next;
+} NVGcaptureBuffer;
+
+typedef struct NVGcapture
+{
+    FILE*             file;
+    NVGcaptureBuffer* current; // Filled by the render thread
+    NVGcaptureBuffer* queue;   // Waiting for the writer thread, oldest first
+    NVGcaptureBuffer* queueTail;
+    NVGcaptureBuffer* spare; // Written, ready to be filled again
+    size_t            queuedBytes;
+    int               stop;
+    int               failed;      // Set by the writer thread when a write fails
+    int               outOfMemory; // Set by the render thread when a record was dropped
+#ifdef _WIN32
+    CRITICAL_SECTION   lock;
+    CONDITION_VARIABLE cond;
+    HANDLE             thread;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    pthread_t       thread;
+#endif
+} NVGcapture;
+
+static void nvg__captureLock(NVGcapture* capture)
+{
+#ifdef _WIN32
+    EnterCriticalSection(&capture->lock);
+#else
+    pthread_mutex_lock(&capture->lock);
+#endif
+}
+
+static void nvg__captureUnlock(NVGcapture* capture)
+{
+#ifdef _WIN32
+    LeaveCriticalSection(&capture->lock);
+#else
+    pthread_mutex_unlock(&capture->lock);
+#endif
+}
+
+static void nvg__captureWait(NVGcapture* capture)
+{
+#ifdef _WIN32
+    SleepConditionVariableCS(&capture->cond, &capture->lock, INFINITE);
+#else
+    pthread_cond_wait(&capture->cond, &capture->lock);
+#endif
+}
+
+static void nvg__captureWake(NVGcapture* capture)
+{
+#ifdef _WIN32
+    WakeAllConditionVariable(&capture->cond);
+#else
+    pthread_cond_broadcast(&capture->cond);
+#endif
+}
+
+// Writes the queued buffers until the capture stops
+static void nvg__captureWrite(NVGcapture* capture)
+{
+    nvg__captureLock(capture);
+    for (;;)
+    {
+        NVGcaptureBuffer* buffer;
+        int               written;
+
+        while (capture->queue == NULL && ! capture->stop)
+            nvg__captureWait(capture);
+        if (capture->queue == NULL)
+            break;
+
+        buffer         = capture->queue;
+        capture->queue = buffer->next;
+        if (capture->queue == NULL)
+            capture->queueTail = NULL;
+        nvg__captureUnlock(capture);
+
+        written = fwrite(buffer->data, 1, buffer->size, capture->file) == buffer->size;
+
+        nvg__captureLock(capture);
+        if (! written)
+            capture->failed = 1;
+        capture->queuedBytes -= buffer->size;
+        buffer->size          = 0;
+        buffer->next          = capture->spare;
+        capture->spare        = buffer;
+        nvg__captureWake(capture);
+    }
+    nvg__captureUnlock(capture);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI nvg__captureThread(LPVOID arg)
+{
+    nvg__captureWrite((NVGcapture*)arg);
+    return 0;
+}
+#else
+static void* nvg__captureThread(void* arg)
+{
+    nvg__captureWrite((NVGcapture*)arg);
+    return NULL;
+}
+#endif
+
+// Returns room for a `size` byte payload at the end of the current buffer, or NULL when out of memory
+static unsigned char* nvg__captureRecord(NVGcapture* capture, unsigned int type, size_t size)
+{
+    NVGcaptureBuffer*      buffer = capture->current;
+    NVGcaptureRecordHeader header;
+    unsigned char*         payload;
+    size_t                 needed;
+
+    size = (size + 3) & ~(size_t)3;
+    if (buffer == NULL)
+    {
+        buffer = (NVGcaptureBuffer*)NVG_MALLOC(sizeof(NVGcaptureBuffer));
+        if (buffer == NULL)
+        {
+            capture->outOfMemory = 1;
+            return NULL;
+        }
+        memset(buffer, 0, sizeof(*buffer));
+        capture->current = buffer;
+    }
 
-NanoVGDrawCallCount nvgGetDrawCallCount(NVGcontext* ctx)
+    needed = buffer->size + sizeof(header) + size;
+    if (needed > buffer->capacity)
+    {
+        size_t         capacity = (needed > 64 * 1024 ? needed : 64 * 1024) + buffer->capacity / 2; // 1.5x Overallocate
+        unsigned char* data     = (unsigned char*)NVG_REALLOC(buffer->data, capacity);
+        if (data == NULL)
+        {
+            capture->outOfMemory = 1;
+            return NULL;
+        }
+        buffer->data     = data;
+        buffer->capacity = capacity;
+    }
+
+    header.type = type;
+    header.size = (unsigned int)size;
+    memcpy(buffer->data + buffer->size, &header, sizeof(header));
+    payload = buffer->data + buffer->size + sizeof(header);
+    // Zero the padding so traces are deterministic
+    memset(payload, 0, size);
+    buffer->size = needed;
+    return payload;
+}
+
+// Hands the current buffer to the writer thread
+static void nvg__captureSubmit(NVGcapture* capture)
 {
-    NanoVGDrawCallCount callCount;
-    callCount.draws  = ctx->drawCallCount;
-    callCount.fill   = ctx->fillTriCount;
-    callCount.stroke = ctx->strokeTriCount;
-    callCount.text   = ctx->textTriCount;
-    callCount.total  = ctx->drawCallCount + ctx->fillTriCount + ctx->strokeTriCount + ctx->textTriCount;
-    return callCount;
+    NVGcaptureBuffer* buffer = capture->current;
+    if (buffer == NULL || buffer->size == 0)
+        return;
+
+    nvg__captureLock(capture);
+    // Only waits when the disk can't keep up
+    while (capture->queuedBytes > NVG_CAPTURE_MAX_QUEUED && ! capture->failed)
+        nvg__captureWait(capture);
+    if (capture->failed)
+    {
+        buffer->size = 0;
+        nvg__captureUnlock(capture);
+        return;
+    }
+
+    buffer->next = NULL;
+    if (capture->queueTail)
+        capture->queueTail->next = buffer;
+    else
+        capture->queue = buffer;
+    capture->queueTail    = buffer;
+    capture->queuedBytes += buffer->size;
+    capture->current      = capture->spare;
+    if (capture->spare)
+        capture->spare = capture->spare->next;
+    nvg__captureWake(capture);
+    nvg__captureUnlock(capture);
 }
 
-NVGcolor nvgGetFillColor(NVGcontext* ctx)
+static void nvg__captureFreeBuffers(NVGcaptureBuffer* buffer)
 {
-    NVGstate* state = nvg__getState(ctx);
-    return state->fill.innerColor;
+    while (buffer != NULL)
+    {
+        NVGcaptureBuffer* next = buffer->next;
+        NVG_FREE(buffer->data);
+        NVG_FREE(buffer);
+        buffer = next;
+    }
 }
 
-void nvgCurrentScissor(NVGcontext* ctx, float* x, float* y, float* w, float* h)
+// Writes what's left, stops the writer thread & closes the file. Returns 0 when records were lost
+static int nvg__deleteCapture(NVGcapture* capture)
 {
-    NVGstate* state = nvg__getState(ctx);
-    float     pxform[6], invxorm[6];
-    float     ex, ey, tex, tey;
+    int ok;
+    if (capture == NULL)
+        return 1;
 
-    // If no previous scissor has been set, set the scissor as current scissor.
-    if (state->scissor.extent[0] < 0)
+    nvg__captureSubmit(capture);
+    nvg__captureLock(capture);
+    capture->stop = 1;
+    nvg__captureWake(capture);
+    nvg__captureUnlock(capture);
+#ifdef _WIN32
+    WaitForSingleObject(capture->thread, INFINITE);
+    CloseHandle(capture->thread);
+    DeleteCriticalSection(&capture->lock);
+#else
+    pthread_join(capture->thread, NULL);
+    pthread_mutex_destroy(&capture->lock);
+    pthread_cond_destroy(&capture->cond);
+#endif
+
+    ok = ! capture->failed && ! capture->outOfMemory;
+    ok = fclose(capture->file) == 0 && ok;
+    nvg__captureFreeBuffers(capture->current);
+    nvg__captureFreeBuffers(capture->queue);
+    nvg__captureFreeBuffers(capture->spare);
+    NVG_FREE(capture);
+    return ok;
+}
+
+static void nvg__captureDraw(
+    NVGcompat*                 compat,
+    int                        type,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    float                      strokeWidth,
+    const float*               bounds,
+    const NVGpath*             paths,
+    int                        npaths,
+    const NVGvertex*           verts,
+    int                        nverts)
+{
+    NVGcaptureDraw draw;
+    unsigned char* payload;
+    size_t         size = sizeof(draw);
+    int            i;
+
+    memset(&draw, 0, sizeof(draw));
+    draw.paint              = *paint;
+    draw.compositeOperation = compositeOperation;
+    draw.scissor            = *scissor;
+    draw.fringe             = fringe;
+    draw.strokeWidth        = strokeWidth;
+    draw.count              = type == NVG_DISPLAY_TRIANGLES ? nverts : npaths;
+    if (bounds != NULL)
+        memcpy(draw.bounds, bounds, sizeof(draw.bounds));
+
+    if (type == NVG_DISPLAY_TRIANGLES)
+        size += sizeof(NVGvertex) * nverts;
+    for (i = 0; type != NVG_DISPLAY_TRIANGLES && i < npaths; i++)
+        size += sizeof(NVGcapturePath) +
+                sizeof(NVGvertex) * ((type == NVG_DISPLAY_FILL ? paths[i].nfill : 0) + paths[i].nstroke);
+
+    payload = nvg__captureRecord(
+        compat->capture,
+        type == NVG_DISPLAY_FILL     ? NVG_CAPTURE_FILL
+        : type == NVG_DISPLAY_STROKE ? NVG_CAPTURE_STROKE
+                                     : NVG_CAPTURE_TRIANGLES,
+        size);
+    if (payload == NULL)
+        return;
+
+    memcpy(payload, &draw, sizeof(draw));
+    payload += sizeof(draw);
+    if (type == NVG_DISPLAY_TRIANGLES)
     {
+        memcpy(payload, verts, sizeof(NVGvertex) * nverts);
         return;
     }
+    for (i = 0; i < npaths; i++)
+    {
+        NVGcapturePath path;
+        path.nfill   = type == NVG_DISPLAY_FILL ? paths[i].nfill : 0;
+        path.nstroke = paths[i].nstroke;
+        path.closed  = paths[i].closed;
+        path.nbevel  = paths[i].nbevel;
+        path.winding = paths[i].winding;
+        path.convex  = paths[i].convex;
+        memcpy(payload, &path, sizeof(path));
+        payload += sizeof(path);
+    }
+    for (i = 0; i < npaths; i++)
+    {
+        if (type == NVG_DISPLAY_FILL)
+        {
+            memcpy(payload, paths[i].fill, sizeof(NVGvertex) * paths[i].nfill);
+            payload += sizeof(NVGvertex) * paths[i].nfill;
+        }
+        memcpy(payload, paths[i].stroke, sizeof(NVGvertex) * paths[i].nstroke);
+        payload += sizeof(NVGvertex) * paths[i].nstroke;
+    }
+}
 
-    // Transform the current scissor rect into current transform space.
-    // If there is difference in rotation, this will be approximation.
-    memcpy(pxform, state->scissor.xform, sizeof(float) * 6);
-    ex = state->scissor.extent[0];
-    ey = state->scissor.extent[1];
-    nvgTransformInverse(invxorm, state->xform);
-    nvgTransformMultiply(pxform, invxorm);
-    tex = ex * fabsf(pxform[0]) + ey * fabsf(pxform[2]);
-    tey = ex * fabsf(pxform[1]) + ey * fabsf(pxform[3]);
+static void nvg__captureViewport(NVGcompat* compat, float width, float height, float devicePixelRatio)
+{
+    float* payload = (float*)nvg__captureRecord(compat->capture, NVG_CAPTURE_VIEWPORT, sizeof(float) * 3);
+    if (payload == NULL)
+        return;
+    payload[0] = width;
+    payload[1] = height;
+    payload[2] = devicePixelRatio;
+}
 
-    *x = pxform[4] - tex;
-    *y = pxform[5] - tey;
-    *w = tex * 2;
-    *h = tey * 2;
+// Records the end of a frame, flushed or cancelled, and hands it to the writer thread
+static void nvg__captureEndFrame(NVGcompat* compat, int cancelled)
+{
+    nvg__captureRecord(compat->capture, cancelled ? NVG_CAPTURE_CANCEL : NVG_CAPTURE_FLUSH, 0);
+    nvg__captureSubmit(compat->capture);
 }
 
-void nvgStrokeBlur(NVGcontext* ctx, float fringeWidth)
+// Records a texture create, or an update of the rect `x`, `y`, `w`, `h` when `create` is 0. `data` points to the
+// top left pixel of the rect, whose rows are `pitch` bytes apart. Records hold whole rows of the image, as nanovg
+// passes them to the backend, the pixels left & right of the rect are zero unless the rect spans the image.
+static void nvg__captureTexture(
+    NVGcompat*           compat,
+    int                  create,
+    int                  image,
+    int                  type,
+    int                  width,
+    int                  height,
+    int                  imageFlags,
+    int                  x,
+    int                  y,
+    int                  w,
+    int                  h,
+    const unsigned char* data,
+    size_t               pitch)
 {
-    NVGstate*      state       = nvg__getState(ctx);
-    float          scale       = nvg__getAverageScale(state->xform);
-    float          strokeWidth = nvg__clampf(state->strokeWidth * scale, 0.0f, 200.0f);
-    NVGpaint       strokePaint = state->stroke;
-    const NVGpath* path;
-    int            i;
+    NVGcaptureTexture texture;
+    unsigned char*    payload;
+    int               bpp      = type == NVG_TEXTURE_RGBA ? 4 : 1;
+    size_t            rowBytes = (size_t)width * bpp;
+    size_t            bytes    = data != NULL ? rowBytes * h : 0;
+    int               i;
 
-    if (strokeWidth < fringeWidth)
+    payload = nvg__captureRecord(
+        compat->capture,
+        create ? NVG_CAPTURE_CREATE_TEXTURE : NVG_CAPTURE_UPDATE_TEXTURE,
+        sizeof(texture) + bytes);
+    if (payload == NULL)
+        return;
+
+    texture.image      = image;
+    texture.type       = type;
+    texture.width      = width;
+    texture.height     = height;
+    texture.imageFlags = imageFlags;
+    texture.x          = x;
+    texture.y          = y;
+    texture.w          = w;
+    texture.h          = h;
+    texture.hasData    = data != NULL;
+    memcpy(payload, &texture, sizeof(texture));
+    if (data == NULL)
+        return;
+    payload += sizeof(texture);
+    if (w < width)
+        memset(payload, 0, bytes);
+    for (i = 0; i < h; i++)
+        memcpy(payload + i * rowBytes + (size_t)x * bpp, data + i * pitch, (size_t)w * bpp);
+}
+
+static void nvg__captureCreateTexture(
+    NVGcompat*           compat,
+    int                  image,
+    int                  type,
+    int                  w,
+    int                  h,
+    int                  imageFlags,
+    const unsigned char* data)
+{
+    size_t pitch = (size_t)w * (type == NVG_TEXTURE_RGBA ? 4 : 1);
+    nvg__captureTexture(compat, 1, image, type, w, h, imageFlags, 0, 0, w, h, data, pitch);
+}
+
+// Records an update of the rect `x`, `y`, `w`, `h` of `image` from `data`, whose rows are `pitch` bytes apart
+static void nvg__captureUpdateRegion(
+    NVGcompat*           compat,
+    int                  image,
+    int                  x,
+    int                  y,
+    int                  w,
+    int                  h,
+    const unsigned char* data,
+    size_t               pitch)
+{
+    int width = 0, height = 0;
+    int type  = nvg__compatImageBpp(compat, image) == 1 ? NVG_TEXTURE_ALPHA : NVG_TEXTURE_RGBA;
+    if (! compat->backend.renderGetTextureSize(compat->backend.userPtr, image, &width, &height))
+        return;
+    nvg__captureTexture(compat, 0, image, type, width, height, 0, x, y, w, h, data, pitch);
+}
+
+// Records an update from `data` holding the whole image, as nanovg passes it to renderUpdateTexture
+static void nvg__captureUpdateTexture(
+    NVGcompat*           compat,
+    int                  image,
+    int                  x,
+    int                  y,
+    int                  w,
+    int                  h,
+    const unsigned char* data)
+{
+    int    width = 0, height = 0;
+    int    bpp   = nvg__compatImageBpp(compat, image);
+    size_t pitch;
+    if (! compat->backend.renderGetTextureSize(compat->backend.userPtr, image, &width, &height))
+        return;
+    pitch = (size_t)width * bpp;
+    if (data != NULL)
+        data += y * pitch + (size_t)x * bpp;
+    nvg__captureTexture(
+        compat,
+        0,
+        image,
+        bpp == 1 ? NVG_TEXTURE_ALPHA : NVG_TEXTURE_RGBA,
+        width,
+        height,
+        0,
+        x,
+        y,
+        w,
+        h,
+        data,
+        pitch);
+}
+
+int nvgBeginCapture(NVGcontext* ctx, const char* path)
+{
+    NVGcompat*           compat = nvg__compat(ctx);
+    NVGcapture*          capture;
+    NVGcaptureHeader     header;
+    const unsigned char* atlas;
+    int                  width, height, started;
+
+    if (compat == NULL || compat->capture != NULL || compat->inFrame)
+        return 0;
+    capture = (NVGcapture*)nvg__compatMalloc(compat, sizeof(NVGcapture));
+    if (capture == NULL)
+        return 0;
+    memset(capture, 0, sizeof(*capture));
+
+    memset(&header, 0, sizeof(header));
+    header.magic       = NVG_CAPTURE_MAGIC;
+    header.version     = NVG_CAPTURE_VERSION;
+    header.vertexSize  = (int)sizeof(NVGvertex);
+    header.drawSize    = (int)sizeof(NVGcaptureDraw);
+    header.pathSize    = (int)sizeof(NVGcapturePath);
+    header.textureSize = (int)sizeof(NVGcaptureTexture);
+
+    capture->file = fopen(path, "wb");
+    if (capture->file == NULL || fwrite(&header, sizeof(header), 1, capture->file) != 1)
     {
-        // If the stroke width is less than pixel size, use alpha to emulate
-        // coverage. Since coverage is area, scale by alpha*alpha.
-        float alpha               = nvg__clampf(strokeWidth / fringeWidth, 0.0f, 1.0f);
-        strokePaint.innerColor.a *= alpha * alpha;
-        strokePaint.outerColor.a *= alpha * alpha;
-        strokeWidth               = fringeWidth;
+        if (capture->file != NULL)
+            fclose(capture->file);
+        NVG_FREE(capture);
+        return 0;
     }
 
-    // Apply global alpha
-    strokePaint.innerColor.a *= state->alpha;
-    strokePaint.outerColor.a *= state->alpha;
+#ifdef _WIN32
+    InitializeCriticalSection(&capture->lock);
+    InitializeConditionVariable(&capture->cond);
+    capture->thread = CreateThread(NULL, 0, nvg__captureThread, capture, 0, NULL);
+    started         = capture->thread != NULL;
+    if (! started)
+        DeleteCriticalSection(&capture->lock);
+#else
+    pthread_mutex_init(&capture->lock, NULL);
+    pthread_cond_init(&capture->cond, NULL);
+    started = pthread_create(&capture->thread, NULL, nvg__captureThread, capture) == 0;
+    if (! started)
+    {
+        pthread_mutex_destroy(&capture->lock);
+        pthread_cond_destroy(&capture->cond);
+    }
+#endif
+    if (! started)
+    {
+        fclose(capture->file);
+        NVG_FREE(capture);
+        return 0;
+    }
+    compat->capture = capture;
+
+    // The font atlas was created with the context, record its current contents so replayed text has its glyphs
+    atlas = fonsGetTextureData(ctx->fs, &width, &height);
+    if (atlas != NULL && ctx->fontImages[ctx->fontImageIdx] != 0)
+        nvg__captureCreateTexture(
+            compat,
+            ctx->fontImages[ctx->fontImageIdx],
+            NVG_TEXTURE_ALPHA,
+            width,
+            height,
+            0,
+            atlas);
+    return 1;
+}
+
+int nvgEndCapture(NVGcontext* ctx)
+{
+    NVGcompat*  compat = nvg__compat(ctx);
+    NVGcapture* capture;
+    if (compat == NULL || compat->capture == NULL)
+        return 0;
+    capture         = compat->capture;
+    compat->capture = NULL;
+    return nvg__deleteCapture(capture);
+}
+
+#ifndef __APPLE__
+void nvgCompatBindFramebuffer(NVGcontext* ctx, int image)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    if (compat != NULL && compat->capture != NULL)
+    {
+        int* payload = (int*)nvg__captureRecord(compat->capture, NVG_CAPTURE_BIND_FRAMEBUFFER, sizeof(int));
+        if (payload != NULL)
+            *payload = image;
+    }
+#ifdef _WIN32
+    d3dnvgBindFramebuffer(ctx, image);
+#else
+    cpunvgBindFramebuffer(ctx, image);
+#endif
+}
+#endif
+
+void nvgCompatClearWithColor(NVGcontext* ctx, NVGcolor color)
+{
+    NVGcompat* compat = nvg__compat(ctx);
+    if (compat != NULL && compat->capture != NULL)
+    {
+        unsigned char* payload = nvg__captureRecord(compat->capture, NVG_CAPTURE_CLEAR, sizeof(color));
+        if (payload != NULL)
+            memcpy(payload, &color, sizeof(color));
+    }
+#ifdef _WIN32
+    d3dnvgClearWithColor(ctx, color);
+#elif defined __APPLE__
+    mnvgClearWithColor(ctx, color);
+#else
+    cpunvgClearWithColor(ctx, color);
+#endif
+}
+
+typedef struct NVGreplayImage
+{
+    int            id; // In the replaying context, 0 when not created
+    int            type;
+    int            width;
+    int            height;
+    unsigned char* data; // Whole image, for updates
+} NVGreplayImage;
+
+typedef struct NVGreplay
+{
+    NVGcontext*     ctx;
+    NVGreplayImage* images; // By id in the trace
+    int             cimages;
+    NVGpath*        paths;
+    int             cpaths;
+    NVGvertex*      verts;
+    int             cverts;
+} NVGreplay;
+
+static void nvg__replayTime(NanoVGReplayCalls* calls, long long ns)
+{
+    calls->count++;
+    calls->ns    += ns;
+    calls->maxNs  = ns > calls->maxNs ? ns : calls->maxNs;
+}
+
+// Returns the replay state of image `id` of the trace, or NULL when out of memory
+static NVGreplayImage* nvg__replayImage(NVGreplay* replay, int id)
+{
+    int cap = replay->cimages;
+    if (id <= 0 || ! nvg__compatReserve((void**)&replay->images, &replay->cimages, id + 1, sizeof(NVGreplayImage)))
+        return NULL;
+    memset(replay->images + cap, 0, sizeof(NVGreplayImage) * (replay->cimages - cap));
+    return &replay->images[id];
+}
+
+static int nvg__replayImageId(NVGreplay* replay, int id)
+{
+    return id > 0 && id < replay->cimages ? replay->images[id].id : 0;
+}
+
+static int nvg__replayDraw(
+    NVGreplay*           replay,
+    unsigned int         type,
+    const unsigned char* payload,
+    size_t               size,
+    long long*           ns)
+{
+    NVGparams*            params = &replay->ctx->params;
+    NVGcaptureDraw        draw;
+    const NVGcapturePath* paths;
+    size_t                offset = sizeof(draw);
+    long long             start;
+    int                   i, nverts = 0;
+
+    if (size < sizeof(draw))
+        return 0;
+    memcpy(&draw, payload, sizeof(draw));
+    if (draw.count < 0)
+        return 0;
+    draw.paint.image = nvg__replayImageId(replay, draw.paint.image);
+
+    if (type == NVG_CAPTURE_TRIANGLES)
+    {
+        if ((size_t)draw.count > (size - offset) / sizeof(NVGvertex) ||
+            ! nvg__compatReserve((void**)&replay->verts, &replay->cverts, draw.count, sizeof(NVGvertex)))
+            return 0;
+        memcpy(replay->verts, payload + offset, sizeof(NVGvertex) * draw.count);
+        start = nvg__nowNs();
+        params->renderTriangles(
+            params->userPtr,
+            &draw.paint,
+            draw.compositeOperation,
+            &draw.scissor,
+            replay->verts,
+            draw.count,
+            draw.fringe);
+        *ns = nvg__nowNs() - start;
+        return 1;
+    }
+
+    if ((size_t)draw.count > (size - offset) / sizeof(NVGcapturePath) ||
+        ! nvg__compatReserve((void**)&replay->paths, &replay->cpaths, draw.count, sizeof(NVGpath)))
+        return 0;
+    paths   = (const NVGcapturePath*)(payload + offset);
+    offset += sizeof(NVGcapturePath) * draw.count;
+    for (i = 0; i < draw.count; i++)
+    {
+        if (paths[i].nfill < 0 || paths[i].nstroke < 0)
+            return 0;
+        nverts += paths[i].nfill + paths[i].nstroke;
+    }
+    if ((size_t)nverts > (size - offset) / sizeof(NVGvertex) ||
+        ! nvg__compatReserve((void**)&replay->verts, &replay->cverts, nverts, sizeof(NVGvertex)))
+        return 0;
+    memcpy(replay->verts, payload + offset, sizeof(NVGvertex) * nverts);
 
-    nvg__flattenPaths(ctx);
+    nverts = 0;
+    for (i = 0; i < draw.count; i++)
+    {
+        NVGpath* path = &replay->paths[i];
+        memset(path, 0, sizeof(*path));
+        path->closed  = (unsigned char)paths[i].closed;
+        path->nbevel  = paths[i].nbevel;
+        path->winding = paths[i].winding;
+        path->convex  = paths[i].convex;
+        path->fill    = replay->verts + nverts;
+        path->nfill   = paths[i].nfill;
+        nverts       += paths[i].nfill;
+        path->stroke  = replay->verts + nverts;
+        path->nstroke = paths[i].nstroke;
+        nverts       += paths[i].nstroke;
+    }
 
-    if (ctx->params.edgeAntiAlias && state->shapeAntiAlias)
-        nvg__expandStroke(ctx, strokeWidth * 0.5f, fringeWidth, state->lineCap, state->lineJoin, state->miterLimit);
+    start = nvg__nowNs();
+    if (type == NVG_CAPTURE_FILL)
+        params->renderFill(
+            params->userPtr,
+            &draw.paint,
+            draw.compositeOperation,
+            &draw.scissor,
+            draw.fringe,
+            draw.bounds,
+            replay->paths,
+            draw.count);
     else
-        nvg__expandStroke(ctx, strokeWidth * 0.5f, 0.0f, state->lineCap, state->lineJoin, state->miterLimit);
+        params->renderStroke(
+            params->userPtr,
+            &draw.paint,
+            draw.compositeOperation,
+            &draw.scissor,
+            draw.fringe,
+            draw.strokeWidth,
+            replay->paths,
+            draw.count);
+    *ns = nvg__nowNs() - start;
+    return 1;
+}
 
-    ctx->params.renderStroke(
-        ctx->params.userPtr,
-        &strokePaint,
-        state->compositeOperation,
-        &state->scissor,
-        fringeWidth,
-        strokeWidth,
-        ctx->cache->paths,
-        ctx->cache->npaths);
+static int nvg__replayTexture(
+    NVGreplay*           replay,
+    unsigned int         type,
+    const unsigned char* payload,
+    size_t               size,
+    long long*           ns)
+{
+    NVGparams*        params = &replay->ctx->params;
+    NVGcaptureTexture texture;
+    NVGreplayImage*   image;
+    size_t            rowBytes;
+    long long         start;
 
-    // Count triangles
-    for (i = 0; i < ctx->cache->npaths; i++)
+    if (size < sizeof(texture))
+        return 0;
+    memcpy(&texture, payload, sizeof(texture));
+    if (texture.type != NVG_TEXTURE_ALPHA && texture.type != NVG_TEXTURE_RGBA)
+        return 0;
+    if (texture.width <= 0 || texture.height <= 0 || texture.x < 0 || texture.w < 0 ||
+        texture.x + texture.w > texture.width || texture.y < 0 || texture.h < 0 ||
+        texture.y + texture.h > texture.height)
+        return 0;
+    // renderCreateTexture reads the whole image
+    if (type == NVG_CAPTURE_CREATE_TEXTURE && (texture.y != 0 || texture.h != texture.height))
+        return 0;
+    rowBytes = (size_t)texture.width * (texture.type == NVG_TEXTURE_RGBA ? 4 : 1);
+    if (texture.hasData && rowBytes * texture.h > size - sizeof(texture))
+        return 0;
+    image = nvg__replayImage(replay, texture.image);
+    if (image == NULL)
+        return 0;
+
+    start = nvg__nowNs();
+    if (type == NVG_CAPTURE_CREATE_TEXTURE || image->id == 0)
     {
-        path                 = &ctx->cache->paths[i];
-        ctx->strokeTriCount += path->nstroke - 2;
-        ctx->drawCallCount++;
+        // Updates of images created before the capture started create them
+        if (image->id != 0)
+            nvgDeleteImage(replay->ctx, image->id);
+        NVG_FREE(image->data);
+        memset(image, 0, sizeof(*image));
+        image->id = params->renderCreateTexture(
+            params->userPtr,
+            texture.type,
+            texture.width,
+            texture.height,
+            texture.imageFlags,
+            type == NVG_CAPTURE_CREATE_TEXTURE && texture.hasData ? payload + sizeof(texture) : NULL);
+        image->type   = texture.type;
+        image->width  = texture.width;
+        image->height = texture.height;
+    }
+    if (type == NVG_CAPTURE_UPDATE_TEXTURE && texture.hasData && image->id > 0)
+    {
+        if (image->type != texture.type || image->width != texture.width || image->height != texture.height)
+            return 0;
+        if (image->data == NULL)
+        {
+            image->data = (unsigned char*)NVG_MALLOC(rowBytes * texture.height);
+            if (image->data == NULL)
+                return 0;
+            memset(image->data, 0, rowBytes * texture.height);
+        }
+        memcpy(image->data + rowBytes * texture.y, payload + sizeof(texture), rowBytes * texture.h);
+        params->renderUpdateTexture(
+            params->userPtr,
+            image->id,
+            texture.x,
+            texture.y,
+            texture.w,
+            texture.h,
+            image->data);
     }
+    *ns = nvg__nowNs() - start;
+    return 1;
 }
 
-void    nvgPopPath(NVGcontext* ctx, int N) { ctx->ncommands -= N; }
-int     nvgPathLen(NVGcontext* ctx) { return ctx->ncommands; }
-float** nvgGetPath(NVGcontext* ctx) { return &ctx->commands; }
+int nvgReplayCapture(NVGcontext* ctx, const char* path, NanoVGReplayStats* stats)
+{
+    NVGcompat*           compat = nvg__compat(ctx);
+    NVGparams*           params = &ctx->params;
+    NVGmappedFile        file;
+    NVGcaptureHeader     header;
+    NVGreplay            replay;
+    NanoVGReplayStats    local;
+    const unsigned char* data;
+    size_t               offset     = 0;
+    long long            frameStart = 0, start, ns;
+    int                  i, ok = 1, inFrame = 0;
+
+    if (stats == NULL)
+        stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    if (compat == NULL || compat->inFrame || ! nvg__mapFile(&file, path))
+        return 0;
+
+    data = nvg__readMapped(&file, &offset, sizeof(header));
+    if (data != NULL)
+        memcpy(&header, data, sizeof(header));
+    if (data == NULL || header.magic != NVG_CAPTURE_MAGIC || header.version != NVG_CAPTURE_VERSION ||
+        header.vertexSize != (int)sizeof(NVGvertex) || header.drawSize != (int)sizeof(NVGcaptureDraw) ||
+        header.pathSize != (int)sizeof(NVGcapturePath) || header.textureSize != (int)sizeof(NVGcaptureTexture))
+    {
+        nvg__unmapFile(&file);
+        return 0;
+    }
+
+    memset(&replay, 0, sizeof(replay));
+    replay.ctx = ctx;
+    while (ok && offset < file.size)
+    {
+        NVGcaptureRecordHeader record;
+        const unsigned char*   payload;
+
+        data = nvg__readMapped(&file, &offset, sizeof(record));
+        if (data == NULL)
+        {
+            ok = 0;
+            break;
+        }
+        memcpy(&record, data, sizeof(record));
+        payload = nvg__readMapped(&file, &offset, record.size);
+        if (payload == NULL)
+        {
+            ok = 0;
+            break;
+        }
+
+        switch (record.type)
+        {
+        case NVG_CAPTURE_VIEWPORT:
+        {
+            float viewport[3];
+            if (record.size < sizeof(viewport))
+            {
+                ok = 0;
+                break;
+            }
+            memcpy(viewport, payload, sizeof(viewport));
+            frameStart = nvg__nowNs();
+            params->renderViewport(params->userPtr, viewport[0], viewport[1], viewport[2]);
+            nvg__replayTime(&stats->other, nvg__nowNs() - frameStart);
+            inFrame = 1;
+            break;
+        }
+        case NVG_CAPTURE_FLUSH:
+            start = nvg__nowNs();
+            params->renderFlush(params->userPtr);
+            ns = nvg__nowNs();
+            nvg__replayTime(&stats->flush, ns - start);
+            if (inFrame)
+            {
+                stats->frames++;
+                stats->frameNs    += ns - frameStart;
+                stats->maxFrameNs  = ns - frameStart > stats->maxFrameNs ? ns - frameStart : stats->maxFrameNs;
+            }
+            inFrame = 0;
+            break;
+        case NVG_CAPTURE_CANCEL:
+            start = nvg__nowNs();
+            params->renderCancel(params->userPtr);
+            nvg__replayTime(&stats->other, nvg__nowNs() - start);
+            inFrame = 0;
+            break;
+        case NVG_CAPTURE_FILL:
+        case NVG_CAPTURE_STROKE:
+        case NVG_CAPTURE_TRIANGLES:
+            ok = nvg__replayDraw(&replay, record.type, payload, record.size, &ns);
+            if (ok)
+                nvg__replayTime(
+                    record.type == NVG_CAPTURE_FILL     ? &stats->fill
+                    : record.type == NVG_CAPTURE_STROKE ? &stats->stroke
+                                                        : &stats->triangles,
+                    ns);
+            break;
+        case NVG_CAPTURE_CREATE_TEXTURE:
+        case NVG_CAPTURE_UPDATE_TEXTURE:
+            ok = nvg__replayTexture(&replay, record.type, payload, record.size, &ns);
+            if (ok)
+                nvg__replayTime(&stats->textures, ns);
+            break;
+#ifndef __APPLE__
+        case NVG_CAPTURE_BIND_FRAMEBUFFER:
+        {
+            int image;
+            if (record.size < sizeof(image))
+            {
+                ok = 0;
+                break;
+            }
+            memcpy(&image, payload, sizeof(image));
+            start = nvg__nowNs();
+            nvgCompatBindFramebuffer(ctx, nvg__replayImageId(&replay, image));
+            nvg__replayTime(&stats->other, nvg__nowNs() - start);
+            break;
+        }
+#endif
+        case NVG_CAPTURE_CLEAR:
+        {
+            NVGcolor color;
+            if (record.size < sizeof(color))
+            {
+                ok = 0;
+                break;
+            }
+            memcpy(&color, payload, sizeof(color));
+            start = nvg__nowNs();
+            nvgCompatClearWithColor(ctx, color);
+            nvg__replayTime(&stats->other, nvg__nowNs() - start);
+            break;
+        }
+        default:
+            // Unknown & platform specific records are skipped
+            break;
+        }
+    }
+
+    if (inFrame)
+        params->renderCancel(params->userPtr);
+#ifndef __APPLE__
+    nvgCompatBindFramebuffer(ctx, 0);
+#endif
+    for (i = 0; i < replay.cimages; i++)
+    {
+        if (replay.images[i].id > 0)
+            nvgDeleteImage(ctx, replay.images[i].id);
+        NVG_FREE(replay.images[i].data);
+    }
+    NVG_FREE(replay.images);
+    NVG_FREE(replay.paths);
+    NVG_FREE(replay.verts);
+    nvg__unmapFile(&file);
+    return ok;
+}
 
 #ifdef _WIN32
 
@@ -114,7 +7730,7 @@ float** nvgGetPath(NVGcontext* ctx) { return &ctx->commands; }
 
 struct D3DNVGdevice* d3dnvgGetDevice(NVGcontext* ctx)
 {
-    struct D3DNVGcontext* D3D    = (struct D3DNVGcontext*)ctx->params.userPtr;
+    struct D3DNVGcontext* D3D    = (struct D3DNVGcontext*)nvgInternalParams(ctx)->userPtr;
     struct D3DNVGdevice*  device = (struct D3DNVGdevice*)D3D->userPtr;
     return device;
 }
@@ -342,7 +7958,7 @@ NVGcontext* d3dnvgCreateContext(void* hwnd, int flags, unsigned int width, unsig
     struct D3DNVGcontext* D3D = (struct D3DNVGcontext*)ctx->params.userPtr;
     D3D->userPtr              = device;
 
-    return ctx;
+    return nvgCompatInit(ctx);
 }
 
 void d3dnvgDeleteContext(NVGcontext* ctx)
@@ -544,13 +8160,28 @@ void d3dnvgWriteImage(NVGcontext* ctx, int image, void* data)
     struct D3DNVGcontext* D3D    = (struct D3DNVGcontext*)params->userPtr;
     struct D3DNVGtexture* tex    = D3Dnvg__findTexture(D3D, image);
 
+    if (tex == NULL)
+        return;
+    d3dnvgWriteImageRegion(ctx, image, 0, 0, tex->width, tex->height, data, tex->width * sizeof(unsigned));
+}
+
+void d3dnvgWriteImageRegion(NVGcontext* ctx, int image, int x, int y, int w, int h, const void* data, int pitch)
+{
+    NVGparams*            params = nvgInternalParams(ctx);
+    struct D3DNVGcontext* D3D    = (struct D3DNVGcontext*)params->userPtr;
+    struct D3DNVGtexture* tex    = D3Dnvg__findTexture(D3D, image);
+
     D3D11_MAPPED_SUBRESOURCE resource;
-    int                      width  = tex->width;
-    int                      height = tex->height;
+    int                      bpp;
+
+    if (tex == NULL || x < 0 || y < 0 || x + w > tex->width || y + h > tex->height)
+        return;
+    bpp = tex->type == NVG_TEXTURE_RGBA ? 4 : 1;
 
     // All the results on stackoverflow mention to use the UpdateResource function to write to a tex CPU -> GPU
     // But the resulting tex looks all messed up...
     // This strategy, Map, memcpy, Upmap seems to do the trick...
+    // D3D11_MAP_WRITE keeps the content outside of the rect
     HRESULT hr = D3D->pDeviceContext->lpVtbl
                      ->Map(D3D->pDeviceContext, (ID3D11Resource*)tex->tex, 0, D3D11_MAP_WRITE, 0, &resource);
 
@@ -561,13 +8192,17 @@ void d3dnvgWriteImage(NVGcontext* ctx, int image, void* data)
         return;
     }
 
-    size_t row_bytes = width * sizeof(unsigned);
-    for (int i = 0; i < height; i++)
+    size_t row_bytes = (size_t)w * bpp;
+    for (int i = 0; i < h; i++)
     {
-        memcpy((char*)resource.pData + i * resource.RowPitch, (char*)data + i * row_bytes, row_bytes);
+        memcpy(
+            (char*)resource.pData + (size_t)(y + i) * resource.RowPitch + x * bpp,
+            (const char*)data + (size_t)i * pitch,
+            row_bytes);
     }
 
     D3D_API_2(D3D->pDeviceContext, Unmap, (ID3D11Resource*)tex->tex, 0);
+    nvg__compatImageWritten(ctx, image, x, y, w, h, data, pitch);
 }
 
 void d3dnvgReadPixels(NVGcontext* ctx, int image, int x, int y, int width, int height, void* data)
@@ -587,11 +8222,11 @@ void d3dnvgReadPixels(NVGcontext* ctx, int image, int x, int y, int width, int h
         return;
     }
 
-    for (int i = y; i < height; i++)
+    for (int i = 0; i < height; i++)
     {
         memcpy(
             (char*)data + i * width * sizeof(unsigned),
-            (char*)resource.pData + i * resource.RowPitch,
+            (char*)resource.pData + (y + i) * resource.RowPitch + x * sizeof(unsigned),
             width * sizeof(unsigned));
     }
 
@@ -6,6 +6,7 @@ extern "C" {
 #endif
 
 #include <nanovg.h>
+#include <stddef.h>
 
 #define NVG_ALIGN_TL (NVG_ALIGN_TOP | NVG_ALIGN_LEFT)
 #define NVG_ALIGN_TC (NVG_ALIGN_TOP | NVG_ALIGN_CENTER)
@@ -28,6 +29,67 @@ extern "C" {
                                      ( hex        & 0xff) / 255.0f}
 // clang-format on
 
+// Packed vertex, which backends may take in place of NVGvertex, see nvgVertexFormat(). Coordinates are in 1/16 device
+// pixels from the origin of the call, texture coordinates are 16 bit UNORM.
+struct NVGpackedVertex
+{
+    unsigned short x, y;
+    unsigned short u, v;
+};
+typedef struct NVGpackedVertex NVGpackedVertex;
+
+// Path of a packed call, `fill` & `stroke` are the index of their first vertex in the call's vertices
+struct NVGpackedPath
+{
+    int fill;
+    int nfill;
+    int stroke;
+    int nstroke;
+    int convex;
+};
+typedef struct NVGpackedPath NVGpackedPath;
+
+// Geometry of a packed call. A vertex lies at `origin` + (x, y) / `scale` in logical units.
+struct NVGpackedCall
+{
+    float                  origin[2];
+    float                  scale;
+    const NVGpackedVertex* verts;
+    int                    nverts;
+    const NVGpackedPath*   paths;
+    int                    npaths;
+};
+typedef struct NVGpackedCall NVGpackedCall;
+
+// Draw calls of a backend taking packed vertices, as those of NVGparams. `uptr` is the userPtr of its NVGparams.
+struct NVGpackedParams
+{
+    void (*renderFill)(
+        void*                      uptr,
+        NVGpaint*                  paint,
+        NVGcompositeOperationState compositeOperation,
+        NVGscissor*                scissor,
+        float                      fringe,
+        const float*               bounds,
+        const NVGpackedCall*       call);
+    void (*renderStroke)(
+        void*                      uptr,
+        NVGpaint*                  paint,
+        NVGcompositeOperationState compositeOperation,
+        NVGscissor*                scissor,
+        float                      fringe,
+        float                      strokeWidth,
+        const NVGpackedCall*       call);
+    void (*renderTriangles)(
+        void*                      uptr,
+        NVGpaint*                  paint,
+        NVGcompositeOperationState compositeOperation,
+        NVGscissor*                scissor,
+        const NVGpackedCall*       call,
+        float                      fringe);
+};
+typedef struct NVGpackedParams NVGpackedParams;
+
 #ifdef _WIN32
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
@@ -75,6 +137,8 @@ int d3dnvgCreateFramebuffer(NVGcontext* ctx, int w, int h, int flags);
 
 void d3dnvgCopyImage(NVGcontext* ctx, int imgDest, int imgSrc);
 void d3dnvgWriteImage(NVGcontext* ctx, int imgDest, void* data);
+// Writes the `w` x `h` rect at `x`, `y` of an image from `data`, whose rows are `pitch` bytes apart.
+void d3dnvgWriteImageRegion(NVGcontext* ctx, int image, int x, int y, int w, int h, const void* data, int pitch);
 
 // Copies the pixels from the specified image into the specified `data`.
 void d3dnvgReadPixels(NVGcontext* ctx, int image, int x, int y, int width, int height, void* data);
@@ -86,11 +150,11 @@ void d3dnvgPresent(NVGcontext* ctx);
 
 #define nvgCreateContext d3dnvgCreateContext
 #define nvgDeleteContext d3dnvgDeleteContext
-#define nvgBindFramebuffer d3dnvgBindFramebuffer
+#define nvgBindFramebuffer nvgCompatBindFramebuffer
 #define nvgCreateFramebuffer d3dnvgCreateFramebuffer
 #define nvgDeleteFramebuffer nvgDeleteImage
 #define nvgReadPixels d3dnvgReadPixels
-#define nvgClearWithColor d3dnvgClearWithColor
+#define nvgClearWithColor nvgCompatClearWithColor
 #define nvgSetViewBounds(ctx, window, w, h) d3dnvgSetViewBounds(d3dnvgGetDevice(ctx), window, w, h)
 
 #elif defined __APPLE__
@@ -106,22 +170,37 @@ void        mnvgSetViewBounds(void* view, int width, int height);
 #define nvgBindFramebuffer mnvgBindFramebuffer
 #define nvgCreateFramebuffer mnvgCreateFramebuffer
 #define nvgDeleteFramebuffer nvgDeleteImage
-#define nvgClearWithColor mnvgClearWithColor
+#define nvgClearWithColor nvgCompatClearWithColor
 #define nvgSetViewBounds(ctx, nsview, w, h) mnvgSetViewBounds(nsview, w, h)
 #define nvgReadPixels mnvgReadPixels
 
 #elif defined __linux__
-// TODO make linux work...
-#include <nanovg_gl.h>
-#include <nanovg_gl_utils.h>
+// Headless software renderer. There is no window, so `window` arguments are ignored
+#include "nanovg_cpu.h"
+#define NVG_DEFAULT_CONTEXT_FLAGS NVG_ANTIALIAS
+#define NVG_DEFAULT_PIXEL_RATIO 1.0f
+
+#define nvgCreateContext(window, flags, w, h) nvgCompatInit(nvgCreateCPU(flags, w, h))
+#define nvgDeleteContext nvgDeleteCPU
+#define nvgBindFramebuffer nvgCompatBindFramebuffer
+#define nvgCreateFramebuffer cpunvgCreateFramebuffer
+#define nvgDeleteFramebuffer nvgDeleteImage
+#define nvgClearWithColor nvgCompatClearWithColor
+#define nvgSetViewBounds(ctx, window, w, h) cpunvgSetViewBounds(ctx, w, h)
+#define nvgReadPixels cpunvgReadPixels
+
+#endif
 
-#define nvgCreateContext nvgCreateGLES2
-#define nvgDeleteContext nvgDeleteGLES2
-#define nvgBindFramebuffer(ctx, fb) nvgluBindFramebuffer(fb)
-#define nvgCreateFramebuffer nvgluCreateFramebuffer
-#define nvgDeleteFramebuffer nvgluDeleteFramebuffer
+// Creates the wrapper's state of a context, which is stored in the context. nvgCreateContext() does it, contexts
+// created with a backend's own function, like nvgCreateD3D11(), get it on first use. Returns `ctx`.
+NVGcontext* nvgCompatInit(NVGcontext* ctx);
 
+// nvgBindFramebuffer & nvgClearWithColor go through these so frame captures record them. Metal framebuffers are bound
+// with mnvgBindFramebuffer, which isn't recorded.
+#ifndef __APPLE__
+void nvgCompatBindFramebuffer(NVGcontext* ctx, int image);
 #endif
+void nvgCompatClearWithColor(NVGcontext* ctx, NVGcolor color);
 
 struct NanoVGDrawCallCount
 {
@@ -135,6 +214,31 @@ typedef struct NanoVGDrawCallCount NanoVGDrawCallCount;
 
 NanoVGDrawCallCount nvgGetDrawCallCount(NVGcontext* ctx);
 
+// Allocator hooks for the memory nanovg & this wrapper allocate for a context, like its command buffer, path cache &
+// the D3D device. Fonts, images & the backends' own buffers aren't covered. All three functions must be set.
+struct NVGallocator
+{
+    void* (*allocate)(void* userPtr, size_t size);
+    void* (*reallocate)(void* userPtr, void* ptr, size_t size);
+    void (*deallocate)(void* userPtr, void* ptr);
+    void* userPtr;
+};
+typedef struct NVGallocator NVGallocator;
+
+// Same as nvgCreateContext() with the context's allocations going through `allocator`, or the C runtime when NULL.
+// The allocations of such contexts are counted in the frame stats. Features enabled after creation, like the
+// tessellation cache, & the blocks allocated during frames or image creation go through `allocator` too.
+NVGcontext* nvgCreateContextAllocator(void* window, int flags, int w, int h, const NVGallocator* allocator);
+
+// Returns `size` bytes, 16 byte aligned, from a per context linear arena reset at the end of the frame, for transient
+// geometry like the arrays passed to nvgFillRects(). Returns NULL on allocation failure.
+void* nvgFrameAlloc(NVGcontext* ctx, size_t size);
+
+// Shrink to fit policy for the command buffer, the path cache & the frame arena, which otherwise only grow. At the end
+// of a frame, a buffer whose capacity stayed over `slack` times its use for `frames` frames in a row is shrunk to its
+// peak use over these frames, plus a quarter. A `frames` of 0 disables it, the default.
+void nvgShrinkPolicy(NVGcontext* ctx, int frames, float slack);
+
 NVGcolor nvgGetFillColor(NVGcontext* ctx);
 
 void nvgCurrentScissor(NVGcontext* ctx, float* x, float* y, float* w, float* h);
@@ -142,13 +246,400 @@ void nvgCurrentScissor(NVGcontext* ctx, float* x, float* y, float* w, float* h);
 // Fills the current path with current stroke style.
 // Set fringeWidth to value > 1 to control blur amount.
 // https://github.com/memononen/nanovg/issues/460
+// Uses the tessellation cache when it is enabled.
 void nvgStrokeBlur(NVGcontext* ctx, float fringeWidth);
 
+// Gaussian blurred shapes. `blur` is the standard deviation of the Gaussian, in the units of the current transform.
+// Only the software renderer on Linux draws an actual Gaussian: NVG_COMPAT_BLUR_PAINT marks the paint with a negative
+// feather & the backend integrates the shape against the Gaussian with erf, within 5 / 255 of a sampled convolution
+// (see the blur check of nanovg_compat_check). The D3D11 & Metal shaders know nothing of it, on Windows & macOS the
+// profile is a linear ramp with the slope of the Gaussian at the edge, 1 / (blur * sqrt(2 pi)). It's as wide as 2.5
+// blur instead of 6, so shadows look tighter there. All of these use the tessellation cache when it is enabled.
+// Like nvgBoxGradient(), but the rounded rect is convolved with a Gaussian: `icol` inside, fading to `ocol` outside.
+NVGpaint nvgBoxShadow(
+    NVGcontext* ctx,
+    float       x,
+    float       y,
+    float       w,
+    float       h,
+    float       r,
+    float       blur,
+    NVGcolor    icol,
+    NVGcolor    ocol);
+// Draws the blurred rounded rect `x`, `y`, `w`, `h` of corner radius `r` as a single quad with an nvgBoxShadow()
+// paint. Use r = w / 2 = h / 2 for circles. Replaces the current path.
+void nvgShadow(NVGcontext* ctx, float x, float y, float w, float h, float r, float blur, NVGcolor color);
+// Fills the current path, which should be convex, with its edges blurred. Solid colour fills get a Gaussian edge
+// profile, other paints a linear one. The blur shouldn't exceed a sixth of the smallest size of the shape. Needs
+// NVG_ANTIALIAS.
+void nvgFillBlur(NVGcontext* ctx, float blur);
+
+// Fill a rect, rounded rect or circle with the current fill colour as a single quad, whose paint computes the coverage
+// of the shape from its signed distance instead of tessellating Beziers & an AA fringe. Edges ramp over one device
+// pixel like nvgFill()'s at any scale & pixel ratio. Gradient & image fills, and shapes without anti-aliasing, go
+// through nvgFill(). Replace the current path.
+void nvgFillRectFast(NVGcontext* ctx, float x, float y, float w, float h);
+void nvgFillRoundedRectFast(NVGcontext* ctx, float x, float y, float w, float h, float r);
+void nvgFillCircleFast(NVGcontext* ctx, float cx, float cy, float r);
+
+// The tessellation cache keeps the flattened & expanded geometry of recently drawn paths, so repeated shapes skip
+// nvg__flattenPaths & nvg__expand*. Paths are matched by their commands relative to their first point, so a shape moved
+// around the screen still hits. Entries are evicted least recently used first once `budgetBytes` is exceeded.
+// A budget of 0 disables the cache and frees its memory. Disabled by default.
+void nvgTessellationCacheBudget(NVGcontext* ctx, int budgetBytes);
+
+// Selects the flattener & stroke expander of fills & strokes. `flatten` replaces nanovg's recursive subdivision with
+// uniform segments evaluated 4 at a time, whose count keeps each Bezier within the same tolerance, so it emits a few
+// more points on most curves. `stroke` computes joins & miter runs 4 points at a time, its output is identical to
+// nanovg's. Defaults to NVG_COMPAT_SIMD_FLATTEN & NVG_COMPAT_SIMD_STROKE, both 0.
+void nvgSimdTessellation(NVGcontext* ctx, int flatten, int stroke);
+
+struct NanoVGTessCacheStats
+{
+    int    hits;
+    int    misses;
+    int    evictions;
+    int    entries;
+    size_t bytes;
+};
+typedef struct NanoVGTessCacheStats NanoVGTessCacheStats;
+
+NanoVGTessCacheStats nvgGetTessellationCacheStats(NVGcontext* ctx);
+
+// Adaptive tessellation. Tolerances are in logical pixels, like nanovg's own, which is 0.25 / devicePixelRatio. When
+// `relTol` isn't 0, each path filled or stroked gets a tolerance of `relTol` times the larger side of its bounds, so
+// large shapes are flattened coarser than small ones. The tolerances, the governor's included, are clamped to
+// `minTol`..`maxTol`, 0 for the defaults of nanovg's tolerance & 4 times it. Paths recorded in display lists keep
+// nanovg's tolerance. Disabled by default.
+void nvgTessellationLod(NVGcontext* ctx, float minTol, float maxTol, float relTol);
+
+// Frame time governor. When the CPU time of a frame, from nvgBeginFrame to the end of nvgEndFrame, exceeds `budgetNs`,
+// the tolerances of the following frames are multiplied by 1.25, up to maxTol / minTol, and once they can't grow
+// anymore nvgStrokeBlur() draws plain strokes. Frames under 3/4 of the budget undo one step. A budget of 0 disables
+// the governor, the default.
+void nvgTessellationGovernor(NVGcontext* ctx, long long budgetNs);
+
+struct NanoVGLodStats
+{
+    float     scale;     // Multiplier the governor applies to the tolerances, 1 at full quality
+    int       skipBlur;  // Set while nvgStrokeBlur draws plain strokes
+    int       coarsened; // Steps taken by the governor since it was enabled
+    int       refined;
+    long long frameNs; // CPU time of the last frame
+    // Paths tessellated with an adaptive tolerance since nvgBeginFrame & the range of their tolerances
+    int   paths;
+    float minTol;
+    float maxTol;
+};
+typedef struct NanoVGLodStats NanoVGLodStats;
+
+NanoVGLodStats nvgGetLodStats(NVGcontext* ctx);
+
+// Same as nvgFill() & nvgStroke(), but go through the tessellation cache when it is enabled.
+void nvgFillCached(NVGcontext* ctx);
+void nvgStrokeCached(NVGcontext* ctx);
+
+// The text run cache keeps the glyph quads & atlas coordinates laid out by nvgText() & the rows of nvgTextBox(), so a
+// repeated label skips glyph lookup & layout and goes straight to the backend. Runs are matched by font, size, letter
+// spacing, blur, alignment, the sub pixel part of their position and the string, so a label moved by whole pixels or
+// drawn under a different transform still hits. Entries are evicted least recently used first once `budgetBytes` is
+// exceeded, and all of them are dropped when the font atlas is reset or grows. A budget of 0 disables the cache and
+// frees its memory. Disabled by default. Set the budget again after adding fallback fonts to drop stale runs.
+void nvgTextCacheBudget(NVGcontext* ctx, int budgetBytes);
+
+struct NanoVGTextCacheStats
+{
+    int hits;
+    int misses;
+    int evictions;
+    // Times the whole cache was dropped because the font atlas changed
+    int    invalidations;
+    int    entries;
+    size_t bytes;
+};
+typedef struct NanoVGTextCacheStats NanoVGTextCacheStats;
+
+NanoVGTextCacheStats nvgGetTextCacheStats(NVGcontext* ctx);
+
+// Prebaked glyph atlases. nvgBakeGlyphs() & nvgSaveGlyphAtlas() write the font atlas & glyph tables of a context to a
+// file, see tools/nanovg_bake.c, which nvgLoadGlyphAtlas() memory maps & uploads as the font atlas of another context
+// in one texture upload, so text drawn at startup doesn't rasterize glyphs. Files are only meant to be read by the
+// build that wrote them. None of these may be called between nvgBeginFrame() & nvgEndFrame().
+
+// Rasterizes the glyphs of codepoints `first` to `last` of `font` into the font atlas, growing it as needed. `size` is
+// in pixels, that is the font size times the device pixel ratio. Codepoints missing from the font & its fallbacks are
+// skipped. Returns the number of glyphs in the atlas for the range, or -1 when the atlas is full.
+int nvgBakeGlyphs(NVGcontext* ctx, int font, float size, float blur, unsigned int first, unsigned int last);
+// Writes the font atlas & the glyphs of every font to `path`. Returns 1 on success.
+int nvgSaveGlyphAtlas(NVGcontext* ctx, const char* path);
+// Replaces the font atlas with the one in `path`. Glyphs are restored for the fonts created with the same name & font
+// data size as when the file was saved, so create the fonts first. Returns the number of fonts restored, 0 when the
+// file can't be read, doesn't match this build or none of its fonts exist.
+int nvgLoadGlyphAtlas(NVGcontext* ctx, const char* path);
+
+// Frame captures record every call nanovg makes to the backend, with its paint, scissor & vertices, plus texture
+// creates & updates, nvgWriteImageRegion(), the D3D11 & software renderer image writes, nvgBindFramebuffer() &
+// nvgClearWithColor(), to a binary trace. Records are written to disk by a thread, the render thread only waits when
+// NVG_CAPTURE_MAX_QUEUED bytes are already waiting to be written. Images created before the capture started aren't
+// recorded, except the font atlas, so their draws sample an image that is only filled by later updates. On macOS
+// nvgBindFramebuffer() is mnvgBindFramebuffer(), which takes no context & isn't recorded, so replayed frames are all
+// drawn into the framebuffer bound when replaying. Traces are only meant to be read by the build that wrote them.
+
+// Starts writing a trace to `path`. Returns 1 on success, 0 when the file can't be created, a capture is running or
+// when called between nvgBeginFrame() & nvgEndFrame().
+int nvgBeginCapture(NVGcontext* ctx, const char* path);
+// Writes what's left of the trace & closes it. Returns 1 when every record was written.
+int nvgEndCapture(NVGcontext* ctx);
+
+struct NanoVGReplayCalls
+{
+    int       count;
+    long long ns;
+    long long maxNs;
+};
+typedef struct NanoVGReplayCalls NanoVGReplayCalls;
+
+struct NanoVGReplayStats
+{
+    int       frames;
+    long long frameNs; // From the viewport to the end of the flush, summed over frames
+    long long maxFrameNs;
+
+    NanoVGReplayCalls fill;
+    NanoVGReplayCalls stroke;
+    NanoVGReplayCalls triangles;
+    NanoVGReplayCalls textures; // Creates & updates
+    NanoVGReplayCalls flush;
+    NanoVGReplayCalls other; // Viewports, cancels, framebuffer binds & clears
+};
+typedef struct NanoVGReplayStats NanoVGReplayStats;
+
+// Issues the calls of the trace at `path` to the backend of `ctx`, timing each. Images created by the trace are
+// deleted at the end, framebuffers are unbound. `stats` may be NULL. Returns 1 when the whole trace was replayed, 0
+// when it can't be read, doesn't match this build or is truncated.
+int nvgReplayCapture(NVGcontext* ctx, const char* path, NanoVGReplayStats* stats);
+
+// Bulk primitives for dense data views. Points are read from caller owned arrays & added straight to the path cache,
+// skipping the path commands & the flattener. The current path is left untouched.
+// Fills `n` rects, packed as x, y, w, h, with `paint`. They are filled as one shape like nvgRect() * n + nvgFill().
+void nvgFillRects(NVGcontext* ctx, const float* xywh, int n, NVGpaint paint);
+// Strokes the open polyline through `n` points, packed as x, y, with the current stroke style.
+void nvgStrokePolyline(NVGcontext* ctx, const float* xy, int n);
+// Fills a `size` wide square centered on each of the `n` points, packed as x, y, with the current fill style.
+void nvgDrawPoints(NVGcontext* ctx, const float* xy, int n, float size);
+// Fills `n` copies of the current path, each transformed by its 6 floats of `xforms` applied in the current user
+// space, as in nvgTransform(). None of the backends draw instances: the path is flattened & expanded at the scale of
+// a copy, then its vertices are rotated & moved into place for it & the following copies whose scale & shear are
+// within 1%, so the fringe & the flattening tolerance stay in device pixels. Copies at many different scales cost a
+// tessellation each, like separate nvgFill() calls. Consecutive copies with the same colour of `colors` & scale are
+// filled in one call, up to 256 of them, or with the fill style when `colors` is NULL. A copy overlapping another one
+// of the call starts a new call, so overlapping translucent copies blend as with separate nvgFill() calls. Gradients
+// & patterns don't follow the copies. Uses the tessellation cache when it is enabled.
+void nvgDrawPathInstances(NVGcontext* ctx, const float* xforms, const NVGcolor* colors, int n);
+
+// Draw call batching merges consecutive strokes with identical paint, composite operation, scissor & width into one
+// backend call when their geometry doesn't overlap. Draw order & the rendered result are unchanged. Fills, convex ones
+// included, aren't merged & flush the pending strokes: the backends only draw single path convex fills in one pass,
+// merged ones would take a stencil pass & a cover quad over their union. Disabled by default.
+void nvgDrawBatching(NVGcontext* ctx, int enabled);
+
+// Fill, stroke & triangle calls made by nanovg (`submitted`) and made to the backend after batching (`issued`)
+// since nvgBeginFrame.
+struct NanoVGBatchStats
+{
+    int submitted;
+    int issued;
+};
+typedef struct NanoVGBatchStats NanoVGBatchStats;
+
+NanoVGBatchStats nvgGetBatchStats(NVGcontext* ctx);
+
+// Culling drops fills & strokes whose path, grown by its fringe & stroke width, lies entirely outside the viewport or
+// the bounding box of the scissor, before it is flattened. Path bounds include Bezier control points, so culling is
+// conservative. Paths drawn while recording a display list, and those of the bulk primitives, aren't culled. Enabled
+// by default.
+void nvgCulling(NVGcontext* ctx, int enabled);
+
+// Paths culled since nvgBeginFrame, and their points, Bezier control points included, that were never flattened. Each
+// point saves at least one vertex, two to four once expanded with a fringe or a stroke.
+struct NanoVGCullStats
+{
+    int paths;
+    int points;
+};
+typedef struct NanoVGCullStats NanoVGCullStats;
+
+NanoVGCullStats nvgGetCullStats(NVGcontext* ctx);
+
+// Damage tracking compares each frame's draw calls with the previous frame's to find the framebuffer regions that
+// changed. NVG_DAMAGE_TRACK only reports them. NVG_DAMAGE_PARTIAL also holds back the frame's draw calls until
+// nvgEndFrame, then clears each damaged region to `clearColor` & redraws the calls touching it, scissored to it, so
+// pixels outside the damage are left as they were. It needs a framebuffer that keeps its content between frames,
+// like the Linux software renderer or an image bound with nvgBindFramebuffer, and the frame must not be cleared with
+// nvgClearWithColor. Rendering into images used by the frame isn't tracked, call nvgDamageInvalidate after it.
+enum NVGdamageMode
+{
+    NVG_DAMAGE_OFF,
+    NVG_DAMAGE_TRACK,
+    NVG_DAMAGE_PARTIAL,
+};
+
+void nvgDamageMode(NVGcontext* ctx, int mode, NVGcolor clearColor);
+
+// Damages the whole framebuffer on the next frame.
+void nvgDamageInvalidate(NVGcontext* ctx);
+
+// Copies up to `maxRects` damage rects of the last frame to `xywh`, as x, y, w, h in framebuffer pixels. The rects
+// don't overlap. Returns the number of rects copied.
+int nvgGetDamageRects(NVGcontext* ctx, int* xywh, int maxRects);
+
+// Asynchronous readback. Requests a copy of the `w` x `h` rect at `x`, `y` of `image`, 0 being the framebuffer, and
+// returns a ticket, or 0 when the rect is out of bounds or all NVG_READBACK_SLOTS readbacks are in flight. A request
+// made during a frame reads the image as it is at the end of that frame. On D3D the copy goes through a staging
+// texture and completes some frames later, so poll it each frame instead of stalling on it.
+int nvgRequestReadback(NVGcontext* ctx, int image, int x, int y, int w, int h);
+
+// Copies a completed readback to `data` as tightly packed RGBA rows & frees its ticket. Returns 1 when copied, 0 while
+// it's still in flight and -1 for an unknown ticket or a failed copy.
+int nvgPollReadback(NVGcontext* ctx, int ticket, void* data);
+
+// Frees a ticket without waiting for its copy.
+void nvgCancelReadback(NVGcontext* ctx, int ticket);
+
+// Image atlas. Small images are packed into shared `pageSize` square textures, so image paints using them can share a
+// texture & be batched. Pages are created with `imageFlags` as needed, up to `maxPages` pages. When they are full,
+// adding an image repacks the pages & evicts the least recently used images if it still doesn't fit. Images are moved
+// by repacking, so it's only done outside of frames. A `maxPages` of 0 disables the atlas, changing the page size or
+// flags recreates it, both delete all its images. Disabled by default.
+void nvgImageAtlas(NVGcontext* ctx, int pageSize, int maxPages, int imageFlags);
+
+// Adds an image to the atlas. Returns an id, or 0 when the atlas is disabled, the image is larger than half a page or
+// there's no room for it. Alpha images go to separate pages.
+int  nvgAtlasAddRGBA(NVGcontext* ctx, int w, int h, const unsigned char* data);
+int  nvgAtlasAddAlpha(NVGcontext* ctx, int w, int h, const unsigned char* data);
+void nvgAtlasRemove(NVGcontext* ctx, int id);
+
+// Returns the page image holding an atlas image & optionally its sub-rect `uv` as u0, v0, u1, v1. Returns 0 when the
+// image was evicted. Counts as a use for eviction, call it again after images are added as they may move.
+int nvgAtlasImage(NVGcontext* ctx, int id, float* uv);
+
+// Same as nvgImagePattern() for an atlas image. Fill only the `ex` x `ey` rect at `ox`, `oy`, the rest of the page
+// shows around it. Returns an empty paint when the image was evicted.
+NVGpaint nvgAtlasPattern(NVGcontext* ctx, int id, float ox, float oy, float ex, float ey, float angle, float alpha);
+
+// Repacks the atlas images & frees the pages left empty. Removed images leave holes until then.
+void nvgAtlasDefragment(NVGcontext* ctx);
+
+struct NanoVGAtlasPageStats
+{
+    int    image;
+    int    alpha;         // 1 for pages of alpha images
+    int    images;        // Images packed in the page, each would otherwise be its own texture
+    size_t pageBytes;     // Memory of the page texture
+    size_t usedBytes;     // Pixels of the packed images
+    size_t separateBytes; // Estimated memory of the packed images as separate textures, with 4 KiB allocations
+};
+typedef struct NanoVGAtlasPageStats NanoVGAtlasPageStats;
+
+// Copies the stats of up to `maxPages` atlas pages to `stats`. Returns the number of pages copied.
+int nvgGetAtlasStats(NVGcontext* ctx, NanoVGAtlasPageStats* stats, int maxPages);
+
+// Writes the `w` x `h` rect at `x`, `y` of an image from `data`, whose rows are `pitch` bytes apart. The rest of the
+// image is left untouched.
+void nvgWriteImageRegion(NVGcontext* ctx, int image, int x, int y, int w, int h, const void* data, int pitch);
+
+// Streaming images are RGBA images rewritten every frame, backed by `buffers` textures, up to 4. Writes go to a CPU
+// copy & each frame draws the next texture, brought up to date with the writes made since it was last drawn, so the
+// upload doesn't wait on the GPU still reading the texture of the previous frames. `data` may be NULL.
+int nvgCreateStreamImage(NVGcontext* ctx, int w, int h, int imageFlags, int buffers, const unsigned char* data);
+// Writes a rect of the image from `data`, whose rows are `pitch` bytes apart.
+void nvgStreamImageWrite(NVGcontext* ctx, int stream, int x, int y, int w, int h, const void* data, int pitch);
+// Returns the image to draw this frame. Call it once per frame, after the frame's writes.
+int  nvgStreamImage(NVGcontext* ctx, int stream);
+void nvgDeleteStreamImage(NVGcontext* ctx, int stream);
+
+// Per frame telemetry. When enabled, the stats of the last N frames are kept in a ring buffer. A frame runs from
+// nvgBeginFrame to the end of nvgEndFrame. Times are nanoseconds measured on the thread calling nanovg.
+struct NanoVGFrameStats
+{
+    unsigned int frame; // Frames since telemetry was enabled
+    long long    frameNs;
+    long long    flattenNs;      // nvgFill & nvgStroke, tessellation cache hits take no time
+    long long    expandFillNs;   // nvgFill
+    long long    expandStrokeNs; // nvgStroke & nvgStrokeBlur
+    long long    textNs;         // nvgText & nvgTextBox, layout, glyph rasterization & submission
+    long long    flushNs;        // Backend work in nvgEndFrame
+    int          drawCalls;      // Fill, stroke & triangle calls submitted to the backend
+    int          fillTris;
+    int          strokeTris;
+    int          textTris;
+    size_t       vertexBytes;      // Vertices passed to the backend, packed or not
+    size_t       vertexBytesSaved; // By passing vertices packed, see nvgVertexFormat()
+    size_t       uniformBytes;     // Estimated as one fragment uniform block per backend draw pass
+    size_t       uploadBytes;      // Texture data passed to the backend by nvgCreateImage* & nvgUpdateImage
+    int          imagesCreated;
+    int          pointsHighWater; // Most path points used at once
+    int          vertsHighWater;  // Most vertices passed to the backend by one call
+    int          pointsCapacity;  // Path cache allocations at the end of the frame
+    int          vertsCapacity;
+    int          allocations;    // NVG_MALLOC & NVG_REALLOC calls, for contexts from nvgCreateContextAllocator
+    size_t       allocatedBytes; // Bytes requested by these calls
+    size_t       heapBytes;      // Bytes held through the context's allocator at the end of the frame
+    size_t       arenaBytes;     // Bytes returned by nvgFrameAlloc
+    float        lodScale;       // Tolerance multiplier of the governor, see nvgTessellationGovernor()
+    int          lodSkipBlur;
+};
+typedef struct NanoVGFrameStats NanoVGFrameStats;
+
+// Layouts of the vertices passed to the backend
+enum NVGvertexFormat
+{
+    NVG_VERTEX_FLOAT,  // NVGvertex, 16 bytes
+    NVG_VERTEX_PACKED, // NVGpackedVertex, 8 bytes
+};
+
+// Asks for the vertices of the following draw calls to be passed to the backend as `format`, returns the format the
+// backend takes. Only the Linux software renderer takes packed vertices, see cpunvgPackedParams(). The front end packs
+// the vertices of each call as it passes it to the backend, so edges move by up to 1/32 device pixel. Calls spanning
+// 4096 device pixels or more, or with texture coordinates outside 0..1, are still passed as NVGvertex.
+int nvgVertexFormat(NVGcontext* ctx, int format);
+
+// Keeps the stats of the last `frames` frames. 0 disables telemetry and frees the ring buffer.
+void nvgTelemetryFrames(NVGcontext* ctx, int frames);
+
+// Copies the stats of up to `maxFrames` of the most recent frames to `stats`, newest first. Returns the number of
+// frames copied. The frame in progress is not included.
+int nvgGetFrameStats(NVGcontext* ctx, NanoVGFrameStats* stats, int maxFrames);
+
 // Remove N commands from the path cache. MoveTo = 3, LineTo = 3, BezierTo = 7, QuadTo = 7, Close = 1
 void    nvgPopPath(NVGcontext* ctx, int N);
 int     nvgPathLen(NVGcontext* ctx);
 float** nvgGetPath(NVGcontext* ctx);
 
+// Display lists record the tessellated output of the draw calls made between nvgBeginDisplayList() and
+// nvgEndDisplayList(), so static layers can be redrawn without building, flattening and expanding their paths again.
+// Calls are still drawn while recording. Images used by the recorded paints must outlive the list.
+typedef struct NVGdisplayList NVGdisplayList;
+
+void            nvgBeginDisplayList(NVGcontext* ctx);
+NVGdisplayList* nvgEndDisplayList(NVGcontext* ctx);
+// Submits the recorded calls to the backend. `xform` is applied on top of the recorded geometry, paints and scissors,
+// pass NULL for identity. Must be called between nvgBeginFrame() and nvgEndFrame().
+void nvgDrawDisplayList(NVGcontext* ctx, const NVGdisplayList* list, const float* xform);
+void nvgDeleteDisplayList(NVGdisplayList* list);
+
+// Recorders take the regular path, paint, transform & scissor calls on another thread and flatten & expand the paths
+// there, much like D3D11 deferred contexts. Each recording is a display list the render thread draws into its context
+// with nvgDrawDisplayList(), in whatever order it wants. A recorder is used by one thread at a time. Create & delete
+// them on the render thread while no recorder of `ctx` is in use, other contexts & their recorders don't matter.
+// Recorders have no backend: they can use the images of `ctx`, which must not be created or deleted while they
+// record, but can't create images or draw text.
+NVGcontext* nvgCreateRecorder(NVGcontext* ctx);
+void        nvgDeleteRecorder(NVGcontext* recorder);
+// Same as nvgBeginFrame(), the size & pixel ratio should match those of the frame the recording will be drawn in.
+void            nvgBeginRecording(NVGcontext* recorder, float windowWidth, float windowHeight, float devicePixelRatio);
+NVGdisplayList* nvgEndRecording(NVGcontext* recorder);
+
 #ifdef __cplusplus
 }
 #endif
@@ -23,5 +23,5 @@ NVGcontext* mnvgCreateContext(void* view, int flags, int width, int height) {
     [(CAMetalLayer*)[(__bridge NSView*)view layer]
         setDrawableSize:CGSizeMake(width, height)];
 
-    return nvgCreateMTL((__bridge void*)((__bridge NSView*)view).layer, flags);
+    return nvgCompatInit(nvgCreateMTL((__bridge void*)((__bridge NSView*)view).layer, flags));
 }
@@ -0,0 +1,2264 @@
+//
+// Software rendering backend for NanoVG.
+//
+// Renders into plain RGBA8 (premultiplied) memory without any GPU. Draw calls are recorded during the frame the same
+// way the GL/D3D/Metal backends do, and are rasterized on renderFlush. The target is split into tiles and each tile
+// replays every call that touches it, so tiles can be processed on a pool of worker threads without synchronisation.
+// The rasterizer follows the GL backend's pipeline (stencil winding fills, fringe strips for AA and the same
+// fragment shader), so images rendered here should match the GPU backends closely.
+//
+#ifndef NANOVG_CPU_H
+#define NANOVG_CPU_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Create flags
+enum NVGcreateFlags
+{
+    // Flag indicating if geometry based anti-aliasing is used (may not be needed when using MSAA).
+    NVG_ANTIALIAS = 1 << 0,
+    // Flag indicating if strokes should be drawn using stencil buffer. The rendering will be a little
+    // slower, but path overlaps (i.e. self-intersecting or sharp turns) will be drawn just once.
+    NVG_STENCIL_STROKES = 1 << 1,
+    // Flag indicating that additional debug checks are done.
+    NVG_DEBUG = 1 << 2,
+};
+
+// Maximum number of rasterizer threads, including the calling thread
+#ifndef NVG_CPU_MAX_THREADS
+#define NVG_CPU_MAX_THREADS 32
+#endif
+
+// Width & height in pixels of the tiles handed to the worker threads
+#ifndef NVG_CPU_TILE_SIZE
+#define NVG_CPU_TILE_SIZE 64
+#endif
+
+// Maximum number of frames in the ring of a shared framebuffer
+#define NVG_CPU_MAX_SHARED_BUFFERS 3
+
+#define NVG_CPU_SHARED_MAGIC 0x5347564e // "NVGS"
+#define NVG_CPU_SHARED_VERSION 1
+
+enum NVGimageFlagsCPU
+{
+    // cpunvgCreateFramebuffer allocates a triple buffered shared framebuffer, see cpunvgCreateSharedFramebuffer()
+    NVG_IMAGE_SHARED = 1 << 16,
+};
+
+// Header at the start of a shared framebuffer's memory, slot `i` starts at bufferOffset + i * bufferSize. The renderer
+// draws each frame into a slot that holds neither the last completed frame nor the one the consumer fenced, then on
+// nvgEndFrame stores the frame's sequence number into the slot's entry of `slots` & into `sequence`. A consumer
+// process maps the memfd read only, and for each frame:
+//  1. loads `sequence` (acquire). If it didn't change since the last frame read, there is no new frame,
+//  2. stores it into `fence` (sequentially consistent) & finds the slot holding it, or starts over if none does,
+//  3. reads the slot's pixels, then checks the slot still holds the same sequence number. It changes when the
+//     renderer picked the slot before seeing the fence, or when it had no other slot to draw into, which only happens
+//     with 2 buffers. The pixels read are torn then.
+// Slots keep the frame drawn in them 2 or 3 frames earlier, so frames should start with a clear.
+struct CPUNVGsharedHeader
+{
+    unsigned int       magic;   // NVG_CPU_SHARED_MAGIC
+    unsigned int       version; // NVG_CPU_SHARED_VERSION
+    int                width;
+    int                height;
+    int                stride; // Bytes between rows of RGBA8 premultiplied pixels
+    int                nbuffers;
+    unsigned long long bufferOffset;
+    unsigned long long bufferSize;
+    unsigned long long sequence;                           // Last completed frame, 0 before the first one
+    unsigned long long slots[NVG_CPU_MAX_SHARED_BUFFERS]; // Frame held by each slot, 0 while it's drawn into
+    unsigned long long fence;                              // Frame being read, written by the consumer
+};
+typedef struct CPUNVGsharedHeader CPUNVGsharedHeader;
+
+// Creates a context which renders into a `width` x `height` RGBA8 framebuffer held in memory.
+NVGcontext* nvgCreateCPU(int flags, int width, int height);
+void        nvgDeleteCPU(NVGcontext* ctx);
+
+// Sets the number of threads used by renderFlush. 0 uses one per online CPU. 1 rasterizes on the calling thread.
+void cpunvgSetThreadCount(NVGcontext* ctx, int nthreads);
+
+// Resizes the main framebuffer. Its contents are cleared.
+void cpunvgSetViewBounds(NVGcontext* ctx, int width, int height);
+// Binds an image as the target of the following frames. 0 is the main framebuffer.
+void cpunvgBindFramebuffer(NVGcontext* ctx, int image);
+// Creates an RGBA image to use as a render target. Every RGBA image can be bound, this only exists for parity with
+// the other backends, & to create shared framebuffers with NVG_IMAGE_SHARED.
+int  cpunvgCreateFramebuffer(NVGcontext* ctx, int w, int h, int flags);
+void cpunvgClearWithColor(NVGcontext* ctx, NVGcolor color);
+// Copies the pixels from the specified image into the specified `data`. Image 0 reads the main framebuffer.
+void cpunvgReadPixels(NVGcontext* ctx, int image, int x, int y, int width, int height, void* data);
+// Writes the `w` x `h` rect at `x`, `y` of an RGBA or alpha image from `data`, whose rows are `pitch` bytes apart.
+void cpunvgWriteImageRegion(NVGcontext* ctx, int image, int x, int y, int w, int h, const void* data, int pitch);
+// Returns the memory behind an image, or the main framebuffer when `image` is 0. Rows are `*stride` bytes apart.
+unsigned char* cpunvgImageData(NVGcontext* ctx, int image, int* w, int* h, int* stride);
+// Writes the draw calls taking packed vertices to `packed` & returns 1 when `params` are those of a context created by
+// nvgCreateCPU, returns 0 otherwise. Packed calls keep their vertices packed until they are rasterized.
+int cpunvgPackedParams(const NVGparams* params, NVGpackedParams* packed);
+// Creates an RGBA render target whose pixels live in a ring of `nbuffers` frames, 2 or 3, in a memfd another process
+// can map, see CPUNVGsharedHeader. Rows are `stride` bytes apart, a multiple of 4 of at least `w` * 4, or 0 to round
+// `w` * 4 up to 64 bytes. While bound, each nvgEndFrame completes a frame & moves drawing to the next slot, which
+// doesn't hold the previous frame, so damage tracking doesn't work on these. Returns 0 on failure.
+int cpunvgCreateSharedFramebuffer(NVGcontext* ctx, int w, int h, int stride, int nbuffers, int flags);
+// Returns the memfd of a shared framebuffer & the size to map in `*size`, or -1 for other images. The fd belongs to the
+// context, which closes it when the image is deleted: dup it, or send it over a Unix socket, to hand it to a consumer.
+int cpunvgSharedFramebufferFd(NVGcontext* ctx, int image, size_t* size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NANOVG_CPU_H
+
+#ifdef NANOVG_CPU_IMPLEMENTATION
+
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Called after cpunvgWriteImageRegion writes a rect, so code compiled with the implementation can track such writes
+#ifndef CPUNVG_IMAGE_WRITTEN
+#define CPUNVG_IMAGE_WRITTEN(ctx, image, x, y, w, h, data, pitch)
+#endif
+
+// memfd_create & file seals are only declared with _GNU_SOURCE
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CPUNVG_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CPUNVG_NEON 1
+#endif
+
+enum CPUNVGcallType
+{
+    CPUNVG_NONE = 0,
+    CPUNVG_FILL,
+    CPUNVG_CONVEXFILL,
+    CPUNVG_STROKE,
+    CPUNVG_TRIANGLES,
+};
+
+enum CPUNVGshaderType
+{
+    CPUNVG_SHADER_FILLGRAD,
+    CPUNVG_SHADER_FILLIMG,
+    CPUNVG_SHADER_SIMPLE,
+    CPUNVG_SHADER_IMG,
+    // Paints with a negative feather, see nvgBoxShadow()
+    CPUNVG_SHADER_FILLBLUR
+};
+
+// Mapping of a shared framebuffer, see cpunvgCreateSharedFramebuffer()
+struct CPUNVGshared
+{
+    int                 fd;
+    size_t              size;
+    unsigned char*      memory;
+    CPUNVGsharedHeader* header;
+    // Slot drawn into, the texture's data
+    int slot;
+};
+typedef struct CPUNVGshared CPUNVGshared;
+
+struct CPUNVGtexture
+{
+    int            id;
+    int            type;
+    int            width, height;
+    int            stride;
+    int            flags;
+    unsigned char* data;
+    // Set for shared framebuffers, whose data points into the mapping
+    CPUNVGshared* shared;
+};
+typedef struct CPUNVGtexture CPUNVGtexture;
+
+// Mirrors the uniforms of the GL fragment shader
+struct CPUNVGfragUniforms
+{
+    float    scissorMat[6];
+    float    paintMat[6];
+    NVGcolor innerCol;
+    NVGcolor outerCol;
+    float    scissorExt[2];
+    float    scissorScale[2];
+    float    extent[2];
+    float    radius;
+    float    feather;
+    float    strokeMult;
+    float    strokeThr;
+    int      texType;
+    int      type;
+};
+typedef struct CPUNVGfragUniforms CPUNVGfragUniforms;
+
+struct CPUNVGpath
+{
+    int fillOffset;
+    int fillCount;
+    int strokeOffset;
+    int strokeCount;
+};
+typedef struct CPUNVGpath CPUNVGpath;
+
+struct CPUNVGcall
+{
+    int                        type;
+    int                        image;
+    int                        pathOffset;
+    int                        pathCount;
+    int                        triangleOffset;
+    int                        triangleCount;
+    int                        uniformOffset;
+    NVGcompositeOperationState blendFunc;
+    // Bounds of the call's vertices in logical units
+    float bounds[4];
+    // Set when the call's offsets index packedVerts, which lie at origin + (x, y) / scale
+    int   packed;
+    float origin[2];
+    float scale;
+    // Bounds in target pixels, x0 y0 x1 y1 with max exclusive. Computed on flush
+    int pixelBounds[4];
+};
+typedef struct CPUNVGcall CPUNVGcall;
+
+// Pixel rectangle being rendered to
+struct CPUNVGtarget
+{
+    unsigned char* pixels;
+    int            width;
+    int            height;
+    int            stride;
+};
+typedef struct CPUNVGtarget CPUNVGtarget;
+
+struct CPUNVGcontext;
+
+struct CPUNVGworker
+{
+    struct CPUNVGcontext* cpu;
+    int                   index;
+};
+typedef struct CPUNVGworker CPUNVGworker;
+
+struct CPUNVGcontext
+{
+    int            flags;
+    float          view[2];
+    CPUNVGtexture* textures;
+    int            ntextures;
+    int            ctextures;
+    int            textureId;
+
+    CPUNVGcall*         calls;
+    int                 ccalls;
+    int                 ncalls;
+    CPUNVGpath*         paths;
+    int                 cpaths;
+    int                 npaths;
+    NVGvertex*          verts;
+    int                 cverts;
+    int                 nverts;
+    NVGpackedVertex*    packedVerts;
+    int                 cpackedVerts;
+    int                 npackedVerts;
+    CPUNVGfragUniforms* uniforms;
+    int                 cuniforms;
+    int                 nuniforms;
+
+    // Main framebuffer
+    unsigned char* mainPixels;
+    int            mainWidth;
+    int            mainHeight;
+    // Currently bound framebuffer image, 0 = main
+    int image;
+
+    // Worker pool. Threads wait on `wake` for a new `generation`, then pull tiles until `nextTile` reaches `ntiles`
+    pthread_t       threads[NVG_CPU_MAX_THREADS];
+    CPUNVGworker    workers[NVG_CPU_MAX_THREADS];
+    int             nthreads;
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;
+    pthread_cond_t  done;
+    int             generation;
+    int             quit;
+    int             nextTile;
+    int             ntiles;
+    int             tilesX;
+    int             tilesDone;
+    CPUNVGtarget    job;
+    // One tile sized stencil buffer per thread
+    unsigned char* stencil;
+};
+typedef struct CPUNVGcontext CPUNVGcontext;
+
+static int cpunvg__maxi(int a, int b) { return a > b ? a : b; }
+static int cpunvg__mini(int a, int b) { return a < b ? a : b; }
+
+static float cpunvg__clampf(float a, float mn, float mx) { return a < mn ? mn : (a > mx ? mx : a); }
+
+static CPUNVGtexture* cpunvg__allocTexture(CPUNVGcontext* cpu)
+{
+    CPUNVGtexture* tex = NULL;
+    int            i;
+
+    for (i = 0; i < cpu->ntextures; i++)
+    {
+        if (cpu->textures[i].id == 0)
+        {
+            tex = &cpu->textures[i];
+            break;
+        }
+    }
+    if (tex == NULL)
+    {
+        if (cpu->ntextures + 1 > cpu->ctextures)
+        {
+            CPUNVGtexture* textures;
+            int            ctextures = cpunvg__maxi(cpu->ntextures + 1, 4) + cpu->ctextures / 2; // 1.5x Overallocate
+            textures = (CPUNVGtexture*)realloc(cpu->textures, sizeof(CPUNVGtexture) * ctextures);
+            if (textures == NULL)
+                return NULL;
+            cpu->textures  = textures;
+            cpu->ctextures = ctextures;
+        }
+        tex = &cpu->textures[cpu->ntextures++];
+    }
+
+    memset(tex, 0, sizeof(*tex));
+    tex->id = ++cpu->textureId;
+
+    return tex;
+}
+
+static CPUNVGtexture* cpunvg__findTexture(CPUNVGcontext* cpu, int id)
+{
+    int i;
+    for (i = 0; i < cpu->ntextures; i++)
+        if (cpu->textures[i].id == id)
+            return &cpu->textures[i];
+    return NULL;
+}
+
+static void cpunvg__deleteShared(CPUNVGshared* shared)
+{
+    if (shared == NULL)
+        return;
+    if (shared->memory != NULL)
+        munmap(shared->memory, shared->size);
+    if (shared->fd != -1)
+        close(shared->fd);
+    free(shared);
+}
+
+static void cpunvg__freeTextureData(CPUNVGtexture* tex)
+{
+    if (tex->shared != NULL)
+        cpunvg__deleteShared(tex->shared);
+    else
+        free(tex->data);
+}
+
+// Replaces the pixels of an RGBA texture with the first slot of a ring of `nbuffers` frames in a sealed memfd
+static int cpunvg__createShared(CPUNVGtexture* tex, int stride, int nbuffers)
+{
+    long                page = sysconf(_SC_PAGESIZE);
+    CPUNVGshared*       shared;
+    CPUNVGsharedHeader* header;
+    size_t              bufferSize;
+
+    if (stride == 0)
+        stride = (tex->width * 4 + 63) & ~63;
+    if (stride < tex->width * 4 || stride % 4 != 0 || nbuffers < 2 || nbuffers > NVG_CPU_MAX_SHARED_BUFFERS)
+        return 0;
+    if (page <= 0)
+        page = 4096;
+
+    shared = (CPUNVGshared*)calloc(1, sizeof(CPUNVGshared));
+    if (shared == NULL)
+        return 0;
+    // The header takes the first page & each slot starts on a page
+    bufferSize   = ((size_t)stride * tex->height + page - 1) / page * page;
+    shared->size = page + bufferSize * nbuffers;
+    shared->fd   = (int)syscall(SYS_memfd_create, "nanovg framebuffer", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (shared->fd == -1 || ftruncate(shared->fd, (off_t)shared->size) != 0)
+    {
+        cpunvg__deleteShared(shared);
+        return 0;
+    }
+    // Consumers can trust the size they map
+    fcntl(shared->fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+
+    shared->memory = (unsigned char*)mmap(NULL, shared->size, PROT_READ | PROT_WRITE, MAP_SHARED, shared->fd, 0);
+    if (shared->memory == MAP_FAILED)
+    {
+        shared->memory = NULL;
+        cpunvg__deleteShared(shared);
+        return 0;
+    }
+
+    header               = (CPUNVGsharedHeader*)shared->memory;
+    header->magic        = NVG_CPU_SHARED_MAGIC;
+    header->version      = NVG_CPU_SHARED_VERSION;
+    header->width        = tex->width;
+    header->height       = tex->height;
+    header->stride       = stride;
+    header->nbuffers     = nbuffers;
+    header->bufferOffset = (unsigned long long)page;
+    header->bufferSize   = bufferSize;
+    shared->header       = header;
+
+    free(tex->data);
+    tex->data   = shared->memory + header->bufferOffset;
+    tex->stride = stride;
+    tex->shared = shared;
+    return 1;
+}
+
+// Completes the frame drawn into the current slot & moves drawing to the oldest slot the consumer didn't fence
+static void cpunvg__publishShared(CPUNVGtexture* tex)
+{
+    CPUNVGshared*       shared   = tex->shared;
+    CPUNVGsharedHeader* header   = shared->header;
+    unsigned long long  sequence = header->sequence + 1;
+    unsigned long long  fence;
+    int                 i, next = -1;
+
+    __atomic_store_n(&header->slots[shared->slot], sequence, __ATOMIC_RELEASE);
+    __atomic_store_n(&header->sequence, sequence, __ATOMIC_RELEASE);
+
+    fence = __atomic_load_n(&header->fence, __ATOMIC_SEQ_CST);
+    for (i = 0; i < header->nbuffers; i++)
+    {
+        if (i == shared->slot || (fence != 0 && header->slots[i] == fence))
+            continue;
+        if (next == -1 || header->slots[i] < header->slots[next])
+            next = i;
+    }
+    // Double buffered with the consumer reading the previous frame, it sees the slot change
+    if (next == -1)
+        next = (shared->slot + 1) % header->nbuffers;
+
+    __atomic_store_n(&header->slots[next], 0, __ATOMIC_SEQ_CST);
+    shared->slot = next;
+    tex->data    = shared->memory + header->bufferOffset + (size_t)next * header->bufferSize;
+}
+
+static int cpunvg__deleteTexture(CPUNVGcontext* cpu, int id)
+{
+    int i;
+    for (i = 0; i < cpu->ntextures; i++)
+    {
+        if (cpu->textures[i].id == id)
+        {
+            cpunvg__freeTextureData(&cpu->textures[i]);
+            memset(&cpu->textures[i], 0, sizeof(cpu->textures[i]));
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static CPUNVGcall* cpunvg__allocCall(CPUNVGcontext* cpu)
+{
+    CPUNVGcall* ret = NULL;
+    if (cpu->ncalls + 1 > cpu->ccalls)
+    {
+        CPUNVGcall* calls;
+        int         ccalls = cpunvg__maxi(cpu->ncalls + 1, 128) + cpu->ccalls / 2; // 1.5x Overallocate
+        calls              = (CPUNVGcall*)realloc(cpu->calls, sizeof(CPUNVGcall) * ccalls);
+        if (calls == NULL)
+            return NULL;
+        cpu->calls  = calls;
+        cpu->ccalls = ccalls;
+    }
+    ret = &cpu->calls[cpu->ncalls++];
+    memset(ret, 0, sizeof(CPUNVGcall));
+    return ret;
+}
+
+static int cpunvg__allocPaths(CPUNVGcontext* cpu, int n)
+{
+    int ret = 0;
+    if (cpu->npaths + n > cpu->cpaths)
+    {
+        CPUNVGpath* paths;
+        int         cpaths = cpunvg__maxi(cpu->npaths + n, 128) + cpu->cpaths / 2; // 1.5x Overallocate
+        paths              = (CPUNVGpath*)realloc(cpu->paths, sizeof(CPUNVGpath) * cpaths);
+        if (paths == NULL)
+            return -1;
+        cpu->paths  = paths;
+        cpu->cpaths = cpaths;
+    }
+    ret          = cpu->npaths;
+    cpu->npaths += n;
+    return ret;
+}
+
+static int cpunvg__allocVerts(CPUNVGcontext* cpu, int n)
+{
+    int ret = 0;
+    if (cpu->nverts + n > cpu->cverts)
+    {
+        NVGvertex* verts;
+        int        cverts = cpunvg__maxi(cpu->nverts + n, 4096) + cpu->cverts / 2; // 1.5x Overallocate
+        verts             = (NVGvertex*)realloc(cpu->verts, sizeof(NVGvertex) * cverts);
+        if (verts == NULL)
+            return -1;
+        cpu->verts  = verts;
+        cpu->cverts = cverts;
+    }
+    ret          = cpu->nverts;
+    cpu->nverts += n;
+    return ret;
+}
+
+static int cpunvg__allocPackedVerts(CPUNVGcontext* cpu, int n)
+{
+    int ret = 0;
+    if (cpu->npackedVerts + n > cpu->cpackedVerts)
+    {
+        NVGpackedVertex* verts;
+        int              cverts = cpunvg__maxi(cpu->npackedVerts + n, 4096) + cpu->cpackedVerts / 2;
+        verts                   = (NVGpackedVertex*)realloc(cpu->packedVerts, sizeof(NVGpackedVertex) * cverts);
+        if (verts == NULL)
+            return -1;
+        cpu->packedVerts  = verts;
+        cpu->cpackedVerts = cverts;
+    }
+    ret                = cpu->npackedVerts;
+    cpu->npackedVerts += n;
+    return ret;
+}
+
+static int cpunvg__allocFragUniforms(CPUNVGcontext* cpu, int n)
+{
+    int ret = 0;
+    if (cpu->nuniforms + n > cpu->cuniforms)
+    {
+        CPUNVGfragUniforms* uniforms;
+        int                 cuniforms = cpunvg__maxi(cpu->nuniforms + n, 128) + cpu->cuniforms / 2;
+        uniforms = (CPUNVGfragUniforms*)realloc(cpu->uniforms, sizeof(CPUNVGfragUniforms) * cuniforms);
+        if (uniforms == NULL)
+            return -1;
+        cpu->uniforms  = uniforms;
+        cpu->cuniforms = cuniforms;
+    }
+    ret             = cpu->nuniforms;
+    cpu->nuniforms += n;
+    return ret;
+}
+
+static int cpunvg__maxVertCount(const NVGpath* paths, int npaths)
+{
+    int i, count = 0;
+    for (i = 0; i < npaths; i++)
+    {
+        count += paths[i].nfill;
+        count += paths[i].nstroke;
+    }
+    return count;
+}
+
+static NVGcolor cpunvg__premulColor(NVGcolor c)
+{
+    c.r *= c.a;
+    c.g *= c.a;
+    c.b *= c.a;
+    return c;
+}
+
+static int cpunvg__convertPaint(
+    CPUNVGcontext*      cpu,
+    CPUNVGfragUniforms* frag,
+    NVGpaint*           paint,
+    NVGscissor*         scissor,
+    float               width,
+    float               fringe,
+    float               strokeThr)
+{
+    CPUNVGtexture* tex = NULL;
+    float          invxform[6];
+
+    memset(frag, 0, sizeof(*frag));
+
+    frag->innerCol = cpunvg__premulColor(paint->innerColor);
+    frag->outerCol = cpunvg__premulColor(paint->outerColor);
+
+    if (scissor->extent[0] < -0.5f || scissor->extent[1] < -0.5f)
+    {
+        memset(frag->scissorMat, 0, sizeof(frag->scissorMat));
+        frag->scissorExt[0]   = 1.0f;
+        frag->scissorExt[1]   = 1.0f;
+        frag->scissorScale[0] = 1.0f;
+        frag->scissorScale[1] = 1.0f;
+    }
+    else
+    {
+        nvgTransformInverse(frag->scissorMat, scissor->xform);
+        frag->scissorExt[0] = scissor->extent[0];
+        frag->scissorExt[1] = scissor->extent[1];
+        frag->scissorScale[0] =
+            sqrtf(scissor->xform[0] * scissor->xform[0] + scissor->xform[2] * scissor->xform[2]) / fringe;
+        frag->scissorScale[1] =
+            sqrtf(scissor->xform[1] * scissor->xform[1] + scissor->xform[3] * scissor->xform[3]) / fringe;
+    }
+
+    memcpy(frag->extent, paint->extent, sizeof(frag->extent));
+    frag->strokeMult = (width * 0.5f + fringe * 0.5f) / fringe;
+    frag->strokeThr  = strokeThr;
+
+    if (paint->image != 0)
+    {
+        tex = cpunvg__findTexture(cpu, paint->image);
+        if (tex == NULL)
+            return 0;
+        if ((tex->flags & NVG_IMAGE_FLIPY) != 0)
+        {
+            float m1[6], m2[6];
+            nvgTransformTranslate(m1, 0.0f, frag->extent[1] * 0.5f);
+            nvgTransformMultiply(m1, paint->xform);
+            nvgTransformScale(m2, 1.0f, -1.0f);
+            nvgTransformMultiply(m2, m1);
+            nvgTransformTranslate(m1, 0.0f, -frag->extent[1] * 0.5f);
+            nvgTransformMultiply(m1, m2);
+            nvgTransformInverse(invxform, m1);
+        }
+        else
+        {
+            nvgTransformInverse(invxform, paint->xform);
+        }
+        frag->type = CPUNVG_SHADER_FILLIMG;
+
+        if (tex->type == NVG_TEXTURE_RGBA)
+            frag->texType = (tex->flags & NVG_IMAGE_PREMULTIPLIED) ? 0 : 1;
+        else
+            frag->texType = 2;
+    }
+    else
+    {
+        frag->type    = paint->feather < 0.0f ? CPUNVG_SHADER_FILLBLUR : CPUNVG_SHADER_FILLGRAD;
+        frag->radius  = paint->radius;
+        frag->feather = fabsf(paint->feather);
+        nvgTransformInverse(invxform, paint->xform);
+    }
+
+    memcpy(frag->paintMat, invxform, sizeof(frag->paintMat));
+
+    return 1;
+}
+
+//
+// Rasterizer
+//
+
+enum CPUNVGstencilOp
+{
+    // No stencil test, colour is written
+    CPUNVG_STENCIL_OFF,
+    // Colour masked, front faces increment and back faces decrement
+    CPUNVG_STENCIL_WINDING,
+    // Passes where stencil == 0, colour is written
+    CPUNVG_STENCIL_EQUAL_ZERO,
+    // Passes where stencil == 0, colour is written and the stencil is incremented
+    CPUNVG_STENCIL_EQUAL_ZERO_INCR,
+    // Passes where stencil != 0, colour is written and the stencil is zeroed
+    CPUNVG_STENCIL_NOTEQUAL_ZERO,
+    // Colour masked, stencil is zeroed
+    CPUNVG_STENCIL_CLEAR,
+};
+
+struct CPUNVGtile
+{
+    const CPUNVGcontext* cpu;
+    const CPUNVGtarget*  target;
+    unsigned char*       stencil;
+    int                  x0, y0, x1, y1;
+    // Logical units to device pixels
+    float sx, sy;
+};
+typedef struct CPUNVGtile CPUNVGtile;
+
+struct CPUNVGdraw
+{
+    const CPUNVGfragUniforms*  frag;
+    const CPUNVGtexture*       tex;
+    NVGcompositeOperationState blend;
+    int                        stencilOp;
+    // Vertices of the call, packed ones lie at origin + (x, y) * invScale
+    const NVGvertex*       verts;
+    const NVGpackedVertex* packed;
+    float                  origin[2];
+    float                  invScale;
+};
+typedef struct CPUNVGdraw CPUNVGdraw;
+
+// An edge function evaluated in a canonical vertex order, so the two triangles sharing an edge produce exactly
+// negated values and every pixel on the edge is covered once.
+struct CPUNVGedge
+{
+    float ax, ay;
+    float dx, dy;
+    // Flips the canonical value so the inside of the triangle is positive
+    float sign;
+    // Top-left fill rule: pixels exactly on the edge are owned by this triangle
+    int topLeft;
+};
+typedef struct CPUNVGedge CPUNVGedge;
+
+static void cpunvg__setupEdge(CPUNVGedge* e, float x0, float y0, float x1, float y1, float orient)
+{
+    float odx, ody;
+    if (x0 < x1 || (x0 == x1 && y0 < y1))
+    {
+        e->ax   = x0;
+        e->ay   = y0;
+        e->dx   = x1 - x0;
+        e->dy   = y1 - y0;
+        e->sign = orient;
+    }
+    else
+    {
+        e->ax   = x1;
+        e->ay   = y1;
+        e->dx   = x0 - x1;
+        e->dy   = y0 - y1;
+        e->sign = -orient;
+    }
+    // Direction of the edge once the triangle is wound positively
+    odx        = (x1 - x0) * orient;
+    ody        = (y1 - y0) * orient;
+    e->topLeft = ody < 0.0f || (ody == 0.0f && odx > 0.0f);
+}
+
+static float cpunvg__evalEdge(const CPUNVGedge* e, float px, float py)
+{
+    return e->sign * (e->dx * (py - e->ay) - e->dy * (px - e->ax));
+}
+
+// Returns a bitmask of which of the 4 pixel centres starting at `px` are inside the edge
+static int cpunvg__edgeMask4(const CPUNVGedge* e, float px, float py)
+{
+#if defined(CPUNVG_SSE2)
+    __m128 x = _mm_add_ps(_mm_set1_ps(px), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+    __m128 t = _mm_set1_ps(e->dx * (py + 0.5f - e->ay));
+    __m128 v = _mm_mul_ps(
+        _mm_set1_ps(e->sign),
+        _mm_sub_ps(t, _mm_mul_ps(_mm_set1_ps(e->dy), _mm_sub_ps(x, _mm_set1_ps(e->ax)))));
+    __m128 m = e->topLeft ? _mm_cmpge_ps(v, _mm_setzero_ps()) : _mm_cmpgt_ps(v, _mm_setzero_ps());
+    return _mm_movemask_ps(m);
+#elif defined(CPUNVG_NEON)
+    static const float    offsets[4] = {0.5f, 1.5f, 2.5f, 3.5f};
+    static const uint32_t bits[4]    = {1, 2, 4, 8};
+    float32x4_t           x          = vaddq_f32(vdupq_n_f32(px), vld1q_f32(offsets));
+    float32x4_t           t          = vdupq_n_f32(e->dx * (py + 0.5f - e->ay));
+    float32x4_t           v =
+        vmulq_f32(vdupq_n_f32(e->sign), vsubq_f32(t, vmulq_f32(vdupq_n_f32(e->dy), vsubq_f32(x, vdupq_n_f32(e->ax)))));
+    uint32x4_t m = e->topLeft ? vcgeq_f32(v, vdupq_n_f32(0.0f)) : vcgtq_f32(v, vdupq_n_f32(0.0f));
+    m            = vandq_u32(m, vld1q_u32(bits));
+    return (int)(vgetq_lane_u32(m, 0) | vgetq_lane_u32(m, 1) | vgetq_lane_u32(m, 2) | vgetq_lane_u32(m, 3));
+#else
+    int   i, mask = 0;
+    float t = e->dx * (py + 0.5f - e->ay);
+    for (i = 0; i < 4; i++)
+    {
+        float v = e->sign * (t - e->dy * (px + (0.5f + i) - e->ax));
+        if (v > 0.0f || (v == 0.0f && e->topLeft))
+            mask |= 1 << i;
+    }
+    return mask;
+#endif
+}
+
+static float cpunvg__sdroundrect(float px, float py, float ex, float ey, float rad)
+{
+    float dx = fabsf(px) - (ex - rad);
+    float dy = fabsf(py) - (ey - rad);
+    float mx = dx > 0.0f ? dx : 0.0f;
+    float my = dy > 0.0f ? dy : 0.0f;
+    return fminf(fmaxf(dx, dy), 0.0f) + sqrtf(mx * mx + my * my) - rad;
+}
+
+// Abramowitz & Stegun 7.1.27, max error 5e-4
+static float cpunvg__erf(float x)
+{
+    float s = x < 0.0f ? -1.0f : 1.0f;
+    float a = fabsf(x);
+    float t = 1.0f + (0.278393f + (0.230389f + 0.078108f * (a * a)) * a) * a;
+    t      *= t;
+    return s - s / (t * t);
+}
+
+// Coverage of the rounded rect of half size `ex`, `ey` centered on the origin, convolved with a Gaussian of standard
+// deviation `sigma`. Each row of the rect is integrated exactly with erf, the Gaussian along y with 8 samples. Fewer
+// samples miss the bend of the corners, 4 are off by up to 12 / 255 on a circle of radius 40 blurred by 3.
+static float cpunvg__blurRoundRect(float px, float py, float ex, float ey, float rad, float sigma)
+{
+    float start = cpunvg__clampf(-3.0f * sigma, py - ey, py + ey);
+    float end   = cpunvg__clampf(3.0f * sigma, py - ey, py + ey);
+    float step  = (end - start) * 0.125f;
+    float y     = start + step * 0.5f;
+    float k     = 0.70710678f / sigma;
+    float sum   = 0.0f;
+    int   i;
+
+    for (i = 0; i < 8; i++, y += step)
+    {
+        // Half width of the rect at row py - y
+        float d      = fminf(ey - rad - fabsf(py - y), 0.0f);
+        float curved = ex - rad + sqrtf(fmaxf(0.0f, rad * rad - d * d));
+        float g      = expf(-0.5f * y * y / (sigma * sigma));
+        sum         += (cpunvg__erf((px + curved) * k) - cpunvg__erf((px - curved) * k)) * g;
+    }
+    // 0.5 from erf to the normal CDF, 1 / sqrt(2 pi) from the Gaussian
+    return cpunvg__clampf(sum * step * 0.5f * 0.39894228f / sigma, 0.0f, 1.0f);
+}
+
+static float cpunvg__scissorMask(const CPUNVGfragUniforms* frag, float x, float y)
+{
+    const float* m  = frag->scissorMat;
+    float        sx = fabsf(m[0] * x + m[2] * y + m[4]) - frag->scissorExt[0];
+    float        sy = fabsf(m[1] * x + m[3] * y + m[5]) - frag->scissorExt[1];
+    sx              = 0.5f - sx * frag->scissorScale[0];
+    sy              = 0.5f - sy * frag->scissorScale[1];
+    return cpunvg__clampf(sx, 0.0f, 1.0f) * cpunvg__clampf(sy, 0.0f, 1.0f);
+}
+
+static float cpunvg__texel(const CPUNVGtexture* tex, int x, int y, int c)
+{
+    if (tex->flags & NVG_IMAGE_REPEATX)
+        x = ((x % tex->width) + tex->width) % tex->width;
+    else
+        x = cpunvg__maxi(0, cpunvg__mini(x, tex->width - 1));
+    if (tex->flags & NVG_IMAGE_REPEATY)
+        y = ((y % tex->height) + tex->height) % tex->height;
+    else
+        y = cpunvg__maxi(0, cpunvg__mini(y, tex->height - 1));
+
+    if (tex->type == NVG_TEXTURE_RGBA)
+        return tex->data[y * tex->stride + x * 4 + c] * (1.0f / 255.0f);
+    return tex->data[y * tex->stride + x] * (1.0f / 255.0f);
+}
+
+// Samples `tex` at normalized coordinates. Alpha textures return their value in the first channel, like GL_RED.
+static void cpunvg__sample(const CPUNVGtexture* tex, float u, float v, float* out)
+{
+    int nc = tex->type == NVG_TEXTURE_RGBA ? 4 : 1;
+    int c;
+
+    u *= tex->width;
+    v *= tex->height;
+
+    if (tex->flags & NVG_IMAGE_NEAREST)
+    {
+        int x = (int)floorf(u), y = (int)floorf(v);
+        for (c = 0; c < nc; c++)
+            out[c] = cpunvg__texel(tex, x, y, c);
+    }
+    else
+    {
+        float fx = u - 0.5f, fy = v - 0.5f;
+        int   x = (int)floorf(fx), y = (int)floorf(fy);
+        float tx = fx - x, ty = fy - y;
+        for (c = 0; c < nc; c++)
+        {
+            float t0 = cpunvg__texel(tex, x, y, c) * (1.0f - tx) + cpunvg__texel(tex, x + 1, y, c) * tx;
+            float t1 = cpunvg__texel(tex, x, y + 1, c) * (1.0f - tx) + cpunvg__texel(tex, x + 1, y + 1, c) * tx;
+            out[c]   = t0 * (1.0f - ty) + t1 * ty;
+        }
+    }
+    if (nc == 1)
+        out[1] = out[2] = out[3] = 0.0f;
+}
+
+static void cpunvg__applyTexType(int texType, float* color)
+{
+    if (texType == 1)
+    {
+        color[0] *= color[3];
+        color[1] *= color[3];
+        color[2] *= color[3];
+    }
+    else if (texType == 2)
+    {
+        color[1] = color[2] = color[3] = color[0];
+    }
+}
+
+// Port of the GL backend fragment shader. Writes premultiplied colour, returns 0 when the fragment is discarded.
+// (x, y) is the fragment position in logical units and (u, v) the interpolated texture coordinate.
+static int cpunvg__shade(
+    const CPUNVGdraw* draw,
+    int               edgeAA,
+    float             x,
+    float             y,
+    float             u,
+    float             v,
+    float*            color)
+{
+    const CPUNVGfragUniforms* frag        = draw->frag;
+    float                     scissor     = cpunvg__scissorMask(frag, x, y);
+    float                     strokeAlpha = 1.0f;
+    int                       i;
+
+    if (edgeAA)
+    {
+        strokeAlpha = fminf(1.0f, (1.0f - fabsf(u * 2.0f - 1.0f)) * frag->strokeMult) * fminf(1.0f, v);
+        if (strokeAlpha < frag->strokeThr)
+            return 0;
+    }
+
+    if (frag->type == CPUNVG_SHADER_FILLGRAD)
+    {
+        const float* m  = frag->paintMat;
+        float        px = m[0] * x + m[2] * y + m[4];
+        float        py = m[1] * x + m[3] * y + m[5];
+        float        d  = cpunvg__clampf(
+            (cpunvg__sdroundrect(px, py, frag->extent[0], frag->extent[1], frag->radius) + frag->feather * 0.5f) /
+                frag->feather,
+            0.0f,
+            1.0f);
+        for (i = 0; i < 4; i++)
+            color[i] = (frag->innerCol.rgba[i] * (1.0f - d) + frag->outerCol.rgba[i] * d) * strokeAlpha * scissor;
+    }
+    else if (frag->type == CPUNVG_SHADER_FILLBLUR)
+    {
+        const float* m        = frag->paintMat;
+        float        px       = m[0] * x + m[2] * y + m[4];
+        float        py       = m[1] * x + m[3] * y + m[5];
+        float        coverage = 1.0f;
+        if (frag->extent[0] > 0.0f && frag->extent[1] > 0.0f)
+        {
+            coverage = cpunvg__blurRoundRect(px, py, frag->extent[0], frag->extent[1], frag->radius, frag->feather);
+        }
+        else if (edgeAA)
+        {
+            // Blurred edge, see nvgFillBlur(). The fringe spans -3 to 3 sigma, its linear coverage is mapped through
+            // the normal CDF, scaled to reach 0 & 1 at the ends.
+            strokeAlpha = 0.5f + 0.5f * cpunvg__erf((strokeAlpha - 0.5f) * 4.2426407f) / cpunvg__erf(2.1213203f);
+            strokeAlpha = cpunvg__clampf(strokeAlpha, 0.0f, 1.0f);
+        }
+        for (i = 0; i < 4; i++)
+            color[i] = (frag->innerCol.rgba[i] * coverage + frag->outerCol.rgba[i] * (1.0f - coverage)) * strokeAlpha *
+                       scissor;
+    }
+    else if (frag->type == CPUNVG_SHADER_FILLIMG)
+    {
+        const float* m  = frag->paintMat;
+        float        px = (m[0] * x + m[2] * y + m[4]) / frag->extent[0];
+        float        py = (m[1] * x + m[3] * y + m[5]) / frag->extent[1];
+        if (draw->tex == NULL)
+            return 0;
+        cpunvg__sample(draw->tex, px, py, color);
+        cpunvg__applyTexType(frag->texType, color);
+        for (i = 0; i < 4; i++)
+            color[i] *= frag->innerCol.rgba[i] * strokeAlpha * scissor;
+    }
+    else if (frag->type == CPUNVG_SHADER_SIMPLE)
+    {
+        color[0] = color[1] = color[2] = color[3] = 1.0f;
+    }
+    else
+    {
+        if (draw->tex == NULL)
+            return 0;
+        cpunvg__sample(draw->tex, u, v, color);
+        cpunvg__applyTexType(frag->texType, color);
+        for (i = 0; i < 4; i++)
+            color[i] *= scissor * frag->innerCol.rgba[i];
+    }
+    return 1;
+}
+
+static float cpunvg__blendFactor(int factor, const float* src, const float* dst, int c)
+{
+    switch (factor)
+    {
+    case NVG_ZERO:
+        return 0.0f;
+    case NVG_ONE:
+        return 1.0f;
+    case NVG_SRC_COLOR:
+        return src[c];
+    case NVG_ONE_MINUS_SRC_COLOR:
+        return 1.0f - src[c];
+    case NVG_DST_COLOR:
+        return dst[c];
+    case NVG_ONE_MINUS_DST_COLOR:
+        return 1.0f - dst[c];
+    case NVG_SRC_ALPHA:
+        return src[3];
+    case NVG_ONE_MINUS_SRC_ALPHA:
+        return 1.0f - src[3];
+    case NVG_DST_ALPHA:
+        return dst[3];
+    case NVG_ONE_MINUS_DST_ALPHA:
+        return 1.0f - dst[3];
+    case NVG_SRC_ALPHA_SATURATE:
+        return c < 3 ? fminf(src[3], 1.0f - dst[3]) : 1.0f;
+    }
+    return 0.0f;
+}
+
+static void cpunvg__blend(const NVGcompositeOperationState* blend, const float* src, unsigned char* pixel)
+{
+    float dst[4], out[4];
+    int   c;
+
+    if (blend->srcRGB == NVG_ONE && blend->dstRGB == NVG_ONE_MINUS_SRC_ALPHA && blend->srcAlpha == NVG_ONE &&
+        blend->dstAlpha == NVG_ONE_MINUS_SRC_ALPHA)
+    {
+        // Source over, which is nearly every draw
+        float ia = 1.0f - src[3];
+        for (c = 0; c < 4; c++)
+            out[c] = src[c] + pixel[c] * (1.0f / 255.0f) * ia;
+    }
+    else
+    {
+        for (c = 0; c < 4; c++)
+            dst[c] = pixel[c] * (1.0f / 255.0f);
+        for (c = 0; c < 4; c++)
+        {
+            int sf = c < 3 ? blend->srcRGB : blend->srcAlpha;
+            int df = c < 3 ? blend->dstRGB : blend->dstAlpha;
+            out[c] = src[c] * cpunvg__blendFactor(sf, src, dst, c) + dst[c] * cpunvg__blendFactor(df, src, dst, c);
+        }
+    }
+    for (c = 0; c < 4; c++)
+        pixel[c] = (unsigned char)(cpunvg__clampf(out[c], 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+static void cpunvg__rasterTriangle(
+    const CPUNVGtile* tile,
+    const CPUNVGdraw* draw,
+    const NVGvertex*  v0,
+    const NVGvertex*  v1,
+    const NVGvertex*  v2)
+{
+    const CPUNVGtarget* target = tile->target;
+    int                 edgeAA = (tile->cpu->flags & NVG_ANTIALIAS) != 0;
+    float               x0 = v0->x * tile->sx, y0 = v0->y * tile->sy;
+    float               x1 = v1->x * tile->sx, y1 = v1->y * tile->sy;
+    float               x2 = v2->x * tile->sx, y2 = v2->y * tile->sy;
+    float               area = (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0);
+    float               orient, invArea;
+    int                 minx, miny, maxx, maxy, px, py, i;
+    CPUNVGedge          e[3];
+
+    if (area == 0.0f || area != area)
+        return;
+    orient  = area > 0.0f ? 1.0f : -1.0f;
+    invArea = 1.0f / fabsf(area);
+
+    minx = (int)floorf(fminf(x0, fminf(x1, x2)));
+    miny = (int)floorf(fminf(y0, fminf(y1, y2)));
+    maxx = (int)ceilf(fmaxf(x0, fmaxf(x1, x2)));
+    maxy = (int)ceilf(fmaxf(y0, fmaxf(y1, y2)));
+    minx = cpunvg__maxi(minx, tile->x0);
+    miny = cpunvg__maxi(miny, tile->y0);
+    maxx = cpunvg__mini(maxx, tile->x1);
+    maxy = cpunvg__mini(maxy, tile->y1);
+    if (minx >= maxx || miny >= maxy)
+        return;
+
+    // e[0] is opposite v0, and so on, making the edge values the barycentric weights
+    cpunvg__setupEdge(&e[0], x1, y1, x2, y2, orient);
+    cpunvg__setupEdge(&e[1], x2, y2, x0, y0, orient);
+    cpunvg__setupEdge(&e[2], x0, y0, x1, y1, orient);
+
+    for (py = miny; py < maxy; py++)
+    {
+        unsigned char* row      = target->pixels + (size_t)py * target->stride;
+        unsigned char* stencil  = tile->stencil + (py - tile->y0) * NVG_CPU_TILE_SIZE - tile->x0;
+        float          fpy      = (float)py;
+        float          cy       = fpy + 0.5f;
+        float          logicalY = cy / tile->sy;
+
+        for (px = minx; px < maxx; px += 4)
+        {
+            int mask = cpunvg__edgeMask4(&e[0], (float)px, fpy) & cpunvg__edgeMask4(&e[1], (float)px, fpy) &
+                       cpunvg__edgeMask4(&e[2], (float)px, fpy);
+            if (px + 4 > maxx)
+                mask &= (1 << (maxx - px)) - 1;
+
+            for (i = 0; mask != 0; i++, mask >>= 1)
+            {
+                int            x = px + i;
+                unsigned char* s;
+                float          cx, w0, w1, w2, color[4];
+
+                if ((mask & 1) == 0)
+                    continue;
+
+                s = &stencil[x];
+                switch (draw->stencilOp)
+                {
+                case CPUNVG_STENCIL_WINDING:
+                    *s = (unsigned char)(*s + (orient > 0.0f ? 1 : -1));
+                    continue;
+                case CPUNVG_STENCIL_CLEAR:
+                    *s = 0;
+                    continue;
+                case CPUNVG_STENCIL_EQUAL_ZERO:
+                case CPUNVG_STENCIL_EQUAL_ZERO_INCR:
+                    if (*s != 0)
+                        continue;
+                    break;
+                case CPUNVG_STENCIL_NOTEQUAL_ZERO:
+                    if (*s == 0)
+                        continue;
+                    break;
+                }
+
+                cx = x + 0.5f;
+                w0 = cpunvg__evalEdge(&e[0], cx, cy) * invArea;
+                w1 = cpunvg__evalEdge(&e[1], cx, cy) * invArea;
+                w2 = cpunvg__evalEdge(&e[2], cx, cy) * invArea;
+                if (! cpunvg__shade(
+                        draw,
+                        edgeAA,
+                        cx / tile->sx,
+                        logicalY,
+                        v0->u * w0 + v1->u * w1 + v2->u * w2,
+                        v0->v * w0 + v1->v * w1 + v2->v * w2,
+                        color))
+                    continue;
+
+                if (draw->stencilOp == CPUNVG_STENCIL_EQUAL_ZERO_INCR)
+                    *s = 1;
+                else if (draw->stencilOp == CPUNVG_STENCIL_NOTEQUAL_ZERO)
+                    *s = 0;
+
+                cpunvg__blend(&draw->blend, color, row + x * 4);
+            }
+        }
+    }
+}
+
+// Returns vertex `i` of the call, unpacked into `tmp` when the call is packed
+static const NVGvertex* cpunvg__vertex(const CPUNVGdraw* draw, int i, NVGvertex* tmp)
+{
+    const NVGpackedVertex* p;
+    if (draw->packed == NULL)
+        return &draw->verts[i];
+    p      = &draw->packed[i];
+    tmp->x = draw->origin[0] + p->x * draw->invScale;
+    tmp->y = draw->origin[1] + p->y * draw->invScale;
+    tmp->u = p->u * (1.0f / 65535.0f);
+    tmp->v = p->v * (1.0f / 65535.0f);
+    return tmp;
+}
+
+static void cpunvg__rasterFan(const CPUNVGtile* tile, const CPUNVGdraw* draw, int offset, int n)
+{
+    NVGvertex tmp[3];
+    int       i;
+    for (i = 1; i < n - 1; i++)
+        cpunvg__rasterTriangle(
+            tile,
+            draw,
+            cpunvg__vertex(draw, offset, &tmp[0]),
+            cpunvg__vertex(draw, offset + i, &tmp[1]),
+            cpunvg__vertex(draw, offset + i + 1, &tmp[2]));
+}
+
+static void cpunvg__rasterStrip(const CPUNVGtile* tile, const CPUNVGdraw* draw, int offset, int n)
+{
+    NVGvertex tmp[3];
+    int       i;
+    for (i = 0; i < n - 2; i++)
+        cpunvg__rasterTriangle(
+            tile,
+            draw,
+            cpunvg__vertex(draw, offset + i, &tmp[0]),
+            cpunvg__vertex(draw, offset + i + 1, &tmp[1]),
+            cpunvg__vertex(draw, offset + i + 2, &tmp[2]));
+}
+
+static void cpunvg__rasterList(const CPUNVGtile* tile, const CPUNVGdraw* draw, int offset, int n)
+{
+    NVGvertex tmp[3];
+    int       i;
+    for (i = 0; i + 2 < n; i += 3)
+        cpunvg__rasterTriangle(
+            tile,
+            draw,
+            cpunvg__vertex(draw, offset + i, &tmp[0]),
+            cpunvg__vertex(draw, offset + i + 1, &tmp[1]),
+            cpunvg__vertex(draw, offset + i + 2, &tmp[2]));
+}
+
+static void cpunvg__renderTile(CPUNVGcontext* cpu, int tileIndex, unsigned char* stencil)
+{
+    CPUNVGtile tile;
+    CPUNVGdraw draw;
+    int        i, j;
+
+    tile.cpu     = cpu;
+    tile.target  = &cpu->job;
+    tile.stencil = stencil;
+    tile.x0      = (tileIndex % cpu->tilesX) * NVG_CPU_TILE_SIZE;
+    tile.y0      = (tileIndex / cpu->tilesX) * NVG_CPU_TILE_SIZE;
+    tile.x1      = cpunvg__mini(tile.x0 + NVG_CPU_TILE_SIZE, cpu->job.width);
+    tile.y1      = cpunvg__mini(tile.y0 + NVG_CPU_TILE_SIZE, cpu->job.height);
+    tile.sx      = cpu->job.width / cpu->view[0];
+    tile.sy      = cpu->job.height / cpu->view[1];
+
+    memset(stencil, 0, NVG_CPU_TILE_SIZE * NVG_CPU_TILE_SIZE);
+
+    for (i = 0; i < cpu->ncalls; i++)
+    {
+        const CPUNVGcall* call  = &cpu->calls[i];
+        const CPUNVGpath* paths = &cpu->paths[call->pathOffset];
+
+        if (call->pixelBounds[2] <= tile.x0 || call->pixelBounds[0] >= tile.x1 || call->pixelBounds[3] <= tile.y0 ||
+            call->pixelBounds[1] >= tile.y1)
+            continue;
+
+        draw.tex       = call->image != 0 ? cpunvg__findTexture(cpu, call->image) : NULL;
+        draw.blend     = call->blendFunc;
+        draw.frag      = &cpu->uniforms[call->uniformOffset];
+        draw.verts     = cpu->verts;
+        draw.packed    = call->packed ? cpu->packedVerts : NULL;
+        draw.origin[0] = call->origin[0];
+        draw.origin[1] = call->origin[1];
+        draw.invScale  = call->packed ? 1.0f / call->scale : 0.0f;
+
+        switch (call->type)
+        {
+        case CPUNVG_FILL:
+            // Accumulate winding in the stencil
+            draw.stencilOp = CPUNVG_STENCIL_WINDING;
+            for (j = 0; j < call->pathCount; j++)
+                cpunvg__rasterFan(&tile, &draw, paths[j].fillOffset, paths[j].fillCount);
+
+            draw.frag = &cpu->uniforms[call->uniformOffset + 1];
+            if (cpu->flags & NVG_ANTIALIAS)
+            {
+                // Draw fringes outside of the filled area
+                draw.stencilOp = CPUNVG_STENCIL_EQUAL_ZERO;
+                for (j = 0; j < call->pathCount; j++)
+                    cpunvg__rasterStrip(&tile, &draw, paths[j].strokeOffset, paths[j].strokeCount);
+            }
+            // Cover the bounds where the winding is non-zero and reset the stencil
+            draw.stencilOp = CPUNVG_STENCIL_NOTEQUAL_ZERO;
+            cpunvg__rasterStrip(&tile, &draw, call->triangleOffset, call->triangleCount);
+            break;
+        case CPUNVG_CONVEXFILL:
+            draw.stencilOp = CPUNVG_STENCIL_OFF;
+            for (j = 0; j < call->pathCount; j++)
+            {
+                cpunvg__rasterFan(&tile, &draw, paths[j].fillOffset, paths[j].fillCount);
+                if (paths[j].strokeCount > 0)
+                    cpunvg__rasterStrip(&tile, &draw, paths[j].strokeOffset, paths[j].strokeCount);
+            }
+            break;
+        case CPUNVG_STROKE:
+            if (cpu->flags & NVG_STENCIL_STROKES)
+            {
+                // Fill the stroke base without overlap
+                draw.frag      = &cpu->uniforms[call->uniformOffset + 1];
+                draw.stencilOp = CPUNVG_STENCIL_EQUAL_ZERO_INCR;
+                for (j = 0; j < call->pathCount; j++)
+                    cpunvg__rasterStrip(&tile, &draw, paths[j].strokeOffset, paths[j].strokeCount);
+                // Draw anti-aliased pixels
+                draw.frag      = &cpu->uniforms[call->uniformOffset];
+                draw.stencilOp = CPUNVG_STENCIL_EQUAL_ZERO;
+                for (j = 0; j < call->pathCount; j++)
+                    cpunvg__rasterStrip(&tile, &draw, paths[j].strokeOffset, paths[j].strokeCount);
+                // Clear stencil buffer
+                draw.stencilOp = CPUNVG_STENCIL_CLEAR;
+                for (j = 0; j < call->pathCount; j++)
+                    cpunvg__rasterStrip(&tile, &draw, paths[j].strokeOffset, paths[j].strokeCount);
+            }
+            else
+            {
+                draw.stencilOp = CPUNVG_STENCIL_OFF;
+                for (j = 0; j < call->pathCount; j++)
+                    cpunvg__rasterStrip(&tile, &draw, paths[j].strokeOffset, paths[j].strokeCount);
+            }
+            break;
+        case CPUNVG_TRIANGLES:
+            draw.stencilOp = CPUNVG_STENCIL_OFF;
+            cpunvg__rasterList(&tile, &draw, call->triangleOffset, call->triangleCount);
+            break;
+        }
+    }
+}
+
+//
+// Worker pool
+//
+
+static void cpunvg__runTiles(CPUNVGcontext* cpu, int index)
+{
+    unsigned char* stencil = cpu->stencil + (size_t)index * NVG_CPU_TILE_SIZE * NVG_CPU_TILE_SIZE;
+
+    for (;;)
+    {
+        int tile = -1;
+
+        pthread_mutex_lock(&cpu->lock);
+        if (cpu->nextTile < cpu->ntiles)
+            tile = cpu->nextTile++;
+        pthread_mutex_unlock(&cpu->lock);
+
+        if (tile < 0)
+            break;
+
+        cpunvg__renderTile(cpu, tile, stencil);
+
+        pthread_mutex_lock(&cpu->lock);
+        if (++cpu->tilesDone == cpu->ntiles)
+            pthread_cond_broadcast(&cpu->done);
+        pthread_mutex_unlock(&cpu->lock);
+    }
+}
+
+static void* cpunvg__workerMain(void* arg)
+{
+    CPUNVGworker*  worker     = (CPUNVGworker*)arg;
+    CPUNVGcontext* cpu        = worker->cpu;
+    int            generation = 0;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&cpu->lock);
+        while (! cpu->quit && cpu->generation == generation)
+            pthread_cond_wait(&cpu->wake, &cpu->lock);
+        generation = cpu->generation;
+        if (cpu->quit)
+        {
+            pthread_mutex_unlock(&cpu->lock);
+            break;
+        }
+        pthread_mutex_unlock(&cpu->lock);
+
+        cpunvg__runTiles(cpu, worker->index);
+    }
+    return NULL;
+}
+
+static void cpunvg__stopThreads(CPUNVGcontext* cpu)
+{
+    int i;
+
+    pthread_mutex_lock(&cpu->lock);
+    cpu->quit = 1;
+    pthread_cond_broadcast(&cpu->wake);
+    pthread_mutex_unlock(&cpu->lock);
+
+    // Thread 0 is the caller of renderFlush
+    for (i = 1; i < cpu->nthreads; i++)
+        pthread_join(cpu->threads[i], NULL);
+
+    cpu->quit     = 0;
+    cpu->nthreads = 1;
+}
+
+static int cpunvg__startThreads(CPUNVGcontext* cpu, int nthreads)
+{
+    unsigned char* stencil;
+    int            i;
+
+    if (nthreads <= 0)
+        nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    nthreads = cpunvg__maxi(1, cpunvg__mini(nthreads, NVG_CPU_MAX_THREADS));
+
+    stencil = (unsigned char*)realloc(cpu->stencil, (size_t)nthreads * NVG_CPU_TILE_SIZE * NVG_CPU_TILE_SIZE);
+    if (stencil == NULL)
+        return 0;
+    cpu->stencil = stencil;
+
+    cpu->nthreads = 1;
+    for (i = 1; i < nthreads; i++)
+    {
+        cpu->workers[i].cpu   = cpu;
+        cpu->workers[i].index = i;
+        if (pthread_create(&cpu->threads[i], NULL, cpunvg__workerMain, &cpu->workers[i]) != 0)
+            break;
+        cpu->nthreads++;
+    }
+    return 1;
+}
+
+static int cpunvg__target(CPUNVGcontext* cpu, int image, CPUNVGtarget* target)
+{
+    if (image == 0)
+    {
+        target->pixels = cpu->mainPixels;
+        target->width  = cpu->mainWidth;
+        target->height = cpu->mainHeight;
+        target->stride = cpu->mainWidth * 4;
+    }
+    else
+    {
+        CPUNVGtexture* tex = cpunvg__findTexture(cpu, image);
+        if (tex == NULL || tex->type != NVG_TEXTURE_RGBA)
+            return 0;
+        target->pixels = tex->data;
+        target->width  = tex->width;
+        target->height = tex->height;
+        target->stride = tex->stride;
+    }
+    return target->pixels != NULL;
+}
+
+//
+// NVGparams
+//
+
+static void cpunvg__vset(NVGvertex* vtx, float x, float y, float u, float v)
+{
+    vtx->x = x;
+    vtx->y = y;
+    vtx->u = u;
+    vtx->v = v;
+}
+
+static void cpunvg__callBounds(CPUNVGcontext* cpu, CPUNVGcall* call, int offset)
+{
+    int i;
+
+    call->bounds[0] = call->bounds[1] = 1e6f;
+    call->bounds[2] = call->bounds[3] = -1e6f;
+    for (i = offset; i < cpu->nverts; i++)
+    {
+        const NVGvertex* v = &cpu->verts[i];
+        call->bounds[0]    = fminf(call->bounds[0], v->x);
+        call->bounds[1]    = fminf(call->bounds[1], v->y);
+        call->bounds[2]    = fmaxf(call->bounds[2], v->x);
+        call->bounds[3]    = fmaxf(call->bounds[3], v->y);
+    }
+}
+
+// Sets up the uniforms of a fill: the stencil pass' & the fill shader, or the fill shader of a convex fill
+static int cpunvg__fillUniforms(
+    CPUNVGcontext* cpu,
+    CPUNVGcall*    call,
+    NVGpaint*      paint,
+    NVGscissor*    scissor,
+    float          fringe)
+{
+    CPUNVGfragUniforms* frag;
+
+    if (call->type == CPUNVG_FILL)
+    {
+        call->uniformOffset = cpunvg__allocFragUniforms(cpu, 2);
+        if (call->uniformOffset == -1)
+            return 0;
+        // Simple shader for stencil
+        frag = &cpu->uniforms[call->uniformOffset];
+        memset(frag, 0, sizeof(*frag));
+        frag->strokeThr = -1.0f;
+        frag->type      = CPUNVG_SHADER_SIMPLE;
+        // Fill shader
+        cpunvg__convertPaint(cpu, &cpu->uniforms[call->uniformOffset + 1], paint, scissor, fringe, fringe, -1.0f);
+    }
+    else
+    {
+        call->uniformOffset = cpunvg__allocFragUniforms(cpu, 1);
+        if (call->uniformOffset == -1)
+            return 0;
+        // Fill shader
+        cpunvg__convertPaint(cpu, &cpu->uniforms[call->uniformOffset], paint, scissor, fringe, fringe, -1.0f);
+    }
+    return 1;
+}
+
+static int cpunvg__strokeUniforms(
+    CPUNVGcontext* cpu,
+    CPUNVGcall*    call,
+    NVGpaint*      paint,
+    NVGscissor*    scissor,
+    float          fringe,
+    float          strokeWidth)
+{
+    if (cpu->flags & NVG_STENCIL_STROKES)
+    {
+        // Fill shader
+        call->uniformOffset = cpunvg__allocFragUniforms(cpu, 2);
+        if (call->uniformOffset == -1)
+            return 0;
+        cpunvg__convertPaint(cpu, &cpu->uniforms[call->uniformOffset], paint, scissor, strokeWidth, fringe, -1.0f);
+        cpunvg__convertPaint(
+            cpu,
+            &cpu->uniforms[call->uniformOffset + 1],
+            paint,
+            scissor,
+            strokeWidth,
+            fringe,
+            1.0f - 0.5f / 255.0f);
+    }
+    else
+    {
+        // Fill shader
+        call->uniformOffset = cpunvg__allocFragUniforms(cpu, 1);
+        if (call->uniformOffset == -1)
+            return 0;
+        cpunvg__convertPaint(cpu, &cpu->uniforms[call->uniformOffset], paint, scissor, strokeWidth, fringe, -1.0f);
+    }
+    return 1;
+}
+
+static int cpunvg__trianglesUniforms(
+    CPUNVGcontext* cpu,
+    CPUNVGcall*    call,
+    NVGpaint*      paint,
+    NVGscissor*    scissor,
+    float          fringe)
+{
+    CPUNVGfragUniforms* frag;
+
+    // Fill shader
+    call->uniformOffset = cpunvg__allocFragUniforms(cpu, 1);
+    if (call->uniformOffset == -1)
+        return 0;
+    frag = &cpu->uniforms[call->uniformOffset];
+    cpunvg__convertPaint(cpu, frag, paint, scissor, 1.0f, fringe, -1.0f);
+    frag->type = CPUNVG_SHADER_IMG;
+    return 1;
+}
+
+static int cpunvg__renderCreate(void* uptr)
+{
+    NVG_NOTUSED(uptr);
+    return 1;
+}
+
+static int cpunvg__renderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
+{
+    CPUNVGcontext* cpu = (CPUNVGcontext*)uptr;
+    CPUNVGtexture* tex = cpunvg__allocTexture(cpu);
+    int            bpp = type == NVG_TEXTURE_RGBA ? 4 : 1;
+
+    if (tex == NULL)
+        return 0;
+
+    tex->type   = type;
+    tex->width  = w;
+    tex->height = h;
+    tex->stride = w * bpp;
+    tex->flags  = imageFlags;
+    tex->data   = (unsigned char*)calloc((size_t)tex->stride * h, 1);
+    if (tex->data == NULL)
+    {
+        cpunvg__deleteTexture(cpu, tex->id);
+        return 0;
+    }
+    if (data != NULL)
+        memcpy(tex->data, data, (size_t)tex->stride * h);
+
+    return tex->id;
+}
+
+static int cpunvg__renderDeleteTexture(void* uptr, int image)
+{
+    CPUNVGcontext* cpu = (CPUNVGcontext*)uptr;
+    if (cpu->image == image)
+        cpu->image = 0;
+    return cpunvg__deleteTexture(cpu, image);
+}
+
+// Like the GL backend, `data` points to the whole image and only the given rect is copied
+static int cpunvg__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+    CPUNVGcontext* cpu = (CPUNVGcontext*)uptr;
+    CPUNVGtexture* tex = cpunvg__findTexture(cpu, image);
+    int            bpp, row;
+
+    if (tex == NULL)
+        return 0;
+
+    bpp = tex->type == NVG_TEXTURE_RGBA ? 4 : 1;
+    for (row = y; row < y + h; row++)
+        memcpy(tex->data + (size_t)row * tex->stride + x * bpp, data + (size_t)row * tex->width * bpp + x * bpp, w * bpp);
+
+    return 1;
+}
+
+static int cpunvg__renderGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+    CPUNVGcontext* cpu = (CPUNVGcontext*)uptr;
+    CPUNVGtexture* tex = cpunvg__findTexture(cpu, image);
+    if (tex == NULL)
+        return 0;
+    *w = tex->width;
+    *h = tex->height;
+    return 1;
+}
+
+static void cpunvg__renderViewport(void* uptr, float width, float height, float devicePixelRatio)
+{
+    CPUNVGcontext* cpu = (CPUNVGcontext*)uptr;
+    NVG_NOTUSED(devicePixelRatio);
+    cpu->view[0] = width;
+    cpu->view[1] = height;
+}
+
+static void cpunvg__renderCancel(void* uptr)
+{
+    CPUNVGcontext* cpu = (CPUNVGcontext*)uptr;
+    cpu->nverts        = 0;
+    cpu->npackedVerts  = 0;
+    cpu->npaths        = 0;
+    cpu->ncalls        = 0;
+    cpu->nuniforms     = 0;
+}
+
+static void cpunvg__renderFlush(void* uptr)
+{
+    CPUNVGcontext* cpu = (CPUNVGcontext*)uptr;
+    int            i;
+
+    if (cpu->ncalls > 0 && cpu->view[0] > 0.0f && cpu->view[1] > 0.0f && cpunvg__target(cpu, cpu->image, &cpu->job))
+    {
+        float sx = cpu->job.width / cpu->view[0];
+        float sy = cpu->job.height / cpu->view[1];
+
+        for (i = 0; i < cpu->ncalls; i++)
+        {
+            CPUNVGcall* call     = &cpu->calls[i];
+            call->pixelBounds[0] = (int)floorf(cpunvg__clampf(call->bounds[0] * sx, -1.0f, (float)cpu->job.width));
+            call->pixelBounds[1] = (int)floorf(cpunvg__clampf(call->bounds[1] * sy, -1.0f, (float)cpu->job.height));
+            call->pixelBounds[2] = (int)ceilf(cpunvg__clampf(call->bounds[2] * sx, -1.0f, (float)cpu->job.width)) + 1;
+            call->pixelBounds[3] = (int)ceilf(cpunvg__clampf(call->bounds[3] * sy, -1.0f, (float)cpu->job.height)) + 1;
+        }
+
+        pthread_mutex_lock(&cpu->lock);
+        cpu->tilesX    = (cpu->job.width + NVG_CPU_TILE_SIZE - 1) / NVG_CPU_TILE_SIZE;
+        cpu->ntiles    = cpu->tilesX * ((cpu->job.height + NVG_CPU_TILE_SIZE - 1) / NVG_CPU_TILE_SIZE);
+        cpu->nextTile  = 0;
+        cpu->tilesDone = 0;
+        cpu->generation++;
+        pthread_cond_broadcast(&cpu->wake);
+        pthread_mutex_unlock(&cpu->lock);
+
+        cpunvg__runTiles(cpu, 0);
+
+        pthread_mutex_lock(&cpu->lock);
+        while (cpu->tilesDone < cpu->ntiles)
+            pthread_cond_wait(&cpu->done, &cpu->lock);
+        pthread_mutex_unlock(&cpu->lock);
+    }
+
+    if (cpu->image != 0)
+    {
+        CPUNVGtexture* tex = cpunvg__findTexture(cpu, cpu->image);
+        if (tex != NULL && tex->shared != NULL)
+            cpunvg__publishShared(tex);
+    }
+
+    cpunvg__renderCancel(uptr);
+}
+
+static void cpunvg__renderFill(
+    void*                      uptr,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    const float*               bounds,
+    const NVGpath*             paths,
+    int                        npaths)
+{
+    CPUNVGcontext* cpu  = (CPUNVGcontext*)uptr;
+    CPUNVGcall*    call = cpunvg__allocCall(cpu);
+    NVGvertex*     quad;
+    int            i, maxverts, offset, first;
+
+    if (call == NULL)
+        return;
+
+    call->type          = CPUNVG_FILL;
+    call->triangleCount = 4;
+    call->pathOffset    = cpunvg__allocPaths(cpu, npaths);
+    if (call->pathOffset == -1)
+        goto error;
+    call->pathCount = npaths;
+    call->image     = paint->image;
+    call->blendFunc = compositeOperation;
+
+    if (npaths == 1 && paths[0].convex)
+    {
+        call->type          = CPUNVG_CONVEXFILL;
+        call->triangleCount = 0; // Bounding box fill quad not needed for convex fill
+    }
+
+    // Allocate vertices for all the paths.
+    maxverts = cpunvg__maxVertCount(paths, npaths) + call->triangleCount;
+    offset   = cpunvg__allocVerts(cpu, maxverts);
+    if (offset == -1)
+        goto error;
+    first = offset;
+
+    for (i = 0; i < npaths; i++)
+    {
+        CPUNVGpath*    copy = &cpu->paths[call->pathOffset + i];
+        const NVGpath* path = &paths[i];
+        memset(copy, 0, sizeof(CPUNVGpath));
+        if (path->nfill > 0)
+        {
+            copy->fillOffset = offset;
+            copy->fillCount  = path->nfill;
+            memcpy(&cpu->verts[offset], path->fill, sizeof(NVGvertex) * path->nfill);
+            offset += path->nfill;
+        }
+        if (path->nstroke > 0)
+        {
+            copy->strokeOffset = offset;
+            copy->strokeCount  = path->nstroke;
+            memcpy(&cpu->verts[offset], path->stroke, sizeof(NVGvertex) * path->nstroke);
+            offset += path->nstroke;
+        }
+    }
+
+    if (call->type == CPUNVG_FILL)
+    {
+        // Quad
+        call->triangleOffset = offset;
+        quad                 = &cpu->verts[call->triangleOffset];
+        cpunvg__vset(&quad[0], bounds[2], bounds[3], 0.5f, 1.0f);
+        cpunvg__vset(&quad[1], bounds[2], bounds[1], 0.5f, 1.0f);
+        cpunvg__vset(&quad[2], bounds[0], bounds[3], 0.5f, 1.0f);
+        cpunvg__vset(&quad[3], bounds[0], bounds[1], 0.5f, 1.0f);
+    }
+    if (! cpunvg__fillUniforms(cpu, call, paint, scissor, fringe))
+        goto error;
+
+    cpunvg__callBounds(cpu, call, first);
+    return;
+
+error:
+    // We get here if call alloc was ok, but something else is not.
+    // Roll back the last call to prevent drawing it.
+    if (cpu->ncalls > 0)
+        cpu->ncalls--;
+}
+
+static void cpunvg__renderStroke(
+    void*                      uptr,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    float                      strokeWidth,
+    const NVGpath*             paths,
+    int                        npaths)
+{
+    CPUNVGcontext* cpu  = (CPUNVGcontext*)uptr;
+    CPUNVGcall*    call = cpunvg__allocCall(cpu);
+    int            i, maxverts, offset, first;
+
+    if (call == NULL)
+        return;
+
+    call->type       = CPUNVG_STROKE;
+    call->pathOffset = cpunvg__allocPaths(cpu, npaths);
+    if (call->pathOffset == -1)
+        goto error;
+    call->pathCount = npaths;
+    call->image     = paint->image;
+    call->blendFunc = compositeOperation;
+
+    // Allocate vertices for all the paths.
+    maxverts = cpunvg__maxVertCount(paths, npaths);
+    offset   = cpunvg__allocVerts(cpu, maxverts);
+    if (offset == -1)
+        goto error;
+    first = offset;
+
+    for (i = 0; i < npaths; i++)
+    {
+        CPUNVGpath*    copy = &cpu->paths[call->pathOffset + i];
+        const NVGpath* path = &paths[i];
+        memset(copy, 0, sizeof(CPUNVGpath));
+        if (path->nstroke)
+        {
+            copy->strokeOffset = offset;
+            copy->strokeCount  = path->nstroke;
+            memcpy(&cpu->verts[offset], path->stroke, sizeof(NVGvertex) * path->nstroke);
+            offset += path->nstroke;
+        }
+    }
+    // Only the stroke vertices were used
+    cpu->nverts = offset;
+
+    if (! cpunvg__strokeUniforms(cpu, call, paint, scissor, fringe, strokeWidth))
+        goto error;
+
+    cpunvg__callBounds(cpu, call, first);
+    return;
+
+error:
+    // We get here if call alloc was ok, but something else is not.
+    // Roll back the last call to prevent drawing it.
+    if (cpu->ncalls > 0)
+        cpu->ncalls--;
+}
+
+static void cpunvg__renderTriangles(
+    void*                      uptr,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    const NVGvertex*           verts,
+    int                        nverts,
+    float                      fringe)
+{
+    CPUNVGcontext* cpu  = (CPUNVGcontext*)uptr;
+    CPUNVGcall*    call = cpunvg__allocCall(cpu);
+
+    if (call == NULL)
+        return;
+
+    call->type      = CPUNVG_TRIANGLES;
+    call->image     = paint->image;
+    call->blendFunc = compositeOperation;
+
+    // Allocate vertices for all the paths.
+    call->triangleOffset = cpunvg__allocVerts(cpu, nverts);
+    if (call->triangleOffset == -1)
+        goto error;
+    call->triangleCount = nverts;
+
+    memcpy(&cpu->verts[call->triangleOffset], verts, sizeof(NVGvertex) * nverts);
+
+    if (! cpunvg__trianglesUniforms(cpu, call, paint, scissor, fringe))
+        goto error;
+
+    cpunvg__callBounds(cpu, call, call->triangleOffset);
+    return;
+
+error:
+    // We get here if call alloc was ok, but something else is not.
+    // Roll back the last call to prevent drawing it.
+    if (cpu->ncalls > 0)
+        cpu->ncalls--;
+}
+
+//
+// Packed draw calls, see cpunvgPackedParams(). The vertices are copied as they are & unpacked by the rasterizer.
+//
+
+static void cpunvg__packedVset(NVGpackedVertex* vtx, const NVGpackedCall* packed, float x, float y, float u, float v)
+{
+    vtx->x = (unsigned short)cpunvg__clampf((x - packed->origin[0]) * packed->scale + 0.5f, 0.0f, 65535.0f);
+    vtx->y = (unsigned short)cpunvg__clampf((y - packed->origin[1]) * packed->scale + 0.5f, 0.0f, 65535.0f);
+    vtx->u = (unsigned short)(u * 65535.0f + 0.5f);
+    vtx->v = (unsigned short)(v * 65535.0f + 0.5f);
+}
+
+// Copies the vertices & paths of a packed call to the call, & leaves `count` more vertices after them. Returns the
+// offset of the vertex following the copied ones, or -1.
+static int cpunvg__copyPacked(CPUNVGcontext* cpu, CPUNVGcall* call, const NVGpackedCall* packed, int count)
+{
+    int i, offset;
+
+    call->pathOffset = cpunvg__allocPaths(cpu, packed->npaths);
+    offset           = cpunvg__allocPackedVerts(cpu, packed->nverts + count);
+    if (call->pathOffset == -1 || offset == -1)
+        return -1;
+    call->pathCount = packed->npaths;
+    call->packed    = 1;
+    call->origin[0] = packed->origin[0];
+    call->origin[1] = packed->origin[1];
+    call->scale     = packed->scale;
+    memcpy(&cpu->packedVerts[offset], packed->verts, sizeof(NVGpackedVertex) * packed->nverts);
+
+    for (i = 0; i < packed->npaths; i++)
+    {
+        CPUNVGpath*          copy = &cpu->paths[call->pathOffset + i];
+        const NVGpackedPath* path = &packed->paths[i];
+        memset(copy, 0, sizeof(CPUNVGpath));
+        if (path->nfill > 0)
+        {
+            copy->fillOffset = offset + path->fill;
+            copy->fillCount  = path->nfill;
+        }
+        if (path->nstroke > 0)
+        {
+            copy->strokeOffset = offset + path->stroke;
+            copy->strokeCount  = path->nstroke;
+        }
+    }
+    return offset + packed->nverts;
+}
+
+static void cpunvg__packedCallBounds(CPUNVGcontext* cpu, CPUNVGcall* call, int offset)
+{
+    int i, bounds[4] = {65535, 65535, 0, 0};
+
+    if (offset == cpu->npackedVerts)
+    {
+        call->bounds[0] = call->bounds[1] = 1e6f;
+        call->bounds[2] = call->bounds[3] = -1e6f;
+        return;
+    }
+    for (i = offset; i < cpu->npackedVerts; i++)
+    {
+        const NVGpackedVertex* v = &cpu->packedVerts[i];
+        bounds[0]                = cpunvg__mini(bounds[0], v->x);
+        bounds[1]                = cpunvg__mini(bounds[1], v->y);
+        bounds[2]                = cpunvg__maxi(bounds[2], v->x);
+        bounds[3]                = cpunvg__maxi(bounds[3], v->y);
+    }
+    for (i = 0; i < 4; i++)
+        call->bounds[i] = call->origin[i & 1] + bounds[i] / call->scale;
+}
+
+static void cpunvg__renderFillPacked(
+    void*                      uptr,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    const float*               bounds,
+    const NVGpackedCall*       packed)
+{
+    CPUNVGcontext*   cpu  = (CPUNVGcontext*)uptr;
+    CPUNVGcall*      call = cpunvg__allocCall(cpu);
+    NVGpackedVertex* quad;
+    int              offset, first = cpu->npackedVerts;
+
+    if (call == NULL)
+        return;
+
+    call->type          = CPUNVG_FILL;
+    call->triangleCount = 4;
+    call->image         = paint->image;
+    call->blendFunc     = compositeOperation;
+    if (packed->npaths == 1 && packed->paths[0].convex)
+    {
+        call->type          = CPUNVG_CONVEXFILL;
+        call->triangleCount = 0; // Bounding box fill quad not needed for convex fill
+    }
+
+    offset = cpunvg__copyPacked(cpu, call, packed, call->triangleCount);
+    if (offset == -1)
+        goto error;
+    if (call->type == CPUNVG_FILL)
+    {
+        // Quad
+        call->triangleOffset = offset;
+        quad                 = &cpu->packedVerts[call->triangleOffset];
+        cpunvg__packedVset(&quad[0], packed, bounds[2], bounds[3], 0.5f, 1.0f);
+        cpunvg__packedVset(&quad[1], packed, bounds[2], bounds[1], 0.5f, 1.0f);
+        cpunvg__packedVset(&quad[2], packed, bounds[0], bounds[3], 0.5f, 1.0f);
+        cpunvg__packedVset(&quad[3], packed, bounds[0], bounds[1], 0.5f, 1.0f);
+    }
+    if (! cpunvg__fillUniforms(cpu, call, paint, scissor, fringe))
+        goto error;
+
+    cpunvg__packedCallBounds(cpu, call, first);
+    return;
+
+error:
+    if (cpu->ncalls > 0)
+        cpu->ncalls--;
+}
+
+static void cpunvg__renderStrokePacked(
+    void*                      uptr,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    float                      fringe,
+    float                      strokeWidth,
+    const NVGpackedCall*       packed)
+{
+    CPUNVGcontext* cpu   = (CPUNVGcontext*)uptr;
+    CPUNVGcall*    call  = cpunvg__allocCall(cpu);
+    int            first = cpu->npackedVerts;
+
+    if (call == NULL)
+        return;
+
+    call->type      = CPUNVG_STROKE;
+    call->image     = paint->image;
+    call->blendFunc = compositeOperation;
+    if (cpunvg__copyPacked(cpu, call, packed, 0) == -1)
+        goto error;
+    if (! cpunvg__strokeUniforms(cpu, call, paint, scissor, fringe, strokeWidth))
+        goto error;
+
+    cpunvg__packedCallBounds(cpu, call, first);
+    return;
+
+error:
+    if (cpu->ncalls > 0)
+        cpu->ncalls--;
+}
+
+static void cpunvg__renderTrianglesPacked(
+    void*                      uptr,
+    NVGpaint*                  paint,
+    NVGcompositeOperationState compositeOperation,
+    NVGscissor*                scissor,
+    const NVGpackedCall*       packed,
+    float                      fringe)
+{
+    CPUNVGcontext* cpu  = (CPUNVGcontext*)uptr;
+    CPUNVGcall*    call = cpunvg__allocCall(cpu);
+
+    if (call == NULL)
+        return;
+
+    call->type           = CPUNVG_TRIANGLES;
+    call->image          = paint->image;
+    call->blendFunc      = compositeOperation;
+    call->triangleOffset = cpu->npackedVerts;
+    call->triangleCount  = packed->nverts;
+    if (cpunvg__copyPacked(cpu, call, packed, 0) == -1)
+        goto error;
+    if (! cpunvg__trianglesUniforms(cpu, call, paint, scissor, fringe))
+        goto error;
+
+    cpunvg__packedCallBounds(cpu, call, call->triangleOffset);
+    return;
+
+error:
+    if (cpu->ncalls > 0)
+        cpu->ncalls--;
+}
+
+static void cpunvg__renderDelete(void* uptr)
+{
+    CPUNVGcontext* cpu = (CPUNVGcontext*)uptr;
+    int            i;
+
+    if (cpu == NULL)
+        return;
+
+    cpunvg__stopThreads(cpu);
+    pthread_cond_destroy(&cpu->done);
+    pthread_cond_destroy(&cpu->wake);
+    pthread_mutex_destroy(&cpu->lock);
+
+    for (i = 0; i < cpu->ntextures; i++)
+        cpunvg__freeTextureData(&cpu->textures[i]);
+
+    free(cpu->textures);
+    free(cpu->calls);
+    free(cpu->paths);
+    free(cpu->verts);
+    free(cpu->packedVerts);
+    free(cpu->uniforms);
+    free(cpu->mainPixels);
+    free(cpu->stencil);
+    free(cpu);
+}
+
+//
+// Public API
+//
+
+static CPUNVGcontext* cpunvg__context(NVGcontext* ctx) { return (CPUNVGcontext*)nvgInternalParams(ctx)->userPtr; }
+
+NVGcontext* nvgCreateCPU(int flags, int width, int height)
+{
+    NVGparams      params;
+    NVGcontext*    ctx = NULL;
+    CPUNVGcontext* cpu = (CPUNVGcontext*)calloc(1, sizeof(CPUNVGcontext));
+    if (cpu == NULL)
+        return NULL;
+
+    cpu->flags      = flags;
+    cpu->nthreads   = 1;
+    cpu->mainWidth  = width;
+    cpu->mainHeight = height;
+    cpu->mainPixels = (unsigned char*)calloc((size_t)width * height * 4, 1);
+    pthread_mutex_init(&cpu->lock, NULL);
+    pthread_cond_init(&cpu->wake, NULL);
+    pthread_cond_init(&cpu->done, NULL);
+    if (cpu->mainPixels == NULL || ! cpunvg__startThreads(cpu, 0))
+    {
+        cpunvg__renderDelete(cpu);
+        return NULL;
+    }
+
+    memset(&params, 0, sizeof(params));
+    params.renderCreate         = cpunvg__renderCreate;
+    params.renderCreateTexture  = cpunvg__renderCreateTexture;
+    params.renderDeleteTexture  = cpunvg__renderDeleteTexture;
+    params.renderUpdateTexture  = cpunvg__renderUpdateTexture;
+    params.renderGetTextureSize = cpunvg__renderGetTextureSize;
+    params.renderViewport       = cpunvg__renderViewport;
+    params.renderCancel         = cpunvg__renderCancel;
+    params.renderFlush          = cpunvg__renderFlush;
+    params.renderFill           = cpunvg__renderFill;
+    params.renderStroke         = cpunvg__renderStroke;
+    params.renderTriangles      = cpunvg__renderTriangles;
+    params.renderDelete         = cpunvg__renderDelete;
+    params.userPtr              = cpu;
+    params.edgeAntiAlias        = flags & NVG_ANTIALIAS ? 1 : 0;
+
+    // 'cpu' is freed by nvgDeleteInternal.
+    ctx = nvgCreateInternal(&params);
+    if (ctx == NULL)
+        return NULL;
+
+    return ctx;
+}
+
+void nvgDeleteCPU(NVGcontext* ctx) { nvgDeleteInternal(ctx); }
+
+int cpunvgPackedParams(const NVGparams* params, NVGpackedParams* packed)
+{
+    if (params->renderCreate != cpunvg__renderCreate)
+        return 0;
+    packed->renderFill      = cpunvg__renderFillPacked;
+    packed->renderStroke    = cpunvg__renderStrokePacked;
+    packed->renderTriangles = cpunvg__renderTrianglesPacked;
+    return 1;
+}
+
+void cpunvgSetThreadCount(NVGcontext* ctx, int nthreads)
+{
+    CPUNVGcontext* cpu = cpunvg__context(ctx);
+    cpunvg__stopThreads(cpu);
+    cpunvg__startThreads(cpu, nthreads);
+}
+
+void cpunvgSetViewBounds(NVGcontext* ctx, int width, int height)
+{
+    CPUNVGcontext* cpu    = cpunvg__context(ctx);
+    unsigned char* pixels = (unsigned char*)calloc((size_t)width * height * 4, 1);
+    if (pixels == NULL)
+        return;
+    free(cpu->mainPixels);
+    cpu->mainPixels = pixels;
+    cpu->mainWidth  = width;
+    cpu->mainHeight = height;
+}
+
+void cpunvgBindFramebuffer(NVGcontext* ctx, int image) { cpunvg__context(ctx)->image = image; }
+
+int cpunvgCreateFramebuffer(NVGcontext* ctx, int w, int h, int flags)
+{
+    if (flags & NVG_IMAGE_SHARED)
+        return cpunvgCreateSharedFramebuffer(ctx, w, h, 0, 3, flags);
+    return nvgCreateImageRGBA(ctx, w, h, flags, NULL);
+}
+
+int cpunvgCreateSharedFramebuffer(NVGcontext* ctx, int w, int h, int stride, int nbuffers, int flags)
+{
+    // Created as a regular image first so the wrapper's bookkeeping sees it
+    int            image = nvgCreateImageRGBA(ctx, w, h, flags & ~NVG_IMAGE_SHARED, NULL);
+    CPUNVGtexture* tex   = image != 0 ? cpunvg__findTexture(cpunvg__context(ctx), image) : NULL;
+    if (tex == NULL)
+        return 0;
+    if (! cpunvg__createShared(tex, stride, nbuffers))
+    {
+        nvgDeleteImage(ctx, image);
+        return 0;
+    }
+    return image;
+}
+
+int cpunvgSharedFramebufferFd(NVGcontext* ctx, int image, size_t* size)
+{
+    CPUNVGtexture* tex = image != 0 ? cpunvg__findTexture(cpunvg__context(ctx), image) : NULL;
+    if (tex == NULL || tex->shared == NULL)
+        return -1;
+    if (size)
+        *size = tex->shared->size;
+    return tex->shared->fd;
+}
+
+void cpunvgClearWithColor(NVGcontext* ctx, NVGcolor color)
+{
+    CPUNVGcontext* cpu = cpunvg__context(ctx);
+    CPUNVGtarget   target;
+    unsigned char  rgba[4];
+    int            x, y, c;
+
+    if (! cpunvg__target(cpu, cpu->image, &target))
+        return;
+
+    for (c = 0; c < 4; c++)
+        rgba[c] = (unsigned char)(cpunvg__clampf(color.rgba[c], 0.0f, 1.0f) * 255.0f + 0.5f);
+    for (y = 0; y < target.height; y++)
+    {
+        unsigned char* row = target.pixels + (size_t)y * target.stride;
+        for (x = 0; x < target.width; x++)
+            memcpy(row + x * 4, rgba, 4);
+    }
+}
+
+void cpunvgReadPixels(NVGcontext* ctx, int image, int x, int y, int width, int height, void* data)
+{
+    CPUNVGcontext* cpu = cpunvg__context(ctx);
+    CPUNVGtarget   target;
+    int            i;
+
+    if (! cpunvg__target(cpu, image, &target))
+        return;
+    if (x < 0 || y < 0 || x + width > target.width || y + height > target.height)
+        return;
+
+    for (i = 0; i < height; i++)
+    {
+        memcpy(
+            (char*)data + (size_t)i * width * 4,
+            target.pixels + (size_t)(y + i) * target.stride + x * 4,
+            (size_t)width * 4);
+    }
+}
+
+void cpunvgWriteImageRegion(NVGcontext* ctx, int image, int x, int y, int w, int h, const void* data, int pitch)
+{
+    CPUNVGtexture* tex = cpunvg__findTexture(cpunvg__context(ctx), image);
+    int            bpp, i;
+
+    if (tex == NULL || x < 0 || y < 0 || x + w > tex->width || y + h > tex->height)
+        return;
+
+    bpp = tex->type == NVG_TEXTURE_RGBA ? 4 : 1;
+    for (i = 0; i < h; i++)
+    {
+        memcpy(
+            tex->data + (size_t)(y + i) * tex->stride + x * bpp,
+            (const unsigned char*)data + (size_t)i * pitch,
+            (size_t)w * bpp);
+    }
+    CPUNVG_IMAGE_WRITTEN(ctx, image, x, y, w, h, data, pitch);
+}
+
+unsigned char* cpunvgImageData(NVGcontext* ctx, int image, int* w, int* h, int* stride)
+{
+    CPUNVGtarget target;
+    if (! cpunvg__target(cpunvg__context(ctx), image, &target))
+        return NULL;
+    if (w)
+        *w = target.width;
+    if (h)
+        *h = target.height;
+    if (stride)
+        *stride = target.stride;
+    return target.pixels;
+}
+
+#endif // NANOVG_CPU_IMPLEMENTATION
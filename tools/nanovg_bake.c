@@ -0,0 +1,172 @@
+// Bakes fonts into a glyph atlas file for nvgLoadGlyphAtlas()
+//
+// nanovg_bake [-p ratio] [-s sizes] [-b blur] [-r first-last]... -f name=path... output
+//
+//   -f name=path  Font to bake, created as `name`, the name the application passes to nvgCreateFont(). Repeatable
+//   -s sizes      Comma separated font sizes, as passed to nvgFontSize(). Defaults to 14
+//   -p ratio      Device pixel ratio the application draws at. Defaults to NVG_DEFAULT_PIXEL_RATIO
+//   -b blur       Font blur, as passed to nvgFontBlur(). Defaults to 0
+//   -r first-last Codepoint range, decimal or 0x prefixed hex. Repeatable, defaults to 32-126
+//
+// The context is never drawn to, but it needs a backend that can create one without a window, like the Linux one.
+
+#include "nanovg_compat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_FONTS 16
+#define MAX_SIZES 32
+#define MAX_RANGES 64
+
+typedef struct BakeFont
+{
+    char        name[64];
+    const char* path;
+    int         id;
+} BakeFont;
+
+static int usage(void)
+{
+    fprintf(stderr, "usage: nanovg_bake [-p ratio] [-s sizes] [-b blur] [-r first-last]... -f name=path... output\n");
+    return 2;
+}
+
+static int parseSizes(const char* arg, float* sizes)
+{
+    int n = 0;
+    while (*arg && n < MAX_SIZES)
+    {
+        char* end;
+        sizes[n] = strtof(arg, &end);
+        if (end == arg || sizes[n] <= 0.0f)
+            return 0;
+        n++;
+        arg = *end == ',' ? end + 1 : end;
+    }
+    return *arg ? 0 : n;
+}
+
+static int parseRange(const char* arg, unsigned int* range)
+{
+    char* end;
+    range[0] = (unsigned int)strtoul(arg, &end, 0);
+    if (end == arg || *end != '-')
+        return 0;
+    arg      = end + 1;
+    range[1] = (unsigned int)strtoul(arg, &end, 0);
+    return end != arg && *end == '\0' && range[0] <= range[1];
+}
+
+int main(int argc, char** argv)
+{
+    BakeFont     fonts[MAX_FONTS];
+    float        sizes[MAX_SIZES] = {14.0f};
+    unsigned int ranges[MAX_RANGES][2];
+    float        ratio = NVG_DEFAULT_PIXEL_RATIO, blur = 0.0f;
+    int          nfonts = 0, nsizes = 1, nranges = 0;
+    const char*  output = NULL;
+    NVGcontext*  ctx;
+    int          i, j, k, ok = 1;
+
+    for (i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        if (arg[0] != '-')
+        {
+            if (output != NULL)
+                return usage();
+            output = arg;
+            continue;
+        }
+        if (arg[1] == '\0' || arg[2] != '\0' || i + 1 >= argc)
+            return usage();
+
+        switch (arg[1])
+        {
+        case 'f':
+        {
+            const char* spec = argv[++i];
+            const char* eq   = strchr(spec, '=');
+            if (eq == NULL || eq == spec || (size_t)(eq - spec) >= sizeof(fonts[0].name) || nfonts == MAX_FONTS)
+                return usage();
+            memcpy(fonts[nfonts].name, spec, eq - spec);
+            fonts[nfonts].name[eq - spec] = '\0';
+            fonts[nfonts].path            = eq + 1;
+            nfonts++;
+            break;
+        }
+        case 's':
+            nsizes = parseSizes(argv[++i], sizes);
+            if (nsizes == 0)
+                return usage();
+            break;
+        case 'p':
+            ratio = strtof(argv[++i], NULL);
+            if (ratio <= 0.0f)
+                return usage();
+            break;
+        case 'b':
+            blur = strtof(argv[++i], NULL);
+            break;
+        case 'r':
+            if (nranges == MAX_RANGES || ! parseRange(argv[++i], ranges[nranges]))
+                return usage();
+            nranges++;
+            break;
+        default:
+            return usage();
+        }
+    }
+    if (nfonts == 0 || output == NULL)
+        return usage();
+    if (nranges == 0)
+    {
+        ranges[0][0] = 32;
+        ranges[0][1] = 126;
+        nranges      = 1;
+    }
+
+    ctx = nvgCreateContext(NULL, NVG_DEFAULT_CONTEXT_FLAGS, 1, 1);
+    if (ctx == NULL)
+    {
+        fprintf(stderr, "nanovg_bake: failed to create a context\n");
+        return 1;
+    }
+
+    for (i = 0; i < nfonts && ok; i++)
+    {
+        fonts[i].id = nvgCreateFont(ctx, fonts[i].name, fonts[i].path);
+        if (fonts[i].id == -1)
+        {
+            fprintf(stderr, "nanovg_bake: failed to load %s\n", fonts[i].path);
+            ok = 0;
+        }
+    }
+
+    for (i = 0; i < nfonts && ok; i++)
+    {
+        for (j = 0; j < nsizes && ok; j++)
+        {
+            for (k = 0; k < nranges && ok; k++)
+            {
+                int n = nvgBakeGlyphs(ctx, fonts[i].id, sizes[j] * ratio, blur * ratio, ranges[k][0], ranges[k][1]);
+                if (n < 0)
+                {
+                    fprintf(stderr, "nanovg_bake: the atlas is full at %s %gpx\n", fonts[i].name, sizes[j] * ratio);
+                    ok = 0;
+                }
+            }
+        }
+    }
+
+    if (ok && ! nvgSaveGlyphAtlas(ctx, output))
+    {
+        fprintf(stderr, "nanovg_bake: failed to write %s\n", output);
+        ok = 0;
+    }
+
+    nvgDeleteContext(ctx);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+// Replays a trace written between nvgBeginCapture() & nvgEndCapture() & prints the time spent in each kind of call
+//
+// nanovg_replay [-s WxH] [-t threads] [-n loops] trace
+//
+//   -s WxH      Size of the context. Defaults to 1920x1080
+//   -t threads  Rasterizer threads of the Linux backend. Defaults to 0, one per online CPU
+//   -n loops    Number of times the trace is replayed. Defaults to 1
+//
+// The context is created without a window, so this needs a backend that can do that, like the Linux one.
+
+#include "nanovg_compat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int usage(void)
+{
+    fprintf(stderr, "usage: nanovg_replay [-s WxH] [-t threads] [-n loops] trace\n");
+    return 2;
+}
+
+static void printCalls(const char* name, const NanoVGReplayCalls* calls)
+{
+    printf(
+        "%-10s %10d %14.3f %12.3f %12.3f\n",
+        name,
+        calls->count,
+        calls->ns / 1e6,
+        calls->count != 0 ? calls->ns / 1e3 / calls->count : 0.0,
+        calls->maxNs / 1e3);
+}
+
+int main(int argc, char** argv)
+{
+    NanoVGReplayStats stats, total;
+    const char*       trace   = NULL;
+    int               width   = 1920, height = 1080;
+    int               threads = 0, loops = 1;
+    NVGcontext*       ctx;
+    int               i, ok = 1;
+
+    for (i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        if (arg[0] != '-')
+        {
+            if (trace != NULL)
+                return usage();
+            trace = arg;
+            continue;
+        }
+        if (arg[1] == '\0' || arg[2] != '\0' || i + 1 >= argc)
+            return usage();
+
+        switch (arg[1])
+        {
+        case 's':
+            if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+                return usage();
+            break;
+        case 't':
+            threads = atoi(argv[++i]);
+            if (threads < 0)
+                return usage();
+            break;
+        case 'n':
+            loops = atoi(argv[++i]);
+            if (loops <= 0)
+                return usage();
+            break;
+        default:
+            return usage();
+        }
+    }
+    if (trace == NULL)
+        return usage();
+
+    ctx = nvgCreateContext(NULL, NVG_DEFAULT_CONTEXT_FLAGS, width, height);
+    if (ctx == NULL)
+    {
+        fprintf(stderr, "nanovg_replay: failed to create a context\n");
+        return 1;
+    }
+#ifdef __linux__
+    cpunvgSetThreadCount(ctx, threads);
+#endif
+
+    memset(&total, 0, sizeof(total));
+    for (i = 0; i < loops && ok; i++)
+    {
+        NanoVGReplayCalls* calls[6];
+        NanoVGReplayCalls* totals[6];
+        int                j;
+
+        if (! nvgReplayCapture(ctx, trace, &stats))
+        {
+            fprintf(stderr, "nanovg_replay: failed to replay %s\n", trace);
+            ok = 0;
+        }
+
+        calls[0]  = &stats.fill;
+        calls[1]  = &stats.stroke;
+        calls[2]  = &stats.triangles;
+        calls[3]  = &stats.textures;
+        calls[4]  = &stats.flush;
+        calls[5]  = &stats.other;
+        totals[0] = &total.fill;
+        totals[1] = &total.stroke;
+        totals[2] = &total.triangles;
+        totals[3] = &total.textures;
+        totals[4] = &total.flush;
+        totals[5] = &total.other;
+        for (j = 0; j < 6; j++)
+        {
+            totals[j]->count += calls[j]->count;
+            totals[j]->ns    += calls[j]->ns;
+            totals[j]->maxNs  = calls[j]->maxNs > totals[j]->maxNs ? calls[j]->maxNs : totals[j]->maxNs;
+        }
+        total.frames     += stats.frames;
+        total.frameNs    += stats.frameNs;
+        total.maxFrameNs  = stats.maxFrameNs > total.maxFrameNs ? stats.maxFrameNs : total.maxFrameNs;
+    }
+
+    printf("%-10s %10s %14s %12s %12s\n", "call", "count", "total ms", "avg us", "max us");
+    printCalls("fill", &total.fill);
+    printCalls("stroke", &total.stroke);
+    printCalls("triangles", &total.triangles);
+    printCalls("textures", &total.textures);
+    printCalls("flush", &total.flush);
+    printCalls("other", &total.other);
+    printf(
+        "%d frames, %.3f ms avg, %.3f ms max\n",
+        total.frames,
+        total.frames != 0 ? total.frameNs / 1e6 / total.frames : 0.0,
+        total.maxFrameNs / 1e6);
+
+    nvgDeleteContext(ctx);
+    return ok ? 0 : 1;
+}